@@ -2,6 +2,7 @@
 #define AUDIOFILESOURCEBUFFER_H
 
 #include <AudioFileSource.h>
+#include "binlog.h"
 
 extern uint8_t* opusDataBuffer;
 extern size_t opusDataLen;
@@ -21,11 +22,11 @@ public:
             
             // Debug first packet read
             if (currentPosition == 0) {
-                Serial.print("First OPUS packet: ");
+                uint32_t head[4] = {0, 0, 0, 0};
                 for (size_t i = 0; i < min(bytesToRead, (size_t)16); i++) {
-                    Serial.printf("%02X ", ((uint8_t*)data)[i]);
+                    head[i / 4] |= (uint32_t)((uint8_t*)data)[i] << (24 - 8 * (i % 4));
                 }
-                Serial.println();
+                ZLOGD("First OPUS packet: %08X %08X %08X %08X", head[0], head[1], head[2], head[3]);
             }
             
             currentPosition += bytesToRead;
@@ -55,12 +56,12 @@ public:
         }
 
         if (newPos < 0 || newPos > (int32_t)opusDataLen) {
-            Serial.printf("Invalid seek to %d (dir=%d)\n", newPos, dir);
+            ZLOGW("Invalid seek to %d (dir=%d)", newPos, dir);
             return false;
         }
 
         currentPosition = newPos;
-        Serial.printf("Seek to %d (dir=%d)\n", currentPosition, dir);
+        ZLOGD("Seek to %u (dir=%d)", (unsigned)currentPosition, dir);
         return true;
     }
 
@@ -0,0 +1,139 @@
+#pragma once
+
+// Deferred binary logging.
+//
+// ZLOGx(fmt, args...) does not format anything: it stores a pointer to the call
+// site's static format string, a timestamp and the raw 32-bit arguments in a
+// lock-free ring, which a low-priority task formats and prints later. A call
+// costs a few hundred cycles instead of the milliseconds a Serial.printf line
+// takes at 115200 baud.
+//
+// Levels above ZELLO_LOG_LEVEL are removed at compile time.
+// Arguments must be integers, chars or pointers of at most 32 bits (no floats).
+// %s arguments must outlive the deferral: string literals or static buffers only.
+
+#include <atomic>
+#include <stdint.h>
+#include <type_traits>
+
+#define BINLOG_ERROR 1
+#define BINLOG_WARN 2
+#define BINLOG_INFO 3
+#define BINLOG_DEBUG 4
+
+#ifndef ZELLO_LOG_LEVEL
+#define ZELLO_LOG_LEVEL BINLOG_INFO
+#endif
+
+#ifndef BINLOG_RING_SIZE
+#define BINLOG_RING_SIZE 256   // records, must be a power of two
+#endif
+
+#define BINLOG_MAX_ARGS 6
+
+struct BinlogSite {
+    const char* format;
+    uint8_t level;
+};
+
+struct BinlogRecord {
+    std::atomic<uint32_t> sequence;
+    const BinlogSite* site;
+    uint32_t timestampUs;
+    uint8_t argCount;
+    uint32_t args[BINLOG_MAX_ARGS];
+};
+
+// Bounded multi-producer / single-consumer queue (Vyukov style): producers claim
+// a slot with one CAS, the consumer is the formatting task.
+class BinlogRing {
+public:
+    BinlogRing() : _enqueue(0), _dequeue(0), _dropped(0) {
+        for (uint32_t i = 0; i < BINLOG_RING_SIZE; i++) {
+            _records[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const BinlogSite* site, uint32_t timestampUs, const uint32_t* args, uint8_t argCount) {
+        uint32_t pos = _enqueue.load(std::memory_order_relaxed);
+        BinlogRecord* rec;
+        for (;;) {
+            rec = &_records[pos & (BINLOG_RING_SIZE - 1)];
+            uint32_t seq = rec->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            if (diff == 0) {
+                if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);   // full: never block the caller
+                return false;
+            } else {
+                pos = _enqueue.load(std::memory_order_relaxed);
+            }
+        }
+        rec->site = site;
+        rec->timestampUs = timestampUs;
+        rec->argCount = argCount;
+        for (uint8_t i = 0; i < argCount; i++) rec->args[i] = args[i];
+        rec->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; copies the record out and frees the slot
+    bool pop(BinlogSite const*& site, uint32_t& timestampUs, uint32_t* args) {
+        uint32_t pos = _dequeue;
+        BinlogRecord* rec = &_records[pos & (BINLOG_RING_SIZE - 1)];
+        if (rec->sequence.load(std::memory_order_acquire) != pos + 1) return false;
+        site = rec->site;
+        timestampUs = rec->timestampUs;
+        for (uint8_t i = 0; i < BINLOG_MAX_ARGS; i++) args[i] = i < rec->argCount ? rec->args[i] : 0;
+        rec->sequence.store(pos + BINLOG_RING_SIZE, std::memory_order_release);
+        _dequeue = pos + 1;
+        return true;
+    }
+
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    // Records claimed and not yet formatted; approximate from other tasks
+    uint32_t pending() const { return _enqueue.load(std::memory_order_relaxed) - _dequeue; }
+
+private:
+    std::atomic<uint32_t> _enqueue;
+    uint32_t _dequeue;
+    std::atomic<uint32_t> _dropped;
+    BinlogRecord _records[BINLOG_RING_SIZE];
+};
+
+extern BinlogRing binlogRing;
+uint32_t binlogTimestampUs();
+
+template <typename T>
+inline uint32_t binlogArg(T value) {
+    static_assert(!std::is_floating_point<T>::value, "binlog cannot defer floats, log them with Serial or scale to an integer");
+    static_assert(sizeof(T) <= sizeof(uint32_t), "binlog arguments must be 32-bit or smaller");
+    return (uint32_t)(uintptr_t)value;
+}
+
+template <typename... Args>
+inline void binlogWrite(const BinlogSite* site, Args... args) {
+    static_assert(sizeof...(Args) <= BINLOG_MAX_ARGS, "too many binlog arguments");
+    const uint32_t words[sizeof...(Args) + 1] = {binlogArg(args)...};
+    binlogRing.push(site, binlogTimestampUs(), words, sizeof...(Args));
+}
+
+// Never called; lets the compiler check the format against the arguments
+inline void binlogCheckFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void binlogCheckFormat(const char*, ...) {}
+
+#define ZLOG(level, fmt, ...)                                    \
+    do {                                                         \
+        if ((level) <= ZELLO_LOG_LEVEL) {                        \
+            static const BinlogSite _binlogSite = {fmt, level};  \
+            if (0) binlogCheckFormat(fmt, ##__VA_ARGS__);        \
+            binlogWrite(&_binlogSite, ##__VA_ARGS__);            \
+        }                                                        \
+    } while (0)
+
+#define ZLOGE(fmt, ...) ZLOG(BINLOG_ERROR, fmt, ##__VA_ARGS__)
+#define ZLOGW(fmt, ...) ZLOG(BINLOG_WARN, fmt, ##__VA_ARGS__)
+#define ZLOGI(fmt, ...) ZLOG(BINLOG_INFO, fmt, ##__VA_ARGS__)
+#define ZLOGD(fmt, ...) ZLOG(BINLOG_DEBUG, fmt, ##__VA_ARGS__)
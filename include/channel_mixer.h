@@ -0,0 +1,627 @@
+#pragma once
+
+// Pool of Opus decoders for overlapping streams, mixed to one PCM output.
+//
+// Every active stream (keyed by its Zello stream id) gets one of MIX_MAX_STREAMS
+// fixed slots: a libopus decoder and a small PCM FIFO that doubles as its jitter
+// buffer. Packets find their slot through a small open-addressing hash of the
+// stream id. When all slots are busy, a new stream takes the least recently used
+// slot among those of equal or lower priority.
+//
+// mix() sums the playing streams in Q15 fixed point with saturation. Streams below
+// the highest active priority are ducked, or silenced in pre-empt mode. Each
+// stream is also levelled by its own AGC, compressor and look-ahead limiter
+// (talker_agc.h). Gain changes ramp over one block so ducking never clicks. A
+// paused stream fades out, then keeps its decoder state and buffered audio until
+// it is resumed.
+//
+// A stream whose FIFO runs dry while it plays is not cut to silence: the gap is
+// filled with Opus packet loss concealment (SILK PLC and CNG, or CELT's), faded
+// out over MIX_PLC_FADE_SAMPLES, on top of comfort noise at the stream's own
+// background level. The noise bed stays until the jitter buffer has refilled.
+// A stream also fades out across its last block.
+//
+// Each stream is read at its own rate: a DriftEstimator (clock_drift.h) follows
+// its buffer depth as packets arrive and sets a read step a few ppm off unity,
+// and the FIFO is read with cubic (Catmull-Rom) interpolation at that step. At
+// exactly unity the samples are copied unchanged.
+//
+// A stream can also play faster without changing pitch (time_stretch.h, WSOLA):
+// replay at its chosen speed, and any stream whose FIFO has piled up past
+// MIX_BACKLOG_START_SAMPLES, e.g. after a Wi-Fi stall delivered its packets all
+// at once, at the backlog speed until it is down to MIX_BACKLOG_END_SAMPLES.
+// Otherwise the stall's delay would stay in the stream until it ended.
+//
+// Not thread-safe: the firmware decodes in loop() and mixes in the playback
+// task, both holding its audio lock.
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+#else
+// Host builds (tools/decoder_pool_check.cpp) provide millis()
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+uint32_t millis();
+#endif
+#include <opus.h>
+#include "talker_agc.h"
+#include "clock_drift.h"
+#include "time_stretch.h"
+
+#ifndef MIX_MAX_STREAMS
+#define MIX_MAX_STREAMS 4
+#endif
+#define PLAYBACK_SAMPLE_RATE 16000      // every stream is decoded to this rate
+#define MIX_FIFO_SAMPLES 3200           // 200 ms per stream
+#define MIX_PREBUFFER_SAMPLES 640       // 40 ms jitter buffer before a stream is heard
+#define MIX_MAX_PACKET_SAMPLES 1920     // 120 ms, the Opus maximum, at 16 kHz
+#define MIX_MAX_PACKET_BYTES 1276       // largest single-frame Opus packet
+#define MIX_BLOCK_SAMPLES 160           // 10 ms, the unit mix() works in
+#define MIX_UNITY_Q15 32767
+#define MIX_DUCK_Q15 8192               // -12 dB
+#define MIX_HEAP_RESERVE (160 * 1024)   // internal heap left for WiFi, TLS and the web server
+#define MIX_SILENCE_PEAK 330            // -40 dBFS: a decoded packet this quiet is a pause
+#define MIX_CATCHUP_KEEP_SAMPLES 4800   // catch-up shortens pauses to 300 ms
+#define MIX_PLC_FADE_SAMPLES 640        // 40 ms of concealment before only the noise bed is left
+#define MIX_CN_START_RMS 33             // -60 dBFS: comfort noise level until a floor is measured
+#define MIX_CN_MAX_RMS 104              // -50 dBFS: a louder background is not copied into gaps
+#define MIX_BACKLOG_START_SAMPLES 1600  // 100 ms queued: more than jitter alone piles up
+#define MIX_BACKLOG_END_SAMPLES 800     // 50 ms: back to the jitter buffer and a block
+#define MIX_BACKLOG_SPEED 120           // percent, default
+#define MIX_INDEX_BITS 4                // 16 hash buckets, at most a quarter in use
+#define MIX_INDEX_SIZE (1 << MIX_INDEX_BITS)
+#define MIX_INDEX_EMPTY -1
+static_assert(MIX_MAX_STREAMS * 2 <= MIX_INDEX_SIZE, "grow MIX_INDEX_BITS with MIX_MAX_STREAMS");
+
+struct MixStream {
+    uint32_t key;               // Zello stream id
+    uint8_t priority;           // higher wins
+    bool active;                // slot in use
+    bool closing;               // stop received, play out what is queued
+    bool primed;                // jitter buffer filled at least once
+    bool paused;                // parked: not mixed, audio kept for later
+    bool catchUp;               // drop pause audio beyond MIX_CATCHUP_KEEP_SAMPLES
+    bool concealing;            // ran dry: gap filled while the jitter buffer refills
+    bool inPsram;               // slot memory came from PSRAM (slower decode)
+    OpusDecoder* decoder;
+    int16_t* fifo;
+    uint16_t head;
+    uint16_t used;
+    uint16_t gainQ15;           // duck gain at the end of the last block
+    int32_t rampQ24;            // total gain at the end of the last block
+    StreamAgc agc;
+    DriftEstimator drift;
+    uint32_t stepQ24;           // FIFO samples read per output sample
+    uint32_t fracQ24;           // read position between head - 1 and head
+    int16_t prev;               // sample before the head, for the interpolation
+    TimeStretch stretch;
+    uint16_t speed;             // percent, pitch kept; 100 outside replay
+    bool draining;              // playing a backlog down at the backlog speed
+    bool fedAhead;              // decoded ahead from storage: a full FIFO is no backlog
+    uint32_t caughtUp;          // samples of backlog skipped by draining it faster
+    uint32_t silentRun;         // samples of the current pause so far
+    uint32_t skipped;           // samples cut from pauses by catch-up
+    uint32_t startMs;           // when the stream was opened
+    uint32_t lastUse;           // LRU clock at the last packet
+    uint32_t packets;
+    uint32_t starvations;       // times it ran dry while primed
+    uint32_t concealed;         // samples of the current gap so far
+    uint32_t concealedTotal;    // samples filled in over the whole stream
+    uint16_t floorRms;          // background level, for the comfort noise
+    uint32_t noiseSeed;
+    int32_t noiseLp;
+    uint32_t lastPacketMs;
+    char talker[64];
+};
+
+class ChannelMixer {
+public:
+    enum Mode : uint8_t { Duck, Preempt };   // lower priorities while a higher one talks
+
+    // Decoder state and FIFOs are allocated once. Internal RAM is faster, but TLS
+    // needs its share, so slots that would dig into MIX_HEAP_RESERVE go to PSRAM.
+    // Returns the number of usable slots.
+    int begin() {
+        size_t bytes = opus_decoder_get_size(1) + MIX_FIFO_SAMPLES * sizeof(int16_t);
+        _slots = 0;
+        for (int i = 0; i < MIX_INDEX_SIZE; i++) _index[i] = MIX_INDEX_EMPTY;
+        for (int i = 0; i < MIX_MAX_STREAMS; i++) {
+            bool inPsram = false;
+            uint8_t* mem = allocSlot(bytes, inPsram);
+            if (!mem) break;
+            MixStream& s = _streams[_slots++];
+            s = MixStream();
+            s.inPsram = inPsram;
+            s.fifo = (int16_t*)mem;
+            s.decoder = (OpusDecoder*)(mem + MIX_FIFO_SAMPLES * sizeof(int16_t));
+        }
+        return _slots;
+    }
+
+    int slots() const { return _slots; }
+    const MixStream& slot(int i) const { return _streams[i]; }
+
+    void setMode(Mode mode) { _mode = mode; }
+    Mode mode() const { return _mode; }
+
+    // Loudness normalization; off mixes at the duck gain only
+    void setAgc(bool on) { _agc = on; }
+    bool agc() const { return _agc; }
+
+    // Clock drift compensation; off reads every FIFO at exactly one sample per sample
+    void setDriftCompensation(bool on) { _drift = on; }
+
+    // Speed a backlog plays down at, percent; 100 lets it play late
+    void setBacklogSpeed(uint16_t percent) {
+        _backlogSpeed = percent < 100 ? 100 : percent > STRETCH_MAX_SPEED ? STRETCH_MAX_SPEED : percent;
+    }
+    uint16_t backlogSpeed() const { return _backlogSpeed; }
+
+    // Plays the stream faster at the same pitch, percent (100 to STRETCH_MAX_SPEED)
+    void setSpeed(uint32_t key, uint16_t percent) {
+        MixStream* s = find(key);
+        if (s) s->speed = percent < 100 ? 100 : percent > STRETCH_MAX_SPEED ? STRETCH_MAX_SPEED : percent;
+    }
+
+    // For streams played from storage (queue, replay), which keep their FIFO full on purpose
+    void setFedAhead(uint32_t key) {
+        MixStream* s = find(key);
+        if (s) s->fedAhead = true;
+    }
+
+    // O(1): the stream id is hashed into a table that is at most a quarter full,
+    // so a lookup probes one or two buckets
+    MixStream* find(uint32_t key) {
+        for (int h = hash(key), n = 0; n < MIX_INDEX_SIZE; h = (h + 1) & (MIX_INDEX_SIZE - 1), n++) {
+            int8_t i = _index[h];
+            if (i == MIX_INDEX_EMPTY) return nullptr;
+            if (_streams[i].key == key) return &_streams[i];
+        }
+        return nullptr;
+    }
+
+    // A stream of at least this priority is still receiving audio
+    bool talking(uint8_t priority) const { return floorTaken(priority, false); }
+
+    // ... or still playing out its tail: the floor is not free yet
+    bool busy(uint8_t priority) const { return floorTaken(priority, true); }
+
+    // Starts (or restarts) a stream. nullptr when every slot belongs to a
+    // higher-priority stream. If the stream took over a busy slot, *evicted
+    // receives the key of the stream that lost it.
+    MixStream* open(uint32_t key, uint8_t priority, const char* talker, uint32_t* evicted = nullptr) {
+        MixStream* s = find(key);
+        if (s) release(s);
+        for (int i = 0; i < _slots && !s; i++) {
+            if (!_streams[i].active) s = &_streams[i];
+        }
+        if (!s) {
+            s = leastRecentlyUsed(priority);
+            if (!s) return nullptr;
+            if (evicted) *evicted = s->key;
+            release(s);
+        }
+        if (opus_decoder_init(s->decoder, PLAYBACK_SAMPLE_RATE, 1) != OPUS_OK) return nullptr;
+        s->key = key;
+        s->priority = priority;
+        s->active = true;
+        s->closing = false;
+        s->primed = false;
+        s->paused = false;
+        s->catchUp = false;
+        s->concealing = false;
+        s->head = s->used = 0;
+        s->gainQ15 = 0;
+        s->rampQ24 = 0;
+        s->agc.begin(talker && *talker ? _talkerGains.recall(talker) : AGC_UNITY_Q12);
+        s->drift.begin();
+        s->stepQ24 = DRIFT_STEP_UNITY;
+        s->fracQ24 = 0;
+        s->prev = 0;
+        s->stretch.reset();
+        s->speed = 100;
+        s->draining = false;
+        s->fedAhead = false;
+        s->caughtUp = 0;
+        s->silentRun = 0;
+        s->skipped = 0;
+        s->lastUse = ++_clock;
+        s->packets = 0;
+        s->starvations = 0;
+        s->concealed = s->concealedTotal = 0;
+        s->floorRms = MIX_CN_START_RMS;
+        s->noiseSeed = key;
+        s->noiseLp = 0;
+        s->startMs = s->lastPacketMs = millis();
+        snprintf(s->talker, sizeof(s->talker), "%s", talker ? talker : "");
+        insert(s);
+        return s;
+    }
+
+    // Decodes one packet into the stream's FIFO; a full FIFO drops the oldest
+    // audio. With catch-up on, quiet packets past the first 300 ms of a pause are
+    // decoded (to keep the decoder state) but not queued.
+    int decode(MixStream* s, const uint8_t* data, size_t len) {
+        int samples = opus_decode(s->decoder, data, len, _pcm, MIX_MAX_PACKET_SAMPLES, 0);
+        if (samples <= 0) return samples;
+        s->packets++;
+        s->lastUse = ++_clock;
+        s->lastPacketMs = millis();
+        int peak = 0;
+        for (int i = 0; i < samples && peak < MIX_SILENCE_PEAK; i++) {
+            int v = _pcm[i] < 0 ? -_pcm[i] : _pcm[i];
+            if (v > peak) peak = v;
+        }
+        s->silentRun = peak < MIX_SILENCE_PEAK ? s->silentRun + samples : 0;
+        if (s->catchUp && s->silentRun > MIX_CATCHUP_KEEP_SAMPLES) {
+            s->skipped += samples;
+            return samples;
+        }
+        push(s, _pcm, samples);
+        if (s->used >= MIX_PREBUFFER_SAMPLES) s->primed = true;
+        // Live streams at their own pace only: a feeder or a backlog sets the others' depth
+        if (_drift && s->primed && !s->closing && !s->paused && !s->fedAhead && !s->draining) {
+            // The output has played on since the last block was mixed
+            uint32_t played = (millis() - _lastMixMs) * PLAYBACK_SAMPLE_RATE / 1000;
+            if (played > MIX_BLOCK_SAMPLES) played = MIX_BLOCK_SAMPLES;
+            s->stepQ24 = s->drift.update((int32_t)s->used - (int32_t)played, samples);
+        }
+        return samples;
+    }
+
+    void setCatchUp(uint32_t key, bool on) {
+        MixStream* s = find(key);
+        if (s) s->catchUp = on;
+    }
+
+    // A paused stream fades out over one block and then holds its place
+    void setPaused(uint32_t key, bool paused) {
+        MixStream* s = find(key);
+        if (s) s->paused = paused;
+    }
+
+    void close(uint32_t key) {
+        MixStream* s = find(key);
+        if (!s) return;
+        s->closing = true;
+        s->primed = true;   // play out the tail even if it never reached the prebuffer
+        if (s->used == 0) release(s);
+    }
+
+    // Drops a stream immediately, discarding anything queued
+    void drop(uint32_t key) {
+        MixStream* s = find(key);
+        if (s) release(s);
+    }
+
+    // True while a primed stream has samples to play, or a gap to fill
+    bool hasOutput() const {
+        for (int i = 0; i < _slots; i++) {
+            const MixStream& s = _streams[i];
+            if (audible(s) && (s.used || s.concealing)) return true;
+        }
+        return false;
+    }
+
+    uint8_t activeCount() const {
+        uint8_t n = 0;
+        for (int i = 0; i < _slots; i++) n += _streams[i].active;
+        return n;
+    }
+
+    uint16_t queuedMs(uint32_t key) {
+        MixStream* s = find(key);
+        return s ? s->used * 1000 / PLAYBACK_SAMPLE_RATE : 0;
+    }
+
+    // Mixes n (at most MIX_BLOCK_SAMPLES) mono samples; returns how many streams
+    // ran dry during this block (their gaps are concealed, see above)
+    int mix(int16_t* out, int n) {
+        int32_t acc[MIX_BLOCK_SAMPLES];
+        if (n > MIX_BLOCK_SAMPLES) n = MIX_BLOCK_SAMPLES;
+        _lastMixMs = millis();
+        memset(acc, 0, n * sizeof(int32_t));
+
+        int topPriority = -1;
+        for (int i = 0; i < _slots; i++) {
+            const MixStream& s = _streams[i];
+            if (audible(s) && !s.paused && s.priority > topPriority) topPriority = s.priority;
+        }
+
+        int starved = 0;
+        for (int i = 0; i < _slots; i++) {
+            MixStream& s = _streams[i];
+            if (!audible(s)) continue;
+            uint16_t target = s.paused ? 0
+                            : s.priority >= topPriority ? MIX_UNITY_Q15
+                            : (_mode == Duck ? MIX_DUCK_Q15 : 0);
+            if (s.concealing && s.primed) {
+                // Refilled: the first packet after a long gap fades in from the noise bed
+                s.concealing = false;
+                if (s.concealed >= MIX_PLC_FADE_SAMPLES) s.rampQ24 = 0;
+            } else if (s.concealing) {
+                conceal(s, acc, n, target);
+                continue;
+            }
+            bool last = s.closing && s.used <= n;
+            if (last) target = 0;   // the stream's last samples fade out
+            int16_t pcm[MIX_BLOCK_SAMPLES];
+            int avail = read(s, pcm, n);
+            int32_t start = s.rampQ24 >> 12;
+            int32_t end = (target + 4) >> 3;   // Q15 -> Q12, unity stays exact
+            if (_agc) {
+                // Both ends of the ramp under the limit of the samples this block plays,
+                // which a sped-up read takes from up to STRETCH_MAX_LAG further on; the
+                // end also under the limit of what the next read may take from the new head
+                int32_t gain = s.agc.targetQ12(end);
+                int32_t now = StreamAgc::limitQ12(peakOf(pcm, avail), gain);
+                int32_t next = StreamAgc::limitQ12(peak(s, 0, readSpan(s, n)), gain);
+                if (start > now) start = now;
+                end = now < next ? now : next;
+            }
+            // Linear ramp from the previous block's gain to this one's, Q24
+            int32_t g = start << 12;
+            int32_t step = ((end - start) << 12) / (last && avail ? avail : n);
+            uint64_t sumSquares = 0;
+            for (int j = 0; j < avail; j++) {
+                int32_t x = pcm[j];
+                acc[j] += (x * (g >> 12)) >> 12;
+                sumSquares += (uint32_t)(x * x);
+                g += step;
+            }
+            s.gainQ15 = target;
+            s.rampQ24 = end << 12;
+            if (_agc) s.agc.update(sumSquares, avail);
+            if (avail == n) trackFloor(s, sumSquares, n);
+            if (s.closing && s.used == 0) {
+                release(&s);            // fully played out; hasOutput() would not mix it again
+            } else if (avail < n) {
+                s.primed = false;       // refill the jitter buffer before resuming
+                s.concealing = true;
+                s.concealed = 0;
+                s.drift.relearn();
+                s.stepQ24 = DRIFT_STEP_UNITY;
+                s.fracQ24 = 0;
+                s.starvations++;
+                starved++;
+                conceal(s, acc + avail, n - avail, target);
+            }
+        }
+
+        for (int j = 0; j < n; j++) {
+            int32_t v = acc[j];
+            out[j] = v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+        }
+        return starved;
+    }
+
+private:
+    MixStream _streams[MIX_MAX_STREAMS];
+    int _slots = 0;
+    int8_t _index[MIX_INDEX_SIZE];      // slot number per hash bucket
+    Mode _mode = Duck;
+    bool _agc = true;
+    bool _drift = true;
+    uint16_t _backlogSpeed = MIX_BACKLOG_SPEED;
+    uint32_t _lastMixMs = 0;
+    TalkerGainMemory _talkerGains;
+    uint32_t _clock = 0;                // LRU clock, ticks once per packet
+    int16_t _pcm[MIX_MAX_PACKET_SAMPLES];
+    int16_t _stretchIn[STRETCH_MAX_INPUT];
+
+    static uint8_t* allocSlot(size_t bytes, bool& inPsram) {
+#ifdef ARDUINO
+        uint8_t* mem = nullptr;
+        if (heap_caps_get_free_size(MALLOC_CAP_INTERNAL) > bytes + MIX_HEAP_RESERVE) {
+            mem = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        inPsram = !mem;
+        if (!mem) mem = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        return mem;
+#else
+        inPsram = false;
+        return (uint8_t*)malloc(bytes);
+#endif
+    }
+
+    // Mixed this block: primed or filling a gap, and not a paused stream that has
+    // already faded out
+    static bool audible(const MixStream& s) {
+        return s.active && (s.primed || s.concealing) && !(s.paused && s.gainQ15 == 0);
+    }
+
+    // Up to n samples of the stream at its read step into pcm; fewer when the FIFO
+    // runs short. Interpolating needs the two samples after the head as well, so
+    // the last two before running dry (or closing) are copied. A sped-up stream
+    // goes through its TimeStretch instead, a whole block at a time.
+    int read(MixStream& s, int16_t* pcm, int n) {
+        if (s.used > MIX_BACKLOG_START_SAMPLES) s.draining = _backlogSpeed > 100 && !s.fedAhead;
+        if (s.used <= MIX_BACKLOG_END_SAMPLES) s.draining = false;
+        uint16_t speed = s.draining && _backlogSpeed > s.speed ? _backlogSpeed : s.speed;
+        if (speed > 100 && n == STRETCH_SEGMENT_SAMPLES && s.used >= n) {
+            int avail = s.used < STRETCH_MAX_INPUT ? s.used : STRETCH_MAX_INPUT;
+            for (int j = 0; j < avail; j++) _stretchIn[j] = s.fifo[(s.head + j) % MIX_FIFO_SAMPLES];
+            int used = s.stretch.process(_stretchIn, avail, pcm, speed);
+            if (speed > s.speed) s.caughtUp += used - n;
+            s.prev = _stretchIn[used - 1];
+            s.head = (s.head + used) % MIX_FIFO_SAMPLES;
+            s.used -= used;
+            s.fracQ24 = 0;
+            return n;
+        }
+        int j = 0;
+        if (s.stepQ24 != DRIFT_STEP_UNITY || s.fracQ24) {
+            for (; j < n && s.used >= 3; j++) {
+                int32_t t = s.fracQ24 >> 9;   // Q15
+                pcm[j] = catmullRom(s.prev, s.fifo[s.head], s.fifo[(s.head + 1) % MIX_FIFO_SAMPLES],
+                                    s.fifo[(s.head + 2) % MIX_FIFO_SAMPLES], t);
+                s.fracQ24 += s.stepQ24;
+                while (s.fracQ24 >= DRIFT_STEP_UNITY) {
+                    s.fracQ24 -= DRIFT_STEP_UNITY;
+                    take(s);
+                }
+            }
+            if (j == n) return j;
+            s.fracQ24 = 0;
+        }
+        for (; j < n && s.used; j++) pcm[j] = take(s);
+        return j;
+    }
+
+    static int16_t take(MixStream& s) {
+        s.prev = s.fifo[s.head];
+        s.head = (s.head + 1) % MIX_FIFO_SAMPLES;
+        s.used--;
+        return s.prev;
+    }
+
+    // Between x1 (t = 0) and x2 (t = 1), t in Q15
+    static int16_t catmullRom(int32_t x0, int32_t x1, int32_t x2, int32_t x3, int32_t t) {
+        int64_t a = 3 * (x1 - x2) + x3 - x0;
+        int64_t b = 2 * x0 - 5 * x1 + 4 * x2 - x3 + ((a * t) >> 15);
+        int64_t c = x2 - x0 + ((b * t) >> 15);
+        int32_t v = x1 + (int32_t)((c * t) >> 16);
+        return v > 32767 ? 32767 : v < -32768 ? -32768 : v;
+    }
+
+    // Fills count samples of a gap into acc. Concealment is only decoded while the
+    // FIFO is empty: once a packet has arrived, the decoder state is past the gap.
+    void conceal(MixStream& s, int32_t* acc, int count, uint16_t target) {
+        int plc = 0;
+        if (s.used == 0 && s.concealed < MIX_PLC_FADE_SAMPLES &&
+            opus_decode(s.decoder, nullptr, 0, _pcm, MIX_BLOCK_SAMPLES, 0) == MIX_BLOCK_SAMPLES) {
+            plc = count;
+        }
+        int32_t start = s.rampQ24 >> 12;
+        int32_t end = (target + 4) >> 3;
+        int32_t g = start << 12;
+        int32_t step = ((end - start) << 12) / count;
+        for (int j = 0; j < count; j++) {
+            int32_t v = comfortNoise(s);
+            int32_t left = MIX_PLC_FADE_SAMPLES - (int32_t)s.concealed - j;
+            if (j < plc && left > 0) v += _pcm[j] * left / MIX_PLC_FADE_SAMPLES;
+            acc[j] += (v * (g >> 12)) >> 12;
+            g += step;
+        }
+        s.concealed += count;
+        s.concealedTotal += count;
+        s.gainQ15 = target;
+        s.rampQ24 = end << 12;
+    }
+
+    // Low-passed white noise at floorRms. The filter, y += (x - y) / 2, leaves a
+    // third of the variance, so the full-scale noise has an RMS of about 10923.
+    static int32_t comfortNoise(MixStream& s) {
+        s.noiseSeed = s.noiseSeed * 1664525u + 1013904223u;
+        s.noiseLp += (((int32_t)s.noiseSeed >> 16) - s.noiseLp) >> 1;
+        return (s.noiseLp * s.floorRms * 3) >> 15;
+    }
+
+    // The background level follows quiet blocks down quickly and creeps up slowly,
+    // so speech barely lifts it
+    static void trackFloor(MixStream& s, uint64_t sumSquares, int n) {
+        int32_t rms = (int32_t)agcIsqrt((uint32_t)(sumSquares / n));
+        if (rms > MIX_CN_MAX_RMS) rms = MIX_CN_MAX_RMS;
+        int32_t floor = s.floorRms;
+        floor += rms < floor ? (rms - floor) >> 2 : 1;
+        s.floorRms = (uint16_t)(floor > MIX_CN_MAX_RMS ? MIX_CN_MAX_RMS : floor);
+    }
+
+    // Largest magnitude in pcm[0..n)
+    static int32_t peakOf(const int16_t* pcm, int n) {
+        int32_t p = 0;
+        for (int i = 0; i < n; i++) {
+            int32_t v = pcm[i] < 0 ? -pcm[i] : pcm[i];
+            if (v > p) p = v;
+        }
+        return p;
+    }
+
+    // How far past the head the next read() may take samples from: a sped-up
+    // block crossfades into input up to STRETCH_MAX_LAG on, interpolation looks
+    // two samples past the block
+    int readSpan(const MixStream& s, int n) const {
+        bool stretch = s.speed > 100 || (_backlogSpeed > 100 && (s.draining || s.used > MIX_BACKLOG_START_SAMPLES));
+        return stretch ? STRETCH_MAX_INPUT : n + 3;
+    }
+
+    // Largest magnitude among up to n queued samples, starting 'from' past the head
+    static int32_t peak(const MixStream& s, int from, int n) {
+        if (n > s.used - from) n = s.used - from;
+        int32_t p = 0;
+        for (int i = 0, pos = (s.head + from) % MIX_FIFO_SAMPLES; i < n; i++) {
+            int32_t v = s.fifo[pos];
+            if (v < 0) v = -v;
+            if (v > p) p = v;
+            if (++pos == MIX_FIFO_SAMPLES) pos = 0;
+        }
+        return p;
+    }
+
+    // Fibonacci hashing: Zello ids are sequential, the multiply spreads them
+    static int hash(uint32_t key) { return (key * 2654435761u) >> (32 - MIX_INDEX_BITS); }
+
+    void insert(MixStream* s) {
+        int h = hash(s->key);
+        while (_index[h] != MIX_INDEX_EMPTY) h = (h + 1) & (MIX_INDEX_SIZE - 1);
+        _index[h] = (int8_t)(s - _streams);
+    }
+
+    // Frees the slot and unhashes it. The rest of its probe run is reinserted, so
+    // lookups can stop at the first empty bucket without tombstones.
+    void release(MixStream* s) {
+        s->active = false;
+        if (s->agc.adapted && s->talker[0]) _talkerGains.store(s->talker, s->agc.agcQ12);
+        int8_t slot = (int8_t)(s - _streams);
+        int h = hash(s->key);
+        for (int n = 0; _index[h] != slot; h = (h + 1) & (MIX_INDEX_SIZE - 1)) {
+            if (_index[h] == MIX_INDEX_EMPTY || ++n == MIX_INDEX_SIZE) return;
+        }
+        _index[h] = MIX_INDEX_EMPTY;
+        for (h = (h + 1) & (MIX_INDEX_SIZE - 1); _index[h] != MIX_INDEX_EMPTY; h = (h + 1) & (MIX_INDEX_SIZE - 1)) {
+            int8_t moved = _index[h];
+            _index[h] = MIX_INDEX_EMPTY;
+            insert(&_streams[moved]);
+        }
+    }
+
+    bool floorTaken(uint8_t priority, bool draining) const {
+        for (int i = 0; i < _slots; i++) {
+            const MixStream& s = _streams[i];
+            if (s.active && !s.paused && (draining || !s.closing) && s.priority >= priority) return true;
+        }
+        return false;
+    }
+
+    // Lowest priority first, then the one whose last packet is oldest
+    MixStream* leastRecentlyUsed(uint8_t priority) {
+        MixStream* victim = nullptr;
+        for (int i = 0; i < _slots; i++) {
+            MixStream& s = _streams[i];
+            if (!s.active || s.priority > priority) continue;
+            if (!victim || s.priority < victim->priority ||
+                (s.priority == victim->priority && (int32_t)(s.lastUse - victim->lastUse) < 0)) {
+                victim = &s;
+            }
+        }
+        return victim;
+    }
+
+    void push(MixStream* s, const int16_t* pcm, int n) {
+        // Drop the oldest samples rather than the newest: latency stays bounded
+        int overflow = s->used + n - MIX_FIFO_SAMPLES;
+        if (overflow > 0) {
+            s->head = (s->head + overflow) % MIX_FIFO_SAMPLES;
+            s->used -= overflow;
+        }
+        uint16_t tail = (s->head + s->used) % MIX_FIFO_SAMPLES;
+        for (int i = 0; i < n; i++) {
+            s->fifo[tail] = pcm[i];
+            tail = (tail + 1) % MIX_FIFO_SAMPLES;
+        }
+        s->used += n;
+    }
+};
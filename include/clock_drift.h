@@ -0,0 +1,81 @@
+#pragma once
+
+// Clock drift compensation for the channel mixer.
+//
+// The sender's 16 kHz clock and the I2S clock differ by tens of ppm, so over a
+// long message a stream's FIFO slowly fills or drains. DriftEstimator follows
+// the stream's buffer depth and turns its trend into a read step: the mixer then
+// reads the FIFO that much faster or slower, interpolating between samples
+// (channel_mixer.h).
+//
+//   depth    sampled as each packet arrives: the FIFO fill less what the output
+//            has played since the last mix block. Fill levels sampled at mix
+//            time would only move in half-packet steps, whenever the packet and
+//            block clocks slip past each other.
+//   average  over ~1.3 s of audio (DRIFT_AVERAGE_SAMPLES), which flattens most
+//            network jitter
+//   target   the average DRIFT_SETTLE_SAMPLES after the jitter buffer primed, so
+//            the stream keeps the depth its jitter called for; relearned after
+//            every underrun
+//   step     a PI controller on average - target: the integral converges on the
+//            clock ratio, the proportional part steers the depth back, with a
+//            ~15 s time constant and at most DRIFT_MAX_PPM either way, far
+//            below an audible pitch change
+//
+// Once per packet and stream, so the controller runs in float.
+
+#include <stdint.h>
+
+#define DRIFT_STEP_UNITY (1u << 24)    // read step, Q24 input samples per output sample
+#define DRIFT_AVERAGE_SAMPLES 20480.0f // depth average time constant, 1.28 s at 16 kHz
+#define DRIFT_SETTLE_SAMPLES 80000     // 5 s: about four averaging time constants
+#define DRIFT_MAX_PPM 1000.0f
+#define DRIFT_KP 1e-5f                 // per sample of depth error
+#define DRIFT_KI 2e-11f                // per sample of depth error, per sample of audio
+
+struct DriftEstimator {
+    float depth;                       // averaged, samples; < 0 until the first packet
+    float target;
+    uint32_t settled;                  // samples received since the jitter buffer (re)primed
+    float integral;                    // clock ratio - 1, as far as it is known
+    float correction;                  // applied now
+
+    // New stream: nothing known about its clock
+    void begin() {
+        integral = 0;
+        relearn();
+    }
+
+    // After an underrun: the refilled depth is the new target; the clock ratio stays
+    void relearn() {
+        depth = -1;
+        settled = 0;
+        correction = integral;
+    }
+
+    // Per packet of 'samples' with the buffer depth after it; returns the read step
+    uint32_t update(int32_t now, int samples) {
+        depth = depth < 0 ? now : depth + (now - depth) * (samples / DRIFT_AVERAGE_SAMPLES);
+        if (settled < DRIFT_SETTLE_SAMPLES) {
+            settled += samples;
+            if (settled >= DRIFT_SETTLE_SAMPLES) target = depth;
+            return step(integral);
+        }
+        float error = depth - target;
+        integral = clamp(integral + DRIFT_KI * error * samples);
+        return step(integral + DRIFT_KP * error);
+    }
+
+    int32_t ppm() const { return (int32_t)(integral * 1e6f + (integral < 0 ? -0.5f : 0.5f)); }
+
+private:
+    static float clamp(float v) {
+        const float limit = DRIFT_MAX_PPM * 1e-6f;
+        return v > limit ? limit : v < -limit ? -limit : v;
+    }
+
+    uint32_t step(float c) {
+        correction = clamp(c);
+        return (uint32_t)((int32_t)DRIFT_STEP_UNITY + (int32_t)(correction * DRIFT_STEP_UNITY));
+    }
+};
@@ -0,0 +1,370 @@
+#pragma once
+
+// Acoustic echo cancellation for full-duplex transmit, in fixed point.
+//
+// EchoReference keeps what the speaker played on a timeline: playback appends
+// each output block with the time it reaches the DAC, gaps become silence, and
+// the capture task reads back the samples that were playing while a mic frame
+// was recorded.
+//
+// EchoCanceller is a partitioned-block frequency-domain NLMS filter
+// (overlap-save, as in Speex' MDF) on the FFT Opus already carries: 160-sample
+// blocks, EC_PARTITIONS partitions of 320 taps on 480-point transforms. The two
+// blocks of a 20 ms frame are real signals, so each transform carries both as
+// its real and imaginary parts; a filter with a real impulse response applies
+// to both at once, and only the gradient needs them split. Per frame that is
+// five transforms: reference, echo estimate, error, and the constraint that
+// keeps every partition's impulse response inside its 320 taps. The step is
+// normalized per bin by the reference power and scaled per frame by how much
+// of the error is residual echo (Valin's leakage estimate, as in MDF), so it
+// shrinks while the near end talks instead of waiting on a double-talk
+// detector to notice them. A filter that makes things worse for a second
+// starts over.
+//
+// Adds no delay: the output frame is the input frame minus the echo estimate.
+//
+// Not thread-safe: process() belongs to the capture task.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+extern "C" {
+#include "config.h"
+#include "opus_custom.h"
+#include "celt/modes.h"
+}
+
+#define EC_BLOCK 160
+#define EC_FRAME_SAMPLES 320           // two blocks, 20 ms at 16 kHz
+#define EC_FFT_SIZE 480
+#define EC_BINS (EC_FFT_SIZE / 2 + 1)
+#define EC_PARTITION_TAPS 320          // one frame: partition p reuses the reference spectrum from p frames ago
+#define EC_PARTITIONS 2                // 640 taps, 40 ms of echo path
+#define EC_INPUT_SHIFT 8               // headroom bits the samples gain before the FFT
+#define EC_POWER_SHIFT 16              // reference bin power scaled down to fit 32 bits
+#define EC_W_SHIFT 20                  // filter spectrum fraction bits
+#define EC_CONSTRAINT_SHIFT 2          // headroom for the constraint's inverse transform
+#define EC_MU_MAX 0.2f                 // step size ceiling
+#define EC_MU_START 0.25f              // step while the echo path is being found
+#define EC_DELTA 256                   // power floor: quiet reference bins take no big steps
+#define EC_POWER_SMOOTH_SHIFT 2
+#define EC_LEAK_MEAN 0.175f            // energy means the leakage regression works around
+#define EC_LEAK_RATE 0.04f             // leakage estimate update, scaled by echo over error energy
+#define EC_LEAK_RATE_MAX 0.01f
+#define EC_LEAK_MIN 0.005f
+#define EC_ADAPTED_LEAK 0.03f
+#define EC_DOUBLE_TALK_MU 0.05f        // a step cut below this counts as double talk
+#define EC_WORSE_MARGIN 10000          // mean power an output over the mic's must exceed to count as worse
+#define EC_WORSE_FRAMES 50             // and for how many frames in a row before the filter restarts
+#define EC_REF_ENERGY_MIN (64 * 64)    // mean reference power below this: nothing to cancel, nothing to learn
+
+#define EC_SAMPLE_RATE 16000
+#define EC_REF_SAMPLES 8192            // 512 ms of played audio, a power of two
+
+class EchoReference {
+public:
+    // Playback task: n samples (every stride-th of samples) that start playing at playUs.
+    // A block that does not follow on from the previous one leaves silence between.
+    void write(const int16_t* samples, int n, int stride, uint32_t playUs) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        int32_t gapUs = _anchored ? (int32_t)(playUs - expectedUs(head)) : -1;
+        if (gapUs < 0 || gapUs > (int32_t)(EC_REF_SAMPLES * 1000000ull / EC_SAMPLE_RATE)) {
+            // A new start, or overlapping, or long after: restart the timeline on silence
+            memset(_ring, 0, sizeof(_ring));
+            head += EC_REF_SAMPLES;
+        } else {
+            for (uint32_t gap = (uint64_t)gapUs * EC_SAMPLE_RATE / 1000000; gap; gap--) _ring[head++ & (EC_REF_SAMPLES - 1)] = 0;
+        }
+        for (int i = 0; i < n; i++) _ring[(head + i) & (EC_REF_SAMPLES - 1)] = samples[i * stride];
+        // Anchor the block's first sample, then publish it
+        _seq.fetch_add(1, std::memory_order_acq_rel);
+        _anchorIndex = head;
+        _anchorUs = playUs;
+        _seq.fetch_add(1, std::memory_order_release);
+        _head.store(head + n, std::memory_order_release);
+        _anchored = true;
+    }
+
+    // Playback stopped: nothing more follows on
+    void stop() { _anchored = false; }
+
+    // Capture task: the n samples playing from atUs on. Silence where nothing was
+    // (or is yet) written; false when it is all silence.
+    bool read(uint32_t atUs, int16_t* out, int n) const {
+        uint32_t index, anchorUs, seq;
+        do {
+            seq = _seq.load(std::memory_order_acquire);
+            index = _anchorIndex;
+            anchorUs = _anchorUs;
+        } while ((seq & 1) || seq != _seq.load(std::memory_order_acquire));
+        uint32_t head = _head.load(std::memory_order_acquire);
+        index += (int32_t)((int64_t)(int32_t)(atUs - anchorUs) * EC_SAMPLE_RATE / 1000000);
+        bool any = false;
+        for (int i = 0; i < n; i++, index++) {
+            uint32_t age = head - index;   // 1 = newest sample
+            out[i] = age >= 1 && age <= EC_REF_SAMPLES - EC_FRAME_SAMPLES ? _ring[index & (EC_REF_SAMPLES - 1)] : 0;
+            any |= out[i] != 0;
+        }
+        return any;
+    }
+
+private:
+    int16_t _ring[EC_REF_SAMPLES] = {0};
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _seq{0};
+    volatile uint32_t _anchorIndex = 0;
+    volatile uint32_t _anchorUs = 0;
+    bool _anchored = false;            // writer only
+
+    uint32_t expectedUs(uint32_t head) const {
+        return _anchorUs + (uint32_t)((uint64_t)(head - _anchorIndex) * 1000000 / EC_SAMPLE_RATE);
+    }
+};
+
+class EchoCanceller {
+public:
+    // Finds the FFT; false when Opus has no 480-point state
+    bool begin() {
+        int err;
+        const OpusCustomMode* mode = opus_custom_mode_create(48000, 960, &err);
+        _fft = mode ? mode->mdct.kfft[0] : nullptr;
+        if (!_fft || _fft->nfft != EC_FFT_SIZE) {
+            _fft = nullptr;
+            return false;
+        }
+        clear();
+        reset();
+        return true;
+    }
+
+    // Start of a transmission: keeps the echo path, drops the signal history
+    void reset() {
+        memset(_tail, 0, sizeof(_tail));
+        memset(_x, 0, sizeof(_x));
+        memset(_refEnergy, 0, sizeof(_refEnergy));
+    }
+
+    // Forgets the echo path as well
+    void clear() {
+        memset(_w, 0, sizeof(_w));
+        memset(_power, 0, sizeof(_power));
+        _meanE = _meanY = 0;
+        _pey = _pyy = 1;
+        _sumAdapt = 0;
+        _adapted = false;
+        _worse = 0;
+    }
+
+    // pcm[EC_FRAME_SAMPLES] in place; ref is what the speaker played while it was captured
+    void process(int16_t* pcm, const int16_t* ref) {
+        if (!_fft) return;
+        _frame++;
+        kiss_fft_cpx* x = _x[_frame % EC_PARTITIONS];
+
+        // Reference windows: block 1 ends a block into this frame, block 2 at its end
+        for (int i = 0; i < EC_FFT_SIZE; i++) {
+            int32_t a = i < EC_FFT_SIZE - EC_BLOCK ? _tail[i] : ref[i - (EC_FFT_SIZE - EC_BLOCK)];
+            int32_t b = i < EC_BLOCK ? _tail[i + EC_BLOCK] : ref[i - EC_BLOCK];
+            _buf[i].r = a << EC_INPUT_SHIFT;
+            _buf[i].i = b << EC_INPUT_SHIFT;
+        }
+        uint64_t refEnergy = 0;
+        for (int i = 0; i < EC_FRAME_SAMPLES; i++) refEnergy += (int32_t)ref[i] * ref[i];
+        memcpy(_tail, ref, sizeof(_tail));
+        opus_fft_c(_fft, _buf, x);
+        _refEnergy[_frame % (EC_PARTITIONS + 1)] = refEnergy;
+        bool playing = false;
+        for (int p = 0; p <= EC_PARTITIONS; p++) playing |= _refEnergy[p] >= (uint64_t)EC_FRAME_SAMPLES * EC_REF_ENERGY_MIN;
+
+        // Echo estimate for both blocks: the filters are real, so they apply to
+        // the packed spectrum as it is
+        memset(_spec, 0, sizeof(_spec));
+        for (int p = 0; p < EC_PARTITIONS; p++) {
+            const kiss_fft_cpx* xp = _x[(_frame - p) % EC_PARTITIONS];
+            const Cpx* w = _w[p];
+            for (int k = 0; k <= EC_FFT_SIZE / 2; k++) {
+                macc(_spec[k], w[k].r, w[k].i, xp[k]);
+                if (k && k < EC_FFT_SIZE / 2) macc(_spec[EC_FFT_SIZE - k], w[k].r, -w[k].i, xp[EC_FFT_SIZE - k]);
+            }
+        }
+        opus_ifft_c(_fft, _spec, _buf);
+
+        // Error: the mic minus the estimate; the last block of each circular result is valid
+        int64_t micEnergy = 0, outEnergy = 0, echoEnergy = 0, crossEnergy = 0;
+        for (int i = 0; i < EC_FRAME_SAMPLES; i++) {
+            int32_t y = i < EC_BLOCK ? _buf[EC_FFT_SIZE - EC_BLOCK + i].r : _buf[EC_FFT_SIZE - 2 * EC_BLOCK + i].i;
+            y = (y + (1 << (EC_INPUT_SHIFT - 1))) >> EC_INPUT_SHIFT;
+            int32_t d = pcm[i];
+            int32_t e = d - y;
+            e = e > 32767 ? 32767 : e < -32768 ? -32768 : e;
+            micEnergy += (int64_t)d * d;
+            outEnergy += (int64_t)e * e;
+            echoEnergy += (int64_t)y * y;
+            crossEnergy += (int64_t)e * y;
+            pcm[i] = e;
+        }
+
+        // The filter has been making it worse than no filter for a while: start over
+        if (outEnergy > micEnergy + (int64_t)EC_FRAME_SAMPLES * EC_WORSE_MARGIN) {
+            if (++_worse >= EC_WORSE_FRAMES) {
+                clear();
+                _diverged++;
+                return;
+            }
+        } else {
+            _worse = 0;
+        }
+        if (!playing) return;
+        _micEnergy = micEnergy;
+        _outEnergy = outEnergy;
+
+        // Step size from the residual echo over the error (Valin, "On adjusting the
+        // learning rate in frequency domain echo cancellation with double-talk"):
+        // the leakage, how much of the echo estimate's energy is left in the error,
+        // is a regression that near-end speech does not correlate with, so the
+        // step falls as the near end talks, without a detector to miss them
+        float see = (float)outEnergy / EC_FRAME_SAMPLES + 1;
+        float syy = (float)echoEnergy / EC_FRAME_SAMPLES;
+        float sxx = (float)refEnergy / EC_FRAME_SAMPLES;
+        float dE = see - _meanE, dY = syy - _meanY;
+        _meanE += EC_LEAK_MEAN * dE;
+        _meanY += EC_LEAK_MEAN * dY;
+        float rate = EC_LEAK_RATE * syy / see;
+        if (rate > EC_LEAK_RATE_MAX) rate = EC_LEAK_RATE_MAX;
+        _pey += rate * (dE * dY - _pey);
+        _pyy += rate * (dY * dY - _pyy);
+        if (_pyy < 1) _pyy = 1;
+        if (_pey < EC_LEAK_MIN * _pyy) _pey = EC_LEAK_MIN * _pyy;
+        if (_pey > _pyy) _pey = _pyy;
+        float leak = _pey / _pyy;
+
+        float mu;
+        if (!_adapted) {
+            // Echo path not found yet: a fixed step, cut when the error is louder than the reference
+            mu = EC_MU_START * sxx < EC_MU_START * see ? EC_MU_START * sxx / see : EC_MU_START;
+            _sumAdapt += mu;
+            _adapted = _sumAdapt > EC_PARTITIONS && leak > EC_ADAPTED_LEAK;
+        } else {
+            // Residual echo over error, at least the error's correlation with the estimate
+            float sey = (float)crossEnergy / EC_FRAME_SAMPLES;
+            mu = (0.0001f * sxx + 3 * leak * syy) / see;
+            float correlated = sey * sey / (1 + see * syy);
+            if (mu < correlated) mu = correlated;
+            if (mu > EC_MU_MAX) mu = EC_MU_MAX;
+            if (mu < EC_DOUBLE_TALK_MU) _doubleTalk++;
+        }
+        adapt(pcm, x, (int32_t)(mu * 32768));
+    }
+
+    // Echo return loss enhancement of the last frame with a reference: mic over output energy
+    float erleDb() const { return _outEnergy ? 10 * log10f((float)_micEnergy / _outEnergy) : 0; }
+
+    uint32_t divergences() const { return _diverged; }
+    // Frames whose step was cut below EC_DOUBLE_TALK_MU, mostly by the near end talking
+    uint32_t doubleTalkFrames() const { return _doubleTalk; }
+
+private:
+    struct Cpx {
+        int32_t r, i;
+    };
+
+    const kiss_fft_state* _fft = nullptr;
+    int16_t _tail[EC_FRAME_SAMPLES];             // previous frame's reference
+    kiss_fft_cpx _x[EC_PARTITIONS][EC_FFT_SIZE]; // packed reference spectra, by frame
+    Cpx _w[EC_PARTITIONS][EC_BINS];              // filter, Q EC_W_SHIFT, half spectrum
+    uint32_t _power[EC_BINS];                    // smoothed reference power per bin
+    kiss_fft_cpx _buf[EC_FFT_SIZE];
+    kiss_fft_cpx _spec[EC_FFT_SIZE];
+    uint64_t _refEnergy[EC_PARTITIONS + 1];      // per frame, over the filter's span
+    uint32_t _frame = 0;
+    float _meanE = 0, _meanY = 0, _pey = 1, _pyy = 1;   // leakage regression, per-sample powers
+    float _sumAdapt = 0;
+    int _worse = 0;
+    bool _adapted = false;                       // the echo path has been found once
+    uint64_t _micEnergy = 0, _outEnergy = 0;
+    uint32_t _diverged = 0, _doubleTalk = 0;
+
+    // acc += w x, w in Q EC_W_SHIFT
+    static inline void macc(kiss_fft_cpx& acc, int32_t wr, int32_t wi, const kiss_fft_cpx& x) {
+        acc.r += (int32_t)(((int64_t)wr * x.r - (int64_t)wi * x.i) >> EC_W_SHIFT);
+        acc.i += (int32_t)(((int64_t)wr * x.i + (int64_t)wi * x.r) >> EC_W_SHIFT);
+    }
+
+    // The two real signals packed in bins k and N-k of z
+    static inline void split(const kiss_fft_cpx* z, int k, Cpx& a, Cpx& b) {
+        if (k == 0 || k == EC_FFT_SIZE / 2) {
+            a = {z[k].r, 0};
+            b = {z[k].i, 0};
+            return;
+        }
+        const kiss_fft_cpx& zk = z[k];
+        const kiss_fft_cpx& zn = z[EC_FFT_SIZE - k];
+        a = {(zk.r + zn.r) >> 1, (zk.i - zn.i) >> 1};
+        b = {(zk.i + zn.i) >> 1, (zn.r - zk.r) >> 1};
+    }
+
+    // Packs two half spectra of real signals into one full one
+    static inline void pack(kiss_fft_cpx* z, int k, const Cpx& a, const Cpx& b) {
+        z[k].r = a.r - b.i;
+        z[k].i = a.i + b.r;
+        if (k == 0 || k == EC_FFT_SIZE / 2) return;
+        z[EC_FFT_SIZE - k].r = a.r + b.i;
+        z[EC_FFT_SIZE - k].i = b.r - a.i;
+    }
+
+    void adapt(const int16_t* e, const kiss_fft_cpx* x, int32_t muQ15) {
+        // Error spectra of both blocks, each the last block of a zeroed window
+        for (int i = 0; i < EC_FFT_SIZE - EC_BLOCK; i++) _buf[i].r = _buf[i].i = 0;
+        for (int i = 0; i < EC_BLOCK; i++) {
+            _buf[EC_FFT_SIZE - EC_BLOCK + i].r = (int32_t)e[i] << EC_INPUT_SHIFT;
+            _buf[EC_FFT_SIZE - EC_BLOCK + i].i = (int32_t)e[EC_BLOCK + i] << EC_INPUT_SHIFT;
+        }
+        opus_fft_c(_fft, _buf, _spec);
+
+        for (int k = 0; k <= EC_FFT_SIZE / 2; k++) {
+            Cpx x1, x2, e1, e2;
+            split(x, k, x1, x2);
+            split(_spec, k, e1, e2);
+            uint32_t p = (uint32_t)(((int64_t)x1.r * x1.r + (int64_t)x1.i * x1.i +
+                                     (int64_t)x2.r * x2.r + (int64_t)x2.i * x2.i) >> (EC_POWER_SHIFT + 1));
+            uint32_t& s = _power[k];
+            s = p > s ? s + ((p - s) >> EC_POWER_SMOOTH_SHIFT) : s - ((s - p) >> EC_POWER_SMOOTH_SHIFT);
+            // mu e / power, Q30
+            int64_t inv = (int64_t)muQ15 * (int64_t)((1u << 31) / (s + EC_DELTA));
+            Cpx n1 = {(int32_t)((e1.r * inv) >> 32), (int32_t)((e1.i * inv) >> 32)};
+            Cpx n2 = {(int32_t)((e2.r * inv) >> 32), (int32_t)((e2.i * inv) >> 32)};
+            for (int p = 0; p < EC_PARTITIONS; p++) {
+                Cpx a, b;
+                split(_x[(_frame - p) % EC_PARTITIONS], k, a, b);
+                // conj(X) En, both blocks
+                int64_t gr = (int64_t)a.r * n1.r + (int64_t)a.i * n1.i + (int64_t)b.r * n2.r + (int64_t)b.i * n2.i;
+                int64_t gi = (int64_t)a.r * n1.i - (int64_t)a.i * n1.r + (int64_t)b.r * n2.i - (int64_t)b.i * n2.r;
+                _w[p][k].r += (int32_t)(gr >> (30 - EC_W_SHIFT));
+                _w[p][k].i += (int32_t)(gi >> (30 - EC_W_SHIFT));
+            }
+        }
+
+        // Constraint, two partitions per transform pair: back to taps, zero the
+        // circular tail, forward again
+        for (int p = 0; p < EC_PARTITIONS; p += 2) {
+            Cpx* w0 = _w[p];
+            Cpx* w1 = p + 1 < EC_PARTITIONS ? _w[p + 1] : nullptr;
+            for (int k = 0; k <= EC_FFT_SIZE / 2; k++) {
+                Cpx a = {w0[k].r >> EC_CONSTRAINT_SHIFT, w0[k].i >> EC_CONSTRAINT_SHIFT};
+                Cpx b = {0, 0};
+                if (w1) b = {w1[k].r >> EC_CONSTRAINT_SHIFT, w1[k].i >> EC_CONSTRAINT_SHIFT};
+                pack(_spec, k, a, b);
+            }
+            opus_ifft_c(_fft, _spec, _buf);
+            for (int i = EC_PARTITION_TAPS; i < EC_FFT_SIZE; i++) _buf[i].r = _buf[i].i = 0;
+            opus_fft_c(_fft, _buf, _spec);
+            for (int k = 0; k <= EC_FFT_SIZE / 2; k++) {
+                Cpx a, b;
+                split(_spec, k, a, b);
+                w0[k] = {a.r << EC_CONSTRAINT_SHIFT, a.i << EC_CONSTRAINT_SHIFT};
+                if (w1) w1[k] = {b.r << EC_CONSTRAINT_SHIFT, b.i << EC_CONSTRAINT_SHIFT};
+            }
+        }
+    }
+};
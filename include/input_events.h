@@ -0,0 +1,254 @@
+#pragma once
+
+// Buttons and PTT on GPIO interrupts, with debounce, long, repeat and double press.
+//
+// The ISR takes the first edge after a quiet period at once, so a press is seen
+// within microseconds of the contact closing, and ignores the bounces that
+// follow for INPUT_DEBOUNCE_US. An input task re-reads the pin when that window
+// closes, which catches a release that happened inside it (and filters the
+// phantom interrupts GPIO36/39 get while Wi-Fi is active), and times long
+// presses, repeats and double presses. Derived events go to a queue that loop()
+// drains whenever it gets to it; an input with a notify task (PTT) also wakes
+// that task straight from the ISR, so transmit never waits for loop().
+//
+// Inputs are active low. Timestamps are esp_timer microseconds (32-bit).
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "soc/gpio_reg.h"
+#include "metrics.h"
+#include "task_layout.h"
+
+#define INPUT_MAX 6
+#define INPUT_DEBOUNCE_US 20000
+#define INPUT_LONG_PRESS_US 700000
+#define INPUT_REPEAT_US 150000         // after a long press, while still held
+#define INPUT_DOUBLE_PRESS_US 350000   // release to next press
+#define INPUT_QUEUE_DEPTH 16
+
+// Bits in the notification value of an input's notify task
+#define INPUT_NOTIFY_PRESS 0x1
+#define INPUT_NOTIFY_RELEASE 0x2
+
+// Per-input options
+#define INPUT_LONG 0x1                 // LongPress after INPUT_LONG_PRESS_US held
+#define INPUT_REPEAT 0x2               // then Repeat every INPUT_REPEAT_US
+#define INPUT_CLICKS 0x4               // Click / DoublePress, Click once the double window has passed
+
+enum class InputEventType : uint8_t { Press, Release, LongPress, Repeat, Click, DoublePress };
+
+struct InputEvent {
+    uint8_t input;                     // index returned by add()
+    InputEventType type;
+    uint32_t atUs;                     // edge time, or when the timed event fired
+};
+
+class InputEvents {
+public:
+    explicit InputEvents(CounterMetric* bounces) : _bounces(bounces) {}
+
+    // Registers an active-low pin before begin(); returns its input index, -1 when full
+    int add(uint8_t pin, uint8_t options, TaskHandle_t notify = nullptr) {
+        if (_count == INPUT_MAX) return -1;
+        Input& in = _inputs[_count];
+        in.pin = pin;
+        in.options = options;
+        in.notify = notify;
+        in.owner = this;
+        in.index = _count;
+        return _count++;
+    }
+
+    // The task woken on press and release; may be set after begin()
+    void setNotify(int input, TaskHandle_t task) { _inputs[input].notify = task; }
+
+    bool begin() {
+        _raw = xQueueCreate(INPUT_QUEUE_DEPTH, sizeof(InputEvent));
+        _events = xQueueCreate(INPUT_QUEUE_DEPTH, sizeof(InputEvent));
+        if (!_raw || !_events) return false;
+        for (int i = 0; i < _count; i++) {
+            Input& in = _inputs[i];
+            pinMode(in.pin, INPUT_PULLUP);   // GPIO34..39 have no pull-up: those need an external one
+            in.down = isLow(in.pin);
+        }
+        if (xTaskCreatePinnedToCore(inputTask, "inputTask", TASK_INPUT_STACK, this, TASK_INPUT_PRIORITY, nullptr,
+                                    TASK_INPUT_CORE) != pdPASS) return false;
+        for (int i = 0; i < _count; i++) attachInterruptArg(_inputs[i].pin, isr, &_inputs[i], CHANGE);
+        return true;
+    }
+
+    // loop(): next derived event, never blocks
+    bool next(InputEvent& e) { return _events && xQueueReceive(_events, &e, 0) == pdTRUE; }
+
+    // Events waiting for loop(), safe from any task
+    size_t pending() const { return _events ? uxQueueMessagesWaiting(_events) : 0; }
+
+    // Debounced state and the time it last changed, safe from any task
+    bool pressed(int input) const { return _inputs[input].down; }
+    uint32_t changedAtUs(int input) const { return _inputs[input].edgeUs; }
+
+private:
+    struct Input {
+        uint8_t pin = 0;
+        uint8_t options = 0;
+        uint8_t index = 0;
+        TaskHandle_t notify = nullptr;
+        InputEvents* owner = nullptr;
+        // Shared with the ISR, under _mux
+        volatile bool down = false;
+        volatile bool settling = false;  // an edge was taken, later ones are bounce until the task looks
+        volatile uint32_t edgeUs = 0;
+        volatile uint32_t bounces = 0;
+        // Input task only
+        uint32_t pressUs = 0;
+        uint32_t releaseUs = 0;
+        uint32_t nextRepeatUs = 0;
+        bool longSent = false;
+        bool clickPending = false;
+    };
+
+    Input _inputs[INPUT_MAX];
+    int _count = 0;
+    QueueHandle_t _raw = nullptr;      // accepted edges, ISR -> input task
+    QueueHandle_t _events = nullptr;   // derived events, input task -> loop()
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    CounterMetric* _bounces;
+
+    // Straight from the GPIO input registers, so it is safe in an IRAM ISR
+    static inline bool IRAM_ATTR isLow(uint8_t pin) {
+        uint32_t bits = pin < 32 ? REG_READ(GPIO_IN_REG) >> pin : REG_READ(GPIO_IN1_REG) >> (pin - 32);
+        return (bits & 1) == 0;
+    }
+
+    static uint32_t sooner(uint32_t a, uint32_t b) { return a < b ? a : b; }
+
+    static void IRAM_ATTR isr(void* arg) {
+        Input* in = (Input*)arg;
+        InputEvents* self = in->owner;
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        bool down = isLow(in->pin);
+        bool accepted = false;
+        portENTER_CRITICAL_ISR(&self->_mux);
+        if (in->settling) {
+            in->bounces++;
+        } else if (down != in->down) {
+            in->down = down;
+            in->settling = true;
+            in->edgeUs = now;
+            accepted = true;
+        }
+        portEXIT_CRITICAL_ISR(&self->_mux);
+        if (!accepted) return;
+        BaseType_t woken = pdFALSE;
+        if (in->notify) {
+            xTaskNotifyFromISR(in->notify, down ? INPUT_NOTIFY_PRESS : INPUT_NOTIFY_RELEASE, eSetBits, &woken);
+        }
+        InputEvent e = {in->index, down ? InputEventType::Press : InputEventType::Release, now};
+        xQueueSendFromISR(self->_raw, &e, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+
+    void emit(uint8_t input, InputEventType type, uint32_t atUs) {
+        InputEvent e = {input, type, atUs};
+        xQueueSend(_events, &e, 0);   // loop() stalled long enough to fill it: drop
+    }
+
+    // An accepted edge, from the ISR or found when a debounce window closed
+    void edge(Input& in, bool down, uint32_t atUs) {
+        if (down) {
+            bool second = in.clickPending && atUs - in.releaseUs < INPUT_DOUBLE_PRESS_US;
+            if (in.clickPending && !second) emit(in.index, InputEventType::Click, atUs);   // overdue
+            in.pressUs = atUs;
+            in.longSent = false;
+            in.clickPending = false;
+            emit(in.index, InputEventType::Press, atUs);
+            if (second) emit(in.index, InputEventType::DoublePress, atUs);
+            else if (in.options & INPUT_CLICKS) in.clickPending = true;   // confirmed on release
+        } else {
+            in.releaseUs = atUs;
+            if (in.longSent) in.clickPending = false;   // a long press is not a click
+            emit(in.index, InputEventType::Release, atUs);
+        }
+    }
+
+    // Closes debounce windows and fires timed events; returns ticks until the next deadline
+    TickType_t service(uint32_t now) {
+        uint32_t wait = 1000000;
+        for (int i = 0; i < _count; i++) {
+            Input& in = _inputs[i];
+            uint32_t settled = now - in.edgeUs;
+            if (in.settling) {
+                if (settled < INPUT_DEBOUNCE_US) {
+                    wait = sooner(wait, INPUT_DEBOUNCE_US - settled);
+                } else {
+                    bool level = isLow(in.pin);
+                    bool changed = false;
+                    portENTER_CRITICAL(&_mux);
+                    in.settling = level != in.down;   // changed inside the window: take it and settle again
+                    if (in.settling) {
+                        in.down = level;
+                        in.edgeUs = now;
+                        changed = true;
+                    }
+                    portEXIT_CRITICAL(&_mux);
+                    if (changed) {
+                        if (in.notify) xTaskNotify(in.notify, level ? INPUT_NOTIFY_PRESS : INPUT_NOTIFY_RELEASE, eSetBits);
+                        edge(in, level, now);
+                        wait = sooner(wait, INPUT_DEBOUNCE_US);
+                    }
+                }
+            }
+            if (in.bounces) {
+                portENTER_CRITICAL(&_mux);
+                uint32_t bounces = in.bounces;
+                in.bounces = 0;
+                portEXIT_CRITICAL(&_mux);
+                _bounces->inc(bounces);
+            }
+            if (in.down && (in.options & INPUT_LONG)) {
+                uint32_t held = now - in.pressUs;
+                if (!in.longSent) {
+                    if (held >= INPUT_LONG_PRESS_US) {
+                        in.longSent = true;
+                        in.nextRepeatUs = now + INPUT_REPEAT_US;
+                        emit(in.index, InputEventType::LongPress, now);
+                    } else {
+                        wait = sooner(wait, INPUT_LONG_PRESS_US - held);
+                    }
+                }
+                if (in.longSent && (in.options & INPUT_REPEAT)) {
+                    if ((int32_t)(now - in.nextRepeatUs) >= 0) {
+                        in.nextRepeatUs += INPUT_REPEAT_US;
+                        emit(in.index, InputEventType::Repeat, now);
+                    }
+                    wait = sooner(wait, in.nextRepeatUs - now);
+                }
+            }
+            if (in.clickPending && !in.down) {
+                uint32_t since = now - in.releaseUs;
+                if (since >= INPUT_DOUBLE_PRESS_US) {
+                    in.clickPending = false;
+                    emit(in.index, InputEventType::Click, now);
+                } else {
+                    wait = sooner(wait, INPUT_DOUBLE_PRESS_US - since);
+                }
+            }
+        }
+        return pdMS_TO_TICKS(wait / 1000) + 1;
+    }
+
+    static void inputTask(void* arg) {
+        InputEvents* self = (InputEvents*)arg;
+        TickType_t wait = portMAX_DELAY;
+        for (;;) {
+            InputEvent e;
+            if (xQueueReceive(self->_raw, &e, wait) == pdTRUE) {
+                self->edge(self->_inputs[e.input], e.type == InputEventType::Press, e.atUs);
+            }
+            wait = self->service((uint32_t)esp_timer_get_time());
+        }
+    }
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Minimal JSON writer into a caller-provided fixed buffer.
+// No heap allocation; on overflow the output is truncated and overflowed() is set.
+class JsonBuffer {
+public:
+    JsonBuffer(char* buf, size_t cap) : _buf(buf), _cap(cap), _len(0), _depth(0), _first(1), _overflow(false) {
+        if (_cap) _buf[0] = 0;
+    }
+
+    void beginObject(const char* key = nullptr) { open(key, '{'); }
+    void endObject() { close('}'); }
+    void beginArray(const char* key = nullptr) { open(key, '['); }
+    void endArray() { close(']'); }
+
+    void add(const char* key, const char* value) {
+        prefix(key);
+        str(value);
+    }
+
+    void add(const char* key, bool value) {
+        prefix(key);
+        raw(value ? "true" : "false");
+    }
+
+    void add(const char* key, long value) {
+        prefix(key);
+        appendf("%ld", value);
+    }
+
+    void add(const char* key, unsigned long value) {
+        prefix(key);
+        appendf("%lu", value);
+    }
+
+    void add(const char* key, unsigned long long value) {
+        prefix(key);
+        appendf("%llu", value);
+    }
+
+    void add(const char* key, int value) { add(key, (long)value); }
+    void add(const char* key, unsigned value) { add(key, (unsigned long)value); }
+
+    void add(const char* key, float value, int decimals) {
+        prefix(key);
+        appendf("%.*f", decimals, (double)value);
+    }
+
+    const char* c_str() const { return _buf; }
+    size_t length() const { return _len; }
+    bool overflowed() const { return _overflow; }
+
+private:
+    char* _buf;
+    size_t _cap;
+    size_t _len;
+    uint8_t _depth;
+    uint32_t _first;     // bit n set = nothing written yet at nesting depth n
+    bool _overflow;
+
+    void raw(const char* s) {
+        while (*s) put(*s++);
+    }
+
+    void put(char c) {
+        if (_len + 1 >= _cap) {
+            _overflow = true;
+            return;
+        }
+        _buf[_len++] = c;
+        _buf[_len] = 0;
+    }
+
+    void appendf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        if (_len + 1 >= _cap) {
+            _overflow = true;
+            return;
+        }
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(_buf + _len, _cap - _len, fmt, args);
+        va_end(args);
+        if (n < 0) return;
+        if ((size_t)n >= _cap - _len) {
+            _overflow = true;
+            _len = _cap - 1;
+        } else {
+            _len += n;
+        }
+    }
+
+    void str(const char* s) {
+        put('"');
+        for (; s && *s; s++) {
+            char c = *s;
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(c);
+            } else if ((uint8_t)c < 0x20) {
+                appendf("\\u%04x", (unsigned)(uint8_t)c);
+            } else {
+                put(c);   // UTF-8 passes through untouched
+            }
+        }
+        put('"');
+    }
+
+    void prefix(const char* key) {
+        if (_first & (1u << _depth)) {
+            _first &= ~(1u << _depth);
+        } else {
+            put(',');
+        }
+        if (key) {
+            str(key);
+            put(':');
+        }
+    }
+
+    void open(const char* key, char bracket) {
+        if (_len > 0) prefix(key);
+        put(bracket);
+        if (_depth < 31) _depth++;
+        _first |= (1u << _depth);
+    }
+
+    void close(char bracket) {
+        if (_depth > 0) _depth--;
+        put(bracket);
+    }
+};
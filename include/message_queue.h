@@ -0,0 +1,193 @@
+#pragma once
+
+// Store-and-forward queue for streams that arrive while the floor is taken.
+//
+// With overlap_policy=queue, a stream that starts while an equal or higher
+// priority is playing, or a lower-priority one that gets talked over, is kept
+// here as Opus packets instead of being mixed. Once the floor is free the
+// messages play one at a time, highest priority first, then in the order their
+// talkers started.
+//
+// Packets of all waiting messages share one PSRAM byte ring as
+// [u16 length][u16 message tag][u16 duration ms][bytes], in arrival order. Each
+// message remembers where its next unread packet is; reading skips the other
+// messages' records, and space is freed once every message has read past it.
+//
+// Not thread-safe: the RX path and playback both run in loop().
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+// Host builds (tools/decoder_pool_check.cpp) provide millis()
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+uint32_t millis();
+#endif
+#include <opus.h>
+
+#ifndef QUEUE_BYTES
+#define QUEUE_BYTES (256 * 1024)     // ~2 min of Zello audio at 16 kbit/s
+#endif
+#define QUEUE_MAX_MESSAGES 16
+#define QUEUE_RECORD_HEADER 6
+
+struct QueuedMessage {
+    uint32_t key;                // Zello stream id
+    uint32_t next;               // absolute position of the next record to look at
+    uint32_t startMs;            // when the talker started; sets the play order
+    uint32_t queuedMs;           // when it entered the queue, for the wait time
+    uint32_t lastPacketMs;
+    uint32_t unreadMs;           // audio stored and not played yet
+    uint16_t unread;             // packets stored and not played yet
+    uint16_t tag;                // marks this message's records in the ring
+    uint8_t priority;
+    bool used;                   // table entry in use
+    bool complete;               // stop seen: nothing more will arrive
+    char talker[64];
+};
+
+class MessageQueue {
+public:
+    // PSRAM only: without it the queue stays disabled and callers drop instead
+    bool begin() {
+#ifdef ARDUINO
+        _buf = psramFound() ? (uint8_t*)ps_malloc(QUEUE_BYTES) : nullptr;
+#else
+        _buf = (uint8_t*)malloc(QUEUE_BYTES);
+#endif
+        return _buf != nullptr;
+    }
+
+    bool enabled() const { return _buf != nullptr; }
+
+    QueuedMessage* find(uint32_t key) {
+        for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+            if (_messages[i].used && _messages[i].key == key) return &_messages[i];
+        }
+        return nullptr;
+    }
+
+    // Starts storing a stream; nullptr when disabled or the table is full
+    QueuedMessage* hold(uint32_t key, uint8_t priority, const char* talker, uint32_t startMs) {
+        if (!_buf || find(key)) return nullptr;
+        for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+            QueuedMessage& m = _messages[i];
+            if (m.used) continue;
+            m = QueuedMessage();
+            m.used = true;
+            m.key = key;
+            m.priority = priority;
+            m.tag = _nextTag++;
+            m.next = _writePos;
+            m.startMs = startMs;
+            m.queuedMs = m.lastPacketMs = millis();
+            snprintf(m.talker, sizeof(m.talker), "%s", talker ? talker : "");
+            return &m;
+        }
+        return nullptr;
+    }
+
+    // Appends a packet to its message; false when the ring is full
+    bool packet(QueuedMessage* m, const uint8_t* data, size_t len) {
+        m->lastPacketMs = millis();
+        if (len > 0xFFFF || _writePos + QUEUE_RECORD_HEADER + len - tail() > QUEUE_BYTES) return false;
+        int samples = opus_packet_get_nb_samples(data, len, 16000);
+        uint16_t ms = samples > 0 ? samples / 16 : 0;
+        uint8_t header[QUEUE_RECORD_HEADER] = {(uint8_t)len, (uint8_t)(len >> 8), (uint8_t)m->tag,
+                                               (uint8_t)(m->tag >> 8), (uint8_t)ms, (uint8_t)(ms >> 8)};
+        write(header, sizeof(header));
+        write(data, len);
+        m->unread++;
+        m->unreadMs += ms;
+        return true;
+    }
+
+    // The message to play next: highest priority, then the earliest talker
+    QueuedMessage* front() {
+        QueuedMessage* first = nullptr;
+        for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+            QueuedMessage& m = _messages[i];
+            if (!m.used) continue;
+            if (!first || m.priority > first->priority ||
+                (m.priority == first->priority && (int32_t)(m.startMs - first->startMs) < 0)) {
+                first = &m;
+            }
+        }
+        return first;
+    }
+
+    // Copies the message's next packet into out; 0 when nothing is stored yet
+    size_t read(QueuedMessage* m, uint8_t* out, size_t cap) {
+        while (m->unread && m->next != _writePos) {
+            uint8_t header[QUEUE_RECORD_HEADER];
+            copyOut(m->next, header, sizeof(header));
+            size_t len = header[0] | (header[1] << 8);
+            uint16_t tag = header[2] | (header[3] << 8);
+            uint16_t ms = header[4] | (header[5] << 8);
+            uint32_t pos = m->next + QUEUE_RECORD_HEADER;
+            m->next = pos + len;
+            if (tag != m->tag) continue;   // another message's packet
+            m->unread--;
+            m->unreadMs -= ms;
+            if (len > cap) continue;
+            copyOut(pos, out, len);
+            return len;
+        }
+        m->next = _writePos;   // all read: stop pinning other messages' records
+        return 0;
+    }
+
+    void remove(QueuedMessage* m) { m->used = false; }
+
+    // Table entry i, nullptr when unused
+    const QueuedMessage* message(int i) const { return _messages[i].used ? &_messages[i] : nullptr; }
+
+    // Some message of at least this priority is waiting its turn
+    bool waiting(uint8_t priority) const {
+        for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+            if (_messages[i].used && _messages[i].priority >= priority) return true;
+        }
+        return false;
+    }
+
+    uint8_t count() const {
+        uint8_t n = 0;
+        for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) n += _messages[i].used;
+        return n;
+    }
+
+    size_t bytes() const { return _writePos - tail(); }
+
+private:
+    uint8_t* _buf = nullptr;
+    uint32_t _writePos = 0;              // total bytes ever written
+    QueuedMessage _messages[QUEUE_MAX_MESSAGES];
+    uint16_t _nextTag = 0;
+
+    // Oldest byte some message still needs
+    uint32_t tail() const {
+        uint32_t t = _writePos;
+        for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+            const QueuedMessage& m = _messages[i];
+            if (m.used && (int32_t)(m.next - t) < 0) t = m.next;
+        }
+        return t;
+    }
+
+    void write(const uint8_t* data, size_t len) {
+        size_t off = _writePos % QUEUE_BYTES;
+        size_t first = len < QUEUE_BYTES - off ? len : QUEUE_BYTES - off;
+        memcpy(_buf + off, data, first);
+        memcpy(_buf, data + first, len - first);
+        _writePos += len;
+    }
+
+    void copyOut(uint32_t pos, uint8_t* out, size_t len) const {
+        size_t off = pos % QUEUE_BYTES;
+        size_t first = len < QUEUE_BYTES - off ? len : QUEUE_BYTES - off;
+        memcpy(out, _buf + off, first);
+        memcpy(out + first, _buf, len - first);
+    }
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Lock-free metrics: counters, gauges and log2-bucket histograms.
+//
+// Updates are relaxed 32-bit atomics (S32C1I on the ESP32), so they are safe to
+// call from any task on either core and from ISRs. Counter and gauge updates are
+// one atomic each; a histogram observation is three (bucket, count, sum), so a
+// reader may see them briefly out of step (see HistogramMetric). Metrics register
+// themselves in a fixed table at static-init time; export walks that table.
+
+class Metric {
+public:
+    enum Type : uint8_t { Counter, Gauge, Histogram };
+
+    const char* name;
+    const char* help;
+    Type type;
+    Metric* next;
+
+    Metric(const char* name, const char* help, Type type);
+};
+
+// Intrusive list of all metrics, built during static initialization only
+struct MetricRegistry {
+    static Metric*& head() {
+        static Metric* first = nullptr;
+        return first;
+    }
+};
+
+inline Metric::Metric(const char* name, const char* help, Type type)
+    : name(name), help(help), type(type), next(nullptr) {
+    // Append so export order matches declaration order
+    Metric** tail = &MetricRegistry::head();
+    while (*tail) tail = &(*tail)->next;
+    *tail = this;
+}
+
+class CounterMetric : public Metric {
+public:
+    CounterMetric(const char* name, const char* help) : Metric(name, help, Counter), _value(0) {}
+
+    void inc(uint32_t n = 1) { _value.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> _value;
+};
+
+class GaugeMetric : public Metric {
+public:
+    GaugeMetric(const char* name, const char* help) : Metric(name, help, Gauge), _value(0) {}
+
+    void set(int32_t v) { _value.store(v, std::memory_order_relaxed); }
+    void add(int32_t d) { _value.fetch_add(d, std::memory_order_relaxed); }
+
+    // Low-water mark: only ever moves down (0 = not yet set)
+    void setMin(int32_t v) {
+        int32_t cur = _value.load(std::memory_order_relaxed);
+        while ((cur == 0 || v < cur) &&
+               !_value.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+        }
+    }
+
+    int32_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int32_t> _value;
+};
+
+// Bucket i counts observations v with 2^(i-1) <= v < 2^i (bucket 0 holds v == 0);
+// the last bucket also takes everything larger.
+//
+// observe() updates the bucket, _count and _sum with separate atomics, not as one
+// transaction: a scrape or quantile() running alongside it may see the bucket
+// totals, the count and the sum disagree by the observations in flight. Each
+// value is still exact on its own, and they agree again once observe() returns.
+class HistogramMetric : public Metric {
+public:
+    static const int BUCKETS = 24;   // up to ~8.4 s when observing microseconds
+
+    HistogramMetric(const char* name, const char* help) : Metric(name, help, Histogram), _count(0), _sum(0) {
+        for (int i = 0; i < BUCKETS; i++) _buckets[i].store(0, std::memory_order_relaxed);
+    }
+
+    void observe(uint32_t v) {
+        int b = v ? 32 - __builtin_clz(v) : 0;
+        if (b >= BUCKETS) b = BUCKETS - 1;
+        _buckets[b].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(v, std::memory_order_relaxed);   // 32-bit: wraps, rate() it like a counter
+    }
+
+    // Exclusive upper bound of bucket i
+    static uint32_t bucketBound(int i) { return i >= 31 ? UINT32_MAX : (1u << i); }
+
+    uint32_t bucket(int i) const { return _buckets[i].load(std::memory_order_relaxed); }
+    uint32_t count() const { return _count.load(std::memory_order_relaxed); }
+    uint32_t sum() const { return _sum.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding quantile q (0..1); 0 when empty
+    uint32_t quantile(float q) const {
+        uint32_t total = count();
+        if (total == 0) return 0;
+        uint32_t target = (uint32_t)(total * q);
+        uint32_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += bucket(i);
+            if (seen > target) return bucketBound(i);
+        }
+        return bucketBound(BUCKETS - 1);
+    }
+
+private:
+    std::atomic<uint32_t> _buckets[BUCKETS];
+    std::atomic<uint32_t> _count;
+    std::atomic<uint32_t> _sum;
+};
+
+// Prometheus text exposition format (version 0.0.4). Out needs printf().
+template <typename Out>
+void writePrometheusMetrics(Out& out) {
+    for (Metric* m = MetricRegistry::head(); m; m = m->next) {
+        out.printf("# HELP %s %s\n", m->name, m->help);
+        switch (m->type) {
+            case Metric::Counter:
+                out.printf("# TYPE %s counter\n%s %u\n", m->name, m->name,
+                           (unsigned)static_cast<CounterMetric*>(m)->value());
+                break;
+            case Metric::Gauge:
+                out.printf("# TYPE %s gauge\n%s %d\n", m->name, m->name,
+                           (int)static_cast<GaugeMetric*>(m)->value());
+                break;
+            case Metric::Histogram: {
+                HistogramMetric* h = static_cast<HistogramMetric*>(m);
+                out.printf("# TYPE %s histogram\n", m->name);
+                uint32_t cumulative = 0;
+                // Buckets are integer ranges, so "le" is the inclusive bound 2^i - 1
+                for (int i = 0; i < HistogramMetric::BUCKETS - 1; i++) {
+                    cumulative += h->bucket(i);
+                    out.printf("%s_bucket{le=\"%u\"} %u\n", m->name,
+                               (unsigned)(HistogramMetric::bucketBound(i) - 1), (unsigned)cumulative);
+                }
+                out.printf("%s_bucket{le=\"+Inf\"} %u\n", m->name, (unsigned)h->count());
+                out.printf("%s_sum %u\n%s_count %u\n", m->name, (unsigned)h->sum(), m->name, (unsigned)h->count());
+                break;
+            }
+        }
+    }
+}
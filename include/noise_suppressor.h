@@ -0,0 +1,190 @@
+#pragma once
+
+// Spectral noise suppression for the transmit path, in fixed point.
+//
+// A short-time Fourier transform with the FFT Opus already carries
+// (lib/OPUS/celt/kiss_fft.c): 480-point sqrt-Hann frames every 160 samples
+// (10 ms), overlap-added back with the matching synthesis window. The two hops
+// of a 20 ms frame are real signals, so they share one complex FFT as its real
+// and imaginary parts and are separated again bin by bin.
+//
+// Per bin and hop:
+//   noise floor   the power averaged over ~160 ms of hops where the bin is
+//                 within 6 dB of the floor, i.e. has no speech in it. Above that
+//                 it only creeps up, ~1.7 dB/s, so a noise that got louder is
+//                 still followed while speech cannot lift it far
+//   gain          Wiener, from a decision-directed a priori SNR (Ephraim-Malah),
+//                 which is what keeps the residual noise from warbling; floored
+//                 at NS_MIN_GAIN_Q15 so the noise is turned down, not gated
+//
+// Adds NS_LATENCY_SAMPLES (20 ms) of delay. Opus custom modes are not built,
+// so the FFT state is the static 480-point one of the 48 kHz mode: that fixes
+// the frame length at 30 ms.
+//
+// Not thread-safe: process() belongs to the capture task.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+extern "C" {
+#include "config.h"
+#include "opus_custom.h"
+#include "celt/modes.h"
+}
+
+#define NS_FFT_SIZE 480
+#define NS_HOP 160
+#define NS_FRAME_SAMPLES 320           // two hops, 20 ms at 16 kHz
+#define NS_BINS (NS_FFT_SIZE / 2 + 1)
+#define NS_LATENCY_SAMPLES 320
+#define NS_INPUT_SHIFT 8               // headroom bits the samples gain before the FFT
+#define NS_POWER_SHIFT 14              // bin power scaled down to fit 32 bits
+#define NS_MIN_GAIN_Q15 5827           // -15 dB
+#define NS_PRESENCE_SHIFT 2            // a bin 4x (6 dB) over the floor has speech
+#define NS_NOISE_AVG_SHIFT 4           // noise floor averaging, 1/16 per hop
+#define NS_NOISE_RISE_SHIFT 8          // noise floor creep per hop while speech is present, 1/256
+#define NS_NOISE_BIAS_Q8 512           // subtract 2x the floor (3 dB over)
+#define NS_DD_ALPHA_Q15 32113          // 0.98
+#define NS_MAX_SNR_Q8 (1000 << 8)
+
+class NoiseSuppressor {
+public:
+    // Builds the windows and finds the FFT; false when Opus has no 480-point state
+    bool begin() {
+        int err;
+        const OpusCustomMode* mode = opus_custom_mode_create(48000, 960, &err);
+        _fft = mode ? mode->mdct.kfft[0] : nullptr;
+        if (!_fft || _fft->nfft != NS_FFT_SIZE) {
+            _fft = nullptr;
+            return false;
+        }
+        for (int i = 0; i < NS_FFT_SIZE; i++) {
+            double w = sqrt(0.5 - 0.5 * cos(2 * M_PI * i / NS_FFT_SIZE));
+            _window[i] = (int16_t)(w * 32767 + 0.5);
+            // sqrt-Hann twice is Hann, which sums to 1.5 at a third-frame hop
+            _synthesis[i] = (int16_t)(w * 32767 * 2 / 3 + 0.5);
+        }
+        memset(_noise, 0, sizeof(_noise));
+        _floorSet = false;
+        reset();
+        return true;
+    }
+
+    // Start of a transmission: drops the signal history, keeps the noise estimate
+    void reset() {
+        memset(_tail, 0, sizeof(_tail));
+        memset(_overlap, 0, sizeof(_overlap));
+        memset(_prevSnr, 0, sizeof(_prevSnr));
+        _primed = 0;
+    }
+
+    // pcm[NS_FRAME_SAMPLES] in place; the output lags the input by NS_LATENCY_SAMPLES
+    void process(int16_t* pcm) {
+        if (!_fft) return;
+        // Hop A ends a hop into this frame, hop B at its end
+        const int16_t* a = _tail;
+        for (int i = 0; i < NS_FFT_SIZE; i++) {
+            int32_t xa = i < NS_FFT_SIZE - NS_HOP ? a[i] : pcm[i - (NS_FFT_SIZE - NS_HOP)];
+            int32_t xb = i < NS_HOP ? a[i + NS_HOP] : pcm[i - NS_HOP];
+            _buf[i].r = (xa * _window[i]) >> (15 - NS_INPUT_SHIFT);
+            _buf[i].i = (xb * _window[i]) >> (15 - NS_INPUT_SHIFT);
+        }
+        memcpy(_tail, pcm, sizeof(_tail));
+        opus_fft_c(_fft, _buf, _spec);
+
+        // Hops that still overlap the zeros reset() left would drag the floor down
+        bool learn = _primed >= 2;
+        if (_primed < 2) _primed++;
+
+        for (int k = 0; k <= NS_FFT_SIZE / 2; k++) {
+            int n = k ? NS_FFT_SIZE - k : 0;
+            kiss_fft_cpx& zk = _spec[k];
+            kiss_fft_cpx& zn = _spec[n];
+            if (k == 0 || k == n) {
+                // Real bins: hop A is the real part, hop B the imaginary
+                int32_t gA = gain(k, power(zk.r, 0), learn, 0);
+                int32_t gB = gain(k, power(zk.i, 0), learn, 1);
+                zk.r = mulQ15(zk.r, gA);
+                zk.i = mulQ15(zk.i, gB);
+                continue;
+            }
+            // XA = (Zk + conj Zn) / 2, XB = (Zk - conj Zn) / 2j
+            int32_t ar = (zk.r + zn.r) >> 1, ai = (zk.i - zn.i) >> 1;
+            int32_t br = (zk.i + zn.i) >> 1, bi = (zn.r - zk.r) >> 1;
+            int32_t gA = gain(k, power(ar, ai), learn, 0);
+            int32_t gB = gain(k, power(br, bi), learn, 1);
+            // Y[k] = gA XA + j gB XB, rebuilt from Zk and Zn
+            int32_t gSum = (gA + gB) >> 1, gDiff = (gA - gB) >> 1;
+            kiss_fft_cpx yk, yn;
+            yk.r = mulQ15(zk.r, gSum) + mulQ15(zn.r, gDiff);
+            yk.i = mulQ15(zk.i, gSum) - mulQ15(zn.i, gDiff);
+            yn.r = mulQ15(zn.r, gSum) + mulQ15(zk.r, gDiff);
+            yn.i = mulQ15(zn.i, gSum) - mulQ15(zk.i, gDiff);
+            zk = yk;
+            zn = yn;
+        }
+
+        if (learn) _floorSet = true;
+        opus_ifft_c(_fft, _spec, _buf);
+        overlapAdd(pcm, &kiss_fft_cpx::r);
+        overlapAdd(pcm + NS_HOP, &kiss_fft_cpx::i);
+    }
+
+private:
+    const kiss_fft_state* _fft = nullptr;
+    int16_t _window[NS_FFT_SIZE];
+    int16_t _synthesis[NS_FFT_SIZE];
+    int16_t _tail[NS_FRAME_SAMPLES];       // previous frame's input
+    int32_t _overlap[NS_FFT_SIZE];         // output being built, oldest sample first
+    kiss_fft_cpx _buf[NS_FFT_SIZE];
+    kiss_fft_cpx _spec[NS_FFT_SIZE];
+    uint32_t _noise[NS_BINS];
+    uint32_t _prevSnr[2][NS_BINS];         // Q8 clean-speech SNR each hop last ended on
+    int _primed = 0;
+    bool _floorSet = false;                // _noise holds an estimate, not zeros
+
+    static inline int32_t mulQ15(int32_t a, int32_t g) { return (int32_t)(((int64_t)a * g) >> 15); }
+
+    static inline uint32_t power(int32_t r, int32_t i) {
+        return (uint32_t)(((int64_t)r * r + (int64_t)i * i) >> NS_POWER_SHIFT);
+    }
+
+    // Q15 gain for one bin of hop A (0) or B (1); also moves the noise floor
+    int32_t gain(int k, uint32_t p, bool learn, int hop) {
+        if (learn) {
+            uint32_t& n = _noise[k];
+            if (!_floorSet) {
+                n = p;
+            } else if (p < (uint64_t)n << NS_PRESENCE_SHIFT) {
+                // Within 6 dB of the floor: noise alone, average it in
+                n = p > n ? n + ((p - n) >> NS_NOISE_AVG_SHIFT) : n - ((n - p) >> NS_NOISE_AVG_SHIFT);
+            } else {
+                // Speech, or a noise that got louder: creep up so the latter is followed
+                n += (n >> NS_NOISE_RISE_SHIFT) + 1;
+            }
+        }
+        uint32_t noise = (uint32_t)(((uint64_t)_noise[k] * NS_NOISE_BIAS_Q8) >> 8) + 1;
+        // A posteriori SNR (a 64-bit division only for loud bins), then the
+        // decision-directed a priori one
+        uint64_t wide = p < (1u << 24) ? (p << 8) / noise : ((uint64_t)p << 8) / noise;
+        uint32_t post = wide > NS_MAX_SNR_Q8 ? NS_MAX_SNR_Q8 : (uint32_t)wide;
+        uint32_t excess = post > 256 ? (uint32_t)post - 256 : 0;
+        uint32_t prio = (uint32_t)(((uint64_t)NS_DD_ALPHA_Q15 * _prevSnr[hop][k] +
+                                    (uint64_t)(32768 - NS_DD_ALPHA_Q15) * excess) >> 15);
+        int32_t g = 32767 - (int32_t)(8388608u / (prio + 256));   // prio / (1 + prio)
+        if (g < NS_MIN_GAIN_Q15) g = NS_MIN_GAIN_Q15;
+        _prevSnr[hop][k] = (uint32_t)(((uint64_t)((g * g) >> 15) * post) >> 15);
+        return g;
+    }
+
+    // One inverse-transformed hop into the overlap, and its finished oldest hop out
+    void overlapAdd(int16_t* out, kiss_fft_scalar kiss_fft_cpx::*part) {
+        for (int i = 0; i < NS_FFT_SIZE; i++) _overlap[i] += mulQ15(_buf[i].*part, _synthesis[i]);
+        for (int i = 0; i < NS_HOP; i++) {
+            int32_t v = (_overlap[i] + (1 << (NS_INPUT_SHIFT - 1))) >> NS_INPUT_SHIFT;
+            out[i] = v > 32767 ? 32767 : v < -32768 ? -32768 : v;
+        }
+        memmove(_overlap, _overlap + NS_HOP, (NS_FFT_SIZE - NS_HOP) * sizeof(int32_t));
+        memset(_overlap + NS_FFT_SIZE - NS_HOP, 0, NS_HOP * sizeof(int32_t));
+    }
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+// Incremental Ogg Opus muxer (RFC 3533 framing, RFC 7845 mapping).
+//
+// Opus packets go in one at a time and complete, CRC'd pages come out through an
+// OggPageSink as soon as they fill up. Memory is one page buffer (header, lacing
+// table and OGG_MUX_MAX_BODY payload bytes); packets larger than that continue
+// on the next page, so nothing ever holds the whole stream.
+// Granule positions count 48 kHz samples, taken from each packet's TOC byte.
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef OGG_MUX_MAX_BODY
+#define OGG_MUX_MAX_BODY 4096   // payload bytes per page
+#endif
+
+#define OGG_MUX_VENDOR "ESP32-Zello-Client"
+
+// Receives finished pages. header holds the 27 byte page header plus lacing table.
+class OggPageSink {
+public:
+    virtual ~OggPageSink() {}
+    virtual bool writePage(const uint8_t* header, size_t headerLen, const uint8_t* body, size_t bodyLen) = 0;
+};
+
+// Samples at 48 kHz in one Opus packet (RFC 6716 section 3.1), 0 if malformed
+inline uint32_t opusPacketSamples48k(const uint8_t* data, size_t len) {
+    if (len < 1) return 0;
+    uint8_t config = data[0] >> 3;
+    uint32_t frameSamples;
+    if (config < 12) {
+        static const uint16_t SILK[4] = {480, 960, 1920, 2880};    // 10/20/40/60 ms
+        frameSamples = SILK[config & 3];
+    } else if (config < 16) {
+        frameSamples = (config & 1) ? 960 : 480;                    // hybrid 10/20 ms
+    } else {
+        static const uint16_t CELT[4] = {120, 240, 480, 960};      // 2.5/5/10/20 ms
+        frameSamples = CELT[config & 3];
+    }
+    uint32_t frames;
+    switch (data[0] & 3) {
+        case 0: frames = 1; break;
+        case 1:
+        case 2: frames = 2; break;
+        default:
+            if (len < 2) return 0;
+            frames = data[1] & 0x3F;
+            break;
+    }
+    uint32_t samples = frames * frameSamples;
+    return samples > 5760 ? 0 : samples;   // 120 ms is the format maximum
+}
+
+// Ogg's CRC-32: polynomial 0x04C11DB7, MSB first, no reflection, zero init
+inline uint32_t oggCrcUpdate(uint32_t crc, const uint8_t* data, size_t len) {
+    struct Table {
+        uint32_t entries[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t r = i << 24;
+                for (int b = 0; b < 8; b++) r = (r & 0x80000000u) ? (r << 1) ^ 0x04C11DB7u : (r << 1);
+                entries[i] = r;
+            }
+        }
+    };
+    static const Table table;
+    for (size_t i = 0; i < len; i++) crc = (crc << 8) ^ table.entries[((crc >> 24) ^ data[i]) & 0xFF];
+    return crc;
+}
+
+class OggOpusMuxer {
+public:
+    static const size_t HEADER_SIZE = 27;
+    static const uint64_t NO_GRANULE = ~(uint64_t)0;
+
+    OggOpusMuxer() : _sink(nullptr) { reset(0x5A454C4Cu); }   // "ZELL"
+
+    // Starts a new logical stream and emits the OpusHead and OpusTags pages.
+    // inputRate is informational only (RFC 7845 5.1); playback is always 48 kHz.
+    bool begin(OggPageSink* sink, uint32_t serialNo, uint32_t inputRate, uint8_t channels = 1, uint16_t preSkip = 0) {
+        _sink = sink;
+        reset(serialNo);
+
+        uint8_t head[19];
+        memcpy(head, "OpusHead", 8);
+        head[8] = 1;                 // version
+        head[9] = channels;
+        put16(head + 10, preSkip);
+        put32(head + 12, inputRate);
+        put16(head + 16, 0);         // output gain
+        head[18] = 0;                // mapping family 0: mono/stereo
+        _flags = 0x02;               // beginning of stream
+        if (!appendPacket(head, sizeof(head), 0) || !flush()) return false;
+
+        static const char vendor[] = OGG_MUX_VENDOR;
+        uint8_t tags[8 + 4 + sizeof(vendor) - 1 + 4];
+        memcpy(tags, "OpusTags", 8);
+        put32(tags + 8, sizeof(vendor) - 1);
+        memcpy(tags + 12, vendor, sizeof(vendor) - 1);
+        put32(tags + 12 + sizeof(vendor) - 1, 0);   // no user comments
+        if (!appendPacket(tags, sizeof(tags), 0) || !flush()) return false;
+
+        _open = true;
+        return true;
+    }
+
+    // Adds one Opus packet; pages go to the sink as they fill up.
+    // Returns false if the packet is not valid Opus or the sink failed.
+    bool writePacket(const uint8_t* data, size_t len) {
+        if (!_open) return false;
+        uint32_t samples = opusPacketSamples48k(data, len);
+        if (samples == 0) return false;
+        if (!appendPacket(data, len, _granule + samples)) return false;
+        _packets++;
+        return true;
+    }
+
+    // Emits the buffered partial page now, e.g. so a live reader is not kept waiting
+    bool flush() {
+        if (_segments == 0) return true;
+        return emitPage();
+    }
+
+    // Emits the final page with the end-of-stream flag (empty if nothing is pending)
+    bool end() {
+        if (!_open) return false;
+        _open = false;
+        _flags |= 0x04;
+        if (_segments == 0) _pageGranule = _granule;
+        return emitPage();
+    }
+
+    bool isOpen() const { return _open; }
+    uint64_t granule() const { return _granule; }     // 48 kHz samples muxed so far
+    uint32_t packets() const { return _packets; }
+    uint32_t pages() const { return _pageNo; }
+
+private:
+    OggPageSink* _sink;
+    uint32_t _serialNo;
+    uint32_t _pageNo;
+    uint64_t _granule;        // end position of the last complete packet
+    uint64_t _pageGranule;    // granule to stamp on the page being built
+    uint32_t _packets;
+    uint8_t _flags;           // header type for the page being built
+    bool _open;
+    uint8_t _segments;
+    size_t _bodyLen;
+    uint8_t _header[HEADER_SIZE + 255];
+    uint8_t _body[OGG_MUX_MAX_BODY];
+
+    void reset(uint32_t serialNo) {
+        _serialNo = serialNo;
+        _pageNo = 0;
+        _granule = 0;
+        _pageGranule = NO_GRANULE;
+        _packets = 0;
+        _flags = 0;
+        _open = false;
+        _segments = 0;
+        _bodyLen = 0;
+    }
+
+    // Laces a packet into the current page, spilling onto new pages as needed.
+    // A packet whose length is a multiple of 255 ends with a zero lacing value.
+    bool appendPacket(const uint8_t* data, size_t len, uint64_t endGranule) {
+        size_t remaining = len;
+        for (;;) {
+            if (_segments == 255 || (_bodyLen + (remaining < 255 ? remaining : 255) > OGG_MUX_MAX_BODY)) {
+                if (!emitPage()) return false;
+                if (remaining != len) _flags |= 0x01;   // continued packet
+            }
+            size_t lace = remaining < 255 ? remaining : 255;
+            _header[HEADER_SIZE + _segments++] = (uint8_t)lace;
+            memcpy(_body + _bodyLen, data + (len - remaining), lace);
+            _bodyLen += lace;
+            remaining -= lace;
+            if (lace < 255) break;
+        }
+        _granule = endGranule;
+        _pageGranule = endGranule;
+        return true;
+    }
+
+    bool emitPage() {
+        uint8_t* h = _header;
+        memcpy(h, "OggS", 4);
+        h[4] = 0;                          // stream structure version
+        h[5] = _flags;
+        put64(h + 6, _pageGranule);        // -1 when no packet finishes on this page
+        put32(h + 14, _serialNo);
+        put32(h + 18, _pageNo);
+        put32(h + 22, 0);                  // CRC is computed with this field zeroed
+        h[26] = _segments;
+        size_t headerLen = HEADER_SIZE + _segments;
+        uint32_t crc = oggCrcUpdate(0, h, headerLen);
+        crc = oggCrcUpdate(crc, _body, _bodyLen);
+        put32(h + 22, crc);
+
+        bool ok = _sink && _sink->writePage(h, headerLen, _body, _bodyLen);
+        _pageNo++;
+        _flags = 0;
+        _segments = 0;
+        _bodyLen = 0;
+        _pageGranule = NO_GRANULE;
+        return ok;
+    }
+
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = v;
+        p[1] = v >> 8;
+    }
+    static void put32(uint8_t* p, uint32_t v) {
+        for (int i = 0; i < 4; i++) p[i] = v >> (8 * i);
+    }
+    static void put64(uint8_t* p, uint64_t v) {
+        for (int i = 0; i < 8; i++) p[i] = v >> (8 * i);
+    }
+};
+
+#ifdef ARDUINO
+#include <Print.h>
+
+// Writes pages straight to a File, Client or any other Print
+class OggPrintSink : public OggPageSink {
+public:
+    explicit OggPrintSink(Print& out) : _out(out) {}
+
+    bool writePage(const uint8_t* header, size_t headerLen, const uint8_t* body, size_t bodyLen) override {
+        return _out.write(header, headerLen) == headerLen && _out.write(body, bodyLen) == bodyLen;
+    }
+
+private:
+    Print& _out;
+};
+#endif
@@ -0,0 +1,270 @@
+#pragma once
+
+// Streaming decoder for compressed and delta firmware images (tools/ota_image.py).
+//
+// Formats, named by the "format" line of the OTA manifest:
+//   raw    the application image as built
+//   zlib   the image deflated, with zlib header and checksum
+//   patch  a deflated op stream against the running image. Each op is
+//          [u8 op][u32 length][u32 base offset] (little-endian) followed by
+//          length bytes: OTA_OP_LITERAL bytes are output as they are,
+//          OTA_OP_DIFF bytes are added (mod 256) to the base image from the
+//          offset on, so code that only moved compresses to runs of zeros.
+//
+// Input may arrive in pieces of any size; output goes to the sink in pieces of
+// at most OTA_BASE_CHUNK bytes (patch) or one inflate step (zlib). RAM is
+// bounded by the 32 KB inflate window plus the inflater state and a small base
+// buffer, allocated in begin() for the compressed formats only.
+//
+// On the ESP32 the inflater is tinfl from ROM, so it costs no flash; host builds
+// (tools/ota_image_check.cpp) use zlib.
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "esp32/rom/miniz.h"
+#else
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#endif
+
+#define OTA_OP_LITERAL 1
+#define OTA_OP_DIFF 2
+#define OTA_OP_HEADER 9
+#define OTA_BASE_CHUNK 1024
+#define OTA_INFLATE_WINDOW 32768
+
+class OtaImageDecoder {
+public:
+    enum Format : uint8_t { Raw, Zlib, Patch };
+
+    // Sink gets the decoded image in order; base reads the running image
+    typedef bool (*Sink)(void* ctx, const uint8_t* data, size_t len);
+    typedef bool (*BaseReader)(void* ctx, uint32_t offset, uint8_t* out, size_t len);
+
+    ~OtaImageDecoder() { end(); }
+
+    static bool parseFormat(const char* name, Format& format) {
+        if (strncmp(name, "raw", 3) == 0) format = Raw;
+        else if (strncmp(name, "zlib", 4) == 0) format = Zlib;
+        else if (strncmp(name, "patch", 5) == 0) format = Patch;
+        else return false;
+        return true;
+    }
+
+    // false when the inflater buffers cannot be allocated
+    bool begin(Format format, Sink sink, BaseReader base, void* ctx, uint32_t baseSize) {
+        end();
+        _format = format;
+        _sink = sink;
+        _base = base;
+        _ctx = ctx;
+        _baseSize = baseSize;
+        _error = nullptr;
+        _done = format == Raw;
+        _opRemaining = 0;
+        _headerLen = 0;
+        _produced = 0;
+        if (format == Raw) return true;
+        return startInflate();
+    }
+
+    // Releases the inflater; safe to call twice
+    void end() {
+        if (_format == Raw) return;
+#ifdef ARDUINO
+        free(_inflator);
+        free(_window);
+        _inflator = nullptr;
+        _window = nullptr;
+#else
+        if (_zlibOpen) inflateEnd(&_zs);
+        _zlibOpen = false;
+#endif
+        _format = Raw;
+    }
+
+    // Feeds input bytes; false once the stream is bad or the sink refused output
+    bool write(const uint8_t* data, size_t len) {
+        if (_error) return false;
+        if (_format == Raw) return emit(data, len);
+        if (_done) {
+            if (len) _error = "data after the end of the compressed image";
+            return !_error;
+        }
+        return inflateSome(data, len);
+    }
+
+    // The whole stream has been fed: checks that it ended where it should
+    bool finish() {
+        if (_error) return false;
+        if (!_done) _error = "compressed image is truncated";
+        else if (_opRemaining || _headerLen) _error = "patch ends inside an op";
+        end();
+        return !_error;
+    }
+
+    const char* error() const { return _error; }
+    uint32_t produced() const { return _produced; }
+
+private:
+    Format _format = Raw;
+    Sink _sink = nullptr;
+    BaseReader _base = nullptr;
+    void* _ctx = nullptr;
+    uint32_t _baseSize = 0;
+    const char* _error = nullptr;
+    bool _done = false;                  // end of the deflate stream seen
+    uint32_t _produced = 0;
+
+    // Patch op being applied
+    uint8_t _header[OTA_OP_HEADER];
+    uint8_t _headerLen = 0;
+    uint8_t _op = 0;
+    uint32_t _opRemaining = 0;
+    uint32_t _basePos = 0;
+    uint8_t _baseBuf[OTA_BASE_CHUNK];
+
+#ifdef ARDUINO
+    tinfl_decompressor* _inflator = nullptr;
+    uint8_t* _window = nullptr;          // tinfl's circular dictionary, also its output
+    size_t _windowPos = 0;
+
+    static void* allocLarge(size_t bytes) { return psramFound() ? ps_malloc(bytes) : malloc(bytes); }
+
+    bool startInflate() {
+        _inflator = (tinfl_decompressor*)allocLarge(sizeof(tinfl_decompressor));
+        _window = (uint8_t*)allocLarge(OTA_INFLATE_WINDOW);
+        if (!_inflator || !_window) {
+            end();
+            return false;
+        }
+        tinfl_init(_inflator);
+        _windowPos = 0;
+        return true;
+    }
+
+    bool inflateSome(const uint8_t* data, size_t len) {
+        for (;;) {
+            size_t in = len;
+            size_t out = OTA_INFLATE_WINDOW - _windowPos;
+            tinfl_status status = tinfl_decompress(_inflator, data, &in, _window, _window + _windowPos, &out,
+                                                   TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+            data += in;
+            len -= in;
+            if (out && !decoded(_window + _windowPos, out)) return false;
+            _windowPos = (_windowPos + out) & (OTA_INFLATE_WINDOW - 1);
+            if (status < TINFL_STATUS_DONE) {
+                _error = "corrupt compressed image";
+                return false;
+            }
+            if (status == TINFL_STATUS_DONE) {
+                _done = true;
+                if (len) _error = "data after the end of the compressed image";
+                return !_error;
+            }
+            if (status == TINFL_STATUS_NEEDS_MORE_INPUT && len == 0) return true;
+        }
+    }
+#else
+    z_stream _zs;
+    bool _zlibOpen = false;
+    uint8_t _out[4096];
+
+    bool startInflate() {
+        memset(&_zs, 0, sizeof(_zs));
+        _zlibOpen = inflateInit(&_zs) == Z_OK;
+        return _zlibOpen;
+    }
+
+    bool inflateSome(const uint8_t* data, size_t len) {
+        _zs.next_in = (Bytef*)data;
+        _zs.avail_in = len;
+        for (;;) {
+            _zs.next_out = _out;
+            _zs.avail_out = sizeof(_out);
+            int ret = inflate(&_zs, Z_NO_FLUSH);
+            size_t out = sizeof(_out) - _zs.avail_out;
+            if (out && !decoded(_out, out)) return false;
+            if (ret == Z_STREAM_END) {
+                _done = true;
+                if (_zs.avail_in) _error = "data after the end of the compressed image";
+                return !_error;
+            }
+            if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                _error = "corrupt compressed image";
+                return false;
+            }
+            if (_zs.avail_in == 0 && _zs.avail_out != 0) return true;
+        }
+    }
+#endif
+
+    bool emit(const uint8_t* data, size_t len) {
+        if (!_sink(_ctx, data, len)) {
+            if (!_error) _error = "image rejected by the writer";
+            return false;
+        }
+        _produced += len;
+        return true;
+    }
+
+    // Inflated bytes: the image itself, or patch ops to apply
+    bool decoded(const uint8_t* data, size_t len) {
+        if (_format == Zlib) return emit(data, len);
+        while (len) {
+            if (_opRemaining == 0) {
+                size_t need = OTA_OP_HEADER - _headerLen;
+                size_t take = need < len ? need : len;
+                memcpy(_header + _headerLen, data, take);
+                _headerLen += take;
+                data += take;
+                len -= take;
+                if (_headerLen < OTA_OP_HEADER) return true;
+                _headerLen = 0;
+                if (!startOp()) return false;
+                continue;
+            }
+            size_t take = _opRemaining < len ? _opRemaining : len;
+            if (_op == OTA_OP_LITERAL) {
+                if (!emit(data, take)) return false;
+            } else {
+                for (size_t done = 0; done < take;) {
+                    size_t n = take - done < OTA_BASE_CHUNK ? take - done : OTA_BASE_CHUNK;
+                    if (!_base(_ctx, _basePos, _baseBuf, n)) {
+                        _error = "cannot read the running image";
+                        return false;
+                    }
+                    for (size_t i = 0; i < n; i++) _baseBuf[i] += data[done + i];
+                    if (!emit(_baseBuf, n)) return false;
+                    _basePos += n;
+                    done += n;
+                }
+            }
+            _opRemaining -= take;
+            data += take;
+            len -= take;
+        }
+        return true;
+    }
+
+    bool startOp() {
+        _op = _header[0];
+        _opRemaining = readLe32(_header + 1);
+        _basePos = readLe32(_header + 5);
+        if (_op != OTA_OP_LITERAL && _op != OTA_OP_DIFF) {
+            _error = "unknown patch op";
+            return false;
+        }
+        if (_op == OTA_OP_DIFF && (_basePos > _baseSize || _opRemaining > _baseSize - _basePos)) {
+            _error = "patch reads past the end of the running image";
+            return false;
+        }
+        return true;
+    }
+
+    static uint32_t readLe32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+// Public key OTA manifests must be signed with (ECDSA P-256, PEM), see
+// include/ota_pipeline.h. Empty: every update is refused, unless the build sets
+// -DOTA_ALLOW_UNSIGNED=1 (manifest and image hash still checked, but anyone on
+// the network can write one).
+//
+//   python3 tools/ota_sign.py keygen
+//
+// writes ota_private.pem (keep it out of the repository) and regenerates this file.
+
+static const char OTA_PUBLIC_KEY_PEM[] = "";
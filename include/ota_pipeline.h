@@ -0,0 +1,490 @@
+#pragma once
+
+// Streaming firmware update: the HTTP upload callback only hashes and copies,
+// a writer task on core 0 does the flash work.
+//
+// An upload carries a manifest followed by the image, both made by
+// tools/ota_sign.py. The manifest is checked before anything is erased. Upload
+// data is copied into one of two sector-sized buffers; a full buffer goes to the
+// writer task while the next one fills, so the TCP receive path keeps running
+// during erase/program and only waits when both buffers are in flight. The
+// writer decodes compressed and patch images (include/ota_image.h) on the way
+// to flash and hashes what it writes; the boot partition is switched only once
+// size and SHA-256 of the written image match the manifest.
+//
+// Manifest (text; the signed part is everything before the "sig" line):
+//   zello-ota 1
+//   size <image bytes>
+//   sha256 <64 hex digits>
+//   version <firmware version>
+//   format raw|zlib|patch              optional, raw by default
+//   base <sha256> / base_size <bytes>  patch only: the image it applies to
+//   sig <hex DER ECDSA P-256 signature of the lines above, SHA-256>
+//
+// size and sha256 always describe the decoded image.
+//
+// With no public key built in (include/ota_key.h) every manifest is refused,
+// unless the build sets -DOTA_ALLOW_UNSIGNED=1: then the "sig" line is not
+// required but the size and hash still are.
+
+#include <Arduino.h>
+#include <Update.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/sha256.h"
+#include "metrics.h"
+#include "ota_image.h"
+#include "ota_key.h"
+#include "task_layout.h"
+
+#ifndef OTA_ALLOW_UNSIGNED
+#define OTA_ALLOW_UNSIGNED 0
+#endif
+
+#define OTA_CHUNK_BYTES 4096         // one flash sector per write
+#define OTA_BUFFERS 2
+#define OTA_MANIFEST_MAX 1024
+#define OTA_WRITER_TIMEOUT_MS 10000  // a chunk stuck this long fails the update
+
+struct OtaMetrics {
+    HistogramMetric* writeUs;                // decode + erase + program per chunk, writer task
+    HistogramMetric* stallUs;                // upload callback waiting for a free buffer
+    GaugeMetric* kbps;                       // throughput of the last update
+    GaugeMetric* underruns;                  // playback underruns during the last update
+    CounterMetric* failures;
+    const CounterMetric* playbackUnderruns;  // read at start and end of an update
+};
+
+class OtaPipeline {
+public:
+    explicit OtaPipeline(const OtaMetrics& metrics) : _metrics(metrics) {}
+
+    bool begin() {
+        if (OTA_PUBLIC_KEY_PEM[0]) {
+            Serial.println("OTA: manifests must be signed");
+        } else if (OTA_ALLOW_UNSIGNED) {
+            Serial.println("OTA: WARNING no public key built in, unsigned manifests accepted (OTA_ALLOW_UNSIGNED)");
+        } else {
+            Serial.println("OTA: no public key built in, updates refused (run tools/ota_sign.py keygen)");
+        }
+        _full = xQueueCreate(OTA_BUFFERS, sizeof(Chunk));
+        _free = xQueueCreate(OTA_BUFFERS, sizeof(uint8_t));
+        if (!_full || !_free) return false;
+        return xTaskCreatePinnedToCore(writerTask, "otaTask", TASK_OTA_STACK, this, TASK_HOUSEKEEPING_PRIORITY, nullptr,
+                                       TASK_HOUSEKEEPING_CORE) == pdPASS;
+    }
+
+    // Upload callback for every part of the multipart body; owner identifies the
+    // request so a second upload cannot interleave with a running one. A part is
+    // the manifest if it starts with the manifest magic, otherwise the image.
+    void receive(const void* owner, size_t index, const uint8_t* data, size_t len, bool final) {
+        if (index == 0 && len >= 9 && memcmp(data, "zello-ota", 9) == 0) {
+            if (busy() && owner != _owner) return;
+            if (_state == Writing) abortImage();
+            _owner = owner;
+            _state = Manifest;
+            _manifestLen = 0;
+            _error = nullptr;
+            _summary[0] = 0;
+        }
+        if (owner != _owner) return;
+        if (index == 0 && _state != Manifest) {
+            if (_state != Ready) {
+                if (_state != Failed) fail("manifest must come before the image");
+                return;
+            }
+            startImage();
+        }
+        if (_state == Manifest) {
+            if (_manifestLen + len > OTA_MANIFEST_MAX) {
+                fail("manifest too large");
+                return;
+            }
+            memcpy(_manifestText + _manifestLen, data, len);
+            _manifestLen += len;
+            if (final) checkManifest();
+        } else if (_state == Writing) {
+            if (len) writeImage(data, len);
+            if (final && _state == Writing) finishImage();
+        }
+    }
+
+    // Client went away: drop a half-written image, leave the boot partition alone
+    void abort(const void* owner) {
+        if (owner != _owner) return;
+        if (_state == Writing) abortImage();
+        if (busy()) fail("upload aborted");
+        _owner = nullptr;
+    }
+
+    bool succeeded(const void* owner) const { return owner == _owner && _state == Done; }
+
+    // Failure reason, or the throughput summary after success
+    const char* result() const { return _state == Done ? _summary : (_error ? _error : "no image received"); }
+
+private:
+    enum State : uint8_t { Idle, Manifest, Ready, Writing, Done, Failed };
+
+    struct Chunk {
+        uint8_t index;
+        uint16_t len;
+    };
+
+    OtaMetrics _metrics;
+    QueueHandle_t _full = nullptr;   // buffers waiting for the writer
+    QueueHandle_t _free = nullptr;   // buffers the upload side may fill
+    uint8_t* _buf[OTA_BUFFERS] = {};
+    std::atomic<bool> _writeFailed{false};
+
+    // Writer side (otaTask); the upload side reads it only after drain()
+    OtaImageDecoder _decoder;
+    const char* _writeError = nullptr;
+    mbedtls_sha256_context _sha;
+    uint32_t _written = 0;
+
+    // Upload side (HTTP server task)
+    const void* _owner = nullptr;
+    State _state = Idle;
+    const char* _error = nullptr;
+    char _summary[96] = "";
+    char _manifestText[OTA_MANIFEST_MAX + 1];
+    size_t _manifestLen = 0;
+    uint32_t _imageSize = 0;
+    uint8_t _imageSha[32];
+    OtaImageDecoder::Format _format = OtaImageDecoder::Raw;
+    uint32_t _baseSize = 0;
+    uint8_t _baseSha[32];
+    const esp_partition_t* _running = nullptr;
+    int _fill = -1;                  // buffer being filled, -1 = none
+    size_t _fillLen = 0;
+    uint32_t _received = 0;
+    uint32_t _startMs = 0;
+    uint32_t _startUnderruns = 0;
+
+    bool busy() const { return _state == Manifest || _state == Ready || _state == Writing; }
+
+    void fail(const char* why) {
+        _error = why;
+        _state = Failed;
+        _metrics.failures->inc();
+        Serial.printf("OTA failed: %s\n", why);
+    }
+
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Decodes hex up to the end of the line; returns the byte count, 0 on bad input
+    static size_t parseHex(const char* s, uint8_t* out, size_t cap) {
+        size_t n = 0;
+        while (hexValue(s[0]) >= 0 && hexValue(s[1]) >= 0) {
+            if (n == cap) return 0;
+            out[n++] = (hexValue(s[0]) << 4) | hexValue(s[1]);
+            s += 2;
+        }
+        return (*s == 0 || *s == '\r' || *s == '\n') ? n : 0;
+    }
+
+    void checkManifest() {
+        _manifestText[_manifestLen] = 0;
+        const char* text = _manifestText;
+        const char* sig = nullptr;
+        bool haveSize = false, haveSha = false, haveBase = false;
+        char version[24] = "?";
+        _format = OtaImageDecoder::Raw;
+        _baseSize = 0;
+        for (const char* line = text; *line;) {
+            const char* end = strchr(line, '\n');
+            if (!end) end = line + strlen(line);
+            if (line == text && strncmp(line, "zello-ota 1", 11) != 0) {
+                fail("unsupported manifest version");
+                return;
+            }
+            if (strncmp(line, "size ", 5) == 0) {
+                _imageSize = strtoul(line + 5, nullptr, 10);
+                haveSize = _imageSize > 0;
+            } else if (strncmp(line, "sha256 ", 7) == 0) {
+                haveSha = parseHex(line + 7, _imageSha, sizeof(_imageSha)) == sizeof(_imageSha);
+            } else if (strncmp(line, "version ", 8) == 0) {
+                size_t n = end - line - 8;
+                if (n >= sizeof(version)) n = sizeof(version) - 1;
+                memcpy(version, line + 8, n);
+                version[n] = 0;
+            } else if (strncmp(line, "format ", 7) == 0) {
+                if (!OtaImageDecoder::parseFormat(line + 7, _format)) {
+                    fail("unknown image format");
+                    return;
+                }
+            } else if (strncmp(line, "base ", 5) == 0) {
+                haveBase = parseHex(line + 5, _baseSha, sizeof(_baseSha)) == sizeof(_baseSha);
+            } else if (strncmp(line, "base_size ", 10) == 0) {
+                _baseSize = strtoul(line + 10, nullptr, 10);
+            } else if (strncmp(line, "sig ", 4) == 0) {
+                sig = line;
+                break;
+            }
+            line = *end ? end + 1 : end;
+        }
+        if (!haveSize || !haveSha) {
+            fail("manifest lacks size or sha256");
+            return;
+        }
+        if (!verifySignature((const uint8_t*)text, sig ? sig - text : _manifestLen, sig ? sig + 4 : nullptr)) return;
+        if (_format == OtaImageDecoder::Patch && (!haveBase || !_baseSize || !baseMatches())) {
+            fail("patch was made for a different firmware than the one running");
+            return;
+        }
+        Serial.printf("OTA manifest ok: version %s, %u bytes\n", version, (unsigned)_imageSize);
+        _state = Ready;
+    }
+
+    bool verifySignature(const uint8_t* signedPart, size_t signedLen, const char* sigHex) {
+        if (!OTA_PUBLIC_KEY_PEM[0]) {
+            if (OTA_ALLOW_UNSIGNED) {
+                Serial.println("OTA: no public key built in, manifest signature not checked");
+                return true;
+            }
+            fail("no public key built in, updates are refused");
+            return false;
+        }
+        uint8_t sig[80];   // DER ECDSA P-256 is at most 72 bytes
+        size_t sigLen = sigHex ? parseHex(sigHex, sig, sizeof(sig)) : 0;
+        if (!sigLen) {
+            fail("manifest is not signed");
+            return false;
+        }
+        uint8_t digest[32];
+        mbedtls_sha256_context sha;
+        mbedtls_sha256_init(&sha);
+        mbedtls_sha256_starts(&sha, 0);
+        mbedtls_sha256_update(&sha, signedPart, signedLen);
+        mbedtls_sha256_finish(&sha, digest);
+        mbedtls_sha256_free(&sha);
+
+        mbedtls_pk_context key;
+        mbedtls_pk_init(&key);
+        int ret = mbedtls_pk_parse_public_key(&key, (const unsigned char*)OTA_PUBLIC_KEY_PEM, sizeof(OTA_PUBLIC_KEY_PEM));
+        if (ret == 0) ret = mbedtls_pk_verify(&key, MBEDTLS_MD_SHA256, digest, sizeof(digest), sig, sigLen);
+        mbedtls_pk_free(&key);
+        if (ret != 0) {
+            fail("manifest signature does not verify");
+            return false;
+        }
+        return true;
+    }
+
+    // Hashes the start of the running partition; a patch only applies to that exact image
+    bool baseMatches() {
+        _running = esp_ota_get_running_partition();
+        if (!_running || _baseSize > _running->size) return false;
+        mbedtls_sha256_context sha;
+        mbedtls_sha256_init(&sha);
+        mbedtls_sha256_starts(&sha, 0);
+        uint8_t buf[512];
+        bool ok = true;
+        for (uint32_t pos = 0; ok && pos < _baseSize; pos += sizeof(buf)) {
+            size_t n = _baseSize - pos < sizeof(buf) ? _baseSize - pos : sizeof(buf);
+            ok = esp_partition_read(_running, pos, buf, n) == ESP_OK;
+            if (ok) mbedtls_sha256_update(&sha, buf, n);
+        }
+        uint8_t digest[32];
+        mbedtls_sha256_finish(&sha, digest);
+        mbedtls_sha256_free(&sha);
+        return ok && memcmp(digest, _baseSha, sizeof(digest)) == 0;
+    }
+
+    void startImage() {
+        for (int i = 0; i < OTA_BUFFERS; i++) {
+            _buf[i] = (uint8_t*)malloc(OTA_CHUNK_BYTES);
+            if (!_buf[i]) {
+                freeBuffers();
+                fail("out of memory for OTA buffers");
+                return;
+            }
+        }
+        if (!_decoder.begin(_format, writeOut, readBase, this, _baseSize)) {
+            freeBuffers();
+            fail("out of memory for the decompressor");
+            return;
+        }
+        if (!Update.begin(_imageSize)) {
+            _decoder.end();
+            freeBuffers();
+            fail(Update.errorString());
+            return;
+        }
+        xQueueReset(_full);
+        xQueueReset(_free);
+        for (uint8_t i = 0; i < OTA_BUFFERS; i++) xQueueSend(_free, &i, 0);
+        _writeFailed = false;
+        _writeError = nullptr;
+        _written = 0;
+        _fill = -1;
+        _fillLen = 0;
+        _received = 0;
+        mbedtls_sha256_init(&_sha);
+        mbedtls_sha256_starts(&_sha, 0);
+        _startMs = millis();
+        _startUnderruns = _metrics.playbackUnderruns->value();
+        _state = Writing;
+    }
+
+    void writeImage(const uint8_t* data, size_t len) {
+        if (_writeFailed) {
+            abortImage();
+            fail(_writeError);
+            return;
+        }
+        _received += len;
+        while (len) {
+            if (_fill < 0) {
+                uint32_t start = micros();
+                uint8_t index;
+                if (xQueueReceive(_free, &index, pdMS_TO_TICKS(OTA_WRITER_TIMEOUT_MS)) != pdTRUE) {
+                    abortImage();
+                    fail("flash writer stalled");
+                    return;
+                }
+                _metrics.stallUs->observe(micros() - start);
+                _fill = index;
+                _fillLen = 0;
+            }
+            size_t n = len < OTA_CHUNK_BYTES - _fillLen ? len : OTA_CHUNK_BYTES - _fillLen;
+            memcpy(_buf[_fill] + _fillLen, data, n);
+            _fillLen += n;
+            data += n;
+            len -= n;
+            if (_fillLen == OTA_CHUNK_BYTES) submit();
+        }
+    }
+
+    void submit() {
+        Chunk c = {(uint8_t)_fill, (uint16_t)_fillLen};
+        xQueueSend(_full, &c, portMAX_DELAY);   // never blocks: at most OTA_BUFFERS in flight
+        _fill = -1;
+    }
+
+    // Hands over the partial last buffer and waits until the writer has every buffer back
+    bool drain() {
+        if (_fill >= 0) {
+            if (_fillLen) {
+                submit();
+            } else {
+                uint8_t index = _fill;
+                xQueueSend(_free, &index, 0);
+                _fill = -1;
+            }
+        }
+        uint8_t index[OTA_BUFFERS];
+        int back = 0;
+        while (back < OTA_BUFFERS && xQueueReceive(_free, &index[back], pdMS_TO_TICKS(OTA_WRITER_TIMEOUT_MS)) == pdTRUE) {
+            back++;
+        }
+        for (int i = 0; i < back; i++) xQueueSend(_free, &index[i], 0);
+        return back == OTA_BUFFERS;
+    }
+
+    void finishImage() {
+        bool drained = drain();
+        if (drained && !_writeFailed && !_decoder.finish()) {
+            _writeFailed = true;
+            _writeError = _decoder.error();
+        }
+        uint8_t digest[32];
+        mbedtls_sha256_finish(&_sha, digest);
+        mbedtls_sha256_free(&_sha);
+        const char* why = !drained ? "flash writer stalled"
+                        : _writeFailed ? _writeError
+                        : _written != _imageSize ? "image shorter than the manifest says"
+                        : memcmp(digest, _imageSha, sizeof(digest)) != 0 ? "SHA-256 does not match the manifest"
+                        : nullptr;
+        if (why) {
+            if (drained) {
+                _decoder.end();
+                Update.abort();
+                freeBuffers();
+            }
+            fail(why);
+            return;
+        }
+        if (!Update.end()) {   // validates the image header and switches the boot partition
+            freeBuffers();
+            fail(Update.errorString());
+            return;
+        }
+        freeBuffers();
+        uint32_t ms = millis() - _startMs;
+        uint32_t kbps = ms ? (uint32_t)((uint64_t)_received * 8 / ms) : 0;
+        uint32_t underruns = _metrics.playbackUnderruns->value() - _startUnderruns;
+        _metrics.kbps->set(kbps);
+        _metrics.underruns->set(underruns);
+        snprintf(_summary, sizeof(_summary), "OK: %u bytes received, %u written in %u ms, %u kbit/s, %u underruns",
+                 (unsigned)_received, (unsigned)_written, (unsigned)ms, (unsigned)kbps, (unsigned)underruns);
+        Serial.printf("OTA %s\n", _summary);
+        _state = Done;
+    }
+
+    void abortImage() {
+        bool drained = drain();
+        mbedtls_sha256_free(&_sha);
+        if (drained) {
+            _decoder.end();
+            Update.abort();
+            freeBuffers();
+        }
+    }
+
+    // Only once the writer has handed every buffer back; a stalled writer keeps them
+    void freeBuffers() {
+        for (int i = 0; i < OTA_BUFFERS; i++) {
+            free(_buf[i]);
+            _buf[i] = nullptr;
+        }
+    }
+
+    // Decoder sink, writer task: the image as it goes to flash
+    static bool writeOut(void* ctx, const uint8_t* data, size_t len) {
+        OtaPipeline* self = (OtaPipeline*)ctx;
+        if (self->_written + len > self->_imageSize) {
+            self->_writeError = "image larger than the manifest says";
+            return false;
+        }
+        if (Update.write((uint8_t*)data, len) != len) {
+            self->_writeError = Update.errorString();
+            return false;
+        }
+        mbedtls_sha256_update(&self->_sha, data, len);
+        self->_written += len;
+        return true;
+    }
+
+    static bool readBase(void* ctx, uint32_t offset, uint8_t* out, size_t len) {
+        OtaPipeline* self = (OtaPipeline*)ctx;
+        return self->_running && esp_partition_read(self->_running, offset, out, len) == ESP_OK;
+    }
+
+    static void writerTask(void* arg) {
+        OtaPipeline* self = (OtaPipeline*)arg;
+        Chunk c;
+        for (;;) {
+            if (xQueueReceive(self->_full, &c, portMAX_DELAY) != pdTRUE) continue;
+            if (!self->_writeFailed) {
+                uint32_t start = micros();
+                if (!self->_decoder.write(self->_buf[c.index], c.len)) {
+                    if (!self->_writeError) self->_writeError = self->_decoder.error();
+                    self->_writeFailed = true;
+                }
+                self->_metrics.writeUs->observe(micros() - start);
+            }
+            xQueueSend(self->_free, &c.index, portMAX_DELAY);
+        }
+    }
+};
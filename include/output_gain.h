@@ -0,0 +1,63 @@
+#pragma once
+
+// Digital output gain, applied in the mono-to-stereo pass that feeds I2S.
+//
+// The codec volume is set once and left alone: register writes while the
+// amplifier is on are what popped. Volume, mute and the fade at the start of
+// playback move this Q15 gain instead. A change follows a per-sample one-pole
+// (exponential) ramp with a time constant of 2^OUTPUT_GAIN_RAMP_SHIFT samples,
+// 8 ms at 16 kHz, so the DAC never sees a step. Once the ramp has settled the
+// pass is a plain copy at unity, one multiply per sample at any other level and
+// a memset when muted.
+//
+// Not thread-safe: set from loop() and applied by the playback task, both
+// under the firmware's audio lock.
+
+#include <stdint.h>
+#include <string.h>
+
+#define OUTPUT_GAIN_UNITY_Q15 32767
+#define OUTPUT_GAIN_RAMP_SHIFT 7
+#define OUTPUT_GAIN_FRAC_BITS 8        // ramp state keeps this much below Q15
+
+class OutputGain {
+public:
+    // Gain for the volume setting; the ramp starts from wherever the gain is now
+    void setLevel(uint16_t q15) { _level = q15 > OUTPUT_GAIN_UNITY_Q15 ? OUTPUT_GAIN_UNITY_Q15 : q15; }
+    void setMuted(bool muted) { _muted = muted; }
+    bool muted() const { return _muted; }
+
+    // Starts the next pass from this gain: 0 fades in from silence
+    void jump(uint16_t q15) { _g = (int32_t)q15 << OUTPUT_GAIN_FRAC_BITS; }
+
+    uint16_t target() const { return _muted ? 0 : _level; }
+    uint16_t current() const { return _g >> OUTPUT_GAIN_FRAC_BITS; }
+    bool settled() const { return _g == (int32_t)target() << OUTPUT_GAIN_FRAC_BITS; }
+
+    // mono[n] -> interleaved stereo[2n], the same gain on both channels
+    void process(const int16_t* mono, int16_t* stereo, int n) {
+        const int32_t t = (int32_t)target() << OUTPUT_GAIN_FRAC_BITS;
+        const int32_t snap = 1 << OUTPUT_GAIN_RAMP_SHIFT;
+        int i = 0;
+        for (; i < n && _g != t; i++) {
+            int32_t d = t - _g;
+            _g = (d > -snap && d < snap) ? t : _g + (d >> OUTPUT_GAIN_RAMP_SHIFT);
+            int16_t v = (mono[i] * (_g >> OUTPUT_GAIN_FRAC_BITS)) >> 15;
+            stereo[i * 2] = stereo[i * 2 + 1] = v;
+        }
+        if (i == n) return;
+        if (t == 0) {
+            memset(stereo + i * 2, 0, (n - i) * 2 * sizeof(int16_t));
+        } else if (_level == OUTPUT_GAIN_UNITY_Q15) {
+            for (; i < n; i++) stereo[i * 2] = stereo[i * 2 + 1] = mono[i];
+        } else {
+            const int32_t g = _level;
+            for (; i < n; i++) stereo[i * 2] = stereo[i * 2 + 1] = (mono[i] * g) >> 15;
+        }
+    }
+
+private:
+    uint16_t _level = OUTPUT_GAIN_UNITY_Q15;
+    bool _muted = false;
+    int32_t _g = (int32_t)OUTPUT_GAIN_UNITY_Q15 << OUTPUT_GAIN_FRAC_BITS;
+};
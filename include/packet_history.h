@@ -0,0 +1,187 @@
+#pragma once
+
+// Recent received messages kept as Opus packets in a PSRAM byte ring, for replay.
+//
+// Packets are stored as [u16 length][u16 ms since previous packet][bytes], back to
+// back, wrapping around the ring; a small table records where each stream starts
+// and ends plus who was talking. Writing past the oldest stream evicts it, so the
+// ring always holds the most recent HISTORY_BYTES of compressed audio (minutes,
+// where the same memory would hold seconds of PCM).
+//
+// Not thread-safe: the RX path and replay both run in loop().
+
+#include <Arduino.h>
+
+#ifndef HISTORY_BYTES
+#define HISTORY_BYTES (512 * 1024)     // ~4 min at Zello's usual 16 kbit/s
+#endif
+#ifndef HISTORY_FALLBACK_BYTES
+#define HISTORY_FALLBACK_BYTES (32 * 1024)   // internal RAM when there is no PSRAM
+#endif
+#define HISTORY_MAX_STREAMS 32
+
+struct HistoryStream {
+    uint32_t start;          // absolute byte positions: ring offset is pos % capacity
+    uint32_t end;
+    uint32_t startMs;        // uptime when the stream started
+    uint32_t durationMs;
+    uint16_t packets;
+    uint16_t sampleRate;
+    bool complete;           // stream stop seen
+    bool truncated;          // head evicted while still open
+    char talker[32];
+};
+
+class PacketHistory {
+public:
+    bool begin() {
+        _capacity = HISTORY_BYTES;
+        _buf = psramFound() ? (uint8_t*)ps_malloc(_capacity) : nullptr;
+        if (!_buf) {
+            _capacity = HISTORY_FALLBACK_BYTES;
+            _buf = (uint8_t*)malloc(_capacity);
+        }
+        return _buf != nullptr;
+    }
+
+    size_t capacity() const { return _capacity; }
+
+    void streamStart(const char* talker, uint16_t sampleRate) {
+        if (!_buf) return;
+        if (_open) streamStop();
+        if (_count == HISTORY_MAX_STREAMS) dropOldest();
+        HistoryStream& s = _streams[(_firstSeq + _count) % HISTORY_MAX_STREAMS];
+        memset(&s, 0, sizeof(s));
+        s.start = s.end = _writePos;
+        s.startMs = _lastPacketMs = millis();
+        s.sampleRate = sampleRate;
+        strlcpy(s.talker, talker, sizeof(s.talker));
+        _count++;
+        _open = true;
+    }
+
+    void packet(const uint8_t* data, size_t len) {
+        if (!_open || len == 0 || len + 4 > _capacity / 4) return;
+        HistoryStream& s = newestStream();
+        // Make room: evict whole older streams, or trim the head of this one
+        while (_writePos + 4 + len - oldestStart() > _capacity) {
+            if (_count > 1) {
+                dropOldest();
+            } else {
+                trimHead(s);
+            }
+        }
+        uint32_t now = millis();
+        uint32_t delta = now - _lastPacketMs;
+        _lastPacketMs = now;
+        uint8_t prefix[4] = {(uint8_t)len, (uint8_t)(len >> 8), (uint8_t)(delta > 0xFFFF ? 0xFF : delta),
+                             (uint8_t)(delta > 0xFFFF ? 0xFF : delta >> 8)};
+        write(prefix, 4);
+        write(data, len);
+        s.end = _writePos;
+        s.packets++;
+        s.durationMs += delta;
+    }
+
+    void streamStop() {
+        if (!_open) return;
+        newestStream().complete = true;
+        _open = false;
+    }
+
+    // Number of stored streams; index 0 is the newest
+    uint8_t count() const { return _count; }
+
+    bool stream(uint8_t index, HistoryStream& out) const {
+        if (index >= _count) return false;
+        out = _streams[(_firstSeq + _count - 1 - index) % HISTORY_MAX_STREAMS];
+        return true;
+    }
+
+    // Walks one stored stream packet by packet; next() returns 0 once the
+    // stream (or the part still to be read) has been evicted.
+    class Cursor {
+    public:
+        Cursor() : _history(nullptr), _seq(0), _pos(0), _end(0) {}
+
+        bool valid() const { return _history && _history->holds(_seq, _pos); }
+
+        // Copies the next packet into buf, returns its length (0 at the end)
+        size_t next(uint8_t* buf, size_t cap, uint16_t& deltaMs) {
+            if (!valid()) return 0;
+            const HistoryStream& s = _history->_streams[_seq % HISTORY_MAX_STREAMS];
+            _end = s.end;
+            if (_pos + 4 > _end) return 0;
+            uint8_t prefix[4];
+            _history->read(_pos, prefix, 4);
+            size_t len = prefix[0] | (prefix[1] << 8);
+            deltaMs = prefix[2] | (prefix[3] << 8);
+            if (len > cap || _pos + 4 + len > _end) return 0;
+            _history->read(_pos + 4, buf, len);
+            _pos += 4 + len;
+            return len;
+        }
+
+    private:
+        friend class PacketHistory;
+        const PacketHistory* _history;
+        uint32_t _seq;       // absolute stream number, survives table rotation
+        uint32_t _pos;
+        uint32_t _end;
+    };
+
+    bool open(uint8_t index, Cursor& cursor) const {
+        if (index >= _count) return false;
+        cursor._history = this;
+        cursor._seq = _firstSeq + _count - 1 - index;
+        cursor._pos = _streams[cursor._seq % HISTORY_MAX_STREAMS].start;
+        return true;
+    }
+
+private:
+    uint8_t* _buf = nullptr;
+    size_t _capacity = 0;
+    uint32_t _writePos = 0;                 // total bytes ever written
+    HistoryStream _streams[HISTORY_MAX_STREAMS];
+    uint8_t _count = 0;
+    uint32_t _firstSeq = 0;                 // absolute number of the oldest stream; slot is seq % table size
+    bool _open = false;
+    uint32_t _lastPacketMs = 0;
+
+    HistoryStream& newestStream() { return _streams[(_firstSeq + _count - 1) % HISTORY_MAX_STREAMS]; }
+    uint32_t oldestStart() const { return _count ? _streams[_firstSeq % HISTORY_MAX_STREAMS].start : _writePos; }
+
+    void dropOldest() {
+        _firstSeq++;
+        _count--;
+    }
+
+    void trimHead(HistoryStream& s) {
+        uint8_t prefix[2];
+        read(s.start, prefix, 2);
+        s.start += 4 + (prefix[0] | (prefix[1] << 8));
+        s.packets--;
+        s.truncated = true;
+    }
+
+    // Stream seq is still stored and pos has not been overwritten
+    bool holds(uint32_t seq, uint32_t pos) const {
+        if (seq < _firstSeq || seq >= _firstSeq + _count) return false;
+        return pos >= _streams[seq % HISTORY_MAX_STREAMS].start;
+    }
+
+    void write(const uint8_t* data, size_t len) {
+        size_t off = _writePos % _capacity;
+        size_t first = len < _capacity - off ? len : _capacity - off;
+        memcpy(_buf + off, data, first);
+        memcpy(_buf, data + first, len - first);
+        _writePos += len;
+    }
+
+    void read(uint32_t pos, uint8_t* out, size_t len) const {
+        size_t off = pos % _capacity;
+        size_t first = len < _capacity - off ? len : _capacity - off;
+        memcpy(out, _buf + off, first);
+        memcpy(out + first, _buf, len - first);
+    }
+};
@@ -0,0 +1,364 @@
+#pragma once
+
+// Records incoming Zello streams to flash as "capsules": the raw Opus packets
+// exactly as received, with per-packet timing and a per-stream header.
+//
+// The RX path only copies each packet into a FreeRTOS ring buffer without
+// waiting (a full ring drops the packet and counts it); a writer task on core 0
+// batches records into block-sized flash writes. Capsules are appended to a small
+// set of segment files used round-robin, so old recordings are reclaimed a whole
+// segment at a time. A fixed-slot index file maps the last REC_INDEX_SLOTS
+// streams to (segment, offset, length), so "the Nth most recent" is one lookup.
+//
+// Capsule layout (little-endian):
+//   CapsuleHeader
+//   repeated: u16 length, u16 delta ms since the previous packet, Opus bytes
+//   u16 0xFFFF, CapsuleFooter
+
+#include <SPIFFS.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "metrics.h"
+#include "task_layout.h"
+
+#ifndef REC_RING_BYTES
+#define REC_RING_BYTES 16384         // RX -> writer queue, ~2 s of typical Zello audio
+#endif
+#define REC_SEGMENTS 4
+#define REC_SEGMENT_BYTES (192 * 1024)
+#define REC_INDEX_SLOTS 64
+#define REC_BLOCK_BYTES 2048         // flash writes are batched to this size
+#define REC_MIN_FREE_BYTES (32 * 1024)
+#define REC_END_MARK 0xFFFF
+#define REC_IDLE_CLOSE_MS 3000      // closes a capsule whose stop message was lost
+
+struct __attribute__((packed)) CapsuleHeader {
+    char magic[4];          // "ZCAP"
+    uint8_t version;
+    uint8_t codecLen;
+    uint16_t reserved;
+    uint32_t seq;           // recorder-wide stream number
+    uint32_t startMs;       // uptime at stream start
+    char talker[32];
+    char streamId[12];
+    uint8_t codec[8];       // decoded codec_header from on_stream_start
+};
+
+struct __attribute__((packed)) CapsuleFooter {
+    uint32_t packets;
+    uint32_t durationMs;
+};
+
+struct RecIndexEntry {
+    uint32_t seq;           // 0 = empty slot
+    uint8_t segment;
+    uint8_t reserved;
+    uint16_t packets;
+    uint32_t offset;        // capsule start within the segment file
+    uint32_t length;
+    uint32_t startMs;
+    uint32_t durationMs;
+    char talker[32];
+};
+
+struct RecIndexHeader {
+    char magic[4];          // "ZIDX"
+    uint32_t nextSeq;       // streams recorded so far + 1
+};
+
+struct RecorderMetrics {
+    CounterMetric* payloadBytes;     // Opus bytes handed to the recorder
+    CounterMetric* flashBytes;       // bytes written to flash, capsules and index
+    CounterMetric* dropped;          // packets lost because the ring was full
+    HistogramMetric* enqueueCycles;  // RX path cost per packet
+    HistogramMetric* writeUs;        // per block flash write time
+};
+
+class StreamRecorder {
+public:
+    StreamRecorder(fs::SPIFFSFS& fs, const RecorderMetrics& metrics) : _fs(fs), _metrics(metrics) {}
+
+    bool begin() {
+        _ring = xRingbufferCreate(REC_RING_BYTES, RINGBUF_TYPE_NOSPLIT);
+        if (!_ring) return false;
+        loadIndex();
+        return xTaskCreatePinnedToCore(writerTask, "recorderTask", TASK_RECORDER_STACK, this,
+                                       TASK_HOUSEKEEPING_PRIORITY, nullptr, TASK_HOUSEKEEPING_CORE) == pdPASS;
+    }
+
+    void setEnabled(bool enabled) { _enabled = enabled; }
+    bool enabled() const { return _enabled; }
+
+    // Bytes waiting in the ring for the writer task, safe from any task
+    size_t queuedBytes() const { return _ring ? REC_RING_BYTES - xRingbufferGetCurFreeSize(_ring) : 0; }
+
+    // --- RX path: never blocks, never touches flash ---
+
+    void streamStart(const char* talker, const char* streamId, const uint8_t* codec, size_t codecLen) {
+        _active = _enabled && _ring;
+        if (!_active) return;
+        CapsuleHeader h = {};
+        memcpy(h.magic, "ZCAP", 4);
+        h.version = 1;
+        h.codecLen = codecLen < sizeof(h.codec) ? codecLen : sizeof(h.codec);
+        memcpy(h.codec, codec, h.codecLen);
+        h.startMs = millis();
+        strlcpy(h.talker, talker, sizeof(h.talker));
+        strlcpy(h.streamId, streamId, sizeof(h.streamId));
+        _lastPacketMs = h.startMs;
+        _active = send(MSG_START, &h, sizeof(h), nullptr, 0);
+    }
+
+    void packet(const uint8_t* data, size_t len) {
+        if (!_active || len == 0 || len >= REC_END_MARK) return;
+        uint32_t start = ESP.getCycleCount();
+        uint32_t now = millis();
+        uint32_t delta = now - _lastPacketMs;
+        _lastPacketMs = now;
+        uint16_t prefix[2] = {(uint16_t)len, (uint16_t)(delta > 0xFFFF ? 0xFFFF : delta)};
+        if (send(MSG_PACKET, prefix, sizeof(prefix), data, len)) {
+            _metrics.payloadBytes->inc(len);
+        } else {
+            _metrics.dropped->inc();
+        }
+        _metrics.enqueueCycles->observe(ESP.getCycleCount() - start);
+    }
+
+    void streamStop() {
+        if (!_active) return;
+        _active = false;
+        // If the ring is full the writer closes the capsule on its idle timeout instead
+        uint8_t end = MSG_END;
+        xRingbufferSend(_ring, &end, 1, 0);
+    }
+
+    // --- Index queries, safe from any task ---
+
+    // n = 0 is the most recent recording; false if there is no such recording
+    bool recent(uint32_t n, RecIndexEntry& out) {
+        portENTER_CRITICAL(&_indexMux);
+        bool ok = n < REC_INDEX_SLOTS && n + 1 < _nextSeq;
+        if (ok) {
+            out = _index[(_nextSeq - 1 - n) % REC_INDEX_SLOTS];
+            ok = out.seq == _nextSeq - 1 - n;
+        }
+        portEXIT_CRITICAL(&_indexMux);
+        return ok;
+    }
+
+    static void segmentPath(uint8_t segment, char* path, size_t cap) {
+        snprintf(path, cap, "/rec%u.zcap", (unsigned)segment);
+    }
+
+private:
+    enum MsgType : uint8_t { MSG_START = 1, MSG_PACKET = 2, MSG_END = 3 };
+
+    fs::SPIFFSFS& _fs;
+    RecorderMetrics _metrics;
+    RingbufHandle_t _ring = nullptr;
+    std::atomic<bool> _enabled{false};
+    bool _active = false;               // RX task only
+    uint32_t _lastPacketMs = 0;         // RX task only
+
+    portMUX_TYPE _indexMux = portMUX_INITIALIZER_UNLOCKED;
+    RecIndexEntry _index[REC_INDEX_SLOTS];
+    uint32_t _nextSeq = 1;
+
+    // Writer task state
+    File _file;
+    uint8_t _segment = 0;
+    uint32_t _segmentSize = 0;
+    RecIndexEntry _current;
+    uint8_t _block[REC_BLOCK_BYTES];
+    size_t _blockLen = 0;
+    uint32_t _lastItemMs = 0;
+
+    // One ring item per record: type byte, fixed prefix, payload. Zero wait.
+    bool send(MsgType type, const void* prefix, size_t prefixLen, const uint8_t* payload, size_t len) {
+        void* item = nullptr;
+        if (xRingbufferSendAcquire(_ring, &item, 1 + prefixLen + len, 0) != pdTRUE) return false;
+        uint8_t* p = (uint8_t*)item;
+        p[0] = type;
+        memcpy(p + 1, prefix, prefixLen);
+        if (len) memcpy(p + 1 + prefixLen, payload, len);
+        return xRingbufferSendComplete(_ring, item) == pdTRUE;
+    }
+
+    static void writerTask(void* arg) {
+        StreamRecorder* self = (StreamRecorder*)arg;
+        for (;;) {
+            size_t size = 0;
+            uint8_t* item = (uint8_t*)xRingbufferReceive(self->_ring, &size, pdMS_TO_TICKS(500));
+            if (!item) {
+                // Idle: get the tail of the stream onto flash, give up on a lost stop
+                self->flushBlock();
+                if (self->_file && millis() - self->_lastItemMs > REC_IDLE_CLOSE_MS) self->closeCapsule();
+                continue;
+            }
+            self->_lastItemMs = millis();
+            self->handle(item, size);
+            vRingbufferReturnItem(self->_ring, item);
+        }
+    }
+
+    void handle(const uint8_t* item, size_t size) {
+        switch (item[0]) {
+            case MSG_START:
+                if (size == 1 + sizeof(CapsuleHeader)) openCapsule((const CapsuleHeader*)(item + 1));
+                break;
+            case MSG_PACKET:
+                if (_file && size > 5) {
+                    append(item + 1, size - 1);
+                    _current.packets++;
+                    _current.durationMs += ((const uint16_t*)(item + 1))[1];
+                }
+                break;
+            case MSG_END:
+                if (_file) closeCapsule();
+                break;
+        }
+    }
+
+    void openCapsule(const CapsuleHeader* src) {
+        if (_file) closeCapsule();   // previous stop was lost
+        if (_segmentSize >= REC_SEGMENT_BYTES) {
+            _segment = (_segment + 1) % REC_SEGMENTS;
+            _segmentSize = 0;
+            char path[20];
+            segmentPath(_segment, path, sizeof(path));
+            _fs.remove(path);
+            dropSegmentFromIndex(_segment);
+        }
+        if (_fs.totalBytes() - _fs.usedBytes() < REC_MIN_FREE_BYTES) {
+            _metrics.dropped->inc();
+            return;
+        }
+        char path[20];
+        segmentPath(_segment, path, sizeof(path));
+        _file = _fs.open(path, FILE_APPEND);
+        if (!_file) return;
+        _segmentSize = _file.size();
+
+        CapsuleHeader h = *src;
+        h.seq = _nextSeq;
+        _current = {};
+        _current.seq = h.seq;
+        _current.segment = _segment;
+        _current.offset = _segmentSize;
+        _current.startMs = h.startMs;
+        memcpy(_current.talker, h.talker, sizeof(_current.talker));
+        append(&h, sizeof(h));
+    }
+
+    void closeCapsule() {
+        uint16_t mark = REC_END_MARK;
+        append(&mark, sizeof(mark));
+        CapsuleFooter footer = {_current.packets, _current.durationMs};
+        append(&footer, sizeof(footer));
+        flushBlock();
+        _file.close();
+        _current.length = _segmentSize - _current.offset;
+        writeIndexEntry(_current);
+    }
+
+    void append(const void* data, size_t len) {
+        const uint8_t* p = (const uint8_t*)data;
+        while (len) {
+            size_t n = REC_BLOCK_BYTES - _blockLen;
+            if (n > len) n = len;
+            memcpy(_block + _blockLen, p, n);
+            _blockLen += n;
+            p += n;
+            len -= n;
+            if (_blockLen == REC_BLOCK_BYTES) flushBlock();
+        }
+    }
+
+    void flushBlock() {
+        if (!_blockLen || !_file) return;
+        uint32_t start = micros();
+        size_t written = _file.write(_block, _blockLen);
+        _file.flush();
+        _metrics.writeUs->observe(micros() - start);
+        _metrics.flashBytes->inc(written);
+        _segmentSize += written;
+        _blockLen = 0;
+    }
+
+    void loadIndex() {
+        memset(_index, 0, sizeof(_index));
+        File f = _fs.open("/rec.idx", FILE_READ);
+        RecIndexHeader h;
+        if (f && f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && memcmp(h.magic, "ZIDX", 4) == 0 &&
+            f.read((uint8_t*)_index, sizeof(_index)) == sizeof(_index)) {
+            _nextSeq = h.nextSeq;
+        } else {
+            _nextSeq = 1;
+            memset(_index, 0, sizeof(_index));
+        }
+        if (f) f.close();
+        // Keep appending to the segment holding the newest capsule
+        if (_nextSeq > 1) {
+            const RecIndexEntry& last = _index[(_nextSeq - 1) % REC_INDEX_SLOTS];
+            _segment = last.segment;
+            _segmentSize = last.offset + last.length;
+        }
+    }
+
+    // Rewrites one slot and the header in place; the index file never grows
+    void writeIndexEntry(const RecIndexEntry& entry) {
+        uint32_t slot = entry.seq % REC_INDEX_SLOTS;
+        portENTER_CRITICAL(&_indexMux);
+        _index[slot] = entry;
+        _nextSeq = entry.seq + 1;
+        portEXIT_CRITICAL(&_indexMux);
+
+        File f = _fs.open("/rec.idx", _fs.exists("/rec.idx") ? "r+" : "w+");
+        if (!f) return;
+        if (f.size() < sizeof(RecIndexHeader) + sizeof(_index)) {
+            writeIndexFile(f);
+        } else {
+            RecIndexHeader h;
+            memcpy(h.magic, "ZIDX", 4);
+            h.nextSeq = _nextSeq;
+            f.seek(0);
+            f.write((const uint8_t*)&h, sizeof(h));
+            f.seek(sizeof(h) + slot * sizeof(RecIndexEntry));
+            f.write((const uint8_t*)&entry, sizeof(entry));
+            _metrics.flashBytes->inc(sizeof(h) + sizeof(entry));
+        }
+        f.close();
+    }
+
+    void writeIndexFile(File& f) {
+        RecIndexHeader h;
+        memcpy(h.magic, "ZIDX", 4);
+        h.nextSeq = _nextSeq;
+        f.seek(0);
+        f.write((const uint8_t*)&h, sizeof(h));
+        f.write((const uint8_t*)_index, sizeof(_index));
+        _metrics.flashBytes->inc(sizeof(h) + sizeof(_index));
+    }
+
+    // A reclaimed segment takes its capsules with it
+    void dropSegmentFromIndex(uint8_t segment) {
+        bool changed = false;
+        portENTER_CRITICAL(&_indexMux);
+        for (uint32_t i = 0; i < REC_INDEX_SLOTS; i++) {
+            if (_index[i].seq && _index[i].segment == segment) {
+                _index[i].seq = 0;
+                changed = true;
+            }
+        }
+        portEXIT_CRITICAL(&_indexMux);
+        if (!changed) return;
+        File f = _fs.open("/rec.idx", "w");
+        if (f) {
+            writeIndexFile(f);
+            f.close();
+        }
+    }
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+// Per-stream loudness normalization for the channel mixer, in fixed point.
+//
+// Three gains per stream, combined with the mixer's duck gain into one target per
+// 10 ms mix block and ramped linearly across it:
+//   AGC         moves the stream's RMS towards AGC_TARGET_RMS within -12..+18 dB.
+//               It falls a quarter of the way per block (~40 ms) and rises 1/64
+//               of the way (~0.6 s), and holds below AGC_GATE_RMS so pauses and
+//               background noise are not pumped up.
+//   compressor  2:1 above AGC_COMP_THRESHOLD_RMS, for syllables the AGC is too
+//               slow for.
+//   limiter     look-ahead: the block after the one being mixed is already in the
+//               stream's FIFO, so the ramp reaches a peak's limit before the peak
+//               does and no sample of the stream exceeds AGC_CEILING. This adds
+//               no latency; the jitter buffer is the look-ahead. A sped-up block
+//               (replay, backlog) skips ahead, so the mixer limits on the samples
+//               it actually read and looks ahead over the stretch's whole input.
+// AGC and compressor act on the RMS of the previous block, measured while mixing.
+//
+// The AGC gain is remembered per talker (the Zello `from`) in a small LRU table,
+// so their next transmission starts at their level instead of ramping to it.
+//
+// Gains are Q12 (4096 = unity, up to x8); ramps run in Q24.
+
+#include <stdint.h>
+#include <string.h>
+
+#define AGC_UNITY_Q12 4096
+#define AGC_MIN_Q12 1024               // -12 dB
+#define AGC_MAX_Q12 32767              // +18 dB
+#define AGC_TARGET_RMS 3277            // -20 dBFS
+#define AGC_GATE_RMS 328               // -40 dBFS
+#define AGC_COMP_THRESHOLD_RMS 6538    // -14 dBFS, after the AGC
+#define AGC_CEILING 29204              // -1 dBFS, per stream
+#define AGC_ATTACK_SHIFT 2
+#define AGC_RELEASE_SHIFT 6
+#define AGC_MEMORY_SLOTS 16
+
+static inline uint32_t agcIsqrt(uint32_t v) {
+    uint32_t root = 0;
+    for (uint32_t bit = 1u << 30; bit; bit >>= 2) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    return root;
+}
+
+struct StreamAgc {
+    int32_t agcQ12;
+    int32_t compQ12;
+    bool adapted;                      // saw speech: worth remembering
+
+    void begin(int32_t startQ12) {
+        agcQ12 = startQ12;
+        compQ12 = AGC_UNITY_Q12;
+        adapted = false;
+    }
+
+    // Block gain before the limiter: duck x AGC x compressor
+    int32_t targetQ12(int32_t duckQ12) const {
+        return (((duckQ12 * agcQ12) >> 12) * compQ12) >> 12;
+    }
+
+    // Highest gain that keeps a block with this peak under the ceiling
+    static int32_t limitQ12(int32_t peak, int32_t gainQ12) {
+        if (peak * gainQ12 <= AGC_CEILING << 12) return gainQ12;
+        return (AGC_CEILING << 12) / peak;
+    }
+
+    // After a block: sumSquares of its n input samples
+    void update(uint64_t sumSquares, int n) {
+        if (n <= 0) return;
+        int32_t rms = agcIsqrt((uint32_t)(sumSquares / n));
+        if (rms < AGC_GATE_RMS) return;
+        adapted = true;
+        int32_t desired = (AGC_TARGET_RMS << 12) / rms;
+        if (desired < AGC_MIN_Q12) desired = AGC_MIN_Q12;
+        if (desired > AGC_MAX_Q12) desired = AGC_MAX_Q12;
+        int32_t d = desired - agcQ12;
+        agcQ12 += d < 0 ? d >> AGC_ATTACK_SHIFT : d >> AGC_RELEASE_SHIFT;
+        int32_t out = (rms * agcQ12) >> 12;
+        // 2:1 above the threshold: gain = sqrt(threshold / level)
+        compQ12 = out > AGC_COMP_THRESHOLD_RMS
+                      ? agcIsqrt((uint32_t)(((uint64_t)AGC_COMP_THRESHOLD_RMS << 24) / out))
+                      : AGC_UNITY_Q12;
+    }
+};
+
+// AGC gain per talker name, least recently used entry replaced
+class TalkerGainMemory {
+public:
+    int32_t recall(const char* talker) {
+        Entry* e = find(hash(talker));
+        if (!e) return AGC_UNITY_Q12;
+        e->lastUse = ++_clock;
+        return e->gainQ12;
+    }
+
+    void store(const char* talker, int32_t gainQ12) {
+        uint32_t h = hash(talker);
+        Entry* e = find(h);
+        if (!e) {
+            e = &_entries[0];
+            for (int i = 1; i < AGC_MEMORY_SLOTS; i++) {
+                if ((int32_t)(_entries[i].lastUse - e->lastUse) < 0) e = &_entries[i];
+            }
+            e->hash = h;
+        }
+        e->gainQ12 = gainQ12;
+        e->lastUse = ++_clock;
+    }
+
+private:
+    struct Entry {
+        uint32_t hash = 0;             // 0 = empty
+        int32_t gainQ12 = AGC_UNITY_Q12;
+        uint32_t lastUse = 0;
+    };
+    Entry _entries[AGC_MEMORY_SLOTS];
+    uint32_t _clock = 0;
+
+    // FNV-1a; never 0, so 0 can mark an empty entry
+    static uint32_t hash(const char* s) {
+        uint32_t h = 2166136261u;
+        while (s && *s) h = (h ^ (uint8_t)*s++) * 16777619u;
+        return h ? h : 1;
+    }
+
+    Entry* find(uint32_t h) {
+        for (int i = 0; i < AGC_MEMORY_SLOTS; i++) {
+            if (_entries[i].hash == h) return &_entries[i];
+        }
+        return nullptr;
+    }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+// Helpers for handing state between FreeRTOS tasks without sharing live objects.
+
+// Latest-value mailbox: the owner task publishes a copy, other tasks read a copy.
+// Keep T small and trivially copyable, the copy runs inside a critical section.
+template <typename T>
+class SharedSnapshot {
+public:
+    void publish(const T& value) {
+        portENTER_CRITICAL(&_mux);
+        _value = value;
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    T read() {
+        portENTER_CRITICAL(&_mux);
+        T copy = _value;
+        portEXIT_CRITICAL(&_mux);
+        return copy;
+    }
+
+private:
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    T _value = {};
+};
+
+// Fixed-depth command queue; post() does not block unless given a wait,
+// receive() is polled by the owner task.
+template <typename T, size_t DEPTH>
+class CommandQueue {
+public:
+    bool begin() {
+        if (!_queue) _queue = xQueueCreate(DEPTH, sizeof(T));
+        return _queue != nullptr;
+    }
+
+    bool post(const T& cmd, TickType_t wait = 0) {
+        return _queue && xQueueSend(_queue, &cmd, wait) == pdTRUE;
+    }
+
+    bool receive(T& cmd) {
+        return _queue && xQueueReceive(_queue, &cmd, 0) == pdTRUE;
+    }
+
+    // The next command without taking it off the queue
+    bool peek(T& cmd) {
+        return _queue && xQueuePeek(_queue, &cmd, 0) == pdTRUE;
+    }
+
+    size_t pending() const {
+        return _queue ? uxQueueMessagesWaiting(_queue) : 0;
+    }
+
+private:
+    QueueHandle_t _queue = nullptr;
+};
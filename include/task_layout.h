@@ -0,0 +1,110 @@
+#pragma once
+
+// Where every task of the firmware runs: core, priority and stack budget.
+//
+// Core 1 carries the audio path, highest priority first:
+//   playback   mixes the streams and keeps the I2S DMA ring full, every few ms
+//   capture    microphone, echo cancelling, noise suppression, Opus encode (TX)
+//   network    the Arduino loop(): WebSocket I/O, packet decode into the mixer,
+//              stream bookkeeping, dashboard commands
+// so a slow WebSocket read or a reconnect delays decoding, never the output.
+// Playback and network hand the mixer over with AudioDeviceLock (main.cpp).
+//
+// Core 0 has Wi-Fi and lwIP (placed by the SDK) and, below them, the button
+// handler and the housekeeping tasks: HTTP server (async_tcp, sized in
+// platformio.ini), dashboard telemetry, recorder and OTA flash writers, log output.
+//
+// Stack budgets are bytes (ESP-IDF counts stacks in bytes); /api/tasks shows
+// each task's high-water mark against them. Any of these may be overridden
+// with a build flag.
+
+#include <stdint.h>
+
+#ifndef TASK_PLAYBACK_CORE
+#define TASK_PLAYBACK_CORE 1
+#endif
+#ifndef TASK_PLAYBACK_PRIORITY
+#define TASK_PLAYBACK_PRIORITY 4
+#endif
+#ifndef TASK_PLAYBACK_STACK
+#define TASK_PLAYBACK_STACK 4096
+#endif
+
+#ifndef TASK_CAPTURE_CORE
+#define TASK_CAPTURE_CORE 1
+#endif
+#ifndef TASK_CAPTURE_PRIORITY
+#define TASK_CAPTURE_PRIORITY 3
+#endif
+#ifndef TASK_CAPTURE_STACK
+#define TASK_CAPTURE_STACK 6144          // opus_encode() (SILK) alone takes ~3 KB
+#endif
+
+#ifndef TASK_NETWORK_PRIORITY
+#define TASK_NETWORK_PRIORITY 2          // loopTask: its core and stack are the Arduino core's
+#endif
+#ifndef TASK_NETWORK_STACK
+#define TASK_NETWORK_STACK 8192          // CONFIG_ARDUINO_LOOP_STACK_SIZE
+#endif
+
+#ifndef TASK_INPUT_CORE
+#define TASK_INPUT_CORE 0
+#endif
+#ifndef TASK_INPUT_PRIORITY
+#define TASK_INPUT_PRIORITY 3
+#endif
+#ifndef TASK_INPUT_STACK
+#define TASK_INPUT_STACK 3072
+#endif
+
+#ifndef TASK_HOUSEKEEPING_CORE
+#define TASK_HOUSEKEEPING_CORE 0
+#endif
+#ifndef TASK_HOUSEKEEPING_PRIORITY
+#define TASK_HOUSEKEEPING_PRIORITY 1
+#endif
+#ifndef TASK_TELEMETRY_STACK
+#define TASK_TELEMETRY_STACK 4096
+#endif
+#ifndef TASK_RECORDER_STACK
+#define TASK_RECORDER_STACK 4096
+#endif
+#ifndef TASK_OTA_STACK
+#define TASK_OTA_STACK 4096
+#endif
+#ifndef TASK_LOG_STACK
+#define TASK_LOG_STACK 3072
+#endif
+#ifndef TASK_LOG_PRIORITY
+#define TASK_LOG_PRIORITY 1              // tskIDLE_PRIORITY + 1: a slow UART only delays the log
+#endif
+
+struct TaskSpec {
+    const char* name;       // as passed to xTaskCreate
+    const char* role;
+    int8_t core;            // -1: not pinned
+    uint8_t priority;
+    uint16_t stack;         // bytes
+};
+
+static const TaskSpec TASK_LAYOUT[] = {
+    {"playbackTask", "playback", TASK_PLAYBACK_CORE, TASK_PLAYBACK_PRIORITY, TASK_PLAYBACK_STACK},
+    {"audioTxTask", "capture", TASK_CAPTURE_CORE, TASK_CAPTURE_PRIORITY, TASK_CAPTURE_STACK},
+    {"loopTask", "network", 1, TASK_NETWORK_PRIORITY, TASK_NETWORK_STACK},
+    {"inputTask", "buttons", TASK_INPUT_CORE, TASK_INPUT_PRIORITY, TASK_INPUT_STACK},
+    {"telemetryTask", "housekeeping", TASK_HOUSEKEEPING_CORE, TASK_HOUSEKEEPING_PRIORITY, TASK_TELEMETRY_STACK},
+    {"recorderTask", "housekeeping", TASK_HOUSEKEEPING_CORE, TASK_HOUSEKEEPING_PRIORITY, TASK_RECORDER_STACK},
+    {"otaTask", "housekeeping", TASK_HOUSEKEEPING_CORE, TASK_HOUSEKEEPING_PRIORITY, TASK_OTA_STACK},
+    {"binlogTask", "housekeeping", TASK_HOUSEKEEPING_CORE, TASK_LOG_PRIORITY, TASK_LOG_STACK},
+};
+
+// The layout entry for a task name, nullptr for the SDK's own tasks
+inline const TaskSpec* findTaskSpec(const char* name) {
+    for (const TaskSpec& spec : TASK_LAYOUT) {
+        const char* a = spec.name;
+        const char* b = name;
+        while (*a && *a == *b) a++, b++;
+        if (!*a && !*b) return &spec;
+    }
+    return nullptr;
+}
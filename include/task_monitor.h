@@ -0,0 +1,101 @@
+#pragma once
+
+// Per-task CPU load and stack headroom, for /api/tasks.
+//
+// sample() reads every task's state with uxTaskGetSystemState(). CPU load is the
+// task's run-time counter delta over the timer delta since the previous sample,
+// in permille of one core; a core's load is 1000 minus its idle task's. That
+// needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS in the sdkconfig, which the
+// prebuilt Arduino core leaves off: without it cpu is -1 and only stacks and
+// priorities are reported. Stack high-water marks are bytes never touched
+// (ESP-IDF counts stacks in bytes), next to the budget in task_layout.h.
+//
+// Not thread-safe: one task samples (the HTTP server's).
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "task_layout.h"
+
+#define TASK_MONITOR_MAX_TASKS 24
+
+struct TaskStat {
+    char name[configMAX_TASK_NAME_LEN];
+    int8_t core;              // -1: runs on either
+    uint8_t priority;
+    int16_t cpuPermille;      // of one core since the last sample, -1 if unknown
+    uint32_t stackFree;       // bytes never used
+    const TaskSpec* spec;     // nullptr for the SDK's tasks
+};
+
+class TaskMonitor {
+public:
+    // Fills up to max entries, in the order the scheduler lists them; returns the count
+    int sample(TaskStat* out, int max) {
+#if configUSE_TRACE_FACILITY
+        uint32_t total = 0;
+        int n = uxTaskGetSystemState(_status, TASK_MONITOR_MAX_TASKS, &total);
+        uint32_t elapsed = total - _lastTotal;
+        bool timed = RUN_TIME_STATS && _lastTotal != 0 && elapsed != 0;
+        _coreLoad[0] = _coreLoad[1] = -1;
+        int count = 0;
+        for (int i = 0; i < n; i++) {
+            const TaskStatus_t& st = _status[i];
+            uint32_t delta = st.ulRunTimeCounter - previous(st.xHandle);
+            uint64_t permille = (uint64_t)delta * 1000 / (elapsed ? elapsed : 1);
+            int16_t cpu = timed ? (int16_t)(permille < 1000 ? permille : 1000) : -1;
+            BaseType_t affinity = xTaskGetAffinity(st.xHandle);
+            int8_t core = affinity == tskNO_AFFINITY ? -1 : (int8_t)affinity;
+            if (timed && core >= 0 && core < 2 && strncmp(st.pcTaskName, "IDLE", 4) == 0) {
+                _coreLoad[core] = 1000 - cpu;
+            }
+            if (count < max) {
+                TaskStat& t = out[count++];
+                strlcpy(t.name, st.pcTaskName, sizeof(t.name));
+                t.core = core;
+                t.priority = (uint8_t)st.uxCurrentPriority;
+                t.cpuPermille = cpu;
+                t.stackFree = st.usStackHighWaterMark;
+                t.spec = findTaskSpec(st.pcTaskName);
+            }
+        }
+        // Remembered after the pass: previous() looks up the last sample's counters
+        for (int i = 0; i < n; i++) {
+            _lastHandle[i] = _status[i].xHandle;
+            _lastRunTime[i] = _status[i].ulRunTimeCounter;
+        }
+        _lastCount = n;
+        _lastTotal = total;
+        return count;
+#else
+        return 0;
+#endif
+    }
+
+    // Load of core 0 or 1 over the last sample, permille; -1 if unknown
+    int16_t coreLoad(int core) const { return _coreLoad[core]; }
+
+private:
+#if defined(configGENERATE_RUN_TIME_STATS) && configGENERATE_RUN_TIME_STATS
+    static const bool RUN_TIME_STATS = true;
+#else
+    static const bool RUN_TIME_STATS = false;
+#endif
+
+#if configUSE_TRACE_FACILITY
+    TaskStatus_t _status[TASK_MONITOR_MAX_TASKS];
+#endif
+    TaskHandle_t _lastHandle[TASK_MONITOR_MAX_TASKS];
+    uint32_t _lastRunTime[TASK_MONITOR_MAX_TASKS];
+    int _lastCount = 0;
+    uint32_t _lastTotal = 0;
+    int16_t _coreLoad[2] = {-1, -1};
+
+    // The task's counter at the last sample; 0 for a task new since then
+    uint32_t previous(TaskHandle_t handle) const {
+        for (int i = 0; i < _lastCount; i++) {
+            if (_lastHandle[i] == handle) return _lastRunTime[i];
+        }
+        return 0;
+    }
+};
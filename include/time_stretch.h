@@ -0,0 +1,92 @@
+#pragma once
+
+// Time-scale compression by WSOLA (waveform-similarity overlap-add): plays
+// audio up to STRETCH_MAX_SPEED faster without raising its pitch.
+//
+// process() turns a little more than STRETCH_SEGMENT_SAMPLES of input into
+// exactly that much output. While the speed has built up enough input to skip,
+// the output crossfades from the input's natural continuation (in[0..]) into
+// the segment 'lag' samples further on, and lag samples are dropped. The lag is
+// searched around what the speed has built up (within STRETCH_SEARCH_SAMPLES)
+// for the segment most like the continuation: normalized cross-correlation on
+// every STRETCH_DECIMATE-th sample, which lands on whole pitch periods in voice,
+// so the crossfade joins two waveforms in phase. Whatever a skip takes more or
+// less than was built up carries over, so the average speed is exact.
+// At 100% nothing is searched and the input is copied.
+//
+// Integer arithmetic apart from one float division per candidate lag; the
+// search is at most 2 * STRETCH_SEARCH_SAMPLES + 1 lags of
+// STRETCH_SEGMENT_SAMPLES / STRETCH_DECIMATE products. Cost per output sample
+// is in tools/dsp_bench.cpp.
+
+#include <stdint.h>
+#include <string.h>
+
+#define STRETCH_SEGMENT_SAMPLES 160   // 10 ms of output per call, crossfaded whole
+#define STRETCH_MIN_LAG 40            // 2.5 ms: the shortest pitch period looked for
+#define STRETCH_MAX_LAG 320           // 20 ms: the longest
+#define STRETCH_SEARCH_SAMPLES 80     // how far a skip may stray from what is due
+#define STRETCH_DECIMATE 2
+#define STRETCH_MAX_SPEED 150         // percent
+// Input that lets process() search its full range at any speed
+#define STRETCH_MAX_INPUT (STRETCH_MAX_LAG + STRETCH_SEGMENT_SAMPLES)
+
+class TimeStretch {
+public:
+    void reset() { _due = 0; }
+
+    // STRETCH_SEGMENT_SAMPLES of output from in[0..avail) at speed percent (100 to
+    // STRETCH_MAX_SPEED); returns the input used. Fewer than
+    // STRETCH_SEGMENT_SAMPLES + STRETCH_MIN_LAG samples are copied as they are;
+    // avail must be at least STRETCH_SEGMENT_SAMPLES.
+    int process(const int16_t* in, int avail, int16_t* out, uint16_t speed) {
+        const int n = STRETCH_SEGMENT_SAMPLES;
+        if (speed > STRETCH_MAX_SPEED) speed = STRETCH_MAX_SPEED;
+        if (speed <= 100) _due = 0;
+        _due += n * (speed - 100) / 100;
+        if (_due > STRETCH_MAX_LAG) _due = STRETCH_MAX_LAG;
+        int lag = _due >= STRETCH_MIN_LAG ? bestLag(in, avail) : 0;
+        if (!lag) {
+            memcpy(out, in, n * sizeof(int16_t));
+            return n;
+        }
+        // Linear crossfade from the continuation into the matched segment
+        for (int i = 0; i < n; i++) {
+            out[i] = (int16_t)((in[i] * (n - i) + in[lag + i] * i) / n);
+        }
+        _due -= lag;
+        return lag + n;
+    }
+
+private:
+    int _due = 0;   // samples the speed has asked to skip and no skip has taken yet
+
+    // The lag in range whose segment best continues in[0..]; in silence or noise,
+    // where nothing does, the one due. 0 when there is not enough input.
+    int bestLag(const int16_t* in, int avail) const {
+        const int n = STRETCH_SEGMENT_SAMPLES;
+        int lo = _due - STRETCH_SEARCH_SAMPLES, hi = _due + STRETCH_SEARCH_SAMPLES;
+        if (lo < STRETCH_MIN_LAG) lo = STRETCH_MIN_LAG;
+        if (hi > STRETCH_MAX_LAG) hi = STRETCH_MAX_LAG;
+        if (hi > avail - n) hi = avail - n;
+        if (hi < lo) return 0;
+        int best = _due < lo ? lo : _due > hi ? hi : _due;
+        float bestScore = 0;
+        for (int lag = lo; lag <= hi; lag++) {
+            int64_t corr = 0, energy = 0;
+            for (int i = 0; i < n; i += STRETCH_DECIMATE) {
+                int32_t y = in[lag + i];
+                corr += in[i] * y;
+                energy += y * y;
+            }
+            if (corr <= 0) continue;
+            // corr / sqrt(energy), squared; the continuation's own energy is the same for every lag
+            float score = (float)corr * (float)corr / (float)energy;
+            if (score > bestScore) {
+                bestScore = score;
+                best = lag;
+            }
+        }
+        return best;
+    }
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+// Tones and cues (startup, talk permit, roger, end of message, connect,
+// disconnect, error), synthesized by direct digital synthesis.
+//
+// Each tone is a 32-bit phase accumulator stepping through a 256-entry sine
+// table with linear interpolation (error about -78 dB against an exact sine),
+// at whatever rate the caller renders at.
+// Every step of a cue ramps in and out over TONE_RAMP_MS so it starts and ends
+// without a click, and may carry a second tone for dual-tone cues.
+//
+// render() adds the cue into a block that is about to be played or encoded,
+// saturating; it is the only per-sample work and costs a few multiplies per
+// sample. play() may be called from any task: requests are bits in an atomic
+// word that render() picks up, lowest Cue first, once the current cue is done.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+
+#define TONE_LUT_BITS 8
+#define TONE_LUT_SIZE (1 << TONE_LUT_BITS)
+#define TONE_RAMP_MS 5
+#define TONE_MAX_STEPS 4
+
+enum class Cue : uint8_t {
+    Startup,
+    TalkPermit,
+    Roger,
+    EndOfMessage,
+    Connected,
+    Disconnected,
+    Error,
+    Count
+};
+
+struct ToneStep {
+    uint16_t hz;         // 0: a pause
+    uint16_t hz2;        // second tone of a dual-tone step, 0: none
+    uint16_t ms;
+    uint16_t levelQ15;   // of the generator's level, each tone
+};
+
+struct ToneCue {
+    uint8_t steps;
+    ToneStep step[TONE_MAX_STEPS];
+};
+
+// Indexed by Cue
+static const ToneCue TONE_CUES[(int)Cue::Count] = {
+    {3, {{523, 0, 90, 32767}, {659, 0, 90, 32767}, {784, 0, 140, 32767}}},   // Startup: C-E-G
+    {3, {{1000, 0, 50, 32767}, {0, 0, 40, 0}, {1000, 0, 50, 32767}}},       // TalkPermit
+    {2, {{1200, 0, 70, 32767}, {1600, 0, 90, 32767}}},                     // Roger
+    {1, {{660, 0, 80, 26000}}},                                            // EndOfMessage
+    {2, {{660, 0, 70, 32767}, {880, 0, 90, 32767}}},                       // Connected
+    {2, {{880, 0, 70, 32767}, {660, 0, 110, 32767}}},                      // Disconnected
+    {3, {{350, 440, 150, 20000}, {0, 0, 60, 0}, {350, 440, 150, 20000}}},  // Error: dual tone, twice
+};
+
+class ToneGenerator {
+public:
+    // Sets the level a full-scale step plays at; the first call builds the sine table
+    void begin(uint16_t levelQ15) {
+        _lut = SineTable::get().v;
+        _level = levelQ15;
+    }
+
+    // Any task: the cue plays once the one playing now (if any) has ended
+    void play(Cue cue) { _pending.fetch_or(1u << (int)cue, std::memory_order_relaxed); }
+
+    // The render side only: drops the cue playing and all requested ones
+    void stop() {
+        _pending.store(0, std::memory_order_relaxed);
+        _cue = nullptr;
+    }
+
+    bool active() const { return _cue || _pending.load(std::memory_order_relaxed); }
+
+    // Adds the next n samples of cue audio at rate Hz into pcm; false once idle
+    bool render(int16_t* pcm, int n, uint32_t rate) {
+        if (!_lut) return false;   // before begin()
+        int i = 0;
+        while (i < n) {
+            if (!_cue && !next(rate)) return i > 0;
+            const ToneStep& s = _cue->step[_stepIndex];
+            int chunk = n - i < (int)_left ? n - i : (int)_left;
+            if (s.hz) {
+                uint32_t inc = (uint32_t)(((uint64_t)s.hz << 32) / rate);
+                uint32_t inc2 = (uint32_t)(((uint64_t)s.hz2 << 32) / rate);
+                int32_t gain = (int32_t)(((int64_t)s.levelQ15 * _level) >> 15);
+                uint32_t ramp = (uint32_t)rate * TONE_RAMP_MS / 1000;
+                for (int k = 0; k < chunk; k++) {
+                    uint32_t pos = _length - _left + k;
+                    uint32_t edge = pos < _length - 1 - pos ? pos : _length - 1 - pos;
+                    int32_t env = edge >= ramp ? gain : (int32_t)((int64_t)gain * edge / ramp);
+                    int32_t v = sine(_phase);
+                    _phase += inc;
+                    if (inc2) {
+                        v = (v + sine(_phase2)) >> 1;
+                        _phase2 += inc2;
+                    }
+                    v = pcm[i + k] + ((v * env) >> 15);
+                    pcm[i + k] = v > 32767 ? 32767 : v < -32768 ? -32768 : v;
+                }
+            }
+            i += chunk;
+            _left -= chunk;
+            if (!_left && ++_stepIndex < _cue->steps) {
+                start(rate);
+            } else if (!_left) {
+                _cue = nullptr;
+            }
+        }
+        return true;
+    }
+
+private:
+    // A whole period, plus the first entry again for the interpolation
+    struct SineTable {
+        int16_t v[TONE_LUT_SIZE + 1];
+        SineTable() {
+            for (int i = 0; i <= TONE_LUT_SIZE; i++) v[i] = (int16_t)lrint(32767.0 * sin(2 * M_PI * i / TONE_LUT_SIZE));
+        }
+        static const SineTable& get() {
+            static const SineTable table;
+            return table;
+        }
+    };
+
+    const int16_t* _lut = nullptr;
+    std::atomic<uint32_t> _pending{0};
+    const ToneCue* _cue = nullptr;
+    uint8_t _stepIndex = 0;
+    uint32_t _length = 0;       // samples in the current step
+    uint32_t _left = 0;
+    uint32_t _phase = 0, _phase2 = 0;
+    uint16_t _level = 0;
+
+    inline int32_t sine(uint32_t phase) const {
+        uint32_t index = phase >> (32 - TONE_LUT_BITS);
+        int32_t frac = (phase >> (32 - TONE_LUT_BITS - 15)) & 0x7fff;
+        int32_t a = _lut[index];
+        return a + (((_lut[index + 1] - a) * frac) >> 15);
+    }
+
+    // Takes the lowest requested cue
+    bool next(uint32_t rate) {
+        uint32_t pending = _pending.load(std::memory_order_relaxed);
+        if (!pending) return false;
+        int cue = __builtin_ctz(pending);
+        _pending.fetch_and(~(1u << cue), std::memory_order_relaxed);
+        _cue = &TONE_CUES[cue];
+        _stepIndex = 0;
+        start(rate);
+        return true;
+    }
+
+    void start(uint32_t rate) {
+        _length = (uint32_t)_cue->step[_stepIndex].ms * rate / 1000;
+        if (!_length) _length = 1;
+        _left = _length;
+        _phase = _phase2 = 0;
+    }
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+// Hot-path tracing into per-core rings, timestamped with the CPU cycle counter.
+//
+// Enabled with -DZELLO_TRACE=1; without it every TRACE_* macro compiles to nothing.
+// Recording an event is one atomic slot claim plus an 8 byte store, no locks and
+// no I/O, so it can stay in the audio path. /debug/trace dumps the rings as Chrome
+// trace_event JSON (open in chrome://tracing or ui.perfetto.dev).
+
+#include <stdint.h>
+
+enum TraceId : uint8_t {
+    TRACE_PACKET_RX,
+    TRACE_DECODE,
+    TRACE_DSP,
+    TRACE_I2S_WRITE,
+    TRACE_ENCODE,
+    TRACE_SEND,
+    TRACE_ID_COUNT
+};
+
+static const char* const TRACE_NAMES[TRACE_ID_COUNT] = {
+    "packet_rx", "decode", "dsp", "i2s_write", "encode", "send"
+};
+
+#if ZELLO_TRACE
+
+#include <atomic>
+#include <xtensa/hal.h>
+#include "freertos/FreeRTOS.h"
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 1024   // events per core, must be a power of two
+#endif
+
+struct TraceEvent {
+    uint32_t ccount;
+    uint8_t id;
+    uint8_t phase;   // 'B' or 'E'
+    uint16_t reserved;
+};
+
+struct TraceRing {
+    std::atomic<uint32_t> head;   // total events ever claimed on this core
+    TraceEvent events[TRACE_RING_SIZE];
+};
+
+extern TraceRing traceRings[portNUM_PROCESSORS];
+
+// Each core has its own ring; claiming the slot atomically keeps tasks that
+// preempt each other on the same core from overwriting one another.
+static inline void traceRecord(TraceId id, uint8_t phase) {
+    uint32_t ccount = xthal_get_ccount();
+    TraceRing& ring = traceRings[xPortGetCoreID()];
+    uint32_t slot = ring.head.fetch_add(1, std::memory_order_relaxed) & (TRACE_RING_SIZE - 1);
+    TraceEvent& ev = ring.events[slot];
+    ev.ccount = ccount;
+    ev.id = id;
+    ev.phase = phase;
+}
+
+struct TraceScope {
+    TraceId id;
+    explicit TraceScope(TraceId id) : id(id) { traceRecord(id, 'B'); }
+    ~TraceScope() { traceRecord(id, 'E'); }
+};
+
+#define TRACE_BEGIN(id) traceRecord((id), 'B')
+#define TRACE_END(id) traceRecord((id), 'E')
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(id) TraceScope TRACE_CONCAT(_traceScope, __LINE__)(id)
+
+#else
+
+#define TRACE_BEGIN(id) ((void)0)
+#define TRACE_END(id) ((void)0)
+#define TRACE_SCOPE(id) ((void)0)
+
+#endif
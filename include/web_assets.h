@@ -0,0 +1,323 @@
+// Generated by tools/embed_web_assets.py from web/ - do not edit
+#pragma once
+
+#include <Arduino.h>
+
+struct WebAsset {
+    const char* path;
+    const char* contentType;
+    const uint8_t* data;   // gzip compressed, lives in flash
+    size_t length;
+};
+
+// app.js: 7906 bytes -> 2759 bytes gzip
+static const uint8_t APP_JS_GZ[] PROGMEM = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9D, 0x19, 0x6B, 0x6F, 0xDB, 0x38,
+    0xF2, 0x7B, 0x7E, 0xC5, 0x2C, 0xD0, 0x5D, 0xC9, 0x5B, 0x47, 0x4E, 0xD2, 0xDB, 0xE2, 0x10, 0x5F,
+    0xB6, 0x68, 0xD2, 0xE4, 0xAE, 0xD7, 0xE6, 0x81, 0x38, 0x39, 0xDC, 0x21, 0x08, 0x0A, 0x5A, 0xA2,
+    0x6D, 0xAD, 0x65, 0x51, 0x15, 0x29, 0x3B, 0x41, 0xB7, 0xFF, 0xFD, 0x66, 0x86, 0x14, 0x25, 0xD9,
+    0x4E, 0x36, 0xBB, 0x5F, 0x2C, 0x3E, 0xE6, 0xCD, 0x99, 0xE1, 0x70, 0x3C, 0x18, 0xC0, 0x07, 0xA1,
+    0x67, 0x63, 0x25, 0xCA, 0x04, 0x32, 0x35, 0x4D, 0xE3, 0x43, 0x30, 0x33, 0x09, 0x85, 0x98, 0x4A,
+    0x48, 0x8D, 0x96, 0xD9, 0x04, 0x52, 0x0D, 0xDA, 0x08, 0x93, 0xC6, 0x11, 0x7C, 0x4E, 0x97, 0x12,
+    0x96, 0x22, 0xAB, 0xA4, 0x06, 0x51, 0x22, 0x58, 0xA5, 0x67, 0x32, 0x01, 0xA1, 0xE1, 0xDF, 0xA3,
+    0xCB, 0x0B, 0x48, 0x64, 0x66, 0x84, 0xDE, 0x19, 0x0C, 0x40, 0x2D, 0x65, 0x09, 0x23, 0x59, 0xE2,
+    0x67, 0x77, 0x24, 0x73, 0x03, 0xA7, 0x4B, 0xFC, 0xD5, 0x10, 0x0E, 0x24, 0x0F, 0x7A, 0x43, 0x66,
+    0xA3, 0x33, 0xB5, 0xDA, 0x8D, 0x67, 0x22, 0x9F, 0xA6, 0xF9, 0x14, 0x4A, 0xA9, 0x0D, 0xC4, 0x6A,
+    0x81, 0xC4, 0x27, 0xA5, 0x5A, 0xC0, 0x40, 0x14, 0xE9, 0x80, 0x58, 0x57, 0x3A, 0xDA, 0x59, 0x8A,
+    0x12, 0xAE, 0xAE, 0x2F, 0xCF, 0x3E, 0x7E, 0x3E, 0x1D, 0xC1, 0x11, 0xDC, 0x05, 0x17, 0x2A, 0x97,
+    0x41, 0x1F, 0x82, 0xFF, 0xA8, 0x34, 0xE6, 0xC1, 0x79, 0xA5, 0xD3, 0x38, 0xB8, 0x1F, 0x32, 0x28,
+    0xA1, 0x49, 0x84, 0xFB, 0xF6, 0xDD, 0xCE, 0x0B, 0x95, 0x65, 0x37, 0xE9, 0x02, 0xA5, 0x3A, 0x82,
+    0xBC, 0xCA, 0xB2, 0xE1, 0xCE, 0xCE, 0xA4, 0xCA, 0x63, 0x93, 0xAA, 0x1C, 0x5E, 0x85, 0x69, 0xD2,
+    0x83, 0x6F, 0xC8, 0xDF, 0x54, 0x65, 0x0E, 0x89, 0x8A, 0xAB, 0x05, 0x0A, 0x19, 0x4D, 0xA5, 0x39,
+    0xCD, 0x24, 0x0D, 0x8F, 0x1F, 0x3F, 0x26, 0x04, 0x34, 0x84, 0xEF, 0x0D, 0x9A, 0x96, 0x06, 0xD7,
+    0xFA, 0xB0, 0x24, 0x5C, 0xA6, 0x11, 0x19, 0xF9, 0x60, 0x4E, 0x54, 0x6E, 0x48, 0xE3, 0x23, 0x58,
+    0x12, 0x78, 0x03, 0x3F, 0x13, 0x3A, 0x9C, 0xB7, 0xF8, 0xB0, 0x88, 0x77, 0xF3, 0x7B, 0xF8, 0xE1,
+    0xE8, 0x08, 0xAA, 0x3C, 0x91, 0x93, 0x34, 0x97, 0x49, 0x17, 0xA7, 0x94, 0xB8, 0x5E, 0x86, 0x88,
+    0xB5, 0x03, 0xC0, 0x7A, 0x21, 0x5D, 0x46, 0x1C, 0xE2, 0x42, 0x3A, 0x81, 0x90, 0xA8, 0x06, 0x55,
+    0x61, 0x50, 0xB7, 0xA0, 0x67, 0xE1, 0x80, 0x45, 0xAB, 0x17, 0xFB, 0xA0, 0x23, 0x3B, 0x84, 0xD7,
+    0x10, 0xE0, 0x56, 0xAC, 0xF2, 0x44, 0x07, 0xBD, 0x61, 0x03, 0x39, 0x93, 0xA2, 0xB8, 0x51, 0x46,
+    0x64, 0x0C, 0xEC, 0x67, 0x0C, 0x3F, 0x7E, 0x34, 0xB2, 0x0B, 0x3D, 0xC9, 0xD0, 0x63, 0x18, 0x92,
+    0x47, 0x4F, 0x40, 0xE9, 0xB9, 0x34, 0xF1, 0xEC, 0xAC, 0x94, 0x56, 0x82, 0x66, 0xFA, 0x14, 0x7C,
+    0x32, 0xB7, 0x80, 0xC9, 0xBC, 0xC3, 0x6C, 0x65, 0x39, 0xAD, 0x3A, 0xF2, 0x1A, 0x53, 0x9C, 0x28,
+    0x6D, 0xAC, 0xB8, 0x38, 0x89, 0xD0, 0x53, 0x6E, 0x35, 0x53, 0xAE, 0x34, 0x0C, 0xF0, 0xF3, 0xBA,
+    0xB5, 0xF3, 0x2F, 0x54, 0x88, 0xF7, 0x8E, 0x81, 0x74, 0xEB, 0xB2, 0xD5, 0x69, 0x62, 0xF9, 0x6A,
+    0x3A, 0xDF, 0x66, 0x23, 0x2D, 0x78, 0x39, 0x2D, 0xDA, 0x8B, 0x0B, 0x11, 0xF3, 0x2A, 0x7E, 0xDB,
+    0xCB, 0x53, 0x2B, 0xE4, 0xB4, 0x23, 0x24, 0xB9, 0x75, 0x2E, 0xAD, 0x49, 0xDD, 0x18, 0x85, 0x08,
+    0xFD, 0x24, 0x4A, 0xF1, 0x68, 0x1F, 0x2E, 0x27, 0x21, 0xF9, 0x6E, 0x0F, 0x7E, 0x3D, 0x82, 0x3D,
+    0x78, 0x47, 0xFB, 0x05, 0x1A, 0x69, 0x51, 0x18, 0x9C, 0x04, 0x10, 0xE2, 0x64, 0x97, 0x66, 0xBD,
+    0x00, 0x0E, 0x69, 0x9E, 0x54, 0xF1, 0x1C, 0x63, 0xA5, 0x87, 0x18, 0x38, 0xC7, 0xDF, 0xD7, 0xCC,
+    0x11, 0x08, 0x91, 0x82, 0x2E, 0x43, 0x55, 0x7F, 0xFA, 0x09, 0x9A, 0x09, 0x39, 0x57, 0xB0, 0x48,
+    0x1F, 0x02, 0xA2, 0xD7, 0x07, 0xB7, 0x7C, 0xE8, 0x4C, 0x54, 0x43, 0x31, 0xAD, 0xB6, 0xF4, 0x32,
+    0x47, 0x29, 0x63, 0x7B, 0x76, 0x6E, 0x4C, 0x04, 0x2E, 0x2F, 0x58, 0x8E, 0xCB, 0xB3, 0xB3, 0x8E,
+    0x15, 0xC5, 0xD4, 0xDA, 0x05, 0xBF, 0xCF, 0x40, 0xE5, 0x9A, 0x81, 0x72, 0xFD, 0x0C, 0x4C, 0xA9,
+    0xA6, 0xB2, 0x64, 0x30, 0x1E, 0x3D, 0x03, 0x59, 0x94, 0x6A, 0x92, 0x66, 0x24, 0x61, 0x9D, 0x16,
+    0xEE, 0xC8, 0x76, 0xBC, 0x78, 0x0F, 0xBF, 0xFF, 0x0E, 0xC1, 0xBB, 0x2E, 0xBC, 0x88, 0xD1, 0x07,
+    0xAD, 0x08, 0x6E, 0xDC, 0xDE, 0xA6, 0x00, 0x2C, 0xCB, 0xCA, 0xC9, 0xE8, 0x67, 0xEC, 0x37, 0xE1,
+    0xC7, 0x83, 0x91, 0x33, 0x58, 0x7A, 0xA0, 0x6F, 0xDB, 0x7B, 0xBD, 0x0E, 0x8F, 0xA4, 0x4C, 0x27,
+    0xE4, 0x95, 0x78, 0x18, 0x3C, 0xBC, 0x2A, 0x16, 0xF0, 0x2B, 0x9F, 0x6B, 0xF0, 0x3A, 0xA8, 0x0F,
+    0x0C, 0x5A, 0x9B, 0x44, 0xBD, 0x28, 0x16, 0x5D, 0x22, 0x0B, 0xC1, 0x32, 0xE0, 0xF7, 0x44, 0x55,
+    0x98, 0x49, 0x08, 0xE8, 0xC1, 0xF1, 0xC7, 0xC5, 0xB3, 0x52, 0x50, 0x8A, 0xA4, 0xD5, 0x89, 0x1D,
+    0x86, 0xB4, 0x77, 0x2E, 0xCC, 0x0C, 0x8D, 0x86, 0x92, 0x87, 0x2D, 0xDC, 0x9F, 0x3B, 0x38, 0x03,
+    0xD8, 0x7F, 0xDB, 0x63, 0xCC, 0x85, 0xEE, 0x4A, 0xAE, 0x4D, 0x29, 0xC5, 0xE2, 0xC6, 0x26, 0x0C,
+    0x24, 0x60, 0xE7, 0xE7, 0x8C, 0xB2, 0xB7, 0xB7, 0x87, 0xA9, 0x4D, 0x9D, 0xA5, 0x0F, 0x32, 0x09,
+    0xF7, 0x7B, 0x75, 0x1A, 0xB1, 0x6C, 0x3D, 0x2C, 0x29, 0x29, 0x30, 0x6B, 0x2D, 0x25, 0x6B, 0x4A,
+    0x89, 0x2B, 0x61, 0x75, 0x1B, 0x1B, 0x4D, 0x54, 0x09, 0x21, 0x65, 0xB1, 0x39, 0xA4, 0x98, 0xFF,
+    0xA2, 0x4C, 0x98, 0x9E, 0x65, 0x8F, 0xA3, 0x5D, 0xA2, 0x36, 0xEF, 0xDB, 0x65, 0x4C, 0x8B, 0x77,
+    0x7B, 0xF7, 0xCC, 0xA9, 0x8E, 0x66, 0xB7, 0xBA, 0x7F, 0xEF, 0xC2, 0xBC, 0x23, 0xFE, 0x6F, 0xA9,
+    0x31, 0xB2, 0xBC, 0xB5, 0x87, 0x57, 0x4F, 0xB6, 0x01, 0x96, 0x94, 0xFE, 0x72, 0x19, 0x3B, 0x47,
+    0x68, 0xA6, 0xEB, 0xF9, 0xF0, 0x3C, 0xCD, 0x7D, 0x36, 0xC4, 0xF1, 0x13, 0x59, 0xCB, 0x85, 0xC6,
+    0xB1, 0xC9, 0xD7, 0x23, 0xE5, 0xD4, 0x0E, 0xE9, 0xF6, 0x00, 0x72, 0x5D, 0xB2, 0x49, 0x67, 0xED,
+    0x62, 0x3D, 0x82, 0x6A, 0x22, 0x2E, 0x88, 0xDE, 0xFF, 0xF3, 0xC4, 0x23, 0xF2, 0xF8, 0x62, 0x2D,
+    0x98, 0x6A, 0x78, 0x1B, 0x4F, 0x17, 0x2A, 0xD5, 0x12, 0x46, 0x55, 0x81, 0x19, 0x03, 0x73, 0x19,
+    0xDE, 0x1D, 0x35, 0xF2, 0x96, 0x9D, 0x8B, 0xCD, 0x98, 0xAB, 0xA9, 0xF9, 0xB0, 0xBB, 0xE6, 0xC1,
+    0xB1, 0x94, 0x85, 0xA7, 0xD4, 0x5E, 0xBA, 0xD8, 0x16, 0x8C, 0x96, 0x48, 0x70, 0x81, 0xD7, 0x20,
+    0x5C, 0xD9, 0x25, 0xE7, 0x25, 0xCF, 0xC4, 0xE8, 0x66, 0x18, 0xD1, 0xA9, 0x94, 0x89, 0x3F, 0x20,
+    0x2C, 0x4D, 0x38, 0x0D, 0x40, 0xB8, 0x2A, 0x53, 0xBC, 0xD5, 0xC5, 0xA2, 0xC8, 0xD2, 0x49, 0x1A,
+    0x0B, 0xBE, 0x22, 0x9D, 0x13, 0x22, 0xE0, 0xFB, 0x45, 0x61, 0xDD, 0xB5, 0xF1, 0xD6, 0x03, 0xA6,
+    0xFE, 0xD0, 0xDB, 0x9E, 0x6B, 0x98, 0xB6, 0x57, 0xDC, 0x73, 0xBA, 0xE6, 0x11, 0x55, 0x24, 0x5E,
+    0xF1, 0x66, 0x65, 0xCD, 0x74, 0xB2, 0xC8, 0xC4, 0xA3, 0xC3, 0xA7, 0x21, 0xE7, 0x71, 0x97, 0x92,
+    0x91, 0xD4, 0x39, 0x5A, 0x9C, 0x4A, 0x29, 0x2F, 0x24, 0xC3, 0xBC, 0x06, 0x17, 0x45, 0x6A, 0x52,
+    0x5F, 0x55, 0xA9, 0xB6, 0x71, 0x1E, 0xDA, 0xB9, 0x05, 0xBC, 0x11, 0xD9, 0x1C, 0x0D, 0x4E, 0xF6,
+    0x01, 0x61, 0xA0, 0xBD, 0x35, 0x2A, 0x24, 0x16, 0x5E, 0xAC, 0x2D, 0x6B, 0x18, 0x38, 0x9E, 0x28,
+    0xEC, 0xC7, 0x24, 0x93, 0xFD, 0x75, 0xBA, 0xDA, 0xA8, 0x92, 0xE2, 0xB1, 0x1D, 0xF2, 0x44, 0xC2,
+    0x9D, 0xD8, 0xB5, 0x15, 0xCC, 0x52, 0x7D, 0x96, 0xCF, 0x5A, 0xA6, 0x72, 0xF8, 0x97, 0x95, 0x29,
+    0x2A, 0x03, 0xC7, 0xD5, 0x64, 0x22, 0x4B, 0x7D, 0xD8, 0x24, 0x2B, 0xCE, 0x42, 0x8C, 0xF3, 0xBD,
+    0x5D, 0xB0, 0x50, 0x54, 0x7D, 0x1A, 0x53, 0xC1, 0xE2, 0x03, 0xCE, 0x47, 0xDB, 0xA7, 0x31, 0x4B,
+    0xFC, 0xE9, 0xD8, 0xF2, 0x92, 0x19, 0x7A, 0x6F, 0x07, 0x71, 0x3B, 0xDA, 0x7A, 0x84, 0x7A, 0x94,
+    0x12, 0x9D, 0xDE, 0xA3, 0xF0, 0x84, 0x8F, 0x0B, 0x07, 0x8C, 0x92, 0x1C, 0x2F, 0xD6, 0x10, 0x96,
+    0x2A, 0xAB, 0x36, 0xAA, 0x29, 0xB7, 0x48, 0xA8, 0x76, 0x48, 0xC8, 0x83, 0xB7, 0x6F, 0x5A, 0xC9,
+    0x77, 0x92, 0x29, 0x55, 0x86, 0x7E, 0xFF, 0x67, 0x36, 0xDA, 0x00, 0xDE, 0xBE, 0xE1, 0xC3, 0xFE,
+    0xB1, 0xE7, 0x9C, 0x60, 0x51, 0x19, 0x99, 0xD8, 0xDB, 0x98, 0x87, 0xC1, 0xE6, 0xED, 0x4B, 0xEB,
+    0xB5, 0x5F, 0x7A, 0xF0, 0xDB, 0x9C, 0x86, 0x0C, 0x7D, 0x4E, 0x83, 0x4D, 0xAB, 0x62, 0x60, 0x78,
+    0x45, 0x69, 0xCC, 0xD9, 0x04, 0x83, 0x62, 0xCB, 0x25, 0xEA, 0x71, 0x56, 0xDA, 0xA3, 0xAC, 0x6C,
+    0x4E, 0x5C, 0x71, 0x3E, 0xF9, 0x1F, 0xDA, 0xD1, 0x66, 0x8F, 0x35, 0x04, 0x9B, 0xED, 0x3D, 0x92,
+    0x9B, 0x72, 0x09, 0xE5, 0xEF, 0x81, 0x75, 0x64, 0x86, 0x34, 0xEC, 0xCD, 0x6D, 0x48, 0x2E, 0x54,
+    0xEC, 0x32, 0x62, 0xF9, 0x21, 0x22, 0xEE, 0xB6, 0xF0, 0x7C, 0x85, 0xD6, 0x42, 0xC2, 0x35, 0xC6,
+    0xA0, 0x6F, 0x03, 0xEE, 0x65, 0x2C, 0x8A, 0x46, 0x2B, 0x1A, 0xF3, 0x9D, 0x5F, 0xE8, 0x2E, 0xD0,
+    0xB8, 0x9A, 0x9C, 0x37, 0x60, 0x76, 0x46, 0x80, 0x3C, 0x72, 0x97, 0xE4, 0x1A, 0xDD, 0x44, 0xC6,
+    0xB7, 0x0D, 0x8A, 0x9D, 0xF1, 0x55, 0x4D, 0xA3, 0xCE, 0x75, 0xB3, 0x66, 0x2E, 0xBD, 0xE6, 0x4D,
+    0xF5, 0x6A, 0xA3, 0x97, 0x45, 0xCF, 0xF8, 0xFA, 0x64, 0x37, 0x99, 0xC9, 0x2C, 0xB1, 0x35, 0xA0,
+    0x0B, 0x65, 0x9A, 0x13, 0xCC, 0xD7, 0x4A, 0x56, 0x32, 0xE9, 0x05, 0x6B, 0x05, 0x20, 0xD2, 0x42,
+    0x31, 0x54, 0xE2, 0x92, 0x4D, 0x2D, 0xEF, 0x67, 0x25, 0xE8, 0x1A, 0x7E, 0x67, 0xA5, 0xA4, 0x19,
+    0xE2, 0xED, 0x59, 0x8F, 0xA4, 0xFC, 0x23, 0xF0, 0xC5, 0x55, 0x7A, 0x67, 0x6A, 0xBF, 0x3D, 0xF0,
+    0xB1, 0x34, 0x95, 0x21, 0xBF, 0xE9, 0xAC, 0xEC, 0xDD, 0xEB, 0xDB, 0x6D, 0xF8, 0x57, 0xCC, 0x91,
+    0x5D, 0xC1, 0x21, 0x91, 0xAA, 0x1F, 0x2E, 0xC3, 0x9D, 0xEE, 0x73, 0x66, 0x82, 0x77, 0xD0, 0xCC,
+    0xBD, 0x67, 0x26, 0xF4, 0x24, 0x08, 0x83, 0xD6, 0x33, 0x2F, 0xC0, 0xCC, 0x3D, 0x93, 0x79, 0xE8,
+    0x11, 0xC2, 0xB2, 0xF5, 0x60, 0x2A, 0xA3, 0xDF, 0xB4, 0xCA, 0x43, 0x7A, 0x85, 0x6D, 0xC0, 0xE9,
+    0xDA, 0xBC, 0x28, 0x84, 0xC4, 0x3B, 0x82, 0xC5, 0x72, 0xE9, 0x64, 0x88, 0xCB, 0xF8, 0x26, 0xA5,
+    0x07, 0xE7, 0x04, 0x9F, 0x7E, 0x60, 0x79, 0x41, 0x2C, 0xCA, 0x32, 0xC5, 0xA2, 0x48, 0x3E, 0x60,
+    0xD9, 0xC2, 0x2F, 0x03, 0x9B, 0x3E, 0x98, 0x8C, 0x55, 0xDE, 0x7A, 0x0C, 0x72, 0xC3, 0xBB, 0x06,
+    0x45, 0x6D, 0xD8, 0x91, 0x54, 0xEE, 0x02, 0x60, 0x8D, 0x28, 0x07, 0x7E, 0x90, 0x4B, 0x7C, 0x89,
+    0x42, 0xAE, 0x0C, 0x0A, 0x2C, 0xB0, 0xCA, 0x1F, 0x53, 0x1E, 0x46, 0xD9, 0xCB, 0x47, 0xBC, 0x39,
+    0xA2, 0x28, 0x0A, 0x58, 0xF2, 0xAE, 0x45, 0x8A, 0xD8, 0x84, 0xCB, 0x96, 0x8E, 0x4B, 0xF8, 0x87,
+    0xAD, 0x17, 0xF3, 0x81, 0xA0, 0x13, 0x5E, 0xF2, 0x41, 0x05, 0xFC, 0x2A, 0x44, 0x1D, 0x6E, 0x84,
+    0x9E, 0x83, 0x21, 0xCA, 0xAD, 0x27, 0x32, 0xBE, 0xB9, 0xE7, 0x7A, 0x08, 0x27, 0x57, 0xB7, 0xA0,
+    0x67, 0x0A, 0xC3, 0x17, 0x71, 0x01, 0x69, 0x8F, 0xAB, 0x34, 0x4B, 0x34, 0xAC, 0x52, 0x33, 0x53,
+    0x98, 0x9C, 0xE9, 0xF1, 0x75, 0x7D, 0x73, 0x39, 0x02, 0xAC, 0x5D, 0x77, 0xF9, 0x3D, 0x48, 0x86,
+    0xD0, 0x1B, 0xA7, 0x43, 0x3C, 0xF4, 0x96, 0x23, 0x62, 0x36, 0x7F, 0xFD, 0x84, 0x4C, 0x27, 0x00,
+    0xC8, 0xE9, 0xC8, 0xFD, 0x49, 0x7F, 0x13, 0xF1, 0x0C, 0x0B, 0xBE, 0x5E, 0xAB, 0xE2, 0x6B, 0xEF,
+    0xEC, 0xDF, 0xD7, 0xE9, 0x91, 0xDC, 0xEF, 0x2B, 0xFA, 0x9A, 0x89, 0x38, 0x0C, 0x74, 0x2B, 0x69,
+    0xDA, 0x05, 0xA4, 0xF9, 0x35, 0x5A, 0x49, 0x7B, 0x87, 0xC4, 0x6A, 0xB1, 0x10, 0xF8, 0xDA, 0xB5,
+    0xD7, 0xE1, 0xD7, 0xC8, 0x3C, 0xF0, 0xF2, 0xCD, 0x7F, 0x5D, 0xE5, 0x5C, 0xAF, 0xA7, 0x39, 0xDD,
+    0x5E, 0x7C, 0x81, 0x54, 0xC6, 0xA0, 0xB4, 0xB6, 0x4B, 0x51, 0x6F, 0x67, 0x6A, 0x6A, 0xA3, 0x53,
+    0x51, 0x93, 0x82, 0x4A, 0x01, 0xBB, 0xE5, 0x22, 0xEF, 0x6B, 0x13, 0x9B, 0x0B, 0x7B, 0xDF, 0x7B,
+    0x4C, 0x84, 0x3E, 0x26, 0x9F, 0x72, 0xCF, 0x4F, 0xA3, 0x1C, 0x7E, 0xD0, 0x52, 0x67, 0xAC, 0x92,
+    0x47, 0xD4, 0xE8, 0x15, 0x65, 0x48, 0xB6, 0xB0, 0xDD, 0xA2, 0xE5, 0xB5, 0x86, 0x42, 0x10, 0xD8,
+    0x2D, 0x13, 0x31, 0x64, 0xA4, 0x55, 0x69, 0x5A, 0x16, 0x16, 0x7D, 0x18, 0xB7, 0x0E, 0x43, 0xB0,
+    0xF1, 0x60, 0x17, 0xC6, 0x76, 0x80, 0xE5, 0xD6, 0x18, 0x8B, 0xAF, 0x54, 0xE1, 0x92, 0xE0, 0x81,
+    0x75, 0xC7, 0x36, 0x45, 0x0C, 0xF1, 0x53, 0xD1, 0xF1, 0xF4, 0x79, 0x7D, 0x6C, 0x56, 0xD8, 0x52,
+    0xAD, 0x50, 0x10, 0x96, 0x2D, 0xCD, 0xB5, 0x2C, 0xCD, 0xB5, 0x5A, 0x85, 0x8E, 0x08, 0xC0, 0xDD,
+    0x3C, 0xCA, 0xD1, 0xAE, 0x7D, 0x98, 0x63, 0x1D, 0x99, 0xF1, 0x97, 0x59, 0x3B, 0x9F, 0x16, 0xF9,
+    0x23, 0xF9, 0xB4, 0x5D, 0xA4, 0x4D, 0x12, 0xC2, 0xFA, 0x00, 0xAE, 0x15, 0x55, 0xAF, 0xEF, 0xE8,
+    0x00, 0xEE, 0xA1, 0x73, 0xC6, 0x73, 0xD7, 0x30, 0x08, 0xDD, 0x94, 0xF3, 0xA1, 0x2B, 0x9A, 0xEA,
+    0xA5, 0xFA, 0x55, 0x85, 0xF6, 0x0D, 0xEE, 0xB7, 0x28, 0xB0, 0x6C, 0x14, 0x00, 0x12, 0xDF, 0xC9,
+    0x7D, 0x22, 0xB3, 0x2C, 0xDC, 0xEC, 0xD8, 0x38, 0xC8, 0xDA, 0x2E, 0xDF, 0x9F, 0x49, 0x00, 0x2E,
+    0x94, 0x31, 0x2A, 0xCF, 0x04, 0x66, 0x95, 0x31, 0x09, 0x83, 0x07, 0x4C, 0x9D, 0x26, 0xAA, 0x14,
+    0x57, 0x33, 0xAA, 0x7E, 0xB9, 0x99, 0x56, 0xE9, 0x19, 0xD4, 0x2D, 0x80, 0x54, 0x43, 0xA2, 0x56,
+    0x79, 0xAB, 0x8D, 0x64, 0x44, 0x69, 0xAE, 0x2C, 0x92, 0x8B, 0x3A, 0xBA, 0x3C, 0x7E, 0xF0, 0x1D,
+    0xAB, 0x5E, 0xA7, 0x79, 0x85, 0xAE, 0xFE, 0x11, 0xC5, 0x2D, 0x97, 0x22, 0x0B, 0x5D, 0xC0, 0xF6,
+    0xE1, 0x80, 0x9E, 0x68, 0x24, 0x4D, 0x8B, 0xAA, 0x2A, 0x36, 0x89, 0xB6, 0x68, 0x7E, 0x83, 0x38,
+    0x93, 0xA2, 0xF4, 0xB4, 0x9A, 0xAD, 0xE1, 0x66, 0xB3, 0x6C, 0xED, 0x66, 0x70, 0x6F, 0x26, 0xDB,
+    0xD3, 0x6B, 0xCB, 0xBC, 0x4A, 0x73, 0x54, 0x2E, 0xE2, 0x8D, 0x91, 0xAA, 0xCA, 0x58, 0x72, 0xA2,
+    0xEC, 0x68, 0x38, 0x74, 0xFE, 0x39, 0xE4, 0xDA, 0x85, 0x7C, 0x4A, 0x52, 0x53, 0x2B, 0x97, 0x2B,
+    0x68, 0xE1, 0x61, 0xCE, 0xB1, 0x31, 0xE8, 0x8A, 0x40, 0x1D, 0xA9, 0x5C, 0x15, 0x32, 0x47, 0xC8,
+    0xB5, 0x2C, 0xDC, 0x56, 0x74, 0xB8, 0x91, 0x94, 0xA9, 0x63, 0xC9, 0x79, 0xD7, 0x53, 0xC1, 0xB7,
+    0xBB, 0x2A, 0xB7, 0x90, 0xE9, 0xCA, 0xB8, 0x8D, 0x0E, 0x54, 0x45, 0x22, 0x28, 0x98, 0x33, 0xA5,
+    0x4D, 0xBF, 0x3E, 0xE8, 0x3A, 0xB1, 0x3B, 0x06, 0x22, 0x49, 0x58, 0x8D, 0xCF, 0x58, 0x79, 0x4B,
+    0x64, 0x86, 0x51, 0x8D, 0xF8, 0x0D, 0x33, 0xB6, 0x88, 0xBD, 0x5D, 0xA8, 0x67, 0x1A, 0x15, 0xA2,
+    0xD4, 0x32, 0x94, 0x11, 0x52, 0x16, 0xBD, 0x2D, 0x17, 0x04, 0xDA, 0xDA, 0x60, 0x2C, 0x85, 0x82,
+    0xA7, 0x9B, 0x59, 0xD9, 0xED, 0x23, 0x0F, 0x22, 0x8B, 0x99, 0x3E, 0xC1, 0x80, 0xB8, 0xBA, 0x1C,
+    0xDD, 0xE0, 0x0A, 0x85, 0xE9, 0x21, 0x5B, 0xF6, 0xF6, 0xFA, 0xF3, 0x08, 0x4F, 0x3B, 0x9E, 0x5D,
+    0x09, 0x4C, 0x7C, 0x3A, 0xFC, 0x06, 0x96, 0xDE, 0xA1, 0xFB, 0x22, 0xDB, 0x9A, 0xB3, 0x6F, 0x7F,
+    0x62, 0x3E, 0x2D, 0x1F, 0x47, 0x78, 0x9D, 0xC6, 0xF8, 0x76, 0x78, 0x8F, 0xD1, 0x12, 0xDC, 0x91,
+    0x90, 0xBB, 0x16, 0xE3, 0x1E, 0x6F, 0x82, 0xCD, 0x60, 0x1B, 0x5B, 0x01, 0xC7, 0x68, 0xE7, 0x38,
+    0x4B, 0x31, 0x20, 0xD6, 0xEC, 0xEC, 0x93, 0x9E, 0x63, 0x8B, 0xA9, 0x84, 0xDA, 0xAC, 0xEF, 0x8D,
+    0x29, 0x53, 0x4C, 0xBD, 0x78, 0xEC, 0x2D, 0x16, 0x75, 0x26, 0x5C, 0x33, 0x81, 0x5D, 0x24, 0x7F,
+    0xB3, 0x0B, 0x4D, 0x23, 0xCD, 0xBD, 0xC6, 0x7A, 0x70, 0x74, 0x74, 0x44, 0x35, 0x0E, 0x1E, 0x22,
+    0xB9, 0x31, 0x5E, 0x7E, 0x4D, 0xA8, 0xBC, 0xA1, 0x48, 0xB1, 0x05, 0x81, 0x7B, 0x8D, 0xD9, 0x56,
+    0x31, 0xC6, 0x25, 0xDD, 0xDC, 0x58, 0xD8, 0x50, 0xC8, 0x52, 0x1D, 0x56, 0xB7, 0xB3, 0x81, 0xCE,
+    0x96, 0x8C, 0xF3, 0x87, 0x96, 0xC9, 0xC5, 0xF2, 0xAF, 0x99, 0x05, 0x5C, 0xE0, 0x64, 0xCA, 0x3E,
+    0x6A, 0xA3, 0x19, 0xCA, 0xFB, 0x94, 0x71, 0x90, 0x8B, 0x73, 0x38, 0x12, 0xEA, 0x55, 0xA7, 0x09,
+    0xD1, 0x7B, 0xC6, 0xF0, 0xBE, 0x24, 0xAD, 0x7B, 0x7B, 0xBE, 0x24, 0xAD, 0x0D, 0x6C, 0x8B, 0xA6,
+    0x56, 0x13, 0xC3, 0x0D, 0xBF, 0xA8, 0xC9, 0xC4, 0x35, 0x75, 0xDC, 0x3C, 0x6F, 0xBD, 0x03, 0x9F,
+    0x33, 0xB1, 0x6C, 0x75, 0x3C, 0x3A, 0x76, 0x46, 0xB7, 0x37, 0x94, 0xC9, 0xB7, 0x18, 0x7B, 0xE7,
+    0x3B, 0x6B, 0x55, 0xBF, 0x81, 0x5E, 0xA4, 0x92, 0x7D, 0x48, 0xA1, 0x42, 0x5D, 0x55, 0xFC, 0xDB,
+    0x89, 0x06, 0x5E, 0x0B, 0x3B, 0x61, 0x15, 0x2C, 0x2B, 0xD7, 0x7C, 0x79, 0x11, 0x27, 0x6A, 0x75,
+    0x3E, 0x61, 0x38, 0xD7, 0xB8, 0xC1, 0x8F, 0x67, 0xC5, 0xE3, 0x97, 0x1A, 0x8B, 0xBA, 0x3C, 0x7F,
+    0xD2, 0x48, 0xB6, 0x0B, 0xF4, 0x22, 0xC1, 0x73, 0xFD, 0x94, 0xDC, 0xB6, 0x81, 0x94, 0x6B, 0x2F,
+    0x35, 0x0D, 0x5F, 0x2A, 0xB4, 0x28, 0x8A, 0x2C, 0xAD, 0xFF, 0xB1, 0x21, 0x41, 0x73, 0x6E, 0xFE,
+    0xDC, 0xDC, 0x00, 0xB7, 0x9B, 0x5A, 0xB2, 0xFA, 0x36, 0xD3, 0x8B, 0xC4, 0xB5, 0x8D, 0xE0, 0x27,
+    0x24, 0xF6, 0x4D, 0x2A, 0x1E, 0x78, 0xB9, 0xDD, 0xEC, 0x8F, 0x45, 0x6F, 0x49, 0xD5, 0xEA, 0x5C,
+    0x3D, 0x27, 0x57, 0xCD, 0xBF, 0x86, 0xFF, 0x42, 0x6A, 0xFA, 0x47, 0xEA, 0x13, 0x5C, 0x9C, 0xDE,
+    0xBE, 0xCD, 0xF4, 0x32, 0xC5, 0x5D, 0x81, 0xF8, 0x84, 0xE6, 0xBE, 0x4B, 0x65, 0x47, 0x8D, 0xEE,
+    0x6E, 0xFA, 0x72, 0xE5, 0x29, 0x0D, 0x8F, 0xAE, 0x4E, 0x4F, 0x3F, 0xF0, 0xFF, 0x69, 0xFB, 0x7B,
+    0x7B, 0x7D, 0xD8, 0x3F, 0xF8, 0x05, 0x7F, 0x7E, 0xD9, 0xBB, 0x67, 0xC1, 0x7D, 0x83, 0xE8, 0x85,
+    0x72, 0xFB, 0x7E, 0x51, 0x23, 0x3C, 0xF1, 0x60, 0x87, 0x38, 0x72, 0xAC, 0xEE, 0x42, 0xFB, 0xF5,
+    0x49, 0xBB, 0x56, 0xCB, 0x23, 0xF7, 0x6C, 0x7B, 0xEC, 0x47, 0x87, 0x10, 0x65, 0x32, 0x9F, 0x9A,
+    0xD9, 0x7D, 0xF7, 0x2A, 0x70, 0xDC, 0xBE, 0xB0, 0x88, 0x5F, 0xA8, 0x1C, 0x24, 0x2E, 0x7F, 0x46,
+    0xF3, 0x0F, 0xE7, 0xEF, 0xBF, 0x9C, 0x5C, 0xDE, 0x5E, 0xDC, 0xB0, 0xF6, 0x07, 0x7D, 0xF8, 0x5B,
+    0x1F, 0xFE, 0x6E, 0xF5, 0x76, 0x6D, 0xAD, 0x17, 0x69, 0x5D, 0xB7, 0xB8, 0x36, 0xCF, 0x8B, 0xB6,
+    0x58, 0xB2, 0x86, 0xD3, 0x5D, 0xD8, 0x8C, 0xD7, 0x0C, 0xE0, 0x5B, 0x65, 0xB5, 0xF6, 0x2D, 0x48,
+    0x67, 0x81, 0x3F, 0xE1, 0xD4, 0xA5, 0x1C, 0x2B, 0x65, 0x5E, 0xA2, 0x04, 0x4A, 0x3B, 0x49, 0xCB,
+    0x45, 0x18, 0x5C, 0x4B, 0x2E, 0x81, 0x38, 0x84, 0x13, 0x7E, 0xC9, 0xBE, 0x23, 0x9D, 0x9E, 0xB8,
+    0x98, 0x82, 0x81, 0x65, 0x11, 0xB0, 0x93, 0xEF, 0xF8, 0x77, 0xFD, 0x70, 0x67, 0x6B, 0x7D, 0x8A,
+    0xF2, 0x35, 0x19, 0xC3, 0xFE, 0x19, 0x89, 0xF5, 0x13, 0xFF, 0x09, 0x83, 0x25, 0xB3, 0x11, 0x99,
+    0x06, 0x7C, 0xA6, 0x81, 0x42, 0xE6, 0x25, 0xFF, 0x29, 0x0C, 0x93, 0x14, 0x9F, 0x54, 0x7A, 0x67,
+    0xAD, 0xD2, 0x1C, 0xEE, 0x74, 0xDF, 0xA8, 0x5B, 0xD9, 0xF1, 0x9E, 0xAF, 0x89, 0xFF, 0x0F, 0x87,
+    0xE2, 0x71, 0x72, 0xE2, 0x1E, 0x00, 0x00,
+};
+
+// index.html: 7101 bytes -> 1448 bytes gzip
+static const uint8_t INDEX_HTML_GZ[] PROGMEM = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xBD, 0x59, 0x51, 0x6F, 0xDB, 0x36,
+    0x10, 0x7E, 0xCF, 0xAF, 0xE0, 0x5E, 0xE6, 0x16, 0x9B, 0xA3, 0x35, 0xC3, 0x80, 0x75, 0xB3, 0x0D,
+    0x38, 0x76, 0xDA, 0x65, 0x4B, 0x16, 0x2F, 0xB6, 0x9B, 0x6D, 0x2F, 0x01, 0x2D, 0x9D, 0x22, 0x36,
+    0x94, 0xC8, 0x92, 0x94, 0xDD, 0x14, 0xFB, 0xF1, 0x3B, 0x92, 0x92, 0x93, 0xC1, 0x74, 0x6D, 0x97,
+    0xED, 0x1E, 0x02, 0x4B, 0x3C, 0xF2, 0xBB, 0xD3, 0xF1, 0xEE, 0xE3, 0x1D, 0xD3, 0xFB, 0x6A, 0x7C,
+    0x35, 0x9A, 0xFD, 0x35, 0x39, 0x23, 0x85, 0x29, 0xF9, 0xE0, 0xA8, 0xD7, 0xFE, 0x00, 0xCD, 0xF0,
+    0xA7, 0x04, 0x43, 0x49, 0x45, 0x4B, 0xE8, 0x77, 0x96, 0x0C, 0x56, 0x52, 0x28, 0xD3, 0x21, 0xA9,
+    0xA8, 0x0C, 0x54, 0xA6, 0xDF, 0x59, 0xB1, 0xCC, 0x14, 0xFD, 0x0C, 0x96, 0x2C, 0x85, 0xAE, 0x7B,
+    0xF9, 0x96, 0xB0, 0x8A, 0x19, 0x46, 0x79, 0x57, 0xA7, 0x94, 0x43, 0xFF, 0x45, 0xA7, 0x05, 0x49,
+    0x0B, 0xAA, 0x34, 0xE0, 0xA2, 0xF9, 0xEC, 0x55, 0xF7, 0x47, 0x3B, 0x6C, 0x98, 0xE1, 0x30, 0x38,
+    0x9B, 0x4E, 0xBE, 0x3F, 0x21, 0x7F, 0x03, 0xE7, 0x82, 0x8C, 0x38, 0x43, 0x5C, 0x32, 0xA6, 0xBA,
+    0x58, 0x08, 0xAA, 0xB2, 0x5E, 0xE2, 0xE7, 0x1C, 0xF5, 0x38, 0xAB, 0xEE, 0x89, 0x02, 0xDE, 0xEF,
+    0x68, 0xF3, 0xC0, 0x41, 0x17, 0x00, 0x68, 0x48, 0xA1, 0x20, 0xEF, 0x77, 0x12, 0x37, 0x74, 0x9C,
+    0x6A, 0x6D, 0x51, 0x93, 0xC6, 0xF2, 0x85, 0xC8, 0x1E, 0xEC, 0x77, 0xBC, 0xD8, 0xA1, 0x01, 0x27,
+    0x1C, 0xE1, 0xB4, 0x93, 0xC1, 0xF4, 0x41, 0x1B, 0x28, 0xC9, 0x79, 0x95, 0x0B, 0x55, 0x52, 0xC3,
+    0x44, 0x85, 0xC2, 0x13, 0x84, 0xC8, 0xD8, 0x92, 0xA4, 0x9C, 0x6A, 0x6D, 0x95, 0x53, 0xD3, 0x5D,
+    0x88, 0xF7, 0x9D, 0xC1, 0xC6, 0xE8, 0x9D, 0x62, 0x59, 0x27, 0x30, 0x9B, 0x21, 0x28, 0x4E, 0xD7,
+    0x92, 0x56, 0xED, 0x38, 0xA7, 0x0B, 0xE0, 0x9D, 0xC1, 0x5C, 0x1A, 0x56, 0xC2, 0x4F, 0xBD, 0xC4,
+    0xCA, 0x9A, 0x19, 0x2C, 0xEB, 0x77, 0x6A, 0x37, 0xDE, 0x19, 0x74, 0x5B, 0x49, 0x82, 0x98, 0x07,
+    0x21, 0xBF, 0x52, 0x00, 0xE4, 0x17, 0xA0, 0x72, 0x13, 0x1C, 0xBD, 0x23, 0x63, 0xA0, 0x67, 0xC2,
+    0x50, 0xFE, 0x11, 0x6C, 0x27, 0x8F, 0xB2, 0x1D, 0xDF, 0x0A, 0x32, 0x65, 0x1F, 0x02, 0x9E, 0xC9,
+    0xAD, 0x2C, 0xDA, 0x31, 0xD3, 0x7B, 0x30, 0x29, 0xAA, 0x90, 0x34, 0x0D, 0xE8, 0xD0, 0x4E, 0x6A,
+    0x27, 0xC6, 0x28, 0xF2, 0x31, 0x37, 0x1D, 0xFF, 0x16, 0x50, 0x90, 0xDD, 0x47, 0x7D, 0x02, 0x53,
+    0xE5, 0x8A, 0x2A, 0x20, 0x6F, 0x40, 0x69, 0x0C, 0xD2, 0x80, 0x97, 0x56, 0x31, 0xF8, 0x53, 0x14,
+    0xD7, 0x9A, 0x5C, 0xC3, 0xBB, 0x1A, 0xB4, 0x21, 0x23, 0xA1, 0x4D, 0x60, 0xA7, 0x8D, 0x91, 0x56,
+    0xB2, 0xA9, 0xC8, 0xFD, 0x34, 0x2F, 0x2E, 0xAD, 0x6E, 0xD8, 0x2B, 0xF6, 0x3F, 0x26, 0x95, 0x53,
+    0x37, 0x9D, 0x9E, 0x8F, 0x03, 0x8E, 0xD7, 0x16, 0xEC, 0xD3, 0x3D, 0x73, 0x3E, 0x21, 0xC3, 0x2C,
+    0x53, 0xA0, 0xF5, 0x26, 0x36, 0x8B, 0x4A, 0xAA, 0xCB, 0xE1, 0x68, 0x3B, 0x74, 0x49, 0xD3, 0x18,
+    0x6C, 0xE7, 0x90, 0x6B, 0xF4, 0xC8, 0x26, 0xB2, 0x42, 0x8F, 0xC4, 0x40, 0xBF, 0xA6, 0x06, 0x56,
+    0xF4, 0x81, 0x9C, 0x4F, 0x36, 0xB1, 0xEF, 0x56, 0x7B, 0xC4, 0xC6, 0x05, 0x5B, 0xC2, 0x17, 0x8E,
+    0x87, 0x19, 0xE5, 0xF7, 0xA0, 0x36, 0xED, 0x33, 0x6E, 0x3C, 0x2E, 0x51, 0x14, 0x50, 0x3C, 0x2F,
+    0x42, 0x91, 0x16, 0x17, 0x68, 0x1E, 0x39, 0x10, 0x0A, 0xDA, 0x0B, 0x62, 0xB0, 0x27, 0x34, 0x45,
+    0x82, 0xD3, 0x49, 0x00, 0x5D, 0xCA, 0x38, 0x64, 0x4E, 0x1F, 0x44, 0x6D, 0xC8, 0x69, 0x9D, 0xE7,
+    0x21, 0x8F, 0x2F, 0xEA, 0xFC, 0x32, 0x4A, 0xC1, 0x18, 0x52, 0x91, 0x01, 0x99, 0x05, 0x0F, 0xCD,
+    0x0C, 0xD2, 0x79, 0x14, 0xFA, 0xBC, 0xCA, 0x40, 0xA9, 0xBA, 0x0A, 0x38, 0xA6, 0x6E, 0x45, 0x31,
+    0xF8, 0x57, 0xB5, 0x91, 0xE8, 0x9D, 0xF1, 0xE5, 0x30, 0x60, 0x7C, 0x49, 0x63, 0xA0, 0x47, 0x5C,
+    0xA4, 0xF7, 0x64, 0xAC, 0x58, 0x1E, 0xA0, 0xEA, 0xCC, 0x0E, 0xEF, 0x93, 0x8B, 0x98, 0xCC, 0x55,
+    0xFA, 0x40, 0x9E, 0xC9, 0x1F, 0xBE, 0x23, 0x09, 0x91, 0x2F, 0x5F, 0x3E, 0xFF, 0xC2, 0xA9, 0xE9,
+    0x43, 0x91, 0x0C, 0x95, 0x62, 0x4B, 0xCA, 0x37, 0x2D, 0xE7, 0xB8, 0x9A, 0x7A, 0x61, 0x8C, 0x77,
+    0x7E, 0x65, 0xC6, 0x84, 0xE2, 0xF1, 0xAD, 0x1B, 0x9F, 0x7F, 0x86, 0x90, 0x0C, 0x9B, 0x9E, 0x39,
+    0x59, 0xD4, 0x81, 0x73, 0x32, 0x25, 0x37, 0x0A, 0xE5, 0x61, 0x05, 0xEC, 0x24, 0xCA, 0xF6, 0xB3,
+    0xB4, 0xC0, 0x7A, 0x98, 0x56, 0x29, 0x16, 0xC6, 0xEE, 0x64, 0xDE, 0xB2, 0x03, 0x10, 0x75, 0xFC,
+    0xFC, 0x2E, 0x98, 0xC6, 0x92, 0xAB, 0x96, 0xD2, 0x9E, 0x6E, 0x5B, 0xB5, 0xC4, 0xE5, 0xD6, 0x59,
+    0xB5, 0x7D, 0x1B, 0xA0, 0x8A, 0xDD, 0x86, 0x1B, 0x58, 0x4C, 0x85, 0x0B, 0xD5, 0x29, 0x54, 0x59,
+    0x58, 0xCB, 0x4A, 0x5B, 0x59, 0x8C, 0x96, 0x6B, 0x0C, 0x97, 0xAA, 0x82, 0xD4, 0x04, 0x08, 0x48,
+    0xAD, 0x65, 0x31, 0x1A, 0x6C, 0xD1, 0x4E, 0x2E, 0xC4, 0xAA, 0x7B, 0x43, 0x83, 0x09, 0x61, 0xCB,
+    0xF7, 0x4B, 0x56, 0xED, 0xC1, 0x15, 0x33, 0xAA, 0xEF, 0xF5, 0xC7, 0xD8, 0xE1, 0xE8, 0x33, 0xD0,
+    0xC3, 0x68, 0x32, 0x47, 0x6B, 0x69, 0x46, 0x9E, 0xA5, 0x02, 0xCB, 0x5D, 0x4B, 0x4A, 0x2F, 0x9E,
+    0x6F, 0x5A, 0x6D, 0x85, 0x51, 0x6E, 0xF9, 0xA3, 0x86, 0x1A, 0x02, 0xDB, 0xFA, 0xCE, 0x8E, 0xEB,
+    0x2D, 0xDE, 0xC0, 0xEE, 0x95, 0x2E, 0x38, 0xB4, 0x50, 0xC6, 0x3A, 0xC4, 0xF5, 0xB4, 0xAE, 0xFB,
+    0xEC, 0x19, 0x85, 0x7F, 0x85, 0xF3, 0x13, 0xF6, 0xB0, 0x85, 0x7B, 0xB9, 0x16, 0x1C, 0xD6, 0x2F,
+    0x23, 0xB4, 0x7A, 0xFD, 0x32, 0x51, 0x4C, 0x3C, 0x4A, 0x26, 0xF3, 0xF5, 0x33, 0xD6, 0xE2, 0x48,
+    0xEC, 0xB6, 0x17, 0xF1, 0x43, 0x89, 0xC5, 0x4D, 0x4C, 0xD3, 0xE1, 0x1A, 0xDB, 0xE2, 0x36, 0xC5,
+    0x8C, 0x53, 0x8F, 0xA2, 0xA6, 0xEB, 0x4D, 0x9C, 0x75, 0x8F, 0xC6, 0xCA, 0xD6, 0xD0, 0x5C, 0x08,
+    0x63, 0xCB, 0x9E, 0x9E, 0x2E, 0x29, 0xE7, 0x83, 0x1E, 0x6D, 0x7B, 0x68, 0xEC, 0xD1, 0x15, 0x4B,
+    0x11, 0x64, 0xA2, 0x04, 0x3E, 0x17, 0x80, 0x3D, 0x40, 0x33, 0xD6, 0x4B, 0xE8, 0x80, 0xFC, 0x43,
+    0x1E, 0xE7, 0x52, 0xC9, 0x12, 0x1B, 0x92, 0x2A, 0x63, 0xD5, 0x9D, 0xF6, 0xA1, 0xEB, 0x9F, 0xED,
+    0x54, 0x74, 0x97, 0xC7, 0x4E, 0x64, 0x13, 0x2E, 0xC3, 0x3A, 0x63, 0x82, 0x7C, 0x4D, 0x4B, 0xF9,
+    0x73, 0xD3, 0x86, 0xFB, 0x26, 0xE3, 0x0B, 0x9F, 0x2F, 0xA3, 0x5A, 0x29, 0xDB, 0xEC, 0xBF, 0x11,
+    0xBC, 0x0E, 0x95, 0x0C, 0x4B, 0x37, 0x1E, 0x55, 0xA8, 0x49, 0xA0, 0x58, 0x45, 0x92, 0x61, 0x29,
+    0x39, 0xCB, 0x59, 0x28, 0xA9, 0xF0, 0xA3, 0x23, 0xB9, 0x47, 0x7B, 0xEE, 0x19, 0x79, 0x06, 0x08,
+    0x45, 0xEA, 0x2A, 0x2A, 0xFE, 0x87, 0xA9, 0xC1, 0x32, 0x9C, 0xF8, 0x4D, 0xF2, 0xA5, 0xE7, 0xB6,
+    0xCA, 0x33, 0xAA, 0x48, 0x29, 0x28, 0x7E, 0x00, 0x0F, 0xB0, 0x5B, 0xEA, 0x25, 0x51, 0xDF, 0xE0,
+    0x8C, 0x3F, 0xAB, 0x0A, 0x7B, 0x9C, 0x95, 0xB8, 0xE9, 0x9B, 0x5A, 0xC0, 0x0B, 0xA3, 0xEE, 0x3E,
+    0x5C, 0xCF, 0x40, 0x2E, 0x60, 0x89, 0x41, 0x8C, 0xE1, 0x4E, 0x9E, 0x0D, 0x5F, 0x8F, 0x02, 0x94,
+    0x44, 0xEF, 0xA2, 0x8E, 0xCC, 0xD9, 0x9F, 0x64, 0x8F, 0x53, 0x33, 0xEE, 0xC4, 0xBC, 0x16, 0x77,
+    0xF8, 0x25, 0xA7, 0x00, 0x81, 0x6B, 0x1C, 0x65, 0x65, 0x71, 0xC7, 0xF1, 0x7A, 0x1F, 0x08, 0xD2,
+    0x49, 0xCE, 0x78, 0x20, 0xFB, 0xA4, 0x17, 0xC4, 0xDF, 0x45, 0x35, 0x1D, 0x0D, 0x41, 0x16, 0x02,
+    0x0C, 0xE4, 0x40, 0x7E, 0x48, 0x3F, 0x23, 0x2A, 0x7A, 0x3D, 0x97, 0x24, 0x17, 0x54, 0x9B, 0x1D,
+    0x49, 0x32, 0x8B, 0xBC, 0xBC, 0x5B, 0xB3, 0x69, 0xB8, 0x0E, 0x50, 0x91, 0x55, 0x86, 0xC4, 0x36,
+    0x2D, 0x84, 0x6C, 0xC7, 0xF7, 0x38, 0xFA, 0xC7, 0xEE, 0xB2, 0xD7, 0xB2, 0x91, 0x51, 0x82, 0x07,
+    0x28, 0x3C, 0x6D, 0x24, 0x96, 0xAB, 0x17, 0xB5, 0x31, 0x62, 0x6D, 0xC2, 0xC2, 0x54, 0x1D, 0x92,
+    0x51, 0x43, 0xBB, 0x34, 0xB5, 0xF5, 0x66, 0xCB, 0xC0, 0xB7, 0x35, 0x52, 0xA4, 0x27, 0x69, 0xF2,
+    0x4D, 0x2F, 0xF1, 0x8B, 0xF6, 0x5F, 0x9D, 0x89, 0x55, 0xB5, 0x5E, 0xDF, 0xFD, 0xF8, 0x7A, 0x77,
+    0x9F, 0x52, 0x1B, 0x38, 0xC5, 0x97, 0xC1, 0x25, 0x3E, 0x1C, 0xA0, 0x4E, 0x7B, 0xB2, 0xBF, 0x15,
+    0xD5, 0x23, 0xF1, 0x5F, 0x55, 0x9F, 0x02, 0x90, 0xE7, 0x4F, 0x10, 0xF2, 0x7C, 0xB7, 0xC9, 0x0D,
+    0x77, 0x39, 0xAB, 0x9F, 0x24, 0xD7, 0xEE, 0x85, 0xC8, 0x44, 0x6E, 0x11, 0xF2, 0xD4, 0xEE, 0xC9,
+    0x95, 0x76, 0x73, 0x37, 0xB8, 0x67, 0xF7, 0x4A, 0xC7, 0x18, 0x6E, 0xF1, 0x23, 0xAF, 0xEC, 0x5E,
+    0xD5, 0x30, 0x80, 0x57, 0x0A, 0xEF, 0xD7, 0x5C, 0xB1, 0x87, 0x3E, 0x97, 0x07, 0x5E, 0x61, 0x9B,
+    0x2D, 0x07, 0x6C, 0x84, 0x0F, 0xF6, 0x5B, 0xAC, 0xDB, 0xC1, 0x5E, 0x61, 0xFA, 0x9C, 0x20, 0x36,
+    0xB5, 0x0F, 0x07, 0x11, 0x3C, 0xB3, 0x64, 0xD9, 0x60, 0x5C, 0xD9, 0xB7, 0xC3, 0x41, 0xB4, 0x11,
+    0xD2, 0x5E, 0xFB, 0x08, 0x49, 0x3C, 0xD0, 0x6E, 0x17, 0x60, 0x30, 0x41, 0xEB, 0x01, 0xA7, 0x7A,
+    0x6A, 0x07, 0x76, 0xAF, 0xCB, 0x4A, 0xEA, 0x56, 0x35, 0xD7, 0x11, 0xFE, 0xB2, 0x46, 0x1F, 0x64,
+    0x72, 0xD3, 0x8B, 0x3C, 0x69, 0x59, 0xC8, 0xCD, 0x74, 0x0F, 0x84, 0x8A, 0x2E, 0xB1, 0x78, 0x44,
+    0xCE, 0x46, 0xED, 0xB3, 0x21, 0x99, 0x4B, 0x1C, 0xDD, 0x6B, 0xB3, 0x17, 0x58, 0xB4, 0x36, 0x9F,
+    0x6A, 0x1F, 0xF7, 0x56, 0x85, 0xD6, 0xE5, 0xEC, 0x2E, 0x59, 0x61, 0x69, 0xD6, 0x5E, 0x0C, 0x83,
+    0x31, 0xBE, 0x4E, 0x3D, 0x0C, 0xE2, 0x83, 0xAD, 0x5A, 0x3B, 0x83, 0xA6, 0x78, 0xDD, 0x04, 0x69,
+    0x09, 0x72, 0x4B, 0x9D, 0xDD, 0x7C, 0x47, 0x8E, 0x09, 0x55, 0xE0, 0x59, 0xE2, 0x9D, 0x86, 0x10,
+    0xC7, 0xC7, 0xC7, 0xFF, 0xA9, 0x96, 0x7B, 0x3A, 0x55, 0x4C, 0x1A, 0xA2, 0x55, 0xEA, 0xCA, 0x6C,
+    0x79, 0xFC, 0xD6, 0x95, 0xF5, 0x7E, 0xD8, 0xEA, 0x69, 0xEB, 0x7B, 0xFF, 0x5F, 0xBA, 0x7F, 0x01,
+    0x0F, 0x7F, 0xF5, 0x77, 0xBD, 0x1B, 0x00, 0x00,
+};
+
+// style.css: 992 bytes -> 453 bytes gzip
+static const uint8_t STYLE_CSS_GZ[] PROGMEM = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8D, 0x53, 0x6D, 0x8F, 0x9B, 0x30,
+    0x0C, 0xFE, 0xDE, 0x5F, 0x81, 0x74, 0x9A, 0xB4, 0x49, 0xC7, 0x14, 0xBA, 0x6B, 0xD5, 0x86, 0x2F,
+    0xB7, 0x9F, 0x62, 0x12, 0x07, 0xB2, 0x0B, 0x09, 0x4A, 0xCC, 0x95, 0x0A, 0xF1, 0xDF, 0x97, 0x5C,
+    0xA1, 0xA5, 0xBD, 0x9D, 0x34, 0x59, 0xA0, 0xC4, 0xF1, 0xE3, 0x97, 0xC7, 0x76, 0xE5, 0xE4, 0x79,
+    0x54, 0xCE, 0x52, 0xAE, 0xA0, 0xD5, 0xE6, 0xCC, 0x7F, 0x7B, 0x0D, 0xE6, 0x39, 0x80, 0x0D, 0x79,
+    0x40, 0xAF, 0x55, 0xD9, 0x82, 0xAF, 0xB5, 0xE5, 0xAC, 0xEC, 0x40, 0x4A, 0x6D, 0x6B, 0xBE, 0x65,
+    0xDD, 0x50, 0x0A, 0x67, 0x9C, 0xE7, 0x4F, 0xC8, 0x92, 0x44, 0x9B, 0x21, 0x3F, 0x69, 0x49, 0x0D,
+    0x3F, 0xB0, 0xF4, 0xBA, 0x60, 0x32, 0xE8, 0xC9, 0x95, 0x15, 0x88, 0xB7, 0xDA, 0xBB, 0xDE, 0xCA,
+    0x7C, 0x86, 0x15, 0x98, 0xA4, 0x9C, 0x36, 0x4D, 0x31, 0xCE, 0x2A, 0xC6, 0x8E, 0x47, 0xB5, 0x44,
+    0xCB, 0xC9, 0x75, 0x97, 0x38, 0xF3, 0xBD, 0x72, 0x44, 0xAE, 0xE5, 0x45, 0x52, 0x45, 0xD4, 0xF6,
+    0x86, 0x12, 0xE2, 0x7F, 0x51, 0x3F, 0x03, 0x01, 0x45, 0xDD, 0x30, 0xDE, 0x12, 0xE2, 0x4F, 0x5B,
+    0x99, 0xE4, 0x5A, 0x5C, 0xB1, 0x8B, 0xB6, 0x95, 0xF3, 0x12, 0x7D, 0xEE, 0x41, 0xEA, 0x3E, 0xF0,
+    0xDD, 0x67, 0x87, 0xBB, 0x95, 0xC3, 0xDA, 0x6B, 0x39, 0x4A, 0x1D, 0x3A, 0x03, 0x67, 0x9E, 0x2E,
+    0x65, 0xFA, 0xE5, 0x84, 0x6D, 0xD4, 0x10, 0xA6, 0x92, 0xFB, 0xD6, 0x06, 0x5E, 0x28, 0x9F, 0xC5,
+    0xAF, 0xAC, 0xA1, 0xBB, 0xCF, 0x48, 0x47, 0xD3, 0xAB, 0x03, 0x65, 0x70, 0x28, 0xFF, 0xF4, 0x81,
+    0xB4, 0x3A, 0x47, 0xA8, 0x25, 0xB4, 0xC4, 0x43, 0x07, 0x02, 0xF3, 0x0A, 0xE9, 0x84, 0x68, 0x13,
+    0xCE, 0x40, 0x85, 0xE6, 0xD2, 0xB6, 0x13, 0xEA, 0xBA, 0x21, 0x5E, 0x39, 0x23, 0x97, 0xA6, 0x08,
+    0x96, 0x24, 0xD9, 0x25, 0x07, 0xDE, 0x99, 0x30, 0x3E, 0x12, 0x74, 0x5F, 0xEE, 0x9A, 0x0E, 0xF8,
+    0x05, 0x2F, 0xF0, 0x0F, 0x06, 0xA2, 0xB7, 0x8A, 0xEC, 0x1D, 0x75, 0x8C, 0x1D, 0x0E, 0x42, 0xCC,
+    0x51, 0x4F, 0x4D, 0xAC, 0x63, 0xC6, 0x71, 0xEB, 0x2C, 0x5E, 0x63, 0x1C, 0xBA, 0x21, 0x2B, 0x56,
+    0x24, 0xFA, 0x8F, 0x84, 0x8B, 0x2F, 0xFA, 0x74, 0x1F, 0xF9, 0x25, 0x8D, 0x5A, 0xEF, 0x43, 0x0C,
+    0xD0, 0x39, 0x1D, 0xD9, 0xF0, 0x73, 0x22, 0xBC, 0x71, 0xEF, 0xE8, 0x1F, 0xD2, 0xD9, 0xEF, 0x8F,
+    0xC7, 0xF4, 0x4E, 0x10, 0xDE, 0xC2, 0x78, 0x19, 0xC8, 0x82, 0xB1, 0x6F, 0xEB, 0xF9, 0x58, 0x07,
+    0x89, 0x99, 0x1B, 0xE8, 0x02, 0xF2, 0xE5, 0x70, 0x05, 0x67, 0xD4, 0x3C, 0x2F, 0x27, 0x39, 0x12,
+    0x0E, 0x94, 0x83, 0xD1, 0xB5, 0xE5, 0x06, 0x15, 0xDD, 0x36, 0x21, 0x56, 0xB6, 0xBF, 0x70, 0xB3,
+    0xA0, 0xC6, 0x4F, 0x3D, 0x50, 0xCE, 0xC5, 0xB4, 0xD7, 0x3E, 0x04, 0x7E, 0x14, 0xF2, 0xD8, 0x93,
+    0x69, 0x03, 0x0F, 0x63, 0x3D, 0x6D, 0x5E, 0x5B, 0x94, 0x1A, 0xB2, 0xEF, 0xB7, 0x05, 0xDB, 0xA7,
+    0x05, 0xFB, 0x31, 0xAE, 0x66, 0xEF, 0xCB, 0x71, 0x2B, 0xA7, 0x69, 0xF3, 0x17, 0x61, 0xE9, 0x62,
+    0x64, 0xE0, 0x03, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+    {"/app.js", "application/javascript", APP_JS_GZ, sizeof(APP_JS_GZ)},
+    {"/", "text/html", INDEX_HTML_GZ, sizeof(INDEX_HTML_GZ)},
+    {"/style.css", "text/css", STYLE_CSS_GZ, sizeof(STYLE_CSS_GZ)},
+};
+static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);
@@ -1,16 +1,151 @@
 #pragma once
-#include <Arduino.h>
 
-struct ZelloAudioPacket {
-    static const uint8_t FRAME_MARKER[4];  // {0x6C, 0x2A, 0x0D, 0x01}
-    static const size_t HEADER_SIZE = 16;  // 12 null bytes + 4 frame marker
+// The part of the Zello channel API the client speaks, without the transport:
+// audio packet framing, the fields read from JSON messages, and the
+// start_stream / stop_stream commands. src/main.cpp uses it between the
+// WebSocket and the mixer, and tools/zello_link_check.cpp drives the same
+// code against tools/zello_sim.py on the host.
+//
+// Audio packets, both ways: [type 0x01][stream_id][packet_id][Opus], both ids
+// 32-bit big-endian. JSON fields are found by their "key": prefix, as the
+// server sends them flat and unescaped.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "json_buffer.h"
+
+#define ZELLO_AUDIO_PACKET 0x01
+#define ZELLO_PACKET_HEADER 9   // type, stream_id, packet_id
+
+struct ZelloPacket {
+    uint32_t streamId;
+    uint32_t packetId;
+    const uint8_t* opus;   // points into the message
+    size_t opusLen;
+};
+
+// Splits a binary message; false if it is not an audio packet
+inline bool zelloParsePacket(const uint8_t* data, size_t len, ZelloPacket& packet) {
+    if (len < ZELLO_PACKET_HEADER || data[0] != ZELLO_AUDIO_PACKET) return false;
+    packet.streamId = ((uint32_t)data[1] << 24) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 8) | data[4];
+    packet.packetId = ((uint32_t)data[5] << 24) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 8) | data[8];
+    packet.opus = data + ZELLO_PACKET_HEADER;
+    packet.opusLen = len - ZELLO_PACKET_HEADER;
+    return true;
+}
+
+// Frames one Opus packet for sending; out holds ZELLO_PACKET_HEADER + opusLen bytes
+inline size_t zelloFramePacket(uint8_t* out, uint32_t streamId, uint32_t packetId, const uint8_t* opus,
+                               size_t opusLen) {
+    out[0] = ZELLO_AUDIO_PACKET;
+    for (int i = 0; i < 4; i++) {
+        out[1 + i] = streamId >> (24 - 8 * i);
+        out[5 + i] = packetId >> (24 - 8 * i);
+    }
+    memcpy(out + ZELLO_PACKET_HEADER, opus, opusLen);
+    return ZELLO_PACKET_HEADER + opusLen;
+}
+
+// True if msg is the "command":"<command>" message
+inline bool zelloIsCommand(const char* msg, const char* command) {
+    const char* p = strstr(msg, "\"command\":\"");
+    if (!p) return false;
+    p += 11;
+    size_t n = strlen(command);
+    return strncmp(p, command, n) == 0 && p[n] == '"';
+}
+
+// "key":"value" into out (truncated to cap - 1 bytes); 0 and "" when absent
+inline size_t zelloJsonString(const char* msg, const char* key, char* out, size_t cap) {
+    if (cap) out[0] = 0;
+    size_t keyLen = strlen(key);
+    for (const char* p = strstr(msg, key); p; p = strstr(p + 1, key)) {
+        if (p == msg || p[-1] != '"' || strncmp(p + keyLen, "\":\"", 3) != 0) continue;
+        const char* start = p + keyLen + 3;
+        const char* end = strchr(start, '"');
+        if (!end || !cap) return 0;
+        size_t len = (size_t)(end - start) < cap - 1 ? (size_t)(end - start) : cap - 1;
+        memcpy(out, start, len);
+        out[len] = 0;
+        return len;
+    }
+    return 0;
+}
+
+// "key":123 (or "key":"123")
+inline bool zelloJsonUInt(const char* msg, const char* key, uint32_t& value) {
+    size_t keyLen = strlen(key);
+    for (const char* p = strstr(msg, key); p; p = strstr(p + 1, key)) {
+        if (p == msg || p[-1] != '"' || strncmp(p + keyLen, "\":", 2) != 0) continue;
+        const char* v = p + keyLen + 2;
+        if (*v == '"') v++;
+        if (*v < '0' || *v > '9') return false;
+        value = strtoul(v, nullptr, 10);
+        return true;
+    }
+    return false;
+}
+
+// on_stream_start's codec_header: base64 of [rate u16 LE][frames per packet][frame ms]
+struct ZelloCodecHeader {
+    uint8_t raw[4];
+    uint16_t sampleRate;
+    uint8_t framesPerPacket;
+    uint8_t frameMs;
 };
 
-struct ZelloStreamInfo {
-    String type;           
-    String codec;         
-    int packet_duration;  
-    int stream_id;       
-    String from;         
-    String codec_header; 
-};
\ No newline at end of file
+inline bool zelloCodecHeader(const char* msg, ZelloCodecHeader& header) {
+    char text[16];
+    if (zelloJsonString(msg, "codec_header", text, sizeof(text)) != 8 || strcmp(text + 6, "==") != 0) {
+        return false;   // 4 bytes encode as 6 characters and "=="
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; i++) {
+        char c = text[i];
+        int v = c >= 'A' && c <= 'Z' ? c - 'A'
+              : c >= 'a' && c <= 'z' ? c - 'a' + 26
+              : c >= '0' && c <= '9' ? c - '0' + 52
+              : c == '+' ? 62 : c == '/' ? 63 : -1;
+        if (v < 0) return false;
+        bits = bits << 6 | v;
+    }
+    for (int i = 0; i < 4; i++) header.raw[i] = bits >> (28 - 8 * i);   // 36 bits, 4 of them padding
+    header.sampleRate = header.raw[0] | (header.raw[1] << 8);
+    header.framesPerPacket = header.raw[2];
+    header.frameMs = header.raw[3];
+    return true;
+}
+
+// What the client transmits: 16 kHz mono Opus, one 20 ms frame per packet
+#define ZELLO_TX_CODEC_HEADER "gD4BFA=="
+#define ZELLO_TX_PACKET_MS 20
+
+inline size_t zelloStartStream(char* buf, size_t cap, uint32_t seq, const char* channel) {
+    JsonBuffer json(buf, cap);
+    json.beginObject();
+    json.add("command", "start_stream");
+    json.add("seq", (unsigned long)seq);
+    json.add("channel", channel);
+    json.add("type", "audio");
+    json.add("codec", "opus");
+    json.add("codec_header", ZELLO_TX_CODEC_HEADER);
+    json.add("packet_duration", ZELLO_TX_PACKET_MS);
+    json.endObject();
+    return json.overflowed() ? 0 : json.length();
+}
+
+inline size_t zelloStopStream(char* buf, size_t cap, uint32_t seq, uint32_t streamId) {
+    JsonBuffer json(buf, cap);
+    json.beginObject();
+    json.add("command", "stop_stream");
+    json.add("seq", (unsigned long)seq);
+    json.add("stream_id", (unsigned long)streamId);
+    json.endObject();
+    return json.overflowed() ? 0 : json.length();
+}
+
+// The reply to start_stream: true with the stream id to send under
+inline bool zelloStartReply(const char* msg, uint32_t& streamId) {
+    return strstr(msg, "\"success\":true") && zelloJsonUInt(msg, "stream_id", streamId);
+}
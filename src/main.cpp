@@ -3,13 +3,36 @@
 #include <ArduinoWebsockets.h>
 #include <FS.h>
 #include <SPIFFS.h>
-#include <WebServer.h> // Include the WebServer library
-#include <Update.h>  // Add this for OTA functionality
-#include <mbedtls/base64.h> // Add this include for base64 decoding
+#include <ESPAsyncWebServer.h> // Event-driven HTTP server, runs in its own AsyncTCP task
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
+#include <memory>
+#if ZELLO_TRACE
+#include "esp_ipc.h"
+#include "esp_timer.h"
+#endif
 #include <opus.h> // Add this include for OPUS encoding
+#include "web_assets.h"  // Gzip'd dashboard (generated from web/)
+#include "json_buffer.h"
+#include "task_bridge.h"
+#include "metrics.h"
+#include "trace.h"
+#include "binlog.h"
+#include "stream_recorder.h"
+#include "packet_history.h"
+#include "channel_mixer.h"
+#include "message_queue.h"
+#include "zello_protocol.h"
+#include "ogg_opus_muxer.h"   // opusPacketSamples48k
+#include "ota_pipeline.h"
+#include "input_events.h"
+#include "output_gain.h"
+#include "noise_suppressor.h"
+#include "echo_canceller.h"
+#include "tone_generator.h"
+#include "task_layout.h"
+#include "task_monitor.h"
 
 // Audio-tools includes for handling OPUS
 #include "AudioTools.h"
@@ -61,22 +84,29 @@ void printUtf8HexBytes(const char* str, const char* label) {
 // Volume control settings (only define once)
 static uint8_t volume = 40;        // Start at ~63% volume (0-63 range)
 const uint8_t volume_step = 5;     // Larger steps for quicker adjustment
-float initialVolumeFloat = 0.63f;  // Store the initial float volume set in setup
+#define CODEC_OUTPUT_VOLUME 0.32f  // set once; volume is digital (about the old 0.2 playback level at 40/63)
 
 #define PTT_PIN 36  // GPIO for PTT button
 
+// Transmit noise suppression must fit its share of a 20 ms frame; this many
+// frames in a row over budget switch it off for the rest of the over
+#define NS_BUDGET_US 2000
+#define NS_OVER_BUDGET_FRAMES 25
+
+// Full duplex reads the speaker reference this far ahead of the mic frame, so the
+// echo path's bulk delay lands inside the canceller's taps even where the
+// capture timestamp is a little late
+#define AEC_REF_LEAD_US 8000
+
+// Cues on the speaker, before the volume gain; the roger beep in transmitted audio
+#define CUE_LEVEL_Q15 4000
+#define ROGER_LEVEL_Q15 6000
+
 using namespace websockets;
 
 // Forward declarations and structures
-class WebServer; // Keep this one
 
 // Structure definitions
-struct OpusConfig {
-    uint16_t sampleRate;
-    uint8_t framesPerPacket;  // Fix: removed typo uint88_t
-    uint8_t frameSizeMs;
-};
-
 struct OpusPacket {
     const uint8_t* data;
     size_t length;
@@ -85,14 +115,10 @@ struct OpusPacket {
 };
 
 // Global variables
-WebServer server(80);
+AsyncWebServer server(80);
 // Use AudioBoardStream wrapping the specific AudioBoard instance for AC101
 // Note: AudioKitAC101 is defined in AudioBoard.h from audio-driver library
 audio_tools::AudioBoardStream out(audio_driver::AudioKitAC101); 
-// Add Audio-tools related objects - update to use correct namespaces
-audio_tools::OpusAudioDecoder opusDecoder;
-audio_tools::EncodedAudioStream *decoderStream = nullptr; // Will connect decoder to audio output
-audio_tools::AudioInfo audioInfo;
 
 // Add these global variables near the top with other declarations
 unsigned long streamStartTime = 0;
@@ -107,15 +133,36 @@ WebsocketsClient client;
 String ssid;
 String password;
 String token;
-const char* websocket_server = "wss://zello.io/ws"; // Use wss:// for secure WebSocket
+// server= and server_cert= in the config point the client elsewhere, e.g. at a local
+// tools/zello_sim.py; ws:// skips TLS
+String websocketServer = "wss://zello.io/ws";
+String serverCertPath = "/zello-io.crt";
 
 // Add these variables for Zello credentials
 String zelloUsername = "Gabriel Huang";  // Default value
 String zelloPassword = "22433897";      // Default value
 String zelloChannel = "ZELLO無線聯合網";   // Default value
 
-// Replace these variables for OPUS handling
-bool decoderInitialized = false;
+// Channels followed at logon: zelloChannel (also the one PTT transmits on) plus the
+// ini's "monitor=Name:prio,Name:prio" list. While a higher-priority channel talks,
+// lower ones are ducked, or silenced with priority_mode=preempt. overlap_policy says
+// what a stream starting while an equal or higher priority talks gets: mix, queue
+// (played after, see MessageQueue) or drop.
+#define MAX_CHANNELS 4
+#define PRIMARY_CHANNEL_PRIORITY 1
+struct ChannelSubscription {
+    String name;
+    uint8_t priority;
+};
+ChannelSubscription subscriptions[MAX_CHANNELS];
+uint8_t subscriptionCount = 0;
+String monitorChannels = "";
+bool priorityPreempt = false;
+String overlapPolicy = "mix";
+bool queueCatchUp = true;      // shorten pauses while a queued backlog plays
+bool fullDuplex = false;       // duplex=full: I2S in and out at once, the speaker stays on while transmitting
+enum class OverlapPolicy : uint8_t { Mix, Queue, Drop };
+OverlapPolicy overlap = OverlapPolicy::Mix;
 
 // NTP client variables - Commented out
 // WiFiUDP ntpUDP;
@@ -129,43 +176,347 @@ uint8_t enhancementProfile = 1; // 0=None, 1=Voice, 2=Music
 unsigned long lastPingTime = 0;
 const unsigned long PING_INTERVAL = 30000; // Send ping every 30 seconds
 
-// Add variables for button state tracking
-bool lastPlayState = HIGH;
-bool lastVolUpState = HIGH;
-bool lastVolDownState = HIGH;
-
 // Add these global variables near the top with other globals
 String caCertificate;  // Store the CA certificate globally for reconnection attempts
 
-bool lastPTTState = HIGH;
-bool isTransmitting = false;
-
-// Add global for TX task handle
+// TX task, woken straight from the PTT interrupt
 TaskHandle_t txTaskHandle = nullptr;
 volatile bool txActive = false;
+volatile bool wsConnected = false;     // loop()'s view of client.available(), for the TX task
+
+// Stream traffic from the TX task. Only loopTask touches the WebSocket client:
+// loop() sends these before client.poll(), framing them with the stream id the
+// server returned for start_stream. Frames wait in the queue for that reply.
+#define TX_QUEUE_DEPTH 16              // 320 ms of frames: the start_stream round trip
+#define TX_START_TIMEOUT_MS 3000       // no start_stream reply: the over is dropped
+struct TxMessage {
+    enum Kind : uint8_t { Start, Frame, Stop } kind;
+    uint16_t len;                      // Frame: Opus bytes
+    uint8_t opus[512];
+};
+CommandQueue<TxMessage, TX_QUEUE_DEPTH> txMessages;
+// Outgoing stream, loop() only: Starting until the start_stream reply names it
+enum class TxState : uint8_t { Idle, Starting, Streaming, Refused };
+TxState txState = TxState::Idle;
+uint32_t txSeq = 1;                    // last seq sent; the logon is 1
+uint32_t txStartSeq = 0;               // seq of the pending start_stream
+unsigned long txStartMs = 0;
+uint32_t txStreamId = 0;
+uint32_t txPacketId = 0;
+NoiseSuppressor noiseSuppressor;       // TX task only, after setup
+volatile bool noiseSuppress = true;    // dashboard switch, read by the TX task at each PTT press
+EchoCanceller echoCanceller;           // TX task only, full duplex
+EchoReference echoReference;           // written by the playback task as blocks go to I2S, read by the TX task
+ToneGenerator cues;                    // any task requests, the playback task plays
+volatile bool rogerBeep = false;       // dashboard switch: a beep ends each over
+bool endOfMessageCue = false;          // set by loop() when the last live stream ends, cued once it has played out
+
+// Held by whoever drives I2S and the codec (the playback task, the TX task for the
+// microphone) and by loop() whenever it touches the mixer, which playback reads
+SemaphoreHandle_t audioDeviceMutex = nullptr;
+struct AudioDeviceLock {
+    AudioDeviceLock() { xSemaphoreTakeRecursive(audioDeviceMutex, portMAX_DELAY); }
+    ~AudioDeviceLock() { xSemaphoreGiveRecursive(audioDeviceMutex); }
+};
 
 // Add a global flag to track if playback is active
 bool playbackActive = false;
 
-// Add global for current stream ID (max 8 bytes, null-terminated)
-char currentStreamId[9] = {0};
+// Per-request cost of the web endpoints (latency and heap delta)
+struct HttpRequestStats {
+    uint32_t count;
+    uint32_t lastUs;
+    uint32_t maxUs;
+    int32_t lastHeapDelta;   // bytes of heap consumed by the request (negative = freed)
+};
+HttpRequestStats dashboardHttpStats = {0, 0, 0, 0};
+HttpRequestStats apiHttpStats = {0, 0, 0, 0};
+
+// The HTTP server runs in its own task. It never touches the audio/network objects
+// directly: it reads a StatusSnapshot published by loop() and posts WebCommands back.
+struct StatusSnapshot {
+    uint8_t volume;
+    bool muted;
+    bool ampOn;
+    bool wsConnected;
+    bool streamActive;
+    bool enhanceAudio;
+    bool agc;
+    bool noiseSuppress;
+    bool rogerBeep;
+    uint8_t enhancementProfile;
+    int totalPackets;
+    uint32_t streamMs;
+    uint32_t audioUnderruns;
+    uint32_t i2sUnderruns;
+    uint8_t dmaCount;
+    uint16_t dmaFrames;
+    int16_t driftPpm;             // lead talker's clock against I2S, as compensated
+    uint16_t packetsPerSec10;     // packets/s x10
+    uint16_t bufferMs;            // estimated audio queued for playout
+    uint16_t decodeUs;
+    char channel[128];
+    char talker[64];
+    char streamId[11];            // decimal uint32, "" when no stream is live
+    uint8_t historyCount;
+    int8_t replayIndex;           // -1 when not replaying
+    uint16_t replaySpeed;
+    char replayTalker[32];
+    bool recording;
+    uint8_t liveStreams;
+    uint8_t heldStreams;          // messages waiting in the queue (overlap_policy=queue)
+    bool preempt;                 // priority_mode: a priority channel silences the others
+    char overlap[6];              // overlap_policy in effect: mix, queue or drop
+    uint16_t decodeLoadPermille;  // share of one core spent in opus_decode
+};
+SharedSnapshot<StatusSnapshot> statusSnapshot;
+
+enum class WebCommandType : uint8_t {
+    VolumeUp,
+    VolumeDown,
+    SpeakerOn,
+    SpeakerOff,
+    SetMuted,
+    SetEnhance,
+    SetAgc,
+    SetNoiseSuppress,
+    SetRogerBeep,
+    NextProfile,
+    SetRecording,
+    Replay,
+    SetReplaySpeed,
+    SetDmaBuffers,
+    Reconnect,
+    Reboot,
+    ApplyConfig
+};
+
+// Form values from the config pages; allocated by the HTTP task, applied and freed by loop()
+struct ConfigUpdate {
+    enum Kind : uint8_t { WiFi, Zello } kind;
+    bool hasSsid = false, hasPassword = false;
+    bool hasUsername = false, hasZelloPassword = false, hasChannel = false, hasToken = false;
+    bool hasMonitor = false, hasPriorityMode = false, hasOverlapPolicy = false, hasCatchUp = false;
+    String ssid, password;
+    String username, zelloPassword, channel, token;
+    String monitor, priorityMode, overlapPolicy;
+    bool catchUp = false;
+};
+
+struct WebCommand {
+    WebCommandType type;
+    int32_t arg;
+    ConfigUpdate* config;
+};
+CommandQueue<WebCommand, 16> webCommands;
+
+// Guards the credential Strings, which loop() writes and the config pages read
+SemaphoreHandle_t configMutex = nullptr;
+
+// Metrics, exported on /metrics (Prometheus) and summarized in /api/status
+CounterMetric rxPacketsMetric("zello_rx_packets_total", "Audio packets received");
+CounterMetric rxBytesMetric("zello_rx_opus_bytes_total", "Opus payload bytes received");
+HistogramMetric rxInterarrivalMetric("zello_rx_packet_interarrival_us", "Time between consecutive audio packets");
+GaugeMetric rxJitterMetric("zello_rx_jitter_us", "Smoothed packet inter-arrival jitter (RFC 3550 estimator)");
+HistogramMetric decodeMetric("zello_decode_us", "Opus decode time per packet, excluding I2S writes");
+HistogramMetric i2sWriteMetric("zello_i2s_write_us", "Time blocked in I2S writes per 10 ms output block");
+HistogramMetric encodeMetric("zello_encode_us", "Opus encode time per 20 ms frame");
+HistogramMetric txNsMetric("zello_tx_ns_us", "Transmit noise suppression time per 20 ms frame");
+CounterMetric txNsBypassMetric("zello_tx_ns_bypassed_total", "Overs where noise suppression ran over budget and was switched off");
+HistogramMetric txAecMetric("zello_tx_aec_us", "Transmit echo cancellation time per 20 ms frame");
+GaugeMetric txAecErleMetric("zello_tx_aec_erle_db", "Echo return loss enhancement at the end of the last full-duplex over");
+HistogramMetric wsSendMetric("zello_ws_send_us", "WebSocket binary send latency");
+CounterMetric txDroppedMetric("zello_tx_frames_dropped_total", "Encoded frames dropped because loop() fell behind sending them");
+CounterMetric underrunMetric("zello_playback_underruns_total", "Times a stream's jitter buffer ran dry while playing");
+CounterMetric i2sUnderrunMetric("zello_i2s_underruns_total", "Times I2S ran out of queued audio while the output was on");
+CounterMetric concealMetric("zello_playback_concealed_ms_total", "Stream gaps filled with concealment and comfort noise");
+CounterMetric caughtUpMetric("zello_playback_caught_up_ms_total", "Latency removed by playing stream backlogs faster");
+GaugeMetric driftMetric("zello_playback_drift_ppm", "Estimated clock offset of the lead talker's sender against I2S");
+GaugeMetric decodeLoadMetric("zello_decode_load_permille", "Share of one core spent decoding Opus over the last second");
+CounterMetric mixBusyMetric("zello_mix_streams_refused_total", "Streams not played because every mixer slot was busy");
+CounterMetric mixDroppedMetric("zello_mix_streams_dropped_total", "Streams refused by overlap_policy=drop while another talked");
+CounterMetric mixEvictedMetric("zello_mix_evictions_total", "Streams that lost their mixer slot to a newer stream");
+CounterMetric mixQueuedMetric("zello_mix_streams_queued_total", "Streams held back by overlap_policy=queue until the floor was free");
+GaugeMetric queueDepthMetric("zello_queue_depth", "Messages waiting in the store-and-forward queue");
+GaugeMetric queueBytesMetric("zello_queue_bytes", "PSRAM bytes held by queued messages");
+HistogramMetric queueWaitMetric("zello_queue_wait_ms", "Time a queued message waited before it started playing");
+CounterMetric queueDroppedMetric("zello_queue_dropped_packets_total", "Packets lost because the message queue was full");
+CounterMetric queueSkippedMetric("zello_queue_catchup_skipped_ms_total", "Pause audio cut to catch up on queued messages");
+CounterMetric reconnectMetric("zello_ws_reconnects_total", "WebSocket reconnect attempts");
+CounterMetric reconnectFailMetric("zello_ws_reconnect_failures_total", "Failed WebSocket reconnect attempts");
+GaugeMetric heapFreeMetric("zello_heap_free_bytes", "Free heap");
+GaugeMetric heapLowWaterMetric("zello_heap_min_free_bytes", "Lowest free heap since boot");
+CounterMetric logDroppedMetric("zello_log_dropped_total", "Deferred log records dropped because the ring was full");
+CounterMetric recPayloadMetric("zello_rec_payload_bytes_total", "Opus bytes queued for recording");
+CounterMetric recFlashMetric("zello_rec_flash_bytes_total", "Bytes the recorder wrote to flash, capsules and index");
+CounterMetric recDroppedMetric("zello_rec_dropped_total", "Packets or streams the recorder had to drop");
+HistogramMetric recEnqueueMetric("zello_rec_enqueue_cycles", "CPU cycles the RX path spends handing a packet to the recorder");
+HistogramMetric recWriteMetric("zello_rec_flash_write_us", "Recorder flash write time per block");
+HistogramMetric otaWriteMetric("zello_ota_flash_write_us", "OTA flash erase and write time per 4 KB chunk");
+HistogramMetric otaStallMetric("zello_ota_upload_stall_us", "Time the OTA upload waited for the flash writer");
+GaugeMetric otaKbpsMetric("zello_ota_kbps", "Upload throughput of the last firmware update");
+GaugeMetric otaUnderrunMetric("zello_ota_underruns", "Playback underruns during the last firmware update");
+CounterMetric otaFailedMetric("zello_ota_failures_total", "Firmware updates rejected or aborted");
+HistogramMetric pttLatencyMetric("zello_ptt_latency_us", "PTT press to the first Opus frame being encoded");
+HistogramMetric inputLatencyMetric("zello_input_event_latency_us", "Button press to loop() acting on it");
+CounterMetric inputBouncesMetric("zello_input_bounces_total", "Contact bounces filtered by the input debounce");
+
+// Buttons and PTT: interrupts, debounce and long/double press in their own task
+InputEvents inputs(&inputBouncesMetric);
+int playInput = -1;
+int volUpInput = -1;
+int volDownInput = -1;
+int pttInput = -1;
+
+// Optional capture of incoming streams to SPIFFS, off until enabled from the dashboard
+StreamRecorder recorder(SPIFFS, {&recPayloadMetric, &recFlashMetric, &recDroppedMetric,
+                                 &recEnqueueMetric, &recWriteMetric});
+
+// Firmware updates: hashed in the HTTP task, written to flash by its own task
+OtaPipeline otaPipeline({&otaWriteMetric, &otaStallMetric, &otaKbpsMetric, &otaUnderrunMetric,
+                         &otaFailedMetric, &underrunMetric});
+
+// Last few minutes of received packets for instant replay (Play key / dashboard)
+PacketHistory history;
+#define REPLAY_AHEAD_MS 100    // decoded replay audio kept queued in its mixer slot
+#define REPLAY_OLDER 1         // Replay command args
+#define REPLAY_STOP -1
+#define REPLAY_STREAM_KEY 0xFFFFFFFFu   // mixer key of the replay stream, above any live one
+bool replayActive = false;
+uint8_t replayIndex = 0;       // 0 = most recent message
+uint16_t replaySpeed = 100;    // percent; 125 and 150 play back faster at the same pitch
+PacketHistory::Cursor replayCursor;
+
+// One decoder and jitter buffer per concurrent stream, mixed into the I2S output
+ChannelMixer mixer;
+// I2S DMA ring for playback: more buffers ride out longer playback task stalls, fewer
+// play sooner. i2s_dma_count / i2s_dma_frames in the config, the count also from
+// the dashboard. The output keeps the whole ring queued.
+#define I2S_DMA_COUNT_DEFAULT 4
+#define I2S_DMA_FRAMES_DEFAULT 160     // 10 ms at 16 kHz
+uint8_t i2sDmaCount = I2S_DMA_COUNT_DEFAULT;
+uint16_t i2sDmaFrames = I2S_DMA_FRAMES_DEFAULT;
+#define STREAM_IDLE_TIMEOUT_MS 5000    // a live stream without packets this long counts as stopped
+#define PLAYBACK_SERVICE_MS 5          // how often the playback task tops up the DMA ring
+#define AMP_SETTLE_MS 50               // amplifier on, I2S at zero, before the first block
+#define MIX_BLOCK_MS (MIX_BLOCK_SAMPLES * 1000 / PLAYBACK_SAMPLE_RATE)
+bool outputActive = false;             // I2S configured for playback and amplifier on
+unsigned long outputOnMs = 0;          // when beginPlayback() switched the amplifier on
+uint16_t outputTailMs = 0;             // silence written since the mixer ran out
+OutputGain outputGain;                 // volume, mute and fades, applied in the stereo pass
+int16_t outputMono[MIX_BLOCK_SAMPLES];
+int16_t outputStereo[MIX_BLOCK_SAMPLES * 2];
+
+// The DMA ring's depth: how far ahead the output writes
+uint16_t outputAheadMs() {
+    return (uint32_t)i2sDmaCount * i2sDmaFrames * 1000 / PLAYBACK_SAMPLE_RATE;
+}
+
+void applyDmaBuffers(I2SCodecConfig& cfg) {
+    cfg.buffer_count = i2sDmaCount;
+    cfg.buffer_size = i2sDmaFrames;   // frames per buffer (the driver's dma_buf_len)
+}
+
+// The recorder and replay history take one stream at a time: they follow the first
+// live stream that starts while neither is busy, which also feeds the jitter figures
+bool trackedStreamOpen = false;
+uint32_t trackedStreamId = 0;
+
+// Streams held back by overlap_policy=queue, played one by one once the floor is free
+MessageQueue messageQueue;
+#define QUEUE_AHEAD_MS 100             // decoded audio kept in the playing message's mixer slot
+#define QUEUE_CATCHUP_ON_MS 2000       // backlog that turns pause shortening on...
+#define QUEUE_CATCHUP_OFF_MS 500       // ...and where it goes off again
+QueuedMessage* queuePlaying = nullptr;
+
+unsigned long lastPacketUs = 0;   // arrival time of the previous tracked packet, 0 at stream start
+uint32_t i2sUsInWrite = 0;        // I2S time accumulated during the current output write
+
+// Sits in front of the board output so I2S blocking can be timed apart from decoding
+class I2SWriteTimer : public Print {
+public:
+    explicit I2SWriteTimer(Print& target) : _target(target) {}
+
+    size_t write(uint8_t b) override {
+        return write(&b, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t len) override {
+        TRACE_SCOPE(TRACE_I2S_WRITE);
+        uint32_t start = micros();
+        size_t written = _target.write(data, len);
+        i2sUsInWrite += micros() - start;
+        return written;
+    }
+
+    int availableForWrite() override {
+        return _target.availableForWrite();
+    }
+
+private:
+    Print& _target;
+};
+I2SWriteTimer timedOut(out);
+
+// Live RX figures for the telemetry push channel
+int streamSampleRate = 16000;        // codec header rate of the tracked stream
+uint32_t decodeUsAvg = 0;            // EWMA of opus_decode per packet, in us
+unsigned long playoutStartMs = 0;    // playout clock origin, restarted after an underrun
+uint32_t playoutSamplesWritten = 0;
+
+// Server-Sent Events channel: coalesced deltas, at most every TELEMETRY_INTERVAL_MS
+#define TELEMETRY_INTERVAL_MS 250
+#define TELEMETRY_KEYFRAME_MS 10000
+AsyncEventSource telemetryEvents("/events");
+volatile bool telemetryKeyframeRequested = false;
 
 // Forward declarations for functions
 void readCredentials();
 void setupOTAWebServer();
 OpusPacket findNextOpusPacket(const uint8_t* data, size_t len);
-bool initOpusDecoder(int sampleRate);
 void enableSpeakerAmp(bool enable);
 void volumeUp();
 void volumeDown();
 void setVolume(uint8_t vol);
+void setMuted(bool muted);
 void enhanceVoiceAudio(int16_t* buffer, int samples);
 void onMessageCallback(WebsocketsMessage message); 
 bool connectWebSocket();  // Add this missing declaration
+size_t buildStatusJson(char* buf, size_t cap);
+size_t buildTasksJson(char* buf, size_t cap);
+void publishStatusSnapshot();
+uint16_t playoutBufferMs();
+void startTelemetry();
+void startBinlog();
+void processWebCommands();
+bool postWebCommand(WebCommandType type, int32_t arg, ConfigUpdate* config = nullptr);
+void recordHttpStats(HttpRequestStats& stats, uint32_t startUs, uint32_t startHeap);
 
 // Add these forward declarations to fix the error
-void startTransmission();
+void audioTxTask(void* parameter);
+void playbackTask(void* parameter);
+bool startTransmission();
 void stopTransmission();
+void sendTxMessages();
+void txStartReply(const String& msg);
+void handleInputEvent(const InputEvent& ev);
+void parseSubscriptions();
+void beginPlayback();
+void endPlayback();
+void setDmaBuffers(int count, int frames);
+void beginFullDuplex();
+void serviceAudioOutput();
+void decodeOpusPacket(MixStream* stream, const uint8_t* opusData, size_t opusLen);
+void stopReplay(bool playOut);
+void replayCommand(int32_t arg);
+void serviceReplay();
+void serviceMessageQueue();
+#if ZELLO_LOG_BENCH
+void benchmarkLogging();
+#endif
+#if ZELLO_DECODE_BENCH
+void benchmarkDecode();
+#endif
 
 // Update the validateOpusPacket function
 bool validateOpusPacket(const uint8_t* data, size_t len) {
@@ -177,14 +528,11 @@ bool validateOpusPacket(const uint8_t* data, size_t len) {
     uint8_t c = toc & 0x3;            // Last 2 bits
 
     if (binaryPacketCount < DETAILED_PACKET_COUNT) {
-        Serial.printf("\nValidating OPUS packet:\n");
-        Serial.printf("- TOC: 0x%02X\n", toc);
-        Serial.printf("- Config: %d (mode=%s)\n", config, 
-            config <= 4 ? "SILK-only" : 
-            config <= 7 ? "Hybrid" : "CELT-only");
-        Serial.printf("- VBR flag: %d\n", s);
-        Serial.printf("- Channels: %d\n", c + 1);
-        Serial.printf("- Length: %d bytes\n", len);
+        ZLOGD("Validating OPUS packet: TOC=0x%02X config=%u (mode=%s) VBR=%u channels=%u length=%u",
+              toc, config,
+              config <= 4 ? "SILK-only" :
+              config <= 7 ? "Hybrid" : "CELT-only",
+              s, c + 1, (unsigned)len);
     }
 
     // Less strict validation for Zello packets
@@ -241,18 +589,32 @@ bool flushAudioAndWait(audio_tools::EncodedAudioStream* stream, int maxWaitMs =
 void onEventsCallback(WebsocketsEvent event, String data) {
     if (event == WebsocketsEvent::ConnectionOpened) {
         Serial.println("Connection Opened");
-        // Logon message with UTF-8 channel name
-        char logon[1024];
-        sprintf(logon, "{\"command\": \"logon\",\"seq\": 1,\"auth_token\": \"%s\",\"username\": \"%s\",\"password\": \"%s\",\"channel\": \"%s\"}", 
-               token.c_str(), 
-               zelloUsername.c_str(),
-               zelloPassword.c_str(),
-               zelloChannel.c_str());
+        cues.play(Cue::Connected);
+        // Logon message with UTF-8 channel names; several channels go in "channels"
+        char logon[1536];
+        JsonBuffer json(logon, sizeof(logon));
+        json.beginObject();
+        json.add("command", "logon");
+        json.add("seq", 1);
+        json.add("auth_token", token.c_str());
+        json.add("username", zelloUsername.c_str());
+        json.add("password", zelloPassword.c_str());
+        if (subscriptionCount > 1) {
+            json.beginArray("channels");
+            for (uint8_t i = 0; i < subscriptionCount; i++) {
+                json.add(nullptr, subscriptions[i].name.c_str());
+            }
+            json.endArray();
+        } else {
+            json.add("channel", zelloChannel.c_str());
+        }
+        json.endObject();
         // Remove the debug printing which shows auth token and other sensitive info
         // printUtf8HexBytes(logon, "Logon message UTF-8 bytes");
         client.send(logon);
     } else if (event == WebsocketsEvent::ConnectionClosed) {
         Serial.println("Connection Closed");
+        cues.play(Cue::Disconnected);
     } else if (event == WebsocketsEvent::GotPing) {
         Serial.println("Got Ping - Sending Pong");
         client.pong(); // This is correct - respond to ping with pong
@@ -311,6 +673,28 @@ void readCredentials() {
                 zelloUsername = value;
             } else if (key == "password_zello") {
                 zelloPassword = value;
+            } else if (key == "monitor") {
+                monitorChannels = value;
+                Serial.println("Monitor channels: " + monitorChannels);
+            } else if (key == "priority_mode") {
+                priorityPreempt = value == "preempt";
+            } else if (key == "overlap_policy") {
+                overlapPolicy = value;
+            } else if (key == "queue_catchup") {
+                queueCatchUp = value != "off";
+            } else if (key == "duplex") {
+                fullDuplex = value == "full";
+            } else if (key == "i2s_dma_count") {
+                i2sDmaCount = constrain(value.toInt(), 2, 16);
+            } else if (key == "i2s_dma_frames") {
+                i2sDmaFrames = constrain(value.toInt(), 40, 1024);
+            } else if (key == "backlog_speed") {
+                mixer.setBacklogSpeed(value.toInt());
+            } else if (key == "server") {
+                websocketServer = value;
+                Serial.println("Server: " + websocketServer);
+            } else if (key == "server_cert") {
+                serverCertPath = value;
             }
         }
     }
@@ -329,6 +713,7 @@ void readCredentials() {
 void enhanceVoiceAudio(int16_t* buffer, int samples) {
     // Skip if enhancement is disabled
     if (!enhanceAudio) return;
+    TRACE_SCOPE(TRACE_DSP);
 
     static int16_t prevSample = 0;
     static int16_t prevSamples[3] = {0, 0, 0};
@@ -368,11 +753,13 @@ void enhanceVoiceAudio(int16_t* buffer, int samples) {
 
 // Add this function before setup()
 bool connectWebSocket() {
-    if (caCertificate.length() == 0) {
+    // ws:// (e.g. a local tools/zello_sim.py) has no TLS, so no certificate is needed
+    bool secure = websocketServer.startsWith("wss://");
+    if (secure && caCertificate.length() == 0) {
         // Only load the certificate from SPIFFS if we haven't already
-        File certFile = SPIFFS.open("/zello-io.crt", "r");
+        File certFile = SPIFFS.open(serverCertPath, "r");
         if (!certFile) {
-            Serial.println("Failed to open zello-io.crt - cannot establish secure connection!");
+            Serial.printf("Failed to open %s - cannot establish secure connection!\n", serverCertPath.c_str());
             return false;
         }
         
@@ -383,16 +770,18 @@ bool connectWebSocket() {
     }
 
     Serial.println("Connecting to WebSocket server...");
-    // We need to set the certificate every time we connect
-    client.setCACert(caCertificate.c_str());
-    Serial.println("CA certificate set for SSL connection");
+    if (secure) {
+        // We need to set the certificate every time we connect
+        client.setCACert(caCertificate.c_str());
+        Serial.println("CA certificate set for SSL connection");
+    }
 
-    bool connected = client.connect(websocket_server);
+    bool connected = client.connect(websocketServer);
     if (!connected) {
         Serial.println("WebSocket connection failed!");
         // Check if certificate has issues
-        if (caCertificate.indexOf("BEGIN CERTIFICATE") == -1 || 
-            caCertificate.indexOf("END CERTIFICATE") == -1) {
+        if (secure && (caCertificate.indexOf("BEGIN CERTIFICATE") == -1 ||
+                       caCertificate.indexOf("END CERTIFICATE") == -1)) {
             Serial.println("ERROR: Certificate appears to be invalid. Check the format!");
         }
     }
@@ -402,7 +791,12 @@ bool connectWebSocket() {
 void setup() {
     Serial.begin(115200);
     delay(100);
+    audioDeviceMutex = xSemaphoreCreateRecursiveMutex();
     Serial.println("\n\n=== Booting Zello Client (using Audio-tools with AudioBoardStream) ===");
+    startBinlog();
+#if ZELLO_LOG_BENCH
+    benchmarkLogging();
+#endif
     
     // --- STEP 1: Initialize Audio ---
     Serial.println("Initializing Audio...");
@@ -411,6 +805,7 @@ void setup() {
     cfg.sample_rate = 48000;
     cfg.channels = 2;
     cfg.bits_per_sample = 16;
+    applyDmaBuffers(cfg);
     // Print the configuration 
     Serial.println("Attempting Audio Config:");
     Serial.printf("- Sample Rate: %d\n", cfg.sample_rate);
@@ -425,49 +820,13 @@ void setup() {
     } else {
         playbackActive = true;
         Serial.println("AudioBoardStream initialized successfully.");
-        initialVolumeFloat = volume / 63.0f;
-        // Set volume using the AudioBoardStream instance
-        out.setVolume(initialVolumeFloat); 
-        Serial.printf("Initial volume set to %d (%.2f)\n", volume, initialVolumeFloat);
-        
-        // Play a startup tone
-        Serial.println("Playing startup tone...");
-        enableSpeakerAmp(true);  // Enable amp for the tone
-        float toneVolume = 0.05f;  // Set master volume very low for the tone
-        Serial.printf("Temporarily setting master volume to %.2f for tone\n", toneVolume);
-        out.setVolume(toneVolume); 
-        delay(50);  // Short delay for amp and volume change
-        
-        // Generate tone
-        const int toneFrequency = 440;  // A4 note
-        const int toneDurationMs = 200;  // Play for 200ms
-        const int sampleRate = cfg.sample_rate;
-        const int numSamples = (sampleRate * toneDurationMs) / 1000;
-        const float amplitude = 0.1f;  // 10% amplitude
-        int16_t toneBuffer[128 * 2];
-        int samplesGenerated = 0;
+        // The codec stays at one level from here on; volume is applied digitally
+        out.setVolume(CODEC_OUTPUT_VOLUME);
+        setVolume(volume);
         
-        while (samplesGenerated < numSamples) {
-            int samplesInChunk = 0;
-            for (int i = 0; i < 128 && samplesGenerated < numSamples; ++i) {
-                float time = (float)samplesGenerated / sampleRate;
-                float sineValue = sin(2.0 * PI * toneFrequency * time);
-                int16_t sampleValue = (int16_t)(sineValue * 32767.0f * amplitude);
-                // Stereo output
-                toneBuffer[i * 2] = sampleValue;      // Left channel
-                toneBuffer[i * 2 + 1] = sampleValue;  // Right channel
-                samplesGenerated++;
-                samplesInChunk++;
-            }
-            // Write using the AudioBoardStream 'out'
-            out.write((uint8_t*)toneBuffer, samplesInChunk * 2 * sizeof(int16_t)); 
-        }
-        
-        delay(50);  // Short delay after tone
-        enableSpeakerAmp(false);  // Disable amp after tone
-        Serial.printf("Restoring master volume to %.2f\n", initialVolumeFloat);
-        out.setVolume(initialVolumeFloat); 
-        Serial.println("Startup tone finished.");
+        // Startup cue: played by the playback task once it runs, not blocking boot
+        cues.begin(CUE_LEVEL_Q15);
+        cues.play(Cue::Startup);
     }
     
     // --- END OF STEP 1 ---
@@ -478,6 +837,28 @@ void setup() {
         return;
     }
     readCredentials();
+    if (!recorder.begin()) {
+        Serial.println("Stream recorder unavailable");
+    }
+    if (!otaPipeline.begin()) {
+        Serial.println("OTA writer task unavailable");
+    }
+    if (messageQueue.begin()) {
+        Serial.printf("Message queue: %u KB\n", (unsigned)(QUEUE_BYTES / 1024));
+    } else {
+        Serial.println("Message queue unavailable (no PSRAM): overlap_policy=queue drops instead");
+    }
+    if (history.begin()) {
+        Serial.printf("Replay history: %u KB\n", (unsigned)(history.capacity() / 1024));
+    } else {
+        Serial.println("Replay history unavailable");
+    }
+    parseSubscriptions();
+    int mixerSlots = mixer.begin();
+    Serial.printf("Channel mixer: %d stream slots, %u channel(s) subscribed\n", mixerSlots, subscriptionCount);
+#if ZELLO_DECODE_BENCH
+    benchmarkDecode();
+#endif
     // --- END OF STEP 2 ---
     // --- STEP 3: Initialize WiFi ------
     Serial.println("Initializing WiFi...");
@@ -519,23 +900,44 @@ void setup() {
     // --- END OF STEP 4 ---
     // --- STEP 5: Setup OTA and Buttons ---
     Serial.println("Setting up OTA and Buttons...");
+    configMutex = xSemaphoreCreateMutex();
+    webCommands.begin();
+    txMessages.begin();
+    publishStatusSnapshot();
     setupOTAWebServer();
     Serial.println("HTTP server started");
     Serial.print("Dashboard available at http://"); Serial.println(WiFi.localIP());
     Serial.print("OTA Update available at http://"); Serial.print(WiFi.localIP()); Serial.println("/ota");
-    pinMode(PIN_PLAY, INPUT_PULLUP);
-    pinMode(PIN_VOL_UP, INPUT_PULLUP);
-    pinMode(PIN_VOL_DOWN, INPUT_PULLUP);
     pinMode(GPIO_PA_EN, OUTPUT); // Make sure pin is OUTPUT
     enableSpeakerAmp(false);     // Start with amplifier OFF
-    pinMode(PTT_PIN, INPUT_PULLUP); // PTT button, active LOW
+    if (!noiseSuppressor.begin()) {
+        Serial.println("Noise suppression unavailable: no 480-point FFT in libopus");
+        noiseSuppress = false;
+    }
+    if (fullDuplex) beginFullDuplex();
+    // Audio tasks above loop() on core 1 (task_layout.h): playback keeps I2S fed,
+    // the TX task waits for the PTT interrupt
+    vTaskPrioritySet(nullptr, TASK_NETWORK_PRIORITY);
+    xTaskCreatePinnedToCore(playbackTask, "playbackTask", TASK_PLAYBACK_STACK, nullptr, TASK_PLAYBACK_PRIORITY,
+                            nullptr, TASK_PLAYBACK_CORE);
+    xTaskCreatePinnedToCore(audioTxTask, "audioTxTask", TASK_CAPTURE_STACK, nullptr, TASK_CAPTURE_PRIORITY,
+                            &txTaskHandle, TASK_CAPTURE_CORE);
+    playInput = inputs.add(PIN_PLAY, INPUT_LONG | INPUT_CLICKS);
+    volUpInput = inputs.add(PIN_VOL_UP, INPUT_LONG | INPUT_REPEAT);
+    volDownInput = inputs.add(PIN_VOL_DOWN, INPUT_LONG | INPUT_REPEAT);
+    pttInput = inputs.add(PTT_PIN, 0, txTaskHandle);   // GPIO36: needs the board's external pull-up
+    if (!inputs.begin()) {
+        Serial.println("ERROR: Failed to start button input task");
+    }
     // --- END OF STEP 5 ---
     Serial.println("\nSetup complete");
 }
 
 void loop() {
-    // Handle WebSocket messages and server
-    if (client.available()) {
+    // Handle WebSocket messages and server; the TX task's traffic goes out first
+    wsConnected = client.available();
+    sendTxMessages();
+    if (wsConnected) {
         client.poll();
         // Send ping periodically to keep connection alive
         unsigned long currentTime = millis();
@@ -557,10 +959,12 @@ void loop() {
             client.close();
             delay(100); // Short delay to ensure cleanup
             
+            reconnectMetric.inc();
             if (connectWebSocket()) {
                 reconnectAttempts = 0;
                 Serial.println("WebSocket reconnected successfully!");
             } else {
+                reconnectFailMetric.inc();
                 reconnectAttempts++;
                 // If we've tried too many times, increase the delay
                 if (reconnectAttempts > 5) {
@@ -578,100 +982,68 @@ void loop() {
         }
     }
 
-    // Handle button inputs
+    // The playback task mixes whenever the mixer is free: take it for the stream bookkeeping
     unsigned long now = millis();
-    static unsigned long lastButtonCheck = 0;
-    if (now - lastButtonCheck >= 50) {  // Check buttons every 50ms
-        lastButtonCheck = now;
-        // Read button states with debouncing
-        bool currentPlayState = digitalRead(PIN_PLAY);
-        bool currentVolUpState = digitalRead(PIN_VOL_UP);
-        bool currentVolDownState = digitalRead(PIN_VOL_DOWN);
-        // Play button (Log press for now)
-        if (currentPlayState == LOW && lastPlayState == HIGH) {
-            Serial.println("Play/Mute button pressed");
-            // TODO: Implement mute/unmute using audioKit if needed/available
-            // e.g., audioKit.setVolume(0.0f); or audioKit.mute();
-        }
-        lastPlayState = currentPlayState;
-        // Volume Up button
-        if (currentVolUpState == LOW && lastVolUpState == HIGH) {
-            volumeUp();
-        }
-        lastVolUpState = currentVolUpState;
-        // Volume Down button
-        if (currentVolDownState == LOW && lastVolDownState == HIGH) {
-            volumeDown();
-        }
-        lastVolDownState = currentVolDownState;
-    }
-    // Handle OTA Web Server
-    server.handleClient();
-
-    // PTT handling
-    bool currentPTTState = digitalRead(PTT_PIN);
-    if (lastPTTState == HIGH && currentPTTState == LOW) {
-        // Button pressed
-        Serial.println("PTT button pressed - Starting transmission");
-        startTransmission(); // Your function to start Zello transmission
-        isTransmitting = true;
-    } else if (lastPTTState == LOW && currentPTTState == HIGH) {
-        // Button released
-        Serial.println("PTT button released - Stopping transmission");
-        stopTransmission(); // Your function to stop Zello transmission
-        isTransmitting = false;
+    {
+        AudioDeviceLock lock;
+        // Button events (PTT is handled by the TX task itself)
+        InputEvent ev;
+        while (inputs.next(ev)) {
+            handleInputEvent(ev);
+        }
+        expireIdleStreams();
+        serviceReplay();
+        serviceMessageQueue();
+    }
+
+    // Apply commands from the HTTP server task and refresh what it can see
+    processWebCommands();
+    static unsigned long lastSnapshot = 0;
+    if (now - lastSnapshot >= 100) {
+        lastSnapshot = now;
+        AudioDeviceLock lock;
+        publishStatusSnapshot();
     }
-    lastPTTState = currentPTTState;
 }
 
-bool initOpusDecoder(int sampleRate) {
-    // Log entry and sample rate
-    Serial.printf("Initializing OPUS decoder with sampleRate=%d\n", sampleRate);
-    
-    // Clean up existing decoder if any
-    if (decoderStream != nullptr) {
-        delete decoderStream;
-        decoderStream = nullptr;
-    }
-    // Set up audio info for the decoder
-    audioInfo.sample_rate = sampleRate;
-    audioInfo.channels = 1; // Start with mono from OPUS
-    audioInfo.bits_per_sample = 16;
-    
-    // Create a new EncodedAudioStream using the AudioBoardStream 'out'
-    decoderStream = new audio_tools::EncodedAudioStream(&out, &opusDecoder); 
-    if (!decoderStream) {
-        Serial.println("Failed to create decoder stream!");
-        return false;
+// Play: click replays the last message (each further click steps one back), a
+// double press cycles the replay speed 100/125/150%, a long press stops replay
+// or, when nothing is replaying, toggles mute.
+// Volume keys step on press and keep stepping while held.
+void handleInputEvent(const InputEvent& ev) {
+    if (ev.type == InputEventType::Press) {
+        inputLatencyMetric.observe((uint32_t)esp_timer_get_time() - ev.atUs);
     }
-    
-    // Configure the decoder - output is potentially stereo (based on AudioKit)
-    audio_tools::AudioInfo outputInfo;
-    outputInfo.sample_rate = sampleRate; 
-    outputInfo.channels = 2; // Output to stereo AudioKit
-    outputInfo.bits_per_sample = 16;
-    
-    if (!decoderStream->begin(outputInfo)) {
-        Serial.println("Failed to initialize decoder stream!");
-        delete decoderStream;
-        decoderStream = nullptr;
-        return false;
+    if (ev.input == playInput) {
+        if (ev.type == InputEventType::Click) {
+            Serial.println("Play button pressed");
+            replayCommand(replayActive ? REPLAY_OLDER : 0);
+        } else if (ev.type == InputEventType::DoublePress) {
+            replaySpeed = replaySpeed >= 150 ? 100 : replaySpeed + 25;   // used from the next replay on
+            Serial.printf("Replay speed %u%%\n", replaySpeed);
+        } else if (ev.type == InputEventType::LongPress) {
+            if (replayActive) replayCommand(REPLAY_STOP);
+            else setMuted(!outputGain.muted());
+        }
+    } else if (ev.input == volUpInput || ev.input == volDownInput) {
+        if (ev.type == InputEventType::Press || ev.type == InputEventType::LongPress ||
+            ev.type == InputEventType::Repeat) {
+            if (ev.input == volUpInput) volumeUp();
+            else volumeDown();
+        }
     }
-    
-    Serial.println("OPUS decoder initialized successfully");
-    decoderInitialized = true;
-    return true;
 }
 
+// Ramps the digital output gain; the codec volume is not touched
 void setVolume(uint8_t vol) {
     volume = constrain(vol, 0, 63);
-    float vol_float = volume / 63.0f; // Convert to 0.0 - 1.0 range
-    Serial.printf("Setting volume to %d (%.2f)\n", volume, vol_float);
-    
-    // Use AudioBoardStream instance to set volume instead
-    if (!out.setVolume(vol_float)) { // Check return value if available
-         Serial.println("WARNING: Failed to set volume!");
-    }
+    outputGain.setLevel(volume * OUTPUT_GAIN_UNITY_Q15 / 63);
+    Serial.printf("Setting volume to %d (%.2f)\n", volume, volume / 63.0f);
+}
+
+void setMuted(bool muted) {
+    outputGain.setMuted(muted);
+    Serial.printf("Output %s\n", muted ? "muted" : "unmuted");
 }
 
 void volumeUp() {
@@ -683,221 +1055,662 @@ void volumeDown() {
 }
 
 void enableSpeakerAmp(bool enable) {
-    // *** DEBUG: Log entry and requested state ***
-    Serial.printf("DEBUG: enableSpeakerAmp called with enable=%s\n", enable ? "true" : "false");
+    ZLOGD("enableSpeakerAmp called with enable=%s", enable ? "true" : "false");
     digitalWrite(GPIO_PA_EN, enable ? HIGH : LOW);
-    // *** DEBUG: Log state AFTER writing to pin ***
-    Serial.printf("Speaker amplifier %s (GPIO%d=%s)\n", 
-                  enable ? "ENABLED" : "DISABLED", 
-                  GPIO_PA_EN, digitalRead(GPIO_PA_EN) ? "HIGH" : "LOW");
-    // Force a short delay to let amplifier stabilize
-    delay(50);
+    // Log state AFTER writing to pin
+    ZLOGI("Speaker amplifier %s (GPIO%d=%s)",
+          enable ? "ENABLED" : "DISABLED",
+          GPIO_PA_EN, digitalRead(GPIO_PA_EN) ? "HIGH" : "LOW");
+    // No settling delay here: callers may hold the audio lock, so the playback
+    // task holds its first block back AMP_SETTLE_MS instead (serviceAudioOutput)
     // Check if the amp enable pin is at the expected level
     if (digitalRead(GPIO_PA_EN) != (enable ? HIGH : LOW)) {
-        Serial.println("WARNING: Amplifier control pin not at expected state!");
+        ZLOGW("Amplifier control pin not at expected state!");
+    }
+}
+
+// Brings up I2S for playback and switches the amplifier on
+void beginPlayback() {
+    // Full duplex: I2S runs from setup() on, at one rate, and the mic is on it too
+    if (!fullDuplex) {
+        // Configure audio output using the AudioBoardStream instance
+        auto cfg = out.defaultConfig(TX_MODE);
+        cfg.sample_rate = PLAYBACK_SAMPLE_RATE;
+        cfg.bits_per_sample = 16;
+        cfg.channels = 2;
+        applyDmaBuffers(cfg);
+
+        // Re-initialize the AudioBoardStream with the new config
+        if (!out.begin(cfg)) {
+            Serial.println("WARNING: Failed to apply updated audio config!");
+        } else {
+            Serial.printf("Audio parameters updated (%dHz, 16bit, Stereo).\n", PLAYBACK_SAMPLE_RATE);
+        }
+    }
+    // I2S is idling at zero: switch the amplifier on there and fade the first block in
+    outputGain.jump(0);
+    enableSpeakerAmp(true);
+    outputOnMs = millis();
+    outputTailMs = 0;
+    playoutStartMs = 0;
+    outputActive = true;
+}
+
+// Writes ms of silence to I2S; blocks once the DMA ring is full
+void writeSilence(int ms) {
+    static const int16_t silence[MIX_BLOCK_SAMPLES * 2] = {0};
+    for (int written = 0; written < ms; written += MIX_BLOCK_MS) {
+        timedOut.write((const uint8_t*)silence, sizeof(silence));
+    }
+}
+
+// Switches the output stage off. The caller leaves the DMA ring full of silence
+// first: I2S repeats its last buffer when starved, and the amplifier should
+// switch off at zero, not on a held block.
+void endPlayback() {
+    ZLOGI("Disabling speaker amplifier, output idle");
+    enableSpeakerAmp(false);
+    echoReference.stop();
+    outputActive = false;
+}
+
+// duplex=full, once the config is read: I2S out and in at 16 kHz from here on.
+// The TX task then records from 'out' instead of opening the microphone itself,
+// so the speaker keeps playing over a transmission.
+void beginFullDuplex() {
+    if (!echoCanceller.begin()) {
+        Serial.println("Full duplex unavailable: no 480-point FFT in libopus");
+        fullDuplex = false;
+        return;
+    }
+    AudioDeviceLock lock;
+    auto cfg = out.defaultConfig(RXTX_MODE);
+    cfg.sample_rate = PLAYBACK_SAMPLE_RATE;
+    cfg.channels = 2;
+    cfg.bits_per_sample = 16;
+    applyDmaBuffers(cfg);
+    if (!out.begin(cfg)) {
+        Serial.println("Full duplex I2S config FAILED, staying half duplex");
+        fullDuplex = false;
+        cfg = out.defaultConfig(TX_MODE);
+        cfg.sample_rate = PLAYBACK_SAMPLE_RATE;
+        cfg.channels = 2;
+        cfg.bits_per_sample = 16;
+        applyDmaBuffers(cfg);
+        out.begin(cfg);
+        return;
+    }
+    Serial.println("Full duplex: speaker stays on while transmitting, echo cancelled");
+}
+
+// Resizes the playback DMA ring. Half duplex picks it up whenever playback
+// (re)starts; full duplex restarts I2S now, since it never does.
+void setDmaBuffers(int count, int frames) {
+    AudioDeviceLock lock;
+    i2sDmaCount = constrain(count, 2, 16);
+    i2sDmaFrames = constrain(frames, 40, 1024);
+    Serial.printf("I2S DMA: %u buffers of %u frames, %u ms\n", i2sDmaCount, i2sDmaFrames, outputAheadMs());
+    if (fullDuplex) {
+        auto cfg = out.defaultConfig(RXTX_MODE);
+        cfg.sample_rate = PLAYBACK_SAMPLE_RATE;
+        cfg.channels = 2;
+        cfg.bits_per_sample = 16;
+        applyDmaBuffers(cfg);
+        out.begin(cfg);
+        playoutStartMs = 0;
+    } else if (outputActive && playbackActive) {
+        beginPlayback();
+    }
+}
+
+// Live streams still receiving packets; draining ones and replay do not count
+uint8_t liveStreamCount() {
+    uint8_t n = 0;
+    for (int i = 0; i < mixer.slots(); i++) {
+        const MixStream& s = mixer.slot(i);
+        n += s.active && !s.closing && s.key != REPLAY_STREAM_KEY;
+    }
+    // Queued talkers that are still talking and have no mixer slot yet
+    for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+        const QueuedMessage* m = messageQueue.message(i);
+        n += m && !m->complete && !mixer.find(m->key);
+    }
+    return n;
+}
+
+// Highest-priority live stream; its talker is the one shown on the dashboard
+const MixStream* leadLiveStream() {
+    const MixStream* lead = nullptr;
+    for (int i = 0; i < mixer.slots(); i++) {
+        const MixStream& s = mixer.slot(i);
+        if (s.active && !s.closing && s.key != REPLAY_STREAM_KEY && (!lead || s.priority > lead->priority)) {
+            lead = &s;
+        }
+    }
+    return lead;
+}
+
+uint8_t channelPriority(const String& channel) {
+    for (uint8_t i = 0; i < subscriptionCount; i++) {
+        if (subscriptions[i].name == channel) return subscriptions[i].priority;
+    }
+    return channel.length() ? 0 : PRIMARY_CHANNEL_PRIORITY;   // no "channel" field: single-channel logon
+}
+
+// Rebuilds the subscription list from zelloChannel and monitorChannels
+void parseSubscriptions() {
+    subscriptions[0] = {zelloChannel, PRIMARY_CHANNEL_PRIORITY};
+    subscriptionCount = 1;
+    int pos = 0;
+    while (pos < (int)monitorChannels.length() && subscriptionCount < MAX_CHANNELS) {
+        int comma = monitorChannels.indexOf(',', pos);
+        if (comma < 0) comma = monitorChannels.length();
+        String name = monitorChannels.substring(pos, comma);
+        pos = comma + 1;
+        uint8_t priority = 0;
+        int colon = name.lastIndexOf(':');
+        if (colon > 0 && colon + 1 < (int)name.length() && isDigit(name[colon + 1])) {
+            priority = constrain(name.substring(colon + 1).toInt(), 0, 254);
+            name = name.substring(0, colon);
+        }
+        name.trim();
+        if (name.length() == 0 || name == zelloChannel) continue;
+        subscriptions[subscriptionCount++] = {name, priority};
+    }
+    mixer.setMode(priorityPreempt ? ChannelMixer::Preempt : ChannelMixer::Duck);
+    overlap = overlapPolicy == "queue" ? OverlapPolicy::Queue
+            : overlapPolicy == "drop" ? OverlapPolicy::Drop : OverlapPolicy::Mix;
+}
+
+// Closes the recorder capsule and history entry of the tracked stream
+void endTrackedStream() {
+    if (!trackedStreamOpen) return;
+    recorder.streamStop();
+    history.streamStop();
+    trackedStreamOpen = false;
+}
+
+// Opens a mixer slot for a live stream. overlap_policy=drop (or queue without a
+// message queue) refuses it while an equal or higher priority talks. When every slot
+// is busy, the least recently used stream of equal or lower priority gives its slot up.
+MixStream* openLiveStream(uint32_t streamId, uint8_t priority, const char* talker) {
+    bool refusedByPolicy = overlap != OverlapPolicy::Mix && mixer.talking(priority);
+    if (refusedByPolicy) {
+        mixDroppedMetric.inc();
+        ZLOGI("Stream %u dropped: another stream has the floor", (unsigned)streamId);
+        return nullptr;
+    }
+    uint32_t evicted = 0;
+    MixStream* stream = mixer.open(streamId, priority, talker, &evicted);
+    if (!stream) {
+        mixBusyMetric.inc();
+        ZLOGW("No mixer slot free for stream %u, not playing it", (unsigned)streamId);
+        return nullptr;
+    }
+    if (evicted) {
+        mixEvictedMetric.inc();
+        ZLOGI("Stream %u (priority %u) takes the mixer slot of stream %u",
+              (unsigned)streamId, (unsigned)priority, (unsigned)evicted);
+        if (trackedStreamOpen && evicted == trackedStreamId) endTrackedStream();
+    }
+    return stream;
+}
+
+// overlap_policy=queue: a stream that starts while an equal or higher priority is
+// playing, or behind queued messages of its priority, waits in the message queue.
+// A stream that does get the floor parks the lower-priority ones it talks over.
+// Returns true when the stream was queued instead of opened.
+bool queueLiveStream(uint32_t streamId, uint8_t priority, const char* talker) {
+    if (overlap != OverlapPolicy::Queue || !messageQueue.enabled()) return false;
+    if (!mixer.busy(priority) && !messageQueue.waiting(priority)) {
+        for (int i = 0; i < mixer.slots(); i++) {
+            const MixStream& s = mixer.slot(i);
+            if (!s.active || s.closing || s.paused || s.priority >= priority || s.key == REPLAY_STREAM_KEY) continue;
+            bool playingQueued = queuePlaying && queuePlaying->key == s.key;
+            if (!playingQueued && !messageQueue.hold(s.key, s.priority, s.talker, s.startMs)) continue;
+            if (playingQueued) queuePlaying = nullptr;   // back in line, keeps its place
+            ZLOGI("Stream %u parked in the queue", (unsigned)s.key);
+            mixQueuedMetric.inc();
+            mixer.setPaused(s.key, true);
+        }
+        return false;
+    }
+    if (!messageQueue.hold(streamId, priority, talker, millis())) {
+        ZLOGW("Message queue full, mixing stream %u", (unsigned)streamId);
+        return false;
+    }
+    mixQueuedMetric.inc();
+    ZLOGI("Stream %u queued until the floor is free", (unsigned)streamId);
+    return true;
+}
+
+// Lets a live stream's queued audio play out; prints the totals once the last one ends
+void streamStopped(uint32_t streamId) {
+    if (trackedStreamOpen && streamId == trackedStreamId) endTrackedStream();
+    const MixStream* ended = mixer.find(streamId);
+    if (ended && ended->starvations) {
+        uint32_t concealedMs = ended->concealedTotal * 1000 / PLAYBACK_SAMPLE_RATE;
+        ZLOGI("Stream %u: %u underruns, %u ms concealed", (unsigned)streamId, (unsigned)ended->starvations,
+              (unsigned)concealedMs);
+        concealMetric.inc(concealedMs);
+    }
+    if (ended && ended->caughtUp) {
+        uint32_t caughtUpMs = ended->caughtUp * 1000 / PLAYBACK_SAMPLE_RATE;
+        ZLOGI("Stream %u: caught up %u ms of backlog", (unsigned)streamId, (unsigned)caughtUpMs);
+        caughtUpMetric.inc(caughtUpMs);
+    }
+    QueuedMessage* queued = messageQueue.find(streamId);
+    if (queued) {
+        queued->complete = true;   // the queue closes it once played
+    } else {
+        mixer.close(streamId);
+    }
+    if (!isValidAudioStream || liveStreamCount() > 0) return;
+
+    // Calculate stream stats
+    streamDuration = millis() - streamStartTime;
+
+    uint32_t rate10 = streamDuration ? (uint32_t)((uint64_t)totalPacketsReceived * 10000 / streamDuration) : 0;
+    ZLOGI("Stream statistics: %u ms, %d packets, %u OPUS bytes, %u.%u packets/s", (unsigned)streamDuration,
+          totalPacketsReceived, (unsigned)totalBytesReceived, (unsigned)(rate10 / 10), (unsigned)(rate10 % 10));
+
+    isValidAudioStream = false;
+    endOfMessageCue = true;
+}
+
+// A stream whose stop message never came (lost connection) is ended after a timeout
+void expireIdleStreams() {
+    for (int i = 0; i < mixer.slots(); i++) {
+        const MixStream& s = mixer.slot(i);
+        if (s.active && !s.closing && s.key != REPLAY_STREAM_KEY && !messageQueue.find(s.key) &&
+            millis() - s.lastPacketMs > STREAM_IDLE_TIMEOUT_MS) {
+            ZLOGI("Stream %u idle for %d ms, closing", (unsigned)s.key, STREAM_IDLE_TIMEOUT_MS);
+            streamStopped(s.key);
+        }
+    }
+    for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+        const QueuedMessage* m = messageQueue.message(i);
+        if (m && !m->complete && millis() - m->lastPacketMs > STREAM_IDLE_TIMEOUT_MS) {
+            ZLOGI("Queued stream %u idle for %d ms, closing", (unsigned)m->key, STREAM_IDLE_TIMEOUT_MS);
+            streamStopped(m->key);
+        }
+    }
+}
+
+// Called by the playback task: mixes the active streams into I2S in 10 ms blocks,
+// keeping the DMA ring full, and switches the output stage on and off around them.
+// While any stream is open the ring never runs dry: gaps are concealed by the
+// mixer, and streams still buffering mix to silence, because a starved I2S
+// repeats its last block. Nothing here waits longer than a top-up: the amplifier
+// settles and the trailing silence goes out over several passes, since loop()
+// waits for the lock to hand packets to the mixer.
+void serviceAudioOutput() {
+    AudioDeviceLock lock;
+    if (!playbackActive) return;   // I2S is lent to the TX task
+    bool feeding = mixer.hasOutput() || cues.active();
+    if (endOfMessageCue && !mixer.hasOutput()) {
+        endOfMessageCue = false;
+        cues.play(Cue::EndOfMessage);
+        feeding = true;
+    }
+    if (!outputActive) {
+        if (!feeding) return;
+        beginPlayback();
+    }
+    if (millis() - outputOnMs < AMP_SETTLE_MS) return;   // I2S idles at zero meanwhile
+    bool idle = !feeding && mixer.activeCount() == 0;
+    if (!idle) {
+        outputTailMs = 0;
+    } else if (outputTailMs >= outputAheadMs() * 2) {
+        // Everything audible has played and the ring holds only silence
+        playoutStartMs = 0;
+        endPlayback();
+        return;
+    }
+    if (!idle && playoutStartMs != 0 && playoutBufferMs() == 0) {
+        i2sUnderrunMetric.inc();   // the playback task came round too late for the DMA ring
+        playoutStartMs = 0;
+    }
+    while (playoutBufferMs() < outputAheadMs()) {
+        if (playoutStartMs == 0) {
+            playoutStartMs = millis();
+            playoutSamplesWritten = 0;
+        }
+        if (idle) {
+            // Nothing left to play: pad with silence before the output stage goes off
+            memset(outputStereo, 0, sizeof(outputStereo));
+            outputTailMs += MIX_BLOCK_MS;
+        } else {
+            int starved = mixer.mix(outputMono, MIX_BLOCK_SAMPLES);
+            if (starved) underrunMetric.inc(starved);
+            enhanceVoiceAudio(outputMono, MIX_BLOCK_SAMPLES);
+            cues.render(outputMono, MIX_BLOCK_SAMPLES, PLAYBACK_SAMPLE_RATE);
+            outputGain.process(outputMono, outputStereo, MIX_BLOCK_SAMPLES);
+        }
+        if (fullDuplex) {
+            // What the speaker is about to play, on the playout clock, for the echo canceller
+            echoReference.write(outputStereo, MIX_BLOCK_SAMPLES, 2,
+                                playoutStartMs * 1000 +
+                                    (uint32_t)((uint64_t)playoutSamplesWritten * 1000000 / PLAYBACK_SAMPLE_RATE));
+        }
+        i2sUsInWrite = 0;
+        timedOut.write((const uint8_t*)outputStereo, sizeof(outputStereo));
+        i2sWriteMetric.observe(i2sUsInWrite);
+        playoutSamplesWritten += MIX_BLOCK_SAMPLES;
+    }
+}
+
+// Tops up the DMA ring every PLAYBACK_SERVICE_MS, well inside the ring's 40 ms, so
+// playback no longer waits for loop() to finish a WebSocket read or a reconnect
+void playbackTask(void* parameter) {
+    for (;;) {
+        serviceAudioOutput();
+        vTaskDelay(pdMS_TO_TICKS(PLAYBACK_SERVICE_MS));
+    }
+}
+
+// Decodes one packet into its stream's mixer slot; the playback task mixes it out
+void decodeOpusPacket(MixStream* stream, const uint8_t* opusData, size_t opusLen) {
+    uint32_t decodeStart = micros();
+    TRACE_BEGIN(TRACE_DECODE);
+    int samples = mixer.decode(stream, opusData, opusLen);
+    TRACE_END(TRACE_DECODE);
+    uint32_t decodeUs = micros() - decodeStart;
+    decodeMetric.observe(decodeUs);
+    decodeUsAvg = decodeUsAvg ? (decodeUsAvg * 7 + decodeUs) / 8 : decodeUs;
+    // Check for decode errors
+    if (samples < 0) {
+        ZLOGE("OPUS decode error %d on stream %u (%u bytes)", samples, (unsigned)stream->key, (unsigned)opusLen);
+    } else if (binaryPacketCount == 0 || binaryPacketCount % 100 == 0) {
+        ZLOGI("Opus decode: packet=%d, stream %u, %d samples", binaryPacketCount, (unsigned)stream->key, samples);
+    }
+}
+
+// Starts replaying stored message `index` (0 = most recent) in the replay mixer slot.
+// Sped-up replay is time-compressed in the mixer (WSOLA), so the pitch stays.
+bool startReplay(uint8_t index) {
+    HistoryStream stored;
+    if (liveStreamCount() > 0 || !history.stream(index, stored) || stored.packets == 0) {
+        return false;
+    }
+    if (replayActive) stopReplay(false);
+    Serial.printf("Replaying message %u/%u from %s (%u packets) at %u%%\n", index + 1, history.count(),
+                  stored.talker, stored.packets, replaySpeed);
+    if (!mixer.open(REPLAY_STREAM_KEY, UINT8_MAX, stored.talker)) {
+        return false;
+    }
+    mixer.setSpeed(REPLAY_STREAM_KEY, replaySpeed);
+    mixer.setFedAhead(REPLAY_STREAM_KEY);
+    history.open(index, replayCursor);
+    decodeUsAvg = 0;
+    replayIndex = index;
+    replayActive = true;
+    return true;
+}
+
+// playOut lets the buffered tail play; a live stream taking over skips that
+void stopReplay(bool playOut) {
+    if (!replayActive) return;
+    replayActive = false;
+    if (playOut) {
+        mixer.close(REPLAY_STREAM_KEY);
+    } else {
+        mixer.drop(REPLAY_STREAM_KEY);
+    }
+    ZLOGI("Replay stopped");
+}
+
+// arg: 0 = latest message, REPLAY_OLDER = one further back than now, REPLAY_STOP
+void replayCommand(int32_t arg) {
+    if (arg == REPLAY_STOP) {
+        stopReplay(true);
+        return;
+    }
+    uint8_t index = 0;
+    if (arg == REPLAY_OLDER && replayActive) {
+        index = replayIndex + 1;
+        if (index >= history.count()) {
+            stopReplay(true);   // ran out of history
+            return;
+        }
+    }
+    if (!startReplay(index)) {
+        Serial.println("Nothing to replay");
+    }
+}
+
+// Called from loop(): keeps REPLAY_AHEAD_MS of decoded audio in the replay slot.
+// The mixer drains it at the output rate, so pacing follows each packet's own
+// duration, not the recorded arrival jitter.
+void serviceReplay() {
+    if (!replayActive) return;
+    static uint8_t packetBuf[MAX_PACKET_SIZE];
+    MixStream* stream = mixer.find(REPLAY_STREAM_KEY);
+    while (stream && mixer.queuedMs(REPLAY_STREAM_KEY) < REPLAY_AHEAD_MS) {
+        uint16_t deltaMs;
+        size_t len = replayCursor.next(packetBuf, sizeof(packetBuf), deltaMs);
+        if (len == 0) {
+            stopReplay(true);   // end of message, or it was evicted meanwhile
+            return;
+        }
+        decodeOpusPacket(stream, packetBuf, len);
+    }
+}
+
+// Called from loop(): plays queued messages one at a time, highest priority first
+// and then in the order their talkers started, whenever nothing of equal or higher
+// priority holds the floor. A message whose talker is still talking keeps playing
+// from the queue as packets arrive. While the backlog is long, pauses are shortened.
+void serviceMessageQueue() {
+    if (!messageQueue.enabled()) return;
+    if (!queuePlaying) {
+        QueuedMessage* next = messageQueue.front();
+        if (!next || mixer.busy(next->priority)) return;
+        if (mixer.find(next->key)) {
+            mixer.setPaused(next->key, false);   // a parked stream picks up where it stopped
+        } else if (!openLiveStream(next->key, next->priority, next->talker)) {
+            return;
+        }
+        mixer.setFedAhead(next->key);
+        queueWaitMetric.observe(millis() - next->queuedMs);
+        Serial.printf("Playing queued stream %u from %s after %u ms\n", (unsigned)next->key, next->talker,
+                      (unsigned)(millis() - next->queuedMs));
+        queuePlaying = next;
+    }
+
+    MixStream* stream = mixer.find(queuePlaying->key);
+    if (!stream) {   // lost its slot to a higher priority
+        messageQueue.remove(queuePlaying);
+        queuePlaying = nullptr;
+        return;
+    }
+    if (!queueCatchUp || queuePlaying->unreadMs < QUEUE_CATCHUP_OFF_MS) {
+        stream->catchUp = false;
+    } else if (queuePlaying->unreadMs > QUEUE_CATCHUP_ON_MS) {
+        stream->catchUp = true;
+    }
+    static uint8_t packetBuf[MAX_PACKET_SIZE];
+    while (mixer.queuedMs(queuePlaying->key) < QUEUE_AHEAD_MS) {
+        size_t len = messageQueue.read(queuePlaying, packetBuf, sizeof(packetBuf));
+        if (len == 0) break;
+        uint32_t skipped = stream->skipped;
+        decodeOpusPacket(stream, packetBuf, len);
+        queueSkippedMetric.inc((stream->skipped - skipped) * 1000 / PLAYBACK_SAMPLE_RATE);
+    }
+    if (queuePlaying->complete && queuePlaying->unread == 0) {
+        mixer.close(queuePlaying->key);
+        messageQueue.remove(queuePlaying);
+        queuePlaying = nullptr;
     }
 }
 
+// Called from client.poll() in loop(). Packets and stream events change the mixer,
+// the message queue and the history, so those calls run under the audio lock; the
+// message dumps and header parsing happen outside it, and what logs under it
+// goes through the deferred log.
 void onMessageCallback(WebsocketsMessage message) {
     if (message.isBinary()) {
+        TRACE_SCOPE(TRACE_PACKET_RX);
         // Handle binary message (audio data)
         size_t msgLen = message.length();
         const uint8_t* rawData = (const uint8_t*)message.c_str();
         
         // Print first packet details
         if (binaryPacketCount == 0) {
-            Serial.println("\nFirst packet details:");
-            Serial.printf("Total length: %d bytes\n", msgLen);
-            Serial.printf("Packet type: 0x%02X\n", rawData[0]);
-            Serial.printf("OPUS data length: %d bytes\n", msgLen - 9);
+            ZLOGI("First packet details: total length=%u bytes, type=0x%02X, OPUS data length=%d bytes",
+                  (unsigned)msgLen, rawData[0], (int)msgLen - 9);
         }
         
         // Validate packet type
-        if (rawData[0] != 0x01) {
-            Serial.printf("Invalid packet type: 0x%02X\n", rawData[0]);
+        ZelloPacket packet;
+        if (!zelloParsePacket(rawData, msgLen, packet)) {
+            ZLOGW("Invalid packet type: 0x%02X (%u bytes)", msgLen ? rawData[0] : 0, (unsigned)msgLen);
             return;
         }
         
-        // Extract OPUS data (skip 9-byte header)
-        const uint8_t* opusData = rawData + 9;
-        size_t opusLen = msgLen - 9;
+        // The stream id selects the decoder
+        uint32_t streamId = packet.streamId;
+        bool tracked = trackedStreamOpen && streamId == trackedStreamId;
+        const uint8_t* opusData = packet.opus;
+        size_t opusLen = packet.opusLen;
+
+        // Inter-arrival time and RFC 3550 jitter against the nominal packet duration
+        if (tracked) {
+            unsigned long arrivalUs = micros();
+            if (lastPacketUs != 0) {
+                uint32_t interarrival = arrivalUs - lastPacketUs;
+                rxInterarrivalMetric.observe(interarrival);
+                int nominalSamples = opus_packet_get_nb_samples(opusData, opusLen, streamSampleRate);
+                if (nominalSamples > 0) {
+                    int32_t deviation = (int32_t)interarrival - (int32_t)((int64_t)nominalSamples * 1000000 / streamSampleRate);
+                    int32_t jitter = rxJitterMetric.value();
+                    rxJitterMetric.set(jitter + (abs(deviation) - jitter) / 16);
+                }
+            }
+            lastPacketUs = arrivalUs;
+        }
         
         // Print packet details for first few packets
         if (binaryPacketCount < DETAILED_PACKET_COUNT) {
-            Serial.printf("\nOPUS Packet %d:\n", binaryPacketCount);
-            Serial.printf("- Length: %d bytes\n", opusLen);
-            Serial.printf("- First 8 bytes: ");
+            // Deferred records hold words, not buffers: pack the first 8 bytes big-endian
+            uint32_t head[2] = {0, 0};
             for (int i = 0; i < min(8, (int)opusLen); i++) {
-                Serial.printf("%02X ", opusData[i]);
+                head[i / 4] |= (uint32_t)opusData[i] << (24 - 8 * (i % 4));
             }
-            Serial.println();
+            ZLOGD("OPUS Packet %d (stream %u): length=%u bytes, first 8 bytes: %08X %08X",
+                  binaryPacketCount, (unsigned)streamId, (unsigned)opusLen, head[0], head[1]);
         }
         
         // Check for valid packet size
         if (opusLen < 2) {
-            Serial.println("OPUS packet too small");
+            ZLOGW("OPUS packet too small");
             return;
         }
         if (opusLen > MAX_PACKET_SIZE) {
-            Serial.printf("OPUS packet too large: %d > %d\n", opusLen, MAX_PACKET_SIZE);
+            ZLOGW("OPUS packet too large: %u > %d", (unsigned)opusLen, MAX_PACKET_SIZE);
             return;
         }
         
-        // Using Audio-tools EncodedAudioStream to decode OPUS
-        if (decoderInitialized && decoderStream) {
-            size_t bytes_written = decoderStream->write(opusData, opusLen);
-            // Check for decode errors
-            if (bytes_written != opusLen) {
-                Serial.printf("OPUS decode error: wrote %d of %d bytes\n", bytes_written, opusLen);
-            } else if (binaryPacketCount == 0 || binaryPacketCount % 100 == 0) {
-                Serial.printf("AudioTools decoder write: packet=%d, bytes=%d/%d\n",
-                            binaryPacketCount, bytes_written, opusLen);
+        {
+            AudioDeviceLock lock;
+            if (tracked) {
+                recorder.packet(opusData, opusLen);
+                history.packet(opusData, opusLen);
+            }
+
+            // Queued streams are stored for later; streams that got no mixer slot are
+            // counted at start and ignored here
+            QueuedMessage* queued = messageQueue.find(streamId);
+            MixStream* stream = queued ? nullptr : mixer.find(streamId);
+            if (queued) {
+                if (!messageQueue.packet(queued, opusData, opusLen)) queueDroppedMetric.inc();
+            } else if (stream && !stream->closing) {
+                decodeOpusPacket(stream, opusData, opusLen);
             }
         }
         
         // Update packet counters
         totalBytesReceived += opusLen;
         totalPacketsReceived++;
+        rxPacketsMetric.inc();
+        rxBytesMetric.inc(opusLen);
         binaryPacketCount++;
     } else {
         // Handle text message (JSON control messages)
         String msg = message.data();
             
         // Stream start message
-        if (msg.indexOf("\"command\":\"on_stream_start\"") >= 0) {
+        if (zelloIsCommand(msg.c_str(), "on_stream_start")) {
             Serial.println("\n=== Stream Start Message ===");
             Serial.println(msg);
             Serial.println("===========================\n");
             
-            // Extract codec header from JSON
-            Serial.println("Attempting to find codec_header...");
-            int headerStart = msg.indexOf("\"codec_header\":\"");
-            if (headerStart >= 0) {
-                headerStart += 16; // Skip past "codec_header":""
-                int headerEnd = msg.indexOf("\"", headerStart);
-                if (headerEnd > headerStart) {
-                    String codecHeader = msg.substring(headerStart, headerEnd);
-                    Serial.printf("Extracted Codec Header: [%s]\n", codecHeader.c_str());
-                    
-                    // Decode base64 header
-                    size_t decodedLen = 0;
-                    uint8_t decoded[4];
-                    int decode_ret = mbedtls_base64_decode(decoded, 4, &decodedLen, 
-                        (const uint8_t*)codecHeader.c_str(), codecHeader.length());
-                    Serial.printf("Base64 decode result: %d, decoded length: %d\n", decode_ret, decodedLen);
-                    if (decode_ret == 0 && decodedLen == 4) {
-                        // Parse OpusConfig
-                        OpusConfig config;
-                        config.sampleRate = decoded[0] | (decoded[1] << 8);
-                        config.framesPerPacket = decoded[2];
-                        config.frameSizeMs = decoded[3];
-                        
-                        Serial.printf("Opus Config: %dHz, %d frames/packet, %dms/frame\n",
-                            config.sampleRate, config.framesPerPacket, config.frameSizeMs);
-                        
-                        // Configure audio output using the AudioBoardStream instance
-                        auto cfg = out.defaultConfig(TX_MODE);
-                        cfg.sample_rate = config.sampleRate;
-                        cfg.bits_per_sample = 16;
-                        cfg.channels = 2;
-                        
-                        // Re-initialize the AudioBoardStream with the new config
-                        if (!out.begin(cfg)) { 
-                            Serial.println("WARNING: Failed to apply updated audio config!");
-                        } else {
-                            Serial.printf("Audio parameters updated (%dHz, 16bit, Stereo).\n", config.sampleRate);
-                            delay(10);
-                            
-                            // Set initial stream volume using the AudioBoardStream instance
-                            float streamVolume = 0.2f;
-                            Serial.printf("Setting stream volume to %.2f\n", streamVolume);
-                            out.setVolume(streamVolume); 
-                        }
-                        
-                        // Initialize Opus decoder
-                        if (!initOpusDecoder(config.sampleRate)) {
-                            Serial.println("Failed to initialize Opus decoder");    
-                            return;
-                        }
-                        // Enable amplifier
-                        enableSpeakerAmp(true);
-                    } else {
-                        Serial.println("Base64 decode FAILED or length != 4.");
-                    }
-                } else {
-                    Serial.println("Could not find end quote for codec_header.");
-                }
+            // Every stream is decoded at PLAYBACK_SAMPLE_RATE for mixing; the header
+            // rate is kept for the jitter estimate and the history
+            ZelloCodecHeader codec;
+            size_t codecLen = 0;
+            uint16_t codecSampleRate = PLAYBACK_SAMPLE_RATE;
+            if (zelloCodecHeader(msg.c_str(), codec)) {
+                codecLen = sizeof(codec.raw);
+                codecSampleRate = codec.sampleRate;
+                Serial.printf("Opus Config: %dHz, %d frames/packet, %dms/frame\n",
+                    codec.sampleRate, codec.framesPerPacket, codec.frameMs);
             } else {
-                Serial.println("Could not find start of codec_header string.");
+                Serial.println("Missing or malformed codec_header.");
+            }
+
+            uint32_t streamId = 0;
+            if (!zelloJsonUInt(msg.c_str(), "stream_id", streamId)) {
+                Serial.println("Could not parse stream_id.");
+            }
+            char channel[128];
+            char talker[64];
+            zelloJsonString(msg.c_str(), "channel", channel, sizeof(channel));
+            zelloJsonString(msg.c_str(), "from", talker, sizeof(talker));
+            uint8_t priority = channelPriority(channel);
+            Serial.printf("Stream %u from %s on %s (priority %u)\n", (unsigned)streamId, talker,
+                          channel[0] ? channel : zelloChannel.c_str(), priority);
+
+            AudioDeviceLock lock;
+            stopReplay(false);   // live audio wins over replay
+            // Reset stream counters when the first of possibly several streams starts
+            if (liveStreamCount() == 0) {
+                streamStartTime = millis();
+                totalBytesReceived = 0;
+                totalPacketsReceived = 0;
+                binaryPacketCount = 0;
+                decodeUsAvg = 0;
+            }
+            if (!queueLiveStream(streamId, priority, talker) &&
+                !openLiveStream(streamId, priority, talker)) {
+                return;
             }
-            // Reset stream counters
-            streamStartTime = millis();
-            totalBytesReceived = 0;
-            totalPacketsReceived = 0;
-            binaryPacketCount = 0;
             isValidAudioStream = true;
 
-            // Extract stream_id from JSON
-            int idStart = msg.indexOf("\"stream_id\":\"");
-            if (idStart >= 0) {
-                idStart += 13;
-                int idEnd = msg.indexOf("\"", idStart);
-                if (idEnd > idStart && idEnd - idStart <= 8) {
-                    memset(currentStreamId, 0, sizeof(currentStreamId));
-                    msg.substring(idStart, idEnd).toCharArray(currentStreamId, sizeof(currentStreamId));
-                    Serial.printf("Parsed stream_id: [%s]\n", currentStreamId);
-                }
+            if (!trackedStreamOpen) {
+                trackedStreamOpen = true;
+                trackedStreamId = streamId;
+                streamSampleRate = codecSampleRate;
+                lastPacketUs = 0;
+                char id[11];   // up to 4294967295
+                snprintf(id, sizeof(id), "%u", (unsigned)streamId);
+                recorder.streamStart(talker, id, codec.raw, codecLen);
+                history.streamStart(talker, codecSampleRate);
             }
         }
         // Stream stop message
-        else if (msg.indexOf("\"command\":\"on_stream_stop\"") >= 0) {
+        else if (zelloIsCommand(msg.c_str(), "on_stream_stop")) {
             Serial.println("\n=== Stream Stop Message ===");
             Serial.println(msg);
             Serial.println("===========================\n");
-            
-            // Calculate stream stats
-            streamDuration = millis() - streamStartTime;
-            
-            Serial.println("\n=== Stream Statistics ===");
-            Serial.printf("Duration: %.2f seconds\n", streamDuration/1000.0);
-            Serial.printf("Total packets: %d\n", totalPacketsReceived);
-            Serial.printf("OPUS bytes: %d\n", totalBytesReceived);
-            Serial.printf("Packet rate: %.1f packets/s\n", 
-                        (totalPacketsReceived * 1000.0) / streamDuration);
-            Serial.println("=====================\n");
-            
-            // ADD THIS SECTION - Flush audio and wait before cleanup
-            Serial.println("Flushing audio buffer before ending stream...");
-            if (decoderStream) {
-                // Flush remaining audio data
-                decoderStream->flush();
-                
-                // Wait a moment to allow buffered audio to play
-                // This delay prevents cutting off the last part of audio
-                const int END_STREAM_DELAY_MS = 200;  // ms delay to ensure audio plays out
-                delay(END_STREAM_DELAY_MS);
-                Serial.printf("Waited %dms for audio buffer to empty\n", END_STREAM_DELAY_MS);
-            }
-            // END NEW SECTION
-            
-            // Clean up resources
-            isValidAudioStream = false;
-            if (decoderStream) {
-                decoderStream->end();
-                delete decoderStream;
-                decoderStream = nullptr;
-                decoderInitialized = false;
+            uint32_t streamId = 0;
+            if (zelloJsonUInt(msg.c_str(), "stream_id", streamId)) {
+                AudioDeviceLock lock;
+                streamStopped(streamId);
             }
-            
-            // Disable amplifier only after buffer has played out
-            Serial.println("Disabling speaker amplifier for stream stop...");
-            enableSpeakerAmp(false);
-            // Restore volume using the AudioBoardStream instance
-            Serial.printf("Restoring initial volume to %.2f\n", initialVolumeFloat);
-            out.setVolume(initialVolumeFloat); 
         }
         // Channel status message
-        else if (msg.indexOf("\"command\":\"channel_status\"") >= 0) {
+        else if (zelloIsCommand(msg.c_str(), "channel_status")) {
             Serial.println("\n=== Channel Status ===");
             Serial.println(msg);
             Serial.println("===================\n");
@@ -920,203 +1733,934 @@ void onMessageCallback(WebsocketsMessage message) {
             }
             Serial.println("===================\n");
         }
+        // Reply to our start_stream
+        else if (txState == TxState::Starting) {
+            uint32_t seq = 0;
+            if (zelloJsonUInt(msg.c_str(), "seq", seq) && seq == txStartSeq) txStartReply(msg);
+        }
     }
 }
 
-// Implementation of the missing setupOTAWebServer function
-void setupOTAWebServer() {
-    // Main dashboard page
-    server.on("/", HTTP_GET, []() {
-        String html = "<!DOCTYPE html><html><head>";
-        html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
-        html += "<title>ESP32 Zello Client Dashboard</title>";
-        html += "<style>";
-        html += "body{font-family:Arial,sans-serif;margin:0;padding:20px;color:#e0e0e0;max-width:800px;margin:0 auto;background-color:#1e1e1e;}";
-        html += "h1{color:#0099ff;margin-top:20px;margin-bottom:10px;}";
-        html += "h2{color:#00ccff;margin-top:20px;margin-bottom:10px;}";
-        html += ".stat-box{background:#2d2d2d;padding:15px;border-radius:5px;margin-bottom:15px;}";
-        html += ".stat-grid{display:grid;grid-template-columns:1fr 1fr;gap:10px;}";
-        html += ".stat-item{display:flex;justify-content:space-between;}";
-        html += ".label{font-weight:bold;color:#c0c0c0;}";
-        html += ".controls{margin-top:20px;padding:15px;background:#2a3a4a;border-radius:5px;}";
-        html += ".btn{background:#0088cc;color:white;border:none;padding:8px 15px;margin-right:10px;margin-bottom:10px;border-radius:4px;cursor:pointer;}";
-        html += ".btn:hover{background:#006699;}";
-        html += "@media (max-width:600px){.stat-grid{grid-template-columns:1fr;}}";
-        html += "</style></head><body>";
-        html += "<h1>ESP32 Zello Client Dashboard</h1>";
-        
-        // System Information
-        html += "<h2>System Information</h2>";
-        html += "<div class='stat-box'><div class='stat-grid'>";
-        html += "<div class='stat-item'><span class='label'>Uptime:</span><span>" + String(millis()/1000) + " seconds</span></div>";
-        html += "<div class='stat-item'><span class='label'>Free Heap:</span><span>" + String(ESP.getFreeHeap()) + " bytes</span></div>";
-        html += "<div class='stat-item'><span class='label'>Total Heap:</span><span>" + String(ESP.getHeapSize()) + " bytes</span></div>";
-        html += "<div class='stat-item'><span class='label'>Flash Size:</span><span>" + String(ESP.getFlashChipSize()) + " bytes</span></div>";
-        html += "<div class='stat-item'><span class='label'>Free Sketch Space:</span><span>" + String(ESP.getFreeSketchSpace()) + " bytes</span></div>";
-        html += "<div class='stat-item'><span class='label'>ESP32 SDK:</span><span>" + String(ESP.getSdkVersion()) + "</span></div>";
-        html += "<div class='stat-item'><span class='label'>Firmware Version:</span><span>" + String(FIRMWARE_VERSION) + "</span></div>";
-        html += "</div></div>";
-        
-        // WiFi Information
-        html += "<h2>WiFi Information</h2>";
-        html += "<div class='stat-box'><div class='stat-grid'>";
-        html += "<div class='stat-item'><span class='label'>WiFi SSID:</span><span>" + WiFi.SSID() + "</span></div>";
-        html += "<div class='stat-item'><span class='label'>IP Address:</span><span>" + WiFi.localIP().toString() + "</span></div>";
-        html += "<div class='stat-item'><span class='label'>MAC Address:</span><span>" + WiFi.macAddress() + "</span></div>";
-        html += "<div class='stat-item'><span class='label'>WiFi RSSI:</span><span>" + String(WiFi.RSSI()) + " dBm</span></div>";
-        html += "<div class='stat-item'><span class='label'>Gateway IP:</span><span>" + WiFi.gatewayIP().toString() + "</span></div>";
-        html += "</div></div>";
-        
-        // Audio & Zello Status
-        html += "<h2>Audio & Zello Status</h2>";
-        html += "<div class='stat-box'><div class='stat-grid'>";
-        html += "<div class='stat-item'><span class='label'>Current Volume:</span><span>" + String(volume) + "/63 (" + String(int(volume * 100 / 63)) + "%)</span></div>";
-        html += "<div class='stat-item'><span class='label'>Speaker Amplifier:</span><span>" + String(digitalRead(GPIO_PA_EN) ? "ON" : "OFF") + "</span></div>";
-        html += "<div class='stat-item'><span class='label'>Websocket Connected:</span><span>" + String(client.available() ? "Yes" : "No") + "</span></div>";
-        html += "<div class='stat-item'><span class='label'>Active Audio Stream:</span><span>" + String(isValidAudioStream ? "Yes" : "No") + "</span></div>";
-        
-        // Audio Enhancement Status
-        html += "<div class='stat-item'><span class='label'>Audio Enhancement:</span><span>" + String(enhanceAudio ? "ON" : "OFF") + "</span></div>";
-        html += "<div class='stat-item'><span class='label'>Enhancement Profile:</span><span>";
-        switch (enhancementProfile) {
-            case 0: html += "None"; break;
-            case 1: html += "Voice"; break;
-            case 2: html += "Music"; break;
-        }
-        html += "</span></div>";
-        
-        html += "<div class='stat-item'><span class='label'>Total Packets Received:</span><span>" + String(totalPacketsReceived) + "</span></div>";
-        html += "<div class='stat-item'><span class='label'>Current/Last Stream:</span><span>";
-        if (isValidAudioStream) {
-            html += String((millis() - streamStartTime)/1000.0, 1) + " sec (active)";
-        } else {
-            html += String(streamDuration/1000.0, 1) + " sec (ended)";
-        }
-        html += "</span></div>";
-        html += "</div></div>";
-        
-        // Controls
-        html += "<h2>Device Controls</h2>";
-        html += "<div class='controls'>";
-        html += "<button class='btn' onclick=\"window.location.href='/volume/up'\">Volume +</button>";
-        html += "<button class='btn' onclick=\"window.location.href='/volume/down'\">Volume -</button>";
-        html += "<button class='btn' onclick=\"window.location.href='/speaker/on'\">Speaker On</button>";
-        html += "<button class='btn' onclick=\"window.location.href='/speaker/off'\">Speaker Off</button>";
-        
-        // Audio enhancement
-        html += "<button class='btn' onclick=\"window.location.href='/audio/enhance/" + String(!enhanceAudio) + "'\">" + 
-                String(enhanceAudio ? "Enhancement OFF" : "Enhancement ON") + "</button>";
-        html += "<button class='btn' onclick=\"window.location.href='/audio/profile/next'\">Next Profile (" + 
-                String(enhancementProfile == 0 ? "None" : enhancementProfile == 1 ? "Voice" : "Music") + ")</button>";
-        
-        html += "<button class='btn' onclick=\"window.location.href='/reconnect'\">Reconnect WS</button>";
-        html += "<button class='btn' onclick=\"window.location.href='/ota'\">OTA Update</button>";
-        html += "<button class='btn' onclick=\"if(confirm('Restart the device?')) window.location.href='/reboot'\">Reboot</button>";
-        html += "<button class='btn' onclick=\"window.location.href='/config/wifi'\">WiFi Settings</button>";
-        html += "<button class='btn' onclick=\"window.location.href='/config/zello'\">Zello Settings</button>";
-        html += "</div>";
-         
-        // Auto-refresh
-        html += "<p style='text-align:center;margin-top:20px;'><small>Auto-refreshing every 5 seconds</small></p>";
-        html += "<script>setTimeout(function(){window.location.reload();}, 5000);</script>";
-        html += "</body></html>";
-        server.send(200, "text/html", html);
-    });
+void lockConfig() {
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+}
 
-    // Volume control endpoints
-    server.on("/volume/up", HTTP_GET, []() {
-        volumeUp();
-        server.sendHeader("Location", "/");
-        server.send(303);
-    });
-    
-    server.on("/volume/down", HTTP_GET, []() {
-        volumeDown();
-        server.sendHeader("Location", "/");
-        server.send(303);
-    });
-    
-    // Speaker control endpoints
-    server.on("/speaker/on", HTTP_GET, []() {
-        enableSpeakerAmp(true);
-        server.sendHeader("Location", "/");
-        server.send(303);
-    });
-    
-    server.on("/speaker/off", HTTP_GET, []() {
-        enableSpeakerAmp(false);
-        server.sendHeader("Location", "/");
-        server.send(303);
-    });
-    
-    // Audio enhancement endpoints
-    server.on("/audio/enhance/0", HTTP_GET, []() {
-        enhanceAudio = false;
-        server.sendHeader("Location", "/");
-        server.send(303);
-    });
-    
-    server.on("/audio/enhance/1", HTTP_GET, []() {
-        enhanceAudio = true;
-        server.sendHeader("Location", "/");
-        server.send(303);
-    });
-    
-    server.on("/audio/profile/next", HTTP_GET, []() {
-        enhancementProfile = (enhancementProfile + 1) % 3;  // Cycle through profiles
-        server.sendHeader("Location", "/");
-        server.send(303);
-    });
-    
-    // WebSocket reconnection endpoint
-    server.on("/reconnect", HTTP_GET, []() {
-        if (!client.available()) {
-            client.connect(websocket_server);
+void unlockConfig() {
+    xSemaphoreGive(configMutex);
+}
+
+bool postWebCommand(WebCommandType type, int32_t arg, ConfigUpdate* config) {
+    WebCommand cmd = {type, arg, config};
+    if (!webCommands.post(cmd)) {
+        Serial.println("WARNING: Web command queue full, dropping command");
+        return false;
+    }
+    return true;
+}
+
+void redirectToDashboard(AsyncWebServerRequest* request) {
+    AsyncWebServerResponse* response = request->beginResponse(303);
+    response->addHeader("Location", "/");
+    request->send(response);
+}
+
+// Audio written but not yet played, from samples written vs. elapsed playout time
+uint16_t playoutBufferMs() {
+    if (playoutStartMs == 0) return 0;
+    uint32_t writtenMs = (uint32_t)((uint64_t)playoutSamplesWritten * 1000 / PLAYBACK_SAMPLE_RATE);
+    uint32_t elapsedMs = millis() - playoutStartMs;
+    return writtenMs > elapsedMs ? (uint16_t)min(writtenMs - elapsedMs, (uint32_t)UINT16_MAX) : 0;
+}
+
+// Copy the state the web server may show; called from loop() only
+void publishStatusSnapshot() {
+    StatusSnapshot status;
+    status.volume = volume;
+    status.muted = outputGain.muted();
+    status.ampOn = digitalRead(GPIO_PA_EN) == HIGH;
+    status.wsConnected = client.available();
+    status.streamActive = isValidAudioStream;
+    status.enhanceAudio = enhanceAudio;
+    status.agc = mixer.agc();
+    status.noiseSuppress = noiseSuppress;
+    status.rogerBeep = rogerBeep;
+    status.enhancementProfile = enhancementProfile;
+    status.totalPackets = totalPacketsReceived;
+    status.streamMs = isValidAudioStream ? millis() - streamStartTime : streamDuration;
+    status.audioUnderruns = underrunMetric.value();
+    status.i2sUnderruns = i2sUnderrunMetric.value();
+    status.dmaCount = i2sDmaCount;
+    status.dmaFrames = i2sDmaFrames;
+    status.recording = recorder.enabled();
+    status.preempt = priorityPreempt;
+    strlcpy(status.overlap, overlap == OverlapPolicy::Queue ? "queue" : overlap == OverlapPolicy::Drop ? "drop" : "mix",
+            sizeof(status.overlap));
+    heapFreeMetric.set(ESP.getFreeHeap());
+    heapLowWaterMetric.set(ESP.getMinFreeHeap());
+    // Primary channel first, then the monitored ones
+    status.channel[0] = 0;
+    for (uint8_t i = 0; i < subscriptionCount; i++) {
+        if (i) strlcat(status.channel, ", ", sizeof(status.channel));
+        strlcat(status.channel, subscriptions[i].name.c_str(), sizeof(status.channel));
+    }
+    const MixStream* lead = leadLiveStream();
+    strlcpy(status.talker, lead ? lead->talker : "", sizeof(status.talker));
+    driftMetric.set(lead ? lead->drift.ppm() : 0);
+    status.driftPpm = driftMetric.value();
+    status.liveStreams = liveStreamCount();
+    status.heldStreams = messageQueue.count() - (queuePlaying ? 1 : 0);
+    queueDepthMetric.set(status.heldStreams);
+    queueBytesMetric.set(messageQueue.bytes());
+    if (isValidAudioStream) {
+        snprintf(status.streamId, sizeof(status.streamId), "%u", (unsigned)trackedStreamId);
+    } else {
+        status.streamId[0] = 0;
+    }
+    status.historyCount = history.count();
+    status.replayIndex = replayActive ? replayIndex : -1;
+    status.replaySpeed = replaySpeed;
+    HistoryStream replayed;
+    strlcpy(status.replayTalker, replayActive && history.stream(replayIndex, replayed) ? replayed.talker : "",
+            sizeof(status.replayTalker));
+
+    // Packet rate and decode load over a one second window
+    static unsigned long rateWindowStart = 0;
+    static int rateWindowPackets = 0;
+    static uint32_t rateWindowDecodeUs = 0;
+    static uint16_t packetsPerSec10 = 0;
+    unsigned long now = millis();
+    if (now - rateWindowStart >= 1000) {
+        int packets = totalPacketsReceived - rateWindowPackets;
+        packetsPerSec10 = (packets > 0 && isValidAudioStream) ? (uint16_t)(packets * 10000UL / (now - rateWindowStart)) : 0;
+        // us of decode per ms of wall time is per mille of one core
+        uint32_t decodeUs = decodeMetric.sum();
+        decodeLoadMetric.set((decodeUs - rateWindowDecodeUs) / (now - rateWindowStart));
+        rateWindowStart = now;
+        rateWindowPackets = totalPacketsReceived;
+        rateWindowDecodeUs = decodeUs;
+    }
+    status.decodeLoadPermille = decodeLoadMetric.value();
+    status.packetsPerSec10 = packetsPerSec10;
+    status.bufferMs = isValidAudioStream ? playoutBufferMs() : 0;
+    status.decodeUs = (uint16_t)min(decodeUsAvg, (uint32_t)UINT16_MAX);
+    statusSnapshot.publish(status);
+}
+
+// Rewrite key=value lines in an ini file, appending keys that are missing
+#define INI_MAX_KEYS 8   // settings one updateIniKeys() call may write
+
+void updateIniKeys(const char* path, const char* const* keys, const String* values, size_t count) {
+    if (count > INI_MAX_KEYS) {
+        Serial.printf("ERROR: %u settings for %s, at most %d per update\n", (unsigned)count, path, INI_MAX_KEYS);
+        return;
+    }
+    File iniFile = SPIFFS.open(path, "r");
+    if (!iniFile) {
+        return;
+    }
+    String newContent = "";
+    bool found[INI_MAX_KEYS] = {false};
+    while (iniFile.available()) {
+        String line = iniFile.readStringUntil('\n');
+        bool replaced = false;
+        for (size_t k = 0; k < count; k++) {
+            if (line.startsWith(String(keys[k]) + "=")) {
+                newContent += String(keys[k]) + "=" + values[k] + "\n";
+                found[k] = true;
+                replaced = true;
+                break;
+            }
         }
-        server.sendHeader("Location", "/");
-        server.send(303);
-    });
-    
-    // Reboot endpoint
-    server.on("/reboot", HTTP_GET, []() {
-        server.send(200, "text/html", "<html><body><h1>Device is restarting...</h1><script>setTimeout(function(){window.location.href='/';}, 8000);</script></body></html>");
+        if (!replaced) {
+            newContent += line + "\n";
+        }
+    }
+    iniFile.close();
+
+    // Add any missing entries
+    for (size_t k = 0; k < count; k++) {
+        if (!found[k]) {
+            newContent += String(keys[k]) + "=" + values[k] + "\n";
+        }
+    }
+
+    // Write the updated content back
+    iniFile = SPIFFS.open(path, "w");
+    if (iniFile) {
+        iniFile.print(newContent);
+        iniFile.close();
+        Serial.printf("Settings updated in %s\n", path);
+    }
+}
+
+// Key and value arrays of the same length, checked against INI_MAX_KEYS at compile time
+template <size_t N>
+void updateIniKeys(const char* path, const char* const (&keys)[N], const String (&values)[N]) {
+    static_assert(N <= INI_MAX_KEYS, "raise INI_MAX_KEYS");
+    updateIniKeys(path, keys, values, N);
+}
+
+void applyConfigUpdate(ConfigUpdate* update) {
+    if (update->kind == ConfigUpdate::WiFi) {
+        bool needReboot = false;
+        lockConfig();
+        if (update->hasSsid && update->ssid != ssid) {
+            ssid = update->ssid;
+            needReboot = true;
+        }
+        if (update->hasPassword && update->password != password) {
+            password = update->password;
+            needReboot = true;
+        }
+        unlockConfig();
+        if (needReboot) {
+            const char* keys[] = {"ssid", "password"};
+            String values[] = {ssid, password};
+            updateIniKeys("/wifi_credentials.ini", keys, values);
+            Serial.println("WiFi credentials changed, restarting...");
+            delay(1000);
+            ESP.restart();
+        }
+        return;
+    }
+
+    Serial.println("Received Zello configuration update:");
+    bool needReconnect = false;
+    lockConfig();
+    if (update->hasUsername && update->username != zelloUsername) {
+        zelloUsername = update->username;
+        needReconnect = true;
+    }
+    if (update->hasZelloPassword && update->zelloPassword != zelloPassword) {
+        zelloPassword = update->zelloPassword;
+        needReconnect = true;
+    }
+    if (update->hasChannel && update->channel != zelloChannel) {
+        zelloChannel = update->channel;
+        printUtf8HexBytes(zelloChannel.c_str(), "Channel UTF-8 bytes");
+        needReconnect = true;
+    }
+    if (update->hasToken && update->token != token) {
+        token = update->token;
+        needReconnect = true;
+    }
+    if (update->hasMonitor && update->monitor != monitorChannels) {
+        monitorChannels = update->monitor;
+        needReconnect = true;   // subscriptions are sent at logon
+    }
+    bool modeChanged = false;
+    if (update->hasPriorityMode && (update->priorityMode == "preempt") != priorityPreempt) {
+        priorityPreempt = !priorityPreempt;
+        modeChanged = true;
+    }
+    if (update->hasOverlapPolicy && update->overlapPolicy != overlapPolicy) {
+        overlapPolicy = update->overlapPolicy;
+        modeChanged = true;
+    }
+    if (update->hasCatchUp && update->catchUp != queueCatchUp) {
+        queueCatchUp = update->catchUp;
+        modeChanged = true;
+    }
+    unlockConfig();
+
+    if (needReconnect || modeChanged) {
+        {
+            AudioDeviceLock lock;   // priority mode and channels reach the mixer
+            parseSubscriptions();
+        }
+        const char* keys[] = {"username", "password_zello", "channel", "monitor", "priority_mode",
+                              "overlap_policy", "queue_catchup"};
+        String values[] = {zelloUsername, zelloPassword, zelloChannel, monitorChannels,
+                           priorityPreempt ? "preempt" : "duck", overlapPolicy, queueCatchUp ? "on" : "off"};
+        updateIniKeys("/wifi_credentials.ini", keys, values);
+    }
+    if (needReconnect) {
+        // Save API token separately
+        File tokenFile = SPIFFS.open("/zello-api.key", "w");
+        if (tokenFile) {
+            tokenFile.print(token);
+            tokenFile.close();
+            Serial.println("API token updated in zello-api.key");
+        }
+
+        Serial.println("Reconnecting to Zello with new credentials...");
+        client.close();
         delay(500);
-        ESP.restart();
+        connectWebSocket();
+    }
+}
+
+// Execute commands posted by the HTTP server task. The ones that wait on the
+// network run without the audio lock, so playback never waits for them.
+void processWebCommands() {
+    WebCommand cmd;
+    while (webCommands.receive(cmd)) {
+        switch (cmd.type) {
+            case WebCommandType::Reconnect:
+                if (!client.available()) {
+                    connectWebSocket();
+                }
+                continue;
+            case WebCommandType::Reboot:
+                delay(500);  // Let the HTTP response go out
+                ESP.restart();
+                continue;
+            case WebCommandType::ApplyConfig:
+                if (cmd.config) {
+                    applyConfigUpdate(cmd.config);
+                    delete cmd.config;
+                }
+                continue;
+            default:
+                break;
+        }
+        AudioDeviceLock lock;
+        switch (cmd.type) {
+            case WebCommandType::VolumeUp:    volumeUp(); break;
+            case WebCommandType::VolumeDown:  volumeDown(); break;
+            case WebCommandType::SpeakerOn:   enableSpeakerAmp(true); break;
+            case WebCommandType::SpeakerOff:  enableSpeakerAmp(false); break;
+            case WebCommandType::SetMuted:    setMuted(cmd.arg != 0); break;
+            case WebCommandType::SetEnhance:  enhanceAudio = cmd.arg != 0; break;
+            case WebCommandType::SetAgc:      mixer.setAgc(cmd.arg != 0); break;
+            case WebCommandType::SetNoiseSuppress: noiseSuppress = cmd.arg != 0; break;
+            case WebCommandType::SetRogerBeep: rogerBeep = cmd.arg != 0; break;
+            case WebCommandType::NextProfile:
+                enhancementProfile = (enhancementProfile + 1) % 3;  // Cycle through profiles
+                break;
+            case WebCommandType::SetRecording:
+                recorder.setEnabled(cmd.arg != 0);   // takes effect from the next stream
+                break;
+            case WebCommandType::Replay:
+                replayCommand(cmd.arg);
+                break;
+            case WebCommandType::SetReplaySpeed:
+                if (cmd.arg == 100 || cmd.arg == 125 || cmd.arg == 150) {
+                    replaySpeed = cmd.arg;   // used from the next replay on
+                }
+                break;
+            case WebCommandType::SetDmaBuffers:
+                setDmaBuffers(cmd.arg, i2sDmaFrames);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void recordHttpStats(HttpRequestStats& stats, uint32_t startUs, uint32_t startHeap) {
+    stats.lastUs = micros() - startUs;
+    if (stats.lastUs > stats.maxUs) stats.maxUs = stats.lastUs;
+    stats.lastHeapDelta = (int32_t)startHeap - (int32_t)ESP.getFreeHeap();
+    stats.count++;
+}
+
+// Serialize the dashboard state; returns the JSON length.
+// Called from the HTTP server task, so it only reads the snapshot and thread-safe system calls.
+size_t buildStatusJson(char* buf, size_t cap) {
+    char ip[16], gw[16];
+    WiFi.localIP().toString().toCharArray(ip, sizeof(ip));
+    WiFi.gatewayIP().toString().toCharArray(gw, sizeof(gw));
+    uint8_t macBytes[6];
+    WiFi.macAddress(macBytes);
+    char mac[18];
+    snprintf(mac, sizeof(mac), "%02X:%02X:%02X:%02X:%02X:%02X",
+             macBytes[0], macBytes[1], macBytes[2], macBytes[3], macBytes[4], macBytes[5]);
+
+    JsonBuffer json(buf, cap);
+    json.beginObject();
+    json.add("uptime", (unsigned long)(millis() / 1000));
+    json.add("heap", ESP.getFreeHeap());
+    json.add("heapTotal", ESP.getHeapSize());
+    json.add("flash", ESP.getFlashChipSize());
+    json.add("sketchFree", ESP.getFreeSketchSpace());
+    json.add("sdk", ESP.getSdkVersion());
+    json.add("fw", FIRMWARE_VERSION);
+    json.add("ssid", WiFi.SSID().c_str());
+    json.add("ip", ip);
+    json.add("mac", mac);
+    json.add("rssi", (int)WiFi.RSSI());
+    json.add("gw", gw);
+    StatusSnapshot status = statusSnapshot.read();
+    json.add("volume", (int)status.volume);
+    json.add("muted", status.muted);
+    json.add("amp", status.ampOn);
+    json.add("ws", status.wsConnected);
+    json.add("stream", status.streamActive);
+    json.add("channel", status.channel);
+    json.add("streams", (int)status.liveStreams);
+    json.add("decLoad", status.decodeLoadPermille / 10.0f, 1);
+    json.add("preempt", status.preempt);
+    json.add("held", (int)status.heldStreams);
+    json.add("overlap", status.overlap);
+    json.add("enhance", status.enhanceAudio);
+    json.add("agc", status.agc);
+    json.add("ns", status.noiseSuppress);
+    json.add("roger", status.rogerBeep);
+    json.add("profile", (int)status.enhancementProfile);
+    json.add("packets", status.totalPackets);
+    json.add("streamMs", status.streamMs);
+    json.add("underruns", status.audioUnderruns);
+    json.add("i2sUnderruns", status.i2sUnderruns);
+    json.add("dmaCount", (int)status.dmaCount);
+    json.add("dmaFrames", (int)status.dmaFrames);
+    json.add("driftPpm", (int)status.driftPpm);
+    json.add("talker", status.talker);
+    json.add("sid", status.streamId);
+    json.add("pps", status.packetsPerSec10 / 10.0f, 1);
+    json.add("bufMs", (int)status.bufferMs);
+    json.add("decUs", (int)status.decodeUs);
+    json.add("jitterUs", (int)rxJitterMetric.value());
+    json.add("reconnects", reconnectMetric.value());
+    json.add("heapMin", (int)heapLowWaterMetric.value());
+    json.add("record", status.recording);
+    json.add("hist", (int)status.historyCount);
+    json.add("replay", (int)status.replayIndex);
+    json.add("replaySpeed", (int)status.replaySpeed);
+    json.add("replayTalker", status.replayTalker);
+    // Recorder write amplification: flash bytes per Opus byte, x100
+    uint32_t recPayload = recPayloadMetric.value();
+    json.add("recAmp", recPayload ? (unsigned)((uint64_t)recFlashMetric.value() * 100 / recPayload) : 0u);
+    // p50/p99 upper bounds of the latency histograms, in us
+    const struct {
+        const char* key;
+        HistogramMetric& metric;
+    } latencies[] = {
+        {"arrival", rxInterarrivalMetric},
+        {"decode", decodeMetric},
+        {"i2s", i2sWriteMetric},
+        {"aec", txAecMetric},
+        {"ns", txNsMetric},
+        {"encode", encodeMetric},
+        {"wsSend", wsSendMetric},
+    };
+    json.beginObject("lat");
+    for (const auto& l : latencies) {
+        json.beginArray(l.key);
+        json.add(nullptr, l.metric.quantile(0.5f));
+        json.add(nullptr, l.metric.quantile(0.99f));
+        json.endArray();
+    }
+    json.endObject();
+    json.beginObject("http");
+    json.add("dashUs", dashboardHttpStats.lastUs);
+    json.add("dashMaxUs", dashboardHttpStats.maxUs);
+    json.add("dashHeap", dashboardHttpStats.lastHeapDelta);
+    json.add("apiUs", apiHttpStats.lastUs);
+    json.add("apiMaxUs", apiHttpStats.maxUs);
+    json.add("apiHeap", apiHttpStats.lastHeapDelta);
+    json.endObject();
+    json.endObject();
+    return json.length();
+}
+
+// Per-task CPU, stacks and the depth of the queues between tasks, for the
+// dashboard's task table. HTTP server task only: the monitor keeps the last sample.
+size_t buildTasksJson(char* buf, size_t cap) {
+    static TaskMonitor monitor;
+    static TaskStat tasks[TASK_MONITOR_MAX_TASKS];
+    int count = monitor.sample(tasks, TASK_MONITOR_MAX_TASKS);
+    StatusSnapshot status = statusSnapshot.read();
+
+    JsonBuffer json(buf, cap);
+    json.beginObject();
+    json.beginArray("cores");
+    json.add(nullptr, monitor.coreLoad(0) < 0 ? -1.0f : monitor.coreLoad(0) / 10.0f, 1);
+    json.add(nullptr, monitor.coreLoad(1) < 0 ? -1.0f : monitor.coreLoad(1) / 10.0f, 1);
+    json.endArray();
+    json.beginArray("tasks");
+    for (int i = 0; i < count; i++) {
+        const TaskStat& t = tasks[i];
+        json.beginObject();
+        json.add("name", t.name);
+        json.add("role", t.spec ? t.spec->role : "");
+        json.add("core", (int)t.core);
+        json.add("prio", (int)t.priority);
+        json.add("cpu", t.cpuPermille < 0 ? -1.0f : t.cpuPermille / 10.0f, 1);
+        json.add("stackFree", (unsigned long)t.stackFree);
+        json.add("stack", t.spec ? (int)t.spec->stack : 0);
+        json.endObject();
+    }
+    json.endArray();
+    json.beginObject("queues");
+    json.add("web", (unsigned)webCommands.pending());
+    json.add("tx", (unsigned)txMessages.pending());
+    json.add("input", (unsigned)inputs.pending());
+    json.add("log", (unsigned long)binlogRing.pending());
+    json.add("held", (int)status.heldStreams);
+    json.add("recBytes", (unsigned)recorder.queuedBytes());
+    json.endObject();
+    json.endObject();
+    return json.length();
+}
+
+// One telemetry sample; compared field by field against the last one sent
+struct TelemetryFrame {
+    bool streamActive;
+    bool wsConnected;
+    bool ampOn;
+    uint8_t volume;
+    bool muted;
+    uint16_t packetsPerSec10;
+    uint16_t bufferMs;
+    uint16_t decodeUs;
+    int8_t rssi;
+    uint16_t heapKb;
+    uint8_t liveStreams;
+    uint8_t heldStreams;
+    uint16_t decodeLoadPermille;
+    char talker[64];
+    char streamId[11];            // decimal uint32, "" when no stream is live
+};
+
+TelemetryFrame captureTelemetry() {
+    StatusSnapshot status = statusSnapshot.read();
+    TelemetryFrame frame;
+    frame.streamActive = status.streamActive;
+    frame.wsConnected = status.wsConnected;
+    frame.ampOn = status.ampOn;
+    frame.volume = status.volume;
+    frame.muted = status.muted;
+    frame.packetsPerSec10 = status.packetsPerSec10;
+    frame.bufferMs = status.bufferMs;
+    frame.decodeUs = status.decodeUs;
+    frame.rssi = (int8_t)WiFi.RSSI();
+    frame.heapKb = ESP.getFreeHeap() / 1024;   // KB resolution keeps heap jitter out of the deltas
+    frame.liveStreams = status.liveStreams;
+    frame.heldStreams = status.heldStreams;
+    frame.decodeLoadPermille = status.decodeLoadPermille;
+    memcpy(frame.talker, status.talker, sizeof(frame.talker));
+    memcpy(frame.streamId, status.streamId, sizeof(frame.streamId));
+    return frame;
+}
+
+// Serialize only the fields that differ from 'last' (all of them when last is null)
+size_t buildTelemetryDelta(char* buf, size_t cap, const TelemetryFrame& cur, const TelemetryFrame* last) {
+    JsonBuffer json(buf, cap);
+    json.beginObject();
+    if (!last || strcmp(cur.talker, last->talker) != 0) json.add("talker", cur.talker);
+    if (!last || strcmp(cur.streamId, last->streamId) != 0) json.add("sid", cur.streamId);
+    if (!last || cur.streamActive != last->streamActive) json.add("stream", cur.streamActive);
+    if (!last || cur.wsConnected != last->wsConnected) json.add("ws", cur.wsConnected);
+    if (!last || cur.ampOn != last->ampOn) json.add("amp", cur.ampOn);
+    if (!last || cur.volume != last->volume) json.add("volume", (int)cur.volume);
+    if (!last || cur.muted != last->muted) json.add("muted", cur.muted);
+    if (!last || cur.packetsPerSec10 != last->packetsPerSec10) json.add("pps", cur.packetsPerSec10 / 10.0f, 1);
+    if (!last || cur.bufferMs != last->bufferMs) json.add("bufMs", (int)cur.bufferMs);
+    if (!last || cur.decodeUs != last->decodeUs) json.add("decUs", (int)cur.decodeUs);
+    if (!last || cur.liveStreams != last->liveStreams) json.add("streams", (int)cur.liveStreams);
+    if (!last || cur.heldStreams != last->heldStreams) json.add("held", (int)cur.heldStreams);
+    if (!last || cur.decodeLoadPermille != last->decodeLoadPermille) {
+        json.add("decLoad", cur.decodeLoadPermille / 10.0f, 1);
+    }
+    // RSSI wobbles by a dB or two all the time; only report real changes
+    if (!last || abs(cur.rssi - last->rssi) >= 2) json.add("rssi", (int)cur.rssi);
+    if (!last || cur.heapKb != last->heapKb) json.add("heapKb", (int)cur.heapKb);
+    json.endObject();
+    return json.length();
+}
+
+// Builds each delta once and broadcasts it to every connected browser.
+// Idles without sampling anything while nobody is listening.
+void telemetryTask(void* parameter) {
+    TelemetryFrame last;
+    bool haveLast = false;
+    unsigned long lastKeyframe = 0;
+    char buf[384];
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(TELEMETRY_INTERVAL_MS));
+        if (telemetryEvents.count() == 0) {
+            haveLast = false;
+            continue;
+        }
+
+        TelemetryFrame cur = captureTelemetry();
+        unsigned long now = millis();
+        bool keyframe = !haveLast || telemetryKeyframeRequested || now - lastKeyframe >= TELEMETRY_KEYFRAME_MS;
+        size_t len = buildTelemetryDelta(buf, sizeof(buf), cur, keyframe ? nullptr : &last);
+        if (len > 2) {   // "{}" means nothing changed
+            telemetryEvents.send(buf, "t", now);
+        }
+        if (keyframe) {
+            telemetryKeyframeRequested = false;
+            lastKeyframe = now;
+        }
+        last = cur;
+        haveLast = true;
+    }
+}
+
+void startTelemetry() {
+    telemetryEvents.onConnect([](AsyncEventSourceClient* eventClient) {
+        // Next tick sends the full state so the new browser starts complete
+        telemetryKeyframeRequested = true;
     });
-    
-    // OTA update endpoint
-    server.on("/update", HTTP_POST, []() {
-        server.sendHeader("Connection", "close");
-        server.send(200, "text/plain", (Update.hasError()) ? "FAIL" : "OK");
-        delay(1000);
-        ESP.restart();
-    }, []() {
-        HTTPUpload& upload = server.upload();
-        
-        if (upload.status == UPLOAD_FILE_START) {
-            Serial.printf("Update: %s\n", upload.filename.c_str());
-            if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
-                Update.printError(Serial);
-                return;
+    server.addHandler(&telemetryEvents);
+    xTaskCreatePinnedToCore(telemetryTask, "telemetryTask", TASK_TELEMETRY_STACK, nullptr,
+                            TASK_HOUSEKEEPING_PRIORITY, nullptr, TASK_HOUSEKEEPING_CORE);
+}
+
+BinlogRing binlogRing;
+
+uint32_t binlogTimestampUs() {
+    return (uint32_t)esp_timer_get_time();
+}
+
+// Formats deferred log records and writes them to Serial. Runs at the lowest
+// priority on core 0, so a slow UART only ever delays the log, not the audio.
+void binlogTask(void* parameter) {
+    static const char LEVEL_TAGS[] = "?EWID";
+    char line[192];
+    uint32_t reportedDrops = 0;
+
+    for (;;) {
+        const BinlogSite* site;
+        uint32_t timestampUs;
+        uint32_t a[BINLOG_MAX_ARGS];
+        bool any = false;
+        while (binlogRing.pop(site, timestampUs, a)) {
+            any = true;
+            // Arguments were checked against the format at the call site
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+            snprintf(line, sizeof(line), site->format, a[0], a[1], a[2], a[3], a[4], a[5]);
+#pragma GCC diagnostic pop
+            Serial.printf("[%lu.%03lu] %c %s\n",
+                          (unsigned long)(timestampUs / 1000000), (unsigned long)(timestampUs / 1000 % 1000),
+                          LEVEL_TAGS[site->level <= BINLOG_DEBUG ? site->level : 0], line);
+        }
+        uint32_t drops = binlogRing.dropped();
+        if (drops != reportedDrops) {
+            Serial.printf("[log] %u records dropped\n", (unsigned)(drops - reportedDrops));
+            logDroppedMetric.inc(drops - reportedDrops);
+            reportedDrops = drops;
+        }
+        if (!any) vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+void startBinlog() {
+    xTaskCreatePinnedToCore(binlogTask, "binlogTask", TASK_LOG_STACK, nullptr, TASK_LOG_PRIORITY, nullptr,
+                            TASK_HOUSEKEEPING_CORE);
+}
+
+#if ZELLO_LOG_BENCH
+// Cycles per call for a deferred record vs. the same line through Serial.printf
+void benchmarkLogging() {
+    const int N = 32;
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < N; i++) {
+        ZLOG(BINLOG_ERROR, "bench packet=%d, bytes=%u/%u", i, 120u, 120u);
+    }
+    uint32_t deferredCycles = (ESP.getCycleCount() - start) / N;
+
+    start = ESP.getCycleCount();
+    for (int i = 0; i < N; i++) {
+        Serial.printf("bench packet=%d, bytes=%u/%u\n", i, 120u, 120u);
+    }
+    uint32_t serialCycles = (ESP.getCycleCount() - start) / N;
+
+    Serial.printf("Log benchmark: deferred %u cycles/call (%u ns), Serial.printf %u cycles/call (%u us)\n",
+                  (unsigned)deferredCycles, (unsigned)(deferredCycles * 1000 / ESP.getCpuFreqMHz()),
+                  (unsigned)serialCycles, (unsigned)(serialCycles / ESP.getCpuFreqMHz()));
+}
+#endif
+
+#if ZELLO_DECODE_BENCH
+#define DECODE_BENCH_FRAMES 50              // 1 s of 20 ms packets
+#define DECODE_BENCH_BUDGET_PERMILLE 500    // share of core 1 audio may take; WiFi, TLS and HTTP need the rest
+
+// Decode + mix cost of 1..N concurrent streams at Zello's usual 16 kHz / 16 kbit/s,
+// to find how many monitored channels the ESP32 can follow at once
+void benchmarkDecode() {
+    static uint8_t packets[DECODE_BENCH_FRAMES][160];
+    int lens[DECODE_BENCH_FRAMES];
+    int err = 0;
+    OpusEncoder* enc = opus_encoder_create(PLAYBACK_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+    if (!enc || err != OPUS_OK) {
+        Serial.printf("Decode benchmark: encoder failed (%d)\n", err);
+        return;
+    }
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(16000));
+    // Stand-in for voiced speech: 140 Hz with harmonics under a 4 Hz syllable envelope
+    int16_t pcm[320];
+    uint32_t n = 0;
+    for (int f = 0; f < DECODE_BENCH_FRAMES; f++) {
+        for (int i = 0; i < 320; i++, n++) {
+            float t = n / (float)PLAYBACK_SAMPLE_RATE;
+            float envelope = 0.5f + 0.5f * sinf(2 * PI * 4 * t);
+            float v = sinf(2 * PI * 140 * t) + 0.5f * sinf(2 * PI * 280 * t) +
+                      0.25f * sinf(2 * PI * 560 * t) + 0.1f * sinf(2 * PI * 1400 * t);
+            pcm[i] = (int16_t)(v * envelope * 6000);
+        }
+        lens[f] = opus_encode(enc, pcm, 320, packets[f], sizeof(packets[f]));
+    }
+    opus_encoder_destroy(enc);
+
+    Serial.printf("Decode benchmark, 20 ms packets at %d Hz:\n", PLAYBACK_SAMPLE_RATE);
+    int16_t block[MIX_BLOCK_SAMPLES];
+    uint32_t perStreamUs = 0;
+    for (int count = 1; count <= mixer.slots(); count++) {
+        MixStream* streams[MIX_MAX_STREAMS];
+        for (int s = 0; s < count; s++) streams[s] = mixer.open(s + 1, 0, "bench");
+        uint32_t decodeCycles = 0, mixCycles = 0;
+        for (int f = 0; f < DECODE_BENCH_FRAMES; f++) {
+            uint32_t start = ESP.getCycleCount();
+            for (int s = 0; s < count; s++) {
+                if (streams[s]) mixer.decode(streams[s], packets[f], lens[f]);
             }
-        } else if (upload.status == UPLOAD_FILE_WRITE) {
-            if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
-                Update.printError(Serial);
-                return;
+            decodeCycles += ESP.getCycleCount() - start;
+            start = ESP.getCycleCount();
+            mixer.mix(block, MIX_BLOCK_SAMPLES);
+            mixer.mix(block, MIX_BLOCK_SAMPLES);
+            mixCycles += ESP.getCycleCount() - start;
+        }
+        for (int s = 0; s < count; s++) mixer.drop(s + 1);
+        uint32_t decodeUs = decodeCycles / ESP.getCpuFreqMHz() / DECODE_BENCH_FRAMES;
+        uint32_t mixUs = mixCycles / ESP.getCpuFreqMHz() / DECODE_BENCH_FRAMES;
+        if (count == 1) perStreamUs = decodeUs + mixUs;
+        // us of work per 20 ms of audio / 20 = per mille of one core
+        uint32_t load = (decodeUs + mixUs) / 20;
+        Serial.printf("  %d stream(s): decode %u us + mix %u us per packet time, %u.%u%% of a core%s\n",
+                      count, (unsigned)decodeUs, (unsigned)mixUs, (unsigned)(load / 10), (unsigned)(load % 10),
+                      mixer.slot(count - 1).inPsram ? " (last slot in PSRAM)" : "");
+    }
+    if (perStreamUs) {
+        Serial.printf("  -> about %u concurrent streams fit in %u%% of a core; %d mixer slots built (MIX_MAX_STREAMS)\n",
+                      (unsigned)(DECODE_BENCH_BUDGET_PERMILLE * 20 / perStreamUs),
+                      DECODE_BENCH_BUDGET_PERMILLE / 10, mixer.slots());
+    }
+}
+#endif
+
+#if ZELLO_TRACE
+TraceRing traceRings[portNUM_PROCESSORS];
+
+// (cycle count, esp_timer) pair sampled on one core; CCOUNT is per core and wraps
+// every ~18 s, so each core's events are placed by their age relative to this anchor
+struct TraceClockAnchor {
+    uint32_t ccount;
+    int64_t timeUs;
+};
+
+static void sampleTraceClock(void* arg) {
+    TraceClockAnchor* anchor = (TraceClockAnchor*)arg;
+    anchor->ccount = xthal_get_ccount();
+    anchor->timeUs = esp_timer_get_time();
+}
+
+// Frozen copy of the rings, streamed out as Chrome trace_event JSON
+struct TraceDump {
+    TraceEvent* events[portNUM_PROCESSORS] = {};
+    uint32_t count[portNUM_PROCESSORS] = {};
+    TraceClockAnchor anchor[portNUM_PROCESSORS];
+    uint32_t cyclesPerUs = 240;
+    int stage = 0;       // 0 = header, 1 = events, 2 = footer, 3 = done
+    int core = 0;
+    uint32_t next = 0;
+
+    ~TraceDump() {
+        for (int c = 0; c < portNUM_PROCESSORS; c++) free(events[c]);
+    }
+};
+
+std::shared_ptr<TraceDump> snapshotTrace() {
+    std::shared_ptr<TraceDump> dump(new TraceDump());
+    dump->cyclesPerUs = ESP.getCpuFreqMHz();
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        TraceRing& ring = traceRings[c];
+        uint32_t head = ring.head.load(std::memory_order_relaxed);
+        uint32_t n = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+        dump->events[c] = (TraceEvent*)heap_caps_malloc(n * sizeof(TraceEvent) + 1, MALLOC_CAP_SPIRAM);
+        if (!dump->events[c]) dump->events[c] = (TraceEvent*)malloc(n * sizeof(TraceEvent) + 1);
+        if (!dump->events[c]) return nullptr;
+        for (uint32_t i = 0; i < n; i++) {
+            dump->events[c][i] = ring.events[(head - n + i) & (TRACE_RING_SIZE - 1)];
+        }
+        dump->count[c] = n;
+        // Anchor after copying, so every copied event is older than the anchor
+        if (c == xPortGetCoreID()) {
+            sampleTraceClock(&dump->anchor[c]);
+        } else {
+            esp_ipc_call_blocking(c, sampleTraceClock, &dump->anchor[c]);
+        }
+    }
+    return dump;
+}
+
+// Chunked-response filler: writes whole JSON records while they fit, 0 when finished
+size_t writeTraceChunk(TraceDump& dump, uint8_t* buffer, size_t maxLen) {
+    char* out = (char*)buffer;
+    size_t len = 0;
+    const size_t RECORD_MAX = 128;
+
+    while (dump.stage < 3 && maxLen - len >= RECORD_MAX) {
+        if (dump.stage == 0) {
+            len += snprintf(out + len, maxLen - len, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+            for (int c = 0; c < portNUM_PROCESSORS; c++) {
+                len += snprintf(out + len, maxLen - len,
+                                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"core %d\"}}",
+                                c ? "," : "", c, c);
             }
-        } else if (upload.status == UPLOAD_FILE_END) {
-            if (Update.end(true)) {
-                Serial.printf("Update Success: %u\nRebooting...\n", upload.totalSize);
-            } else {
-                Update.printError(Serial);
+            dump.stage = 1;
+        } else if (dump.stage == 1) {
+            if (dump.core >= portNUM_PROCESSORS) {
+                dump.stage = 2;
+                continue;
             }
+            if (dump.next >= dump.count[dump.core]) {
+                dump.core++;
+                dump.next = 0;
+                continue;
+            }
+            const TraceEvent& ev = dump.events[dump.core][dump.next++];
+            const TraceClockAnchor& anchor = dump.anchor[dump.core];
+            uint32_t ageCycles = anchor.ccount - ev.ccount;
+            int64_t tsNs = anchor.timeUs * 1000 - (int64_t)ageCycles * 1000 / dump.cyclesPerUs;
+            if (ev.id >= TRACE_ID_COUNT || tsNs < 0) continue;
+            len += snprintf(out + len, maxLen - len,
+                            ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld.%03d,\"pid\":1,\"tid\":%d}",
+                            TRACE_NAMES[ev.id], ev.phase, (long long)(tsNs / 1000), (int)(tsNs % 1000), dump.core);
+        } else {
+            len += snprintf(out + len, maxLen - len, "]}");
+            dump.stage = 3;
         }
-        
-        yield();
+    }
+    return len;
+}
+#endif
+
+// Implementation of the missing setupOTAWebServer function
+void setupOTAWebServer() {
+    // Dashboard page, stylesheet and script are served gzip'd straight from flash;
+    // live values are fetched by the page from /api/status
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        const WebAsset* asset = &WEB_ASSETS[i];
+        server.on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest* request) {
+            uint32_t t0 = micros();
+            uint32_t heap0 = ESP.getFreeHeap();
+            AsyncWebServerResponse* response = request->beginResponse(200, asset->contentType, asset->data, asset->length);
+            response->addHeader("Content-Encoding", "gzip");
+            response->addHeader("Cache-Control", strcmp(asset->path, "/") == 0 ? "no-cache" : "max-age=86400");
+            request->send(response);
+            recordHttpStats(dashboardHttpStats, t0, heap0);
+        });
+    }
+
+    // Compact JSON snapshot of the device state, built into a fixed buffer
+    server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest* request) {
+        uint32_t t0 = micros();
+        uint32_t heap0 = ESP.getFreeHeap();
+        // Only the HTTP server task builds into this buffer; the basic response takes
+        // one copy of the finished document, since it is sent after this handler returns
+        static char statusJson[1536];
+        buildStatusJson(statusJson, sizeof(statusJson));
+        AsyncWebServerResponse* response = request->beginResponse(200, "application/json", statusJson);
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+        recordHttpStats(apiHttpStats, t0, heap0);
+    });
+
+    server.on("/api/tasks", HTTP_GET, [](AsyncWebServerRequest* request) {
+        static char tasksJson[3072];   // 24 tasks of ~100 bytes
+        buildTasksJson(tasksJson, sizeof(tasksJson));
+        AsyncWebServerResponse* response = request->beginResponse(200, "application/json", tasksJson);
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+    });
+
+    // Control endpoints only post a command; loop() owns the audio and network state
+    auto commandEndpoint = [](const char* path, WebCommandType type, int32_t arg) {
+        server.on(path, HTTP_GET, [type, arg](AsyncWebServerRequest* request) {
+            postWebCommand(type, arg);
+            redirectToDashboard(request);
+        });
+    };
+    commandEndpoint("/volume/up", WebCommandType::VolumeUp, 0);
+    commandEndpoint("/volume/down", WebCommandType::VolumeDown, 0);
+    commandEndpoint("/speaker/on", WebCommandType::SpeakerOn, 0);
+    commandEndpoint("/speaker/off", WebCommandType::SpeakerOff, 0);
+    commandEndpoint("/audio/enhance/0", WebCommandType::SetEnhance, 0);
+    commandEndpoint("/audio/enhance/1", WebCommandType::SetEnhance, 1);
+    commandEndpoint("/audio/profile/next", WebCommandType::NextProfile, 0);
+    commandEndpoint("/reconnect", WebCommandType::Reconnect, 0);
+
+    // Same controls for the dashboard script: POST action=<name>, answers 204 instead of a redirect
+    server.on("/api/control", HTTP_POST, [](AsyncWebServerRequest* request) {
+        static const struct {
+            const char* action;
+            WebCommandType type;
+            int32_t arg;
+        } actions[] = {
+            {"volume_up", WebCommandType::VolumeUp, 0},
+            {"volume_down", WebCommandType::VolumeDown, 0},
+            {"speaker_on", WebCommandType::SpeakerOn, 0},
+            {"speaker_off", WebCommandType::SpeakerOff, 0},
+            {"mute_on", WebCommandType::SetMuted, 1},
+            {"mute_off", WebCommandType::SetMuted, 0},
+            {"enhance_off", WebCommandType::SetEnhance, 0},
+            {"enhance_on", WebCommandType::SetEnhance, 1},
+            {"agc_off", WebCommandType::SetAgc, 0},
+            {"agc_on", WebCommandType::SetAgc, 1},
+            {"ns_off", WebCommandType::SetNoiseSuppress, 0},
+            {"ns_on", WebCommandType::SetNoiseSuppress, 1},
+            {"roger_off", WebCommandType::SetRogerBeep, 0},
+            {"roger_on", WebCommandType::SetRogerBeep, 1},
+            {"profile_next", WebCommandType::NextProfile, 0},
+            {"record_on", WebCommandType::SetRecording, 1},
+            {"record_off", WebCommandType::SetRecording, 0},
+            {"replay_latest", WebCommandType::Replay, 0},
+            {"replay_older", WebCommandType::Replay, REPLAY_OLDER},
+            {"replay_stop", WebCommandType::Replay, REPLAY_STOP},
+            {"replay_speed_100", WebCommandType::SetReplaySpeed, 100},
+            {"replay_speed_125", WebCommandType::SetReplaySpeed, 125},
+            {"replay_speed_150", WebCommandType::SetReplaySpeed, 150},
+            {"dma_2", WebCommandType::SetDmaBuffers, 2},
+            {"dma_4", WebCommandType::SetDmaBuffers, 4},
+            {"dma_8", WebCommandType::SetDmaBuffers, 8},
+            {"reconnect", WebCommandType::Reconnect, 0},
+        };
+        if (!request->hasParam("action", true)) {
+            request->send(400, "text/plain", "Missing action");
+            return;
+        }
+        const String& action = request->getParam("action", true)->value();
+        for (const auto& entry : actions) {
+            if (action == entry.action) {
+                request->send(postWebCommand(entry.type, entry.arg) ? 204 : 503);
+                return;
+            }
+        }
+        request->send(400, "text/plain", "Unknown action");
+    });
+    
+    // Reboot endpoint
+    server.on("/reboot", HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(200, "text/html", "<html><body><h1>Device is restarting...</h1><script>setTimeout(function(){window.location.href='/';}, 8000);</script></body></html>");
+        postWebCommand(WebCommandType::Reboot, 0);
+    });
+    
+    // OTA update endpoint: manifest, then image (see include/ota_pipeline.h). The
+    // upload callback runs in the HTTP server task; flash writes happen in otaTask.
+    server.on("/update", HTTP_POST, [](AsyncWebServerRequest* request) {
+        bool ok = otaPipeline.succeeded(request);
+        AsyncWebServerResponse* response = request->beginResponse(ok ? 200 : 400, "text/plain", otaPipeline.result());
+        response->addHeader("Connection", "close");
+        request->send(response);
+        if (ok) {
+            postWebCommand(WebCommandType::Reboot, 0);
+        }
+    }, [](AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final) {
+        if (index == 0) {
+            Serial.printf("Update: %s\n", filename.c_str());
+            request->onDisconnect([request]() { otaPipeline.abort(request); });
+        }
+        otaPipeline.receive(request, index, data, len, final);
     });
     
     // OTA update page
-    server.on("/ota", HTTP_GET, []() {
+    server.on("/ota", HTTP_GET, [](AsyncWebServerRequest* request) {
         String html = "<!DOCTYPE html><html><head>";
         html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
         html += "<title>ESP32 OTA Update</title>";
@@ -1130,8 +2674,10 @@ void setupOTAWebServer() {
         html += "</style></head><body>";
         html += "<h1>ESP32 Firmware Update</h1>";
         html += "<p>Current Version: " + String(FIRMWARE_VERSION) + "</p>";
+        html += "<p>Make the manifest with <code>tools/ota_sign.py sign firmware.bin</code>.</p>";
         html += "<form method='POST' action='/update' enctype='multipart/form-data' id='upload_form'>";
-        html += "<input type='file' name='update'><br>";
+        html += "Manifest: <input type='file' name='manifest' accept='.manifest'><br>";
+        html += "Firmware: <input type='file' name='update' accept='.bin,.zota'><br>";
         html += "<progress id='prog' value='0' max='100'></progress><br>";
         html += "<input type='submit' value='Update'>";
         html += "</form>";
@@ -1151,10 +2697,10 @@ void setupOTAWebServer() {
         html += "  xhr.onreadystatechange = function() {";
         html += "    if (xhr.readyState === 4) {";
         html += "      if (xhr.status === 200) {";
-        html += "        stat.innerHTML = 'Update successful! Rebooting...';";
+        html += "        stat.textContent = xhr.responseText + ' - rebooting...';";
         html += "        setTimeout(function(){window.location.href='/';}, 10000);";
         html += "      } else {";
-        html += "        stat.innerHTML = 'Update failed';";
+        html += "        stat.textContent = 'Update failed: ' + xhr.responseText;";
         html += "      }";
         html += "    }";
         html += "  };";
@@ -1163,11 +2709,17 @@ void setupOTAWebServer() {
         html += "</script>";
         html += "<p><a href='/'>&larr; Back to Dashboard</a></p>";
         html += "</body></html>";
-        server.send(200, "text/html", html);
+        request->send(200, "text/html", html);
     });
 
     // Add WiFi configuration page
-    server.on("/config/wifi", HTTP_GET, []() {
+    server.on("/config/wifi", HTTP_GET, [](AsyncWebServerRequest* request) {
+        String ssid, password;
+        lockConfig();
+        ssid = ::ssid;
+        password = ::password;
+        unlockConfig();
+
         String html = "<!DOCTYPE html><html><head>";
         html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
         html += "<title>WiFi Configuration</title>";
@@ -1206,91 +2758,45 @@ void setupOTAWebServer() {
         html += "</div>";
         html += "<p><a href='/'>&larr; Back to Dashboard</a></p>";
         html += "</body></html>";
-        server.send(200, "text/html", html);
+        request->send(200, "text/html", html);
     });
 
     // Handle saving WiFi configuration
-    server.on("/config/wifi/save", HTTP_POST, []() { 
-        bool needReboot = false;
-        
-        // Get form values
-        if (server.hasArg("ssid") && server.arg("ssid") != ssid) {
-            ssid = server.arg("ssid");
-            needReboot = true;
+    server.on("/config/wifi/save", HTTP_POST, [](AsyncWebServerRequest* request) { 
+        ConfigUpdate* update = new ConfigUpdate();
+        update->kind = ConfigUpdate::WiFi;
+        if (request->hasParam("ssid", true)) {
+            update->ssid = request->getParam("ssid", true)->value();
+            update->hasSsid = true;
         }
-        
-        if (server.hasArg("password") && server.arg("password") != password) {
-            password = server.arg("password");
-            needReboot = true;
+        if (request->hasParam("password", true)) {
+            update->password = request->getParam("password", true)->value();
+            update->hasPassword = true;
         }
-        
-        // Save to file if changes were made
-        if (needReboot) {
-            // Read existing file content to preserve other settings
-            File wifiFile = SPIFFS.open("/wifi_credentials.ini", "r");
-            String fileContent = "";
-            
-            if (wifiFile) {
-                while (wifiFile.available()) {
-                    fileContent += wifiFile.readStringUntil('\n') + "\n";
-                }
-                wifiFile.close();
-                
-                // Update or add WiFi credentials
-                bool ssidFound = false;
-                bool passwordFound = false;
-                
-                // Create a temporary buffer for the new content
-                String newContent = "";
-                int startPos = 0;
-                int endPos = 0;
-                
-                while ((endPos = fileContent.indexOf('\n', startPos)) != -1) {
-                    String line = fileContent.substring(startPos, endPos + 1);
-                    if (line.indexOf("ssid=") == 0) {
-                        newContent += "ssid=" + ssid + "\n";
-                        ssidFound = true;
-                    } 
-                    else if (line.indexOf("password=") == 0) {
-                        newContent += "password=" + password + "\n";
-                        passwordFound = true;
-                    } 
-                    else {
-                        newContent += line;
-                    }
-                    startPos = endPos + 1;
-                }
-                
-                // Add any missing entries
-                if (!ssidFound) {
-                    newContent += "ssid=" + ssid + "\n";
-                }
-                if (!passwordFound) {
-                    newContent += "password=" + password + "\n";
-                }
-                
-                // Write the updated content back
-                wifiFile = SPIFFS.open("/wifi_credentials.ini", "w");
-                if (wifiFile) {
-                    wifiFile.print(newContent);
-                    wifiFile.close();
-                    Serial.println("WiFi credentials updated in wifi_credentials.ini");
-                }
-            }
-            
-            // Send response page and reboot
-            server.send(200, "text/html", "<html><body><h2>WiFi Settings Updated</h2><p>The device is restarting to apply the new settings...</p><script>setTimeout(function(){window.location.href='/';}, 10000);</script></body></html>");
-            delay(1000);
-            ESP.restart();
-        } else {
-            // Redirect back to the dashboard if no changes
-            server.sendHeader("Location", "/");
-            server.send(303);
+        // loop() decides whether anything changed and reboots if needed
+        if (!postWebCommand(WebCommandType::ApplyConfig, 0, update)) {
+            delete update;
+            request->send(503, "text/plain", "Busy, try again");
+            return;
         }
+        request->send(200, "text/html", "<html><body><h2>WiFi Settings Submitted</h2><p>If they changed, the device is restarting to apply the new settings...</p><script>setTimeout(function(){window.location.href='/';}, 10000);</script></body></html>");
     });
 
     // Add Zello configuration page - Fixed UTF-8 handling
-    server.on("/config/zello", HTTP_GET, []() {
+    server.on("/config/zello", HTTP_GET, [](AsyncWebServerRequest* request) {
+        String zelloUsername, zelloPassword, zelloChannel, monitorChannels, overlapPolicy, token;
+        bool priorityPreempt, queueCatchUp;
+        lockConfig();
+        zelloUsername = ::zelloUsername;
+        zelloPassword = ::zelloPassword;
+        zelloChannel = ::zelloChannel;
+        monitorChannels = ::monitorChannels;
+        priorityPreempt = ::priorityPreempt;
+        overlapPolicy = ::overlapPolicy;
+        queueCatchUp = ::queueCatchUp;
+        token = ::token;
+        unlockConfig();
+
         String html = "<!DOCTYPE html><html><head>";
         html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
         html += "<meta charset='UTF-8'>"; // Add UTF-8 charset declaration
@@ -1334,6 +2840,32 @@ void setupOTAWebServer() {
         
         html += "<label for='channel'>Zello Channel:</label>";
         html += "<input type='text' id='channel' name='channel' value=\"" + safeChannel + "\">";
+
+        // Extra channels to listen to, with their priorities
+        String safeMonitor = monitorChannels;
+        safeMonitor.replace("&", "&amp;");
+        safeMonitor.replace("\"", "&quot;");
+        safeMonitor.replace("<", "&lt;");
+        safeMonitor.replace(">", "&gt;");
+
+        html += "<label for='monitor'>Monitor Channels (Name:priority, comma separated; main channel is priority 1):</label>";
+        html += "<input type='text' id='monitor' name='monitor' placeholder='Dispatch:2, Chat:0' value=\"" + safeMonitor + "\">";
+        html += "<label for='priority_mode'>While a higher-priority channel talks:</label>";
+        html += "<select id='priority_mode' name='priority_mode' style='margin-bottom:15px;'>";
+        html += String("<option value='duck'") + (priorityPreempt ? "" : " selected") + ">Duck lower channels</option>";
+        html += String("<option value='preempt'") + (priorityPreempt ? " selected" : "") + ">Silence lower channels</option>";
+        html += "</select>";
+        html += "<label for='overlap_policy'>When someone starts while an equal or higher priority talks:</label>";
+        html += "<select id='overlap_policy' name='overlap_policy' style='margin-bottom:15px;'>";
+        html += String("<option value='mix'") + (overlapPolicy == "mix" ? " selected" : "") + ">Mix both</option>";
+        html += String("<option value='queue'") + (overlapPolicy == "queue" ? " selected" : "") + ">Play it afterwards</option>";
+        html += String("<option value='drop'") + (overlapPolicy == "drop" ? " selected" : "") + ">Drop it</option>";
+        html += "</select>";
+        html += "<label for='queue_catchup'>While queued messages pile up:</label>";
+        html += "<select id='queue_catchup' name='queue_catchup' style='margin-bottom:15px;'>";
+        html += String("<option value='on'") + (queueCatchUp ? " selected" : "") + ">Shorten pauses to catch up</option>";
+        html += String("<option value='off'") + (queueCatchUp ? "" : " selected") + ">Play them as received</option>";
+        html += "</select>";
         
         // Zello API token
         html += "<label for='token'>Zello API Token:</label>";
@@ -1365,180 +2897,213 @@ void setupOTAWebServer() {
         
         html += "<p><a href='/'>&larr; Back to Dashboard</a></p>";
         html += "</body></html>";
-        server.send(200, "text/html", html);
+        request->send(200, "text/html", html);
     });
 
     // Handle saving Zello configuration - improved UTF-8 handling
-    server.on("/config/zello/save", HTTP_POST, []() { 
-        bool needReconnect = false;
-        
-        Serial.println("Received Zello configuration update:");
-        
-        // Get form values
-        if (server.hasArg("username")) {
-            String newUsername = server.arg("username");
-            Serial.print("Username: ");
-            Serial.println(newUsername);
-            
-            // Debug UTF-8 bytes
-            Serial.print("Username UTF-8 bytes: ");
-            for (int i = 0; i < newUsername.length(); i++) {
-                Serial.printf("%02X ", (uint8_t)newUsername[i]);
-            }
-            Serial.println();
-            
-            if (newUsername != zelloUsername) {
-                zelloUsername = newUsername;
-                needReconnect = true;
-            }
+    server.on("/config/zello/save", HTTP_POST, [](AsyncWebServerRequest* request) { 
+        ConfigUpdate* update = new ConfigUpdate();
+        update->kind = ConfigUpdate::Zello;
+        if (request->hasParam("username", true)) {
+            update->username = request->getParam("username", true)->value();
+            update->hasUsername = true;
         }
-        
-        if (server.hasArg("password")) {
-            String newPassword = server.arg("password");
-            if (newPassword != zelloPassword) {
-                zelloPassword = newPassword;
-                needReconnect = true;
-            }
+        if (request->hasParam("password", true)) {
+            update->zelloPassword = request->getParam("password", true)->value();
+            update->hasZelloPassword = true;
         }
-        
-        if (server.hasArg("channel")) {
-            String newChannel = server.arg("channel");
-            Serial.print("Channel: ");
-            Serial.println(newChannel);
-            
-            // Debug UTF-8 bytes
-            Serial.print("Channel UTF-8 bytes: ");
-            for (int i = 0; i < newChannel.length(); i++) {
-                Serial.printf("%02X ", (uint8_t)newChannel[i]);
-            }
-            Serial.println();
-            
-            if (newChannel != zelloChannel) {
-                zelloChannel = newChannel;
-                needReconnect = true;
-            }
+        if (request->hasParam("channel", true)) {
+            update->channel = request->getParam("channel", true)->value();
+            update->hasChannel = true;
         }
-        
-        if (server.hasArg("token") && server.arg("token") != token) {
-            token = server.arg("token");
-            needReconnect = true;
+        if (request->hasParam("monitor", true)) {
+            update->monitor = request->getParam("monitor", true)->value();
+            update->hasMonitor = true;
         }
-        
-        // Save to file if changes were made
-        if (needReconnect) {
-            // Save to wifi_credentials.ini
-            File wifiFile = SPIFFS.open("/wifi_credentials.ini", "r");
-            String fileContent = "";
-            
-            if (wifiFile) {
-                while (wifiFile.available()) {
-                    fileContent += wifiFile.readStringUntil('\n') + "\n";
-                }
-                wifiFile.close();
-                
-                // Update or add Zello credentials
-                bool usernameFound = false;
-                bool zelloPasswordFound = false;
-                bool channelFound = false;
-                
-                // Create a temporary buffer for the new content
-                String newContent = "";
-                int startPos = 0;
-                int endPos = 0;
-                
-                while ((endPos = fileContent.indexOf('\n', startPos)) != -1) {
-                    String line = fileContent.substring(startPos, endPos + 1);
-                    if (line.indexOf("username=") == 0) {
-                        newContent += "username=" + zelloUsername + "\n";
-                        usernameFound = true;
-                    } 
-                    else if (line.indexOf("password_zello=") == 0) {
-                        newContent += "password_zello=" + zelloPassword + "\n";
-                        zelloPasswordFound = true;
-                    } 
-                    else if (line.indexOf("channel=") == 0) {
-                        newContent += "channel=" + zelloChannel + "\n";
-                        channelFound = true;
-                    }
-                    else {
-                        newContent += line;
-                    }
-                    startPos = endPos + 1;
-                }
-                
-                // Add any missing entries
-                if (!usernameFound) {
-                    newContent += "username=" + zelloUsername + "\n";
-                }
-                if (!zelloPasswordFound) {
-                    newContent += "password_zello=" + zelloPassword + "\n";
-                }
-                if (!channelFound) {
-                    newContent += "channel=" + zelloChannel + "\n";
-                }
-                
-                // Write the updated content back
-                wifiFile = SPIFFS.open("/wifi_credentials.ini", "w");
-                if (wifiFile) {
-                    wifiFile.print(newContent);
-                    wifiFile.close();
-                    Serial.println("Zello credentials updated in wifi_credentials.ini");
-                }
-            }
-            
-            // Save API token separately
-            File tokenFile = SPIFFS.open("/zello-api.key", "w");
-            if (tokenFile) {
-                tokenFile.print(token);
-                tokenFile.close();
-                Serial.println("API token updated in zello-api.key");
-            }
-            
-            // Reconnect to WebSocket if needed
-            if (needReconnect) {
-                Serial.println("Reconnecting to Zello with new credentials...");
-                client.close();
-                delay(500);
-                connectWebSocket();
-            }
+        if (request->hasParam("priority_mode", true)) {
+            update->priorityMode = request->getParam("priority_mode", true)->value();
+            update->hasPriorityMode = true;
+        }
+        if (request->hasParam("overlap_policy", true)) {
+            update->overlapPolicy = request->getParam("overlap_policy", true)->value();
+            update->hasOverlapPolicy = true;
+        }
+        if (request->hasParam("queue_catchup", true)) {
+            update->catchUp = request->getParam("queue_catchup", true)->value() != "off";
+            update->hasCatchUp = true;
+        }
+        if (request->hasParam("token", true)) {
+            update->token = request->getParam("token", true)->value();
+            update->hasToken = true;
+        }
+        if (!postWebCommand(WebCommandType::ApplyConfig, 0, update)) {
+            delete update;
+            request->send(503, "text/plain", "Busy, try again");
+            return;
         }
-        
         // Redirect back to the dashboard with a success message
-        server.sendHeader("Location", "/");
-        server.send(303);
+        redirectToDashboard(request);
     });
 
     // ...existing server endpoints...
 
-    // Start the server
+    // Most recent recordings from the recorder index, newest first: ?n=<count>
+    server.on("/api/recordings", HTTP_GET, [](AsyncWebServerRequest* request) {
+        uint32_t count = 10;
+        if (request->hasParam("n")) count = constrain(request->getParam("n")->value().toInt(), 1, REC_INDEX_SLOTS);
+        AsyncResponseStream* response = request->beginResponseStream("application/json");
+        response->print("[");
+        RecIndexEntry entry;
+        for (uint32_t i = 0; i < count && recorder.recent(i, entry); i++) {
+            char buf[192];
+            JsonBuffer json(buf, sizeof(buf));
+            json.beginObject();
+            json.add("seq", (unsigned long)entry.seq);
+            json.add("talker", entry.talker);
+            json.add("startMs", (unsigned long)entry.startMs);
+            json.add("durationMs", (unsigned long)entry.durationMs);
+            json.add("packets", (unsigned)entry.packets);
+            json.add("segment", (unsigned)entry.segment);
+            json.add("offset", (unsigned long)entry.offset);
+            json.add("bytes", (unsigned long)entry.length);
+            json.endObject();
+            if (i) response->print(",");
+            response->print(json.c_str());
+        }
+        response->print("]");
+        request->send(response);
+    });
+
+    // Prometheus scrape endpoint
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest* request) {
+        AsyncResponseStream* response = request->beginResponseStream("text/plain; version=0.0.4");
+        writePrometheusMetrics(*response);
+        request->send(response);
+    });
+
+#if ZELLO_TRACE
+    // Hot-path timeline as Chrome trace_event JSON (chrome://tracing, ui.perfetto.dev)
+    server.on("/debug/trace", HTTP_GET, [](AsyncWebServerRequest* request) {
+        std::shared_ptr<TraceDump> dump = snapshotTrace();
+        if (!dump) {
+            request->send(500, "text/plain", "Out of memory for trace snapshot");
+            return;
+        }
+        AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+            [dump](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                return writeTraceChunk(*dump, buffer, maxLen);
+            });
+        response->addHeader("Content-Disposition", "attachment; filename=zello_trace.json");
+        request->send(response);
+    });
+#endif
+
+    // Live telemetry push (Server-Sent Events on /events)
+    startTelemetry();
+
+    // Start the server; requests are handled in the AsyncTCP task (core 0, low priority)
     server.begin();
     Serial.println("HTTP server started");
 }
 
 // --- PTT/Zello transmission control ---
 
-void audioTxTask(void* parameter) {
-    // Prevent starting if playback is active
-    if (playbackActive) {
-        Serial.println("ERROR: Cannot start TX while playback is active. Stop playback first.");
-        vTaskDelete(nullptr);
-        return;
+// TX task: encodes one frame and hands it to loop() for sending
+static void sendTxFrame(OpusEncoder* opusEnc, const int16_t* pcm, int samples) {
+    TxMessage msg;
+    msg.kind = TxMessage::Frame;
+    uint32_t encodeStart = micros();
+    TRACE_BEGIN(TRACE_ENCODE);
+    int opusLen = opus_encode(opusEnc, pcm, samples, msg.opus, sizeof(msg.opus));
+    TRACE_END(TRACE_ENCODE);
+    encodeMetric.observe(micros() - encodeStart);
+    if (opusLen <= 0) return;
+    msg.len = (uint16_t)opusLen;
+    if (!txMessages.post(msg)) {
+        txDroppedMetric.inc();
+    }
+}
+
+// loop(), before client.poll(): sends what the TX task queued, in order. Frames
+// and the stop wait in the queue until the start_stream reply has named the
+// stream; frames queued while offline, or for a stream the server refused or
+// never confirmed, are dropped and counted.
+void sendTxMessages() {
+    if (!wsConnected) txState = TxState::Idle;   // the over ends with the connection
+    if (txState == TxState::Starting && millis() - txStartMs > TX_START_TIMEOUT_MS) {
+        Serial.println("No reply to start_stream, dropping the transmission");
+        txState = TxState::Refused;
     }
+    TxMessage msg;
+    while (txMessages.peek(msg)) {
+        if (msg.kind != TxMessage::Start && txState == TxState::Starting) return;
+        txMessages.receive(msg);
+        if (!wsConnected) {
+            if (msg.kind == TxMessage::Frame) txDroppedMetric.inc();
+            continue;
+        }
+        if (msg.kind == TxMessage::Start) {
+            char cmd[256];
+            zelloStartStream(cmd, sizeof(cmd), ++txSeq, zelloChannel.c_str());
+            client.send(cmd);
+            txStartSeq = txSeq;
+            txStartMs = millis();
+            txStreamId = 0;
+            txPacketId = 0;
+            txState = TxState::Starting;
+            Serial.println("Sent start_stream command to Zello");
+        } else if (msg.kind == TxMessage::Stop) {
+            if (txState == TxState::Streaming) {
+                char cmd[96];
+                zelloStopStream(cmd, sizeof(cmd), ++txSeq, txStreamId);
+                client.send(cmd);
+                Serial.println("Sent stop_stream command to Zello");
+            }
+            txState = TxState::Idle;
+        } else if (txState != TxState::Streaming) {
+            txDroppedMetric.inc();
+        } else {
+            uint8_t zelloPacket[ZELLO_PACKET_HEADER + sizeof(msg.opus)];
+            size_t len = zelloFramePacket(zelloPacket, txStreamId, txPacketId++, msg.opus, msg.len);
+            uint32_t sendStart = micros();
+            TRACE_SCOPE(TRACE_SEND);
+            client.sendBinary((const char*)zelloPacket, len);
+            wsSendMetric.observe(micros() - sendStart);
+        }
+    }
+}
 
+// loop(), from onMessageCallback: the reply to the pending start_stream
+void txStartReply(const String& msg) {
+    uint32_t streamId = 0;
+    if (zelloStartReply(msg.c_str(), streamId)) {
+        txStreamId = streamId;
+        txState = TxState::Streaming;
+        Serial.printf("Transmitting as stream %u\n", (unsigned)streamId);
+    } else {
+        txState = TxState::Refused;
+        char error[64];
+        zelloJsonString(msg.c_str(), "error", error, sizeof(error));
+        Serial.printf("start_stream refused: %s\n", error);
+    }
+}
+
+// Lives for the whole run, above loop() on core 1. The PTT interrupt notifies it
+// directly, so a press opens the microphone and starts encoding without waiting
+// for loop() to come round; the encoder is created once and reset per over.
+void audioTxTask(void* parameter) {
     // Configure input (microphone) stream
     audio_tools::AudioBoardStream mic(audio_driver::AudioKitAC101);
     auto cfg = mic.defaultConfig(RX_MODE);
     cfg.sample_rate = 16000; // Zello default is 16kHz mono
     cfg.channels = 1;
     cfg.bits_per_sample = 16;
-    mic.begin(cfg);
 
     // OPUS encoder setup using libopus
     int opusErr = 0;
     OpusEncoder* opusEnc = opus_encoder_create(16000, 1, OPUS_APPLICATION_VOIP, &opusErr);
     if (!opusEnc || opusErr != OPUS_OK) {
         Serial.printf("Failed to create Opus encoder: %d\n", opusErr);
-        mic.end();
         vTaskDelete(nullptr);
         return;
     }
@@ -1546,77 +3111,166 @@ void audioTxTask(void* parameter) {
 
     const int chunkSamples = 320; // 20ms at 16kHz
     int16_t pcmBuffer[chunkSamples];
-    uint8_t opusBuffer[512];
-
-    // Watchdog timer workaround: periodically yield to keep system alive
-    unsigned long lastYield = millis();
-
-    while (txActive) {
-        // --- Feed the watchdog at the start of each loop iteration ---
-        vTaskDelay(1);
-        // ...existing code...
-        int bytesRead = mic.readBytes((uint8_t*)pcmBuffer, chunkSamples * sizeof(int16_t));
-        int samplesRead = bytesRead / sizeof(int16_t);
-        if (samplesRead > 0 && strlen(currentStreamId) > 0) {
-            int opusLen = opus_encode(opusEnc, pcmBuffer, samplesRead, opusBuffer, sizeof(opusBuffer));
-            if (opusLen > 0) {
-                uint8_t zelloPacket[521];
-                zelloPacket[0] = 0x00; // TX packet type
-                memset(zelloPacket + 1, 0, 8);
-                memcpy(zelloPacket + 1, currentStreamId, strlen(currentStreamId));
-                memcpy(zelloPacket + 9, opusBuffer, opusLen);
-                client.sendBinary((const char*)zelloPacket, opusLen + 9);
+    ToneGenerator roger;
+    roger.begin(ROGER_LEVEL_Q15);
+    // Full duplex: both I2S channels come in, and what the speaker played meanwhile.
+    // Static, the task stack has no room for them next to opus_encode().
+    static int16_t duplexBuffer[chunkSamples * 2];
+    static int16_t echoBuffer[chunkSamples];
+
+    for (;;) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        if (!(bits & INPUT_NOTIFY_PRESS) || !inputs.pressed(pttInput)) continue;
+        uint32_t pressUs = inputs.changedAtUs(pttInput);
+        Serial.println("PTT button pressed - Starting transmission");
+        if (!startTransmission()) continue;
+        if (fullDuplex) {
+            cues.play(Cue::TalkPermit);
+        } else {
+            mic.begin(cfg);
+        }
+        opus_encoder_ctl(opusEnc, OPUS_RESET_STATE);
+        noiseSuppressor.reset();
+        echoCanceller.reset();
+        bool first = true;
+        bool ns = noiseSuppress;       // switched per over: mid-over the 20 ms delay would jump
+        int nsOverBudget = 0;
+        // Capture clock for the echo reference: when the first sample read this over
+        // was recorded. Samples that waited in DMA are read long after they were
+        // recorded and would put it late, so it takes the earliest any read implies.
+        uint32_t captureStartUs = 0;
+        uint32_t samplesCaptured = 0;
+        int echoIdleFrames = EC_PARTITIONS + 1;
+
+        while (inputs.pressed(pttInput)) {
+            // --- Feed the watchdog at the start of each loop iteration ---
+            vTaskDelay(1);
+            int samplesRead;
+            if (fullDuplex) {
+                // Left channel: the AC101's mic
+                samplesRead = out.readBytes((uint8_t*)duplexBuffer, sizeof(duplexBuffer)) / (2 * sizeof(int16_t));
+                for (int i = 0; i < samplesRead; i++) pcmBuffer[i] = duplexBuffer[i * 2];
+            } else {
+                int bytesRead = mic.readBytes((uint8_t*)pcmBuffer, chunkSamples * sizeof(int16_t));
+                samplesRead = bytesRead / sizeof(int16_t);
+            }
+            if (samplesRead <= 0) continue;
+            if (first) {
+                pttLatencyMetric.observe((uint32_t)esp_timer_get_time() - pressUs);
+                first = false;
+            }
+            if (fullDuplex) {
+                uint32_t frameStartUs = (uint32_t)((uint64_t)samplesCaptured * 1000000 / PLAYBACK_SAMPLE_RATE);
+                samplesCaptured += samplesRead;
+                uint32_t impliedUs = micros() - (uint32_t)((uint64_t)samplesCaptured * 1000000 / PLAYBACK_SAMPLE_RATE);
+                if (samplesCaptured == (uint32_t)samplesRead || (int32_t)(impliedUs - captureStartUs) < 0) {
+                    captureStartUs = impliedUs;
+                }
+                if (samplesRead == chunkSamples) {
+                    uint32_t refUs = captureStartUs + frameStartUs - AEC_REF_LEAD_US;
+                    echoIdleFrames = echoReference.read(refUs, echoBuffer, chunkSamples) ? 0 : echoIdleFrames + 1;
+                    // Until the filter's span has seen silence too, the echo is still arriving
+                    if (echoIdleFrames <= EC_PARTITIONS) {
+                        uint32_t aecStart = micros();
+                        echoCanceller.process(pcmBuffer, echoBuffer);
+                        txAecMetric.observe(micros() - aecStart);
+                    }
+                }
             }
+            if (ns && samplesRead == chunkSamples) {
+                uint32_t nsStart = micros();
+                noiseSuppressor.process(pcmBuffer);
+                uint32_t nsUs = micros() - nsStart;
+                txNsMetric.observe(nsUs);
+                nsOverBudget = nsUs > NS_BUDGET_US ? nsOverBudget + 1 : 0;
+                if (nsOverBudget == NS_OVER_BUDGET_FRAMES) {
+                    ns = false;
+                    txNsBypassMetric.inc();
+                    ZLOGW("Noise suppression over its %d us budget, off for this over", NS_BUDGET_US);
+                }
+            }
+            sendTxFrame(opusEnc, pcmBuffer, samplesRead);
         }
-        // ...existing code...
-    }
 
-    opus_encoder_destroy(opusEnc);
-    mic.end();
-    vTaskDelete(nullptr);
+        if (rogerBeep) {
+            // Sent as if from the mic, a frame per 20 ms, before the stream closes
+            roger.play(Cue::Roger);
+            while (roger.active()) {
+                memset(pcmBuffer, 0, sizeof(pcmBuffer));
+                roger.render(pcmBuffer, chunkSamples, 16000);
+                sendTxFrame(opusEnc, pcmBuffer, chunkSamples);
+                vTaskDelay(pdMS_TO_TICKS(20));
+            }
+        }
+        if (fullDuplex) {
+            txAecErleMetric.set((int32_t)echoCanceller.erleDb());
+        } else {
+            mic.end();
+        }
+        Serial.println("PTT button released - Stopping transmission");
+        stopTransmission();
+    }
 }
 
-void startTransmission() {
-    if (client.available()) {
-        // Stop playback before starting TX
-        if (playbackActive) {
-            out.end();
+// TX task: takes I2S from playback and opens the stream; false when offline
+bool startTransmission() {
+    if (!wsConnected) {
+        Serial.println("WebSocket not connected, cannot start transmission");
+        cues.play(Cue::Error);
+        return false;
+    }
+    if (!fullDuplex) {
+        // Stop playback before starting TX; cues would only play late, after it.
+        // Once playbackActive is off the playback task leaves I2S alone, so the
+        // flush and the amplifier switch-off run without the lock.
+        bool wasOutput, wasPlayback;
+        {
+            AudioDeviceLock lock;
+            cues.stop();
+            wasOutput = outputActive;
+            wasPlayback = playbackActive;
             playbackActive = false;
-            Serial.println("Playback stopped to allow TX (recording) to start.");
         }
-        String startMsg = "{\"command\":\"start_stream\",\"channel\":\"" + zelloChannel + "\"}";
-        client.send(startMsg);
-        Serial.println("Sent start_stream command to Zello");
-
-        // Start TX task if not already running
-        if (!txActive) {
-            txActive = true;
-            xTaskCreatePinnedToCore(audioTxTask, "audioTxTask", 4096, nullptr, 1, &txTaskHandle, 1);
+        if (wasOutput) {
+            writeSilence(outputAheadMs() * 2);
+            endPlayback();
+        }
+        if (wasPlayback) {
+            out.end();
+            Serial.println("Playback stopped to allow TX (recording) to start.");
         }
-    } else {
-        Serial.println("WebSocket not connected, cannot start transmission");
     }
+    TxMessage msg;
+    msg.kind = TxMessage::Start;
+    if (!txMessages.post(msg, pdMS_TO_TICKS(100))) {
+        Serial.println("TX queue full, cannot start transmission");
+        cues.play(Cue::Error);
+        return false;
+    }
+    txActive = true;
+    return true;
 }
 
+// TX task, microphone closed: ends the stream and hands I2S back to playback
 void stopTransmission() {
-    if (client.available()) {
-        String stopMsg = "{\"command\":\"stop_stream\",\"channel\":\"" + zelloChannel + "\"}";
-        client.send(stopMsg);
-        Serial.println("Sent stop_stream command to Zello");
-    } else {
+    // Behind the over's last frames; waits out a busy loop() rather than leave the stream open
+    TxMessage msg;
+    msg.kind = TxMessage::Stop;
+    if (!wsConnected) {
         Serial.println("WebSocket not connected, cannot stop transmission");
+    } else if (!txMessages.post(msg, pdMS_TO_TICKS(500))) {
+        Serial.println("TX queue full, stop_stream not sent");
     }
-    // Stop TX task
     txActive = false;
-    // Optionally wait for task to finish
-    vTaskDelay(50 / portTICK_PERIOD_MS);
 
-    // Optionally, re-enable playback after TX
+    AudioDeviceLock lock;
     if (!playbackActive) {
         auto cfg = out.defaultConfig(TX_MODE);
-        cfg.sample_rate = 48000;
+        cfg.sample_rate = PLAYBACK_SAMPLE_RATE;
         cfg.channels = 2;
         cfg.bits_per_sample = 16;
+        applyDmaBuffers(cfg);
         if (out.begin(cfg)) {
             playbackActive = true;
             Serial.println("Playback re-enabled after TX.");
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Convert recorded Zello capsules to playable .opus files.
+
+Reads a segment file downloaded from the device's SPIFFS (/rec0.zcap .. /rec3.zcap,
+see include/stream_recorder.h) and writes every capsule in it as an Ogg Opus file:
+
+    python3 tools/capsule_to_ogg.py rec0.zcap [out_dir]
+"""
+
+import os
+import struct
+import sys
+
+HEADER = struct.Struct("<4sBBHII32s12s8s")
+FOOTER = struct.Struct("<II")
+END_MARK = 0xFFFF
+
+
+def _crc_table():
+    table = []
+    for i in range(256):
+        r = i << 24
+        for _ in range(8):
+            r = ((r << 1) ^ 0x04C11DB7) if r & 0x80000000 else (r << 1)
+        table.append(r & 0xFFFFFFFF)
+    return table
+
+
+CRC_TABLE = _crc_table()
+
+
+def ogg_crc(data):
+    crc = 0
+    for b in data:
+        crc = ((crc << 8) & 0xFFFFFFFF) ^ CRC_TABLE[((crc >> 24) ^ b) & 0xFF]
+    return crc
+
+
+def ogg_page(serial, seq, granule, flags, packets):
+    lacing = bytearray()
+    for p in packets:
+        lacing += b"\xff" * (len(p) // 255) + bytes([len(p) % 255])
+    header = struct.pack("<4sBBqIIIB", b"OggS", 0, flags, granule, serial, seq, 0, len(lacing)) + lacing
+    page = bytearray(header + b"".join(packets))
+    struct.pack_into("<I", page, 22, ogg_crc(page))
+    return bytes(page)
+
+
+def packet_samples(p):
+    """48 kHz samples in one Opus packet (RFC 6716 3.1)."""
+    config = p[0] >> 3
+    if config < 12:
+        frame = (480, 960, 1920, 2880)[config & 3]
+    elif config < 16:
+        frame = 960 if config & 1 else 480
+    else:
+        frame = (120, 240, 480, 960)[config & 3]
+    code = p[0] & 3
+    frames = 1 if code == 0 else 2 if code < 3 else (p[1] & 0x3F if len(p) > 1 else 0)
+    return frames * frame
+
+
+def capsule_to_ogg(header, packets):
+    sample_rate = struct.unpack("<H", header[8][:2])[0] if header[2] >= 2 else 16000
+    serial = header[4] or 1
+    head = b"OpusHead" + struct.pack("<BBHIhB", 1, 1, 0, sample_rate, 0, 0)
+    vendor = b"ESP32-Zello-Client"
+    tags = b"OpusTags" + struct.pack("<I", len(vendor)) + vendor + struct.pack("<I", 0)
+    pages = [ogg_page(serial, 0, 0, 0x02, [head]), ogg_page(serial, 1, 0, 0, [tags])]
+    granule = 0
+    # One packet per page keeps lacing simple; Zello packets are well under 64 KB
+    for i, p in enumerate(packets):
+        granule += packet_samples(p)
+        flags = 0x04 if i == len(packets) - 1 else 0
+        pages.append(ogg_page(serial, len(pages), granule, flags, [p]))
+    return b"".join(pages)
+
+
+def read_capsules(data):
+    pos = 0
+    while pos + HEADER.size <= len(data):
+        header = HEADER.unpack_from(data, pos)
+        if header[0] != b"ZCAP":
+            raise ValueError("no capsule at offset %d" % pos)
+        start = pos
+        pos += HEADER.size
+        packets = []
+        while pos + 2 <= len(data):
+            (length,) = struct.unpack_from("<H", data, pos)
+            if length == END_MARK:
+                pos += 2 + FOOTER.size
+                break
+            packets.append(data[pos + 4:pos + 4 + length])
+            pos += 4 + length
+        yield start, header, packets
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    out_dir = sys.argv[2] if len(sys.argv) > 2 else "."
+    data = open(sys.argv[1], "rb").read()
+    for offset, header, packets in read_capsules(data):
+        talker = header[6].split(b"\0")[0].decode("utf-8", "replace")
+        name = os.path.join(out_dir, "capsule_%u.opus" % header[4])
+        with open(name, "wb") as f:
+            f.write(capsule_to_ogg(header, packets))
+        print("%s: seq %u, talker %s, %d packets (offset %d)" % (name, header[4], talker, len(packets), offset))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,624 @@
+/*
+ * Decoder Pool Check
+ *
+ * Host-side check of include/channel_mixer.h against libopus. Encodes a few
+ * synthetic talkers (or reads streams captured by the recorder), interleaves
+ * their packets through the decoder pool in shuffled order and checks that:
+ *   - with the Mix policy (and the AGC off) the output is the sum of each
+ *     stream decoded alone, so no packet reached another stream's decoder;
+ *   - talkers held in include/message_queue.h while another one talks play
+ *     in full and in order once the floor is free, also across ring wraps;
+ *   - catch-up cuts long pauses in queued messages down to ~300 ms;
+ *   - the AGC brings quiet and loud talkers to about the same level, the
+ *     limiter keeps every sample under its ceiling, also at replay speed,
+ *     and a talker's second transmission starts at the level the first one
+ *     ended on;
+ *   - a stream that runs dry is concealed, then bridged with quiet comfort
+ *     noise, instead of cut to silence;
+ *   - a backlog left by a stall plays down faster at the same pitch;
+ *   - a full pool evicts the least recently used, lowest-priority stream;
+ *   - the hashed lookup agrees with a reference set under heavy collisions.
+ *
+ *   g++ -std=c++11 -Iinclude tools/decoder_pool_check.cpp $(pkg-config --cflags --libs opus) -o decoder_pool_check
+ *   ./decoder_pool_check [rec0.zcap ...]
+ *
+ * Capsule files (downloaded /recN.zcap segments) replace the synthetic talkers;
+ * every capsule in them becomes one stream.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <set>
+#include <vector>
+#define QUEUE_BYTES (32 * 1024)   // small enough that the checks wrap the ring
+#include "channel_mixer.h"
+#include "message_queue.h"
+
+static uint32_t nowMs = 0;
+uint32_t millis() { return nowMs; }
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                          \
+    do {                                          \
+        if (!(cond)) {                            \
+            printf("FAIL line %d: ", __LINE__);   \
+            printf(__VA_ARGS__);                  \
+            printf("\n");                         \
+            failures++;                           \
+        }                                         \
+    } while (0)
+
+typedef std::vector<uint8_t> Packet;
+
+struct TestStream {
+    std::vector<Packet> packets;
+    std::vector<int> samples;     // decoded length of each packet
+    std::vector<int16_t> pcm;     // the stream decoded on its own
+};
+
+static uint32_t rng = 1;
+static uint32_t nextRandom() {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// A talker: a gliding tone with a syllable-rate envelope, 20 ms packets
+static TestStream synthesize(int index, int frames, double amplitude = 5000) {
+    TestStream t;
+    int err;
+    OpusEncoder* enc = opus_encoder_create(PLAYBACK_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(16000));
+    double phase = 0;
+    for (int f = 0; f < frames; f++) {
+        int16_t frame[320];
+        for (int i = 0; i < 320; i++) {
+            double tSec = (f * 320 + i) / (double)PLAYBACK_SAMPLE_RATE;
+            double freq = 180 + 90 * index + 40 * sin(tSec * 3);
+            phase += 2 * M_PI * freq / PLAYBACK_SAMPLE_RATE;
+            double env = 0.5 + 0.5 * sin(tSec * 2 * M_PI * (3 + index));
+            frame[i] = (int16_t)(amplitude * env * sin(phase));
+        }
+        uint8_t out[MIX_MAX_PACKET_BYTES];
+        int len = opus_encode(enc, frame, 320, out, sizeof(out));
+        t.packets.push_back(Packet(out, out + len));
+    }
+    opus_encoder_destroy(enc);
+    return t;
+}
+
+// Every capsule in a recorder segment file (layout in include/stream_recorder.h)
+static void readCapsules(const char* path, std::vector<TestStream>& streams) {
+    const size_t headerLen = 68, footerLen = 8;
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        printf("cannot open %s\n", path);
+        exit(1);
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    fclose(f);
+    size_t pos = 0;
+    while (pos + headerLen <= data.size() && memcmp(&data[pos], "ZCAP", 4) == 0) {
+        TestStream t;
+        pos += headerLen;
+        while (pos + 2 <= data.size()) {
+            size_t len = data[pos] | (data[pos + 1] << 8);
+            if (len == 0xFFFF) {
+                pos += 2 + footerLen;
+                break;
+            }
+            if (pos + 4 + len > data.size()) break;
+            t.packets.push_back(Packet(&data[pos + 4], &data[pos + 4] + len));
+            pos += 4 + len;
+        }
+        if (!t.packets.empty()) streams.push_back(t);
+    }
+}
+
+// Reference: each stream through its own decoder, the way a single-stream client plays it
+static void decodeAlone(TestStream& t) {
+    int err;
+    OpusDecoder* dec = opus_decoder_create(PLAYBACK_SAMPLE_RATE, 1, &err);
+    int16_t pcm[MIX_MAX_PACKET_SAMPLES];
+    t.samples.clear();
+    t.pcm.clear();
+    for (size_t i = 0; i < t.packets.size(); i++) {
+        int n = opus_decode(dec, t.packets[i].data(), t.packets[i].size(), pcm, MIX_MAX_PACKET_SAMPLES, 0);
+        if (n < 0) n = 0;
+        t.samples.push_back(n);
+        t.pcm.insert(t.pcm.end(), pcm, pcm + n);
+    }
+    opus_decoder_destroy(dec);
+}
+
+// Start of the block a stream of this length ends in, which fades out
+static size_t lastBlock(size_t samples) {
+    return samples ? (samples - 1) / MIX_BLOCK_SAMPLES * MIX_BLOCK_SAMPLES : 0;
+}
+
+// Mix policy: streams fed in shuffled order, 40 ms ahead of the output, must mix
+// to the sum of their solo decodes (within Q15 rounding)
+static void checkMix(std::vector<TestStream>& streams) {
+    static ChannelMixer mixer;
+    CHECK(mixer.begin() == MIX_MAX_STREAMS, "begin");
+    mixer.setAgc(false);
+    mixer.setDriftCompensation(false);   // sample-exact comparisons; tools/drift_check.cpp covers it
+    size_t count = std::min(streams.size(), (size_t)MIX_MAX_STREAMS);
+    size_t longest = 0;
+    std::vector<size_t> next(count, 0), fed(count, 0);
+    std::vector<uint32_t> keys(count);
+    for (size_t s = 0; s < count; s++) {
+        keys[s] = 0x10000 + (uint32_t)s * 16;   // ids a few apart, like consecutive Zello streams
+        CHECK(mixer.open(keys[s], 1, "talker"), "open %zu", s);
+        longest = std::max(longest, streams[s].pcm.size());
+    }
+
+    std::vector<int16_t> out;
+    std::vector<size_t> order(count);
+    for (size_t s = 0; s < count; s++) order[s] = s;
+    while (out.size() < longest) {
+        std::random_shuffle(order.begin(), order.end(), [](int n) { return (int)(nextRandom() % n); });
+        for (size_t o = 0; o < count; o++) {
+            size_t s = order[o];
+            TestStream& t = streams[s];
+            while (next[s] < t.packets.size() && fed[s] < out.size() + MIX_PREBUFFER_SAMPLES) {
+                MixStream* m = mixer.find(keys[s]);
+                CHECK(m, "stream %zu lost its slot", s);
+                if (!m) return;
+                int n = mixer.decode(m, t.packets[next[s]].data(), t.packets[next[s]].size());
+                CHECK(n == t.samples[next[s]], "stream %zu packet %zu: %d samples, alone %d", s, next[s], n,
+                      t.samples[next[s]]);
+                fed[s] += t.samples[next[s]++];
+                if (next[s] == t.packets.size()) mixer.close(keys[s]);
+            }
+        }
+        int16_t block[MIX_BLOCK_SAMPLES];
+        CHECK(mixer.mix(block, MIX_BLOCK_SAMPLES) == 0, "underrun at sample %zu", out.size());
+        out.insert(out.end(), block, block + MIX_BLOCK_SAMPLES);
+    }
+
+    int worst = 0;
+    for (size_t i = MIX_BLOCK_SAMPLES; i < longest; i++) {   // the first block ramps up from silence
+        int expected = 0;
+        bool fading = false;
+        for (size_t s = 0; s < count; s++) {
+            if (i < streams[s].pcm.size()) expected += streams[s].pcm[i];
+            fading |= i >= lastBlock(streams[s].pcm.size()) && i < streams[s].pcm.size();
+        }
+        if (fading) continue;   // a stream's last block fades out
+        expected = std::max(-32768, std::min(32767, expected));
+        worst = std::max(worst, abs(expected - out[i]));
+    }
+    CHECK(worst <= 2 * (int)count, "mixed output differs from the solo decodes by %d", worst);
+    CHECK(mixer.activeCount() == 0, "%u streams still active after playing out", mixer.activeCount());
+    printf("mix: %zu interleaved streams, %zu samples, max error %d\n", count, longest, worst);
+}
+
+// Plays queued messages the way serviceMessageQueue() in main.cpp does: one at a
+// time once the floor is free, 100 ms decoded ahead
+struct QueuePlayer {
+    ChannelMixer& mixer;
+    MessageQueue& queue;
+    QueuedMessage* playing;
+
+    QueuePlayer(ChannelMixer& m, MessageQueue& q) : mixer(m), queue(q), playing(nullptr) {}
+
+    void service() {
+        if (!playing) {
+            QueuedMessage* next = queue.front();
+            if (!next || mixer.busy(next->priority)) return;
+            if (!mixer.find(next->key) && !mixer.open(next->key, next->priority, next->talker)) return;
+            mixer.setPaused(next->key, false);
+            mixer.setFedAhead(next->key);
+            playing = next;
+        }
+        MixStream* stream = mixer.find(playing->key);
+        uint8_t packet[MIX_MAX_PACKET_BYTES];
+        while (mixer.queuedMs(playing->key) < 100) {
+            size_t len = queue.read(playing, packet, sizeof(packet));
+            if (!len) break;
+            mixer.decode(stream, packet, len);
+        }
+        if (playing->complete && playing->unread == 0) {
+            mixer.close(playing->key);
+            queue.remove(playing);
+            playing = nullptr;
+        }
+    }
+};
+
+static bool matches(const std::vector<int16_t>& out, size_t at, const std::vector<int16_t>& ref, int& worst) {
+    if (out.size() < at + ref.size()) return false;
+    for (size_t i = MIX_BLOCK_SAMPLES; i < lastBlock(ref.size()); i++) {   // skip the fade-in and fade-out blocks
+        worst = std::max(worst, abs(ref[i] - out[at + i]));
+    }
+    return true;
+}
+
+// B and C start while A talks: their packets go to the message queue, interleaved,
+// and they play complete and in order once A is done. Several rounds wrap the ring.
+static void checkMessageQueue(std::vector<TestStream>& streams) {
+    static ChannelMixer mixer;
+    static MessageQueue queue;
+    mixer.begin();
+    mixer.setAgc(false);
+    mixer.setDriftCompensation(false);
+    CHECK(queue.begin(), "queue begin");
+    QueuePlayer player(mixer, queue);
+    TestStream& a = streams[0];
+    TestStream& b = streams[1];
+    TestStream& c = streams[streams.size() > 2 ? 2 : 1];
+
+    for (int round = 0; round < 3; round++) {
+        uint32_t base = 100 * (round + 1);
+        MixStream* ma = mixer.open(base, 1, "A");
+        nowMs += 1;
+        QueuedMessage* qb = queue.hold(base + 1, 1, "B", nowMs);
+        CHECK(ma && qb, "round %d: open A, queue B", round);
+        QueuedMessage* qc = nullptr;
+        std::vector<int16_t> out;
+        size_t nextA = 0, nextB = 0, nextC = 0, fedA = 0;
+        for (int guard = 0; guard < 100000 && (mixer.activeCount() || queue.count() || out.empty()); guard++) {
+            nowMs += 10;
+            while (nextA < a.packets.size() && fedA < out.size() + MIX_PREBUFFER_SAMPLES) {
+                mixer.decode(ma, a.packets[nextA].data(), a.packets[nextA].size());
+                fedA += a.samples[nextA++];
+                if (nextA == a.packets.size()) mixer.close(base);
+            }
+            if (guard == 20) qc = queue.hold(base + 2, 1, "C", nowMs);
+            if (nextB < b.packets.size()) {   // the talkers keep going while they wait
+                CHECK(queue.packet(qb, b.packets[nextB].data(), b.packets[nextB].size()), "B packet %zu", nextB);
+                if (++nextB == b.packets.size()) qb->complete = true;
+            }
+            if (qc && nextC < c.packets.size()) {
+                CHECK(queue.packet(qc, c.packets[nextC].data(), c.packets[nextC].size()), "C packet %zu", nextC);
+                if (++nextC == c.packets.size()) qc->complete = true;
+            }
+            player.service();
+            if (mixer.hasOutput()) {
+                int16_t block[MIX_BLOCK_SAMPLES];
+                mixer.mix(block, MIX_BLOCK_SAMPLES);
+                out.insert(out.end(), block, block + MIX_BLOCK_SAMPLES);
+            }
+        }
+        int worst = 0;
+        size_t bStart = (a.pcm.size() + MIX_BLOCK_SAMPLES - 1) / MIX_BLOCK_SAMPLES * MIX_BLOCK_SAMPLES;
+        size_t cStart = bStart + (b.pcm.size() + MIX_BLOCK_SAMPLES - 1) / MIX_BLOCK_SAMPLES * MIX_BLOCK_SAMPLES;
+        CHECK(matches(out, 0, a.pcm, worst) && matches(out, bStart, b.pcm, worst) && matches(out, cStart, c.pcm, worst),
+              "round %d: output %zu samples, expected %zu", round, out.size(), cStart + c.pcm.size());
+        CHECK(worst <= 2, "round %d: queued playback differs from the solo decodes by %d", round, worst);
+        CHECK(queue.count() == 0 && queue.bytes() == 0, "round %d: queue not drained", round);
+        if (round == 2) printf("queue: A, then B and C from the queue in order, 3 rounds, max error %d\n", worst);
+    }
+}
+
+// Catch-up: a queued message with a one-second pause plays with the pause cut to ~300 ms
+static void checkCatchUp() {
+    static ChannelMixer mixer;
+    mixer.begin();
+    mixer.setDriftCompensation(false);
+    TestStream t = synthesize(0, 150);
+    int err;
+    OpusEncoder* enc = opus_encoder_create(PLAYBACK_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+    int16_t silence[320] = {0};
+    for (int f = 50; f < 100; f++) {   // frames 50..99 become a pause
+        uint8_t out[MIX_MAX_PACKET_BYTES];
+        int len = opus_encode(enc, silence, 320, out, sizeof(out));
+        t.packets[f] = Packet(out, out + len);
+    }
+    opus_encoder_destroy(enc);
+    decodeAlone(t);
+
+    MixStream* s = mixer.open(1, 1, "x");
+    s->catchUp = true;
+    size_t played = 0;
+    for (size_t p = 0; p < t.packets.size(); p++) {
+        mixer.decode(s, t.packets[p].data(), t.packets[p].size());
+        int16_t block[MIX_BLOCK_SAMPLES];
+        while (s->primed && s->used >= MIX_BLOCK_SAMPLES) {
+            mixer.mix(block, MIX_BLOCK_SAMPLES);
+            played += MIX_BLOCK_SAMPLES;
+        }
+    }
+    played += s->used;
+    size_t cutMs = (t.pcm.size() - played) * 1000 / PLAYBACK_SAMPLE_RATE;
+    CHECK(cutMs >= 600 && cutMs <= 720, "catch-up cut %zu ms of a 1000 ms pause, expected ~700", cutMs);
+    CHECK(s->skipped * 1000 / PLAYBACK_SAMPLE_RATE == cutMs, "skipped counter %u samples", s->skipped);
+    printf("catch-up: cut %zu ms of a 1000 ms pause\n", cutMs);
+}
+
+// Full pool: the least recently used stream of the lowest priority gives up its slot
+// One stream through the mixer with the AGC on, fed 40 ms ahead; returns the output
+// speed above 100 plays it as a replay does: decoded ahead, sped up by the stretch
+static std::vector<int16_t> playAlone(ChannelMixer& mixer, const TestStream& t, uint32_t key, const char* talker,
+                                      uint16_t speed = 100) {
+    std::vector<int16_t> out;
+    MixStream* s = mixer.open(key, 1, talker);
+    if (s && speed > 100) {
+        mixer.setSpeed(key, speed);
+        mixer.setFedAhead(key);
+    }
+    size_t next = 0, fed = 0;
+    while (s && (next < t.packets.size() || mixer.hasOutput())) {
+        while (next < t.packets.size() &&
+               (speed > 100 ? s->used < MIX_PREBUFFER_SAMPLES + STRETCH_MAX_INPUT
+                            : fed < out.size() + MIX_PREBUFFER_SAMPLES)) {
+            fed += mixer.decode(s, t.packets[next].data(), t.packets[next].size());
+            if (++next == t.packets.size()) mixer.close(key);
+        }
+        int16_t block[MIX_BLOCK_SAMPLES];
+        mixer.mix(block, MIX_BLOCK_SAMPLES);
+        out.insert(out.end(), block, block + MIX_BLOCK_SAMPLES);
+    }
+    return out;
+}
+
+static double rmsOf(const std::vector<int16_t>& pcm, size_t from, size_t to) {
+    double sum = 0;
+    to = std::min(to, pcm.size());
+    for (size_t i = from; i < to; i++) sum += (double)pcm[i] * pcm[i];
+    return to > from ? sqrt(sum / (to - from)) : 0;
+}
+
+static double dB(double ratio) { return 20 * log10(ratio); }
+
+// A quiet tone with a 2 ms full-scale click every 87 ms, so the clicks fall at
+// every offset from the mix blocks; coded at a rate that keeps them sharp
+static TestStream clicks(int frames, double amplitude) {
+    TestStream t;
+    int err;
+    OpusEncoder* enc = opus_encoder_create(PLAYBACK_SAMPLE_RATE, 1, OPUS_APPLICATION_AUDIO, &err);
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(64000));
+    for (int f = 0; f < frames; f++) {
+        int16_t frame[320];
+        for (int i = 0; i < 320; i++) {
+            int at = f * 320 + i;
+            double v = amplitude * sin(2 * M_PI * 220 * at / PLAYBACK_SAMPLE_RATE);
+            if (at % 1392 < 32) v = (at % 1392) < 16 ? 32000 : -32000;
+            frame[i] = (int16_t)v;
+        }
+        uint8_t out[MIX_MAX_PACKET_BYTES];
+        int len = opus_encode(enc, frame, 320, out, sizeof(out));
+        t.packets.push_back(Packet(out, out + len));
+    }
+    opus_encoder_destroy(enc);
+    return t;
+}
+
+// Talkers 20 dB apart come out within a few dB of each other and of the target;
+// nothing exceeds the limiter ceiling; the quiet talker's next over starts levelled
+static void checkLoudness() {
+    static ChannelMixer mixer;
+    mixer.begin();
+    TestStream quiet = synthesize(0, 250, 900);
+    TestStream loud = synthesize(1, 250, 9500);
+    // Quiet, so the AGC is near full gain, then a 100 ms burst at full scale
+    TestStream hot = synthesize(2, 150, 900);
+    TestStream burst = synthesize(2, 150, 32000);
+    for (int f = 100; f < 105; f++) hot.packets[f] = burst.packets[f];
+    std::vector<int16_t> q = playAlone(mixer, quiet, 1, "quiet");
+    std::vector<int16_t> l = playAlone(mixer, loud, 2, "loud");
+    std::vector<int16_t> h = playAlone(mixer, hot, 3, "hot");
+    // Sped up, the stretch crossfades into input up to STRETCH_MAX_LAG further on:
+    // clicks are limited even where a skip jumps straight into them
+    std::vector<int16_t> fast = playAlone(mixer, clicks(250, 900), 5, "fast", STRETCH_MAX_SPEED);
+    double qRms = rmsOf(q, q.size() / 2, q.size()), lRms = rmsOf(l, l.size() / 2, l.size());
+    CHECK(fabs(dB(qRms / lRms)) < 4, "talkers 20 dB apart still differ by %.1f dB", dB(qRms / lRms));
+    CHECK(fabs(dB(qRms / AGC_TARGET_RMS)) < 6, "quiet talker at %.1f dB from the target", dB(qRms / AGC_TARGET_RMS));
+    int peak = 0;
+    for (const std::vector<int16_t>* v : {&q, &l, &h, &fast}) {
+        for (int16_t x : *v) peak = std::max(peak, abs((int)x));
+    }
+    CHECK(peak <= AGC_CEILING, "limiter let a %d peak through", peak);
+
+    // Second over from the quiet talker: the first 200 ms are already near its level
+    std::vector<int16_t> again = playAlone(mixer, quiet, 4, "quiet");
+    double startRms = rmsOf(again, 0, 3200), firstRms = rmsOf(q, 0, 3200);
+    CHECK(dB(startRms / firstRms) > 10, "remembered gain not used: start %.0f vs %.0f RMS", startRms, firstRms);
+    printf("loudness: 20 dB apart -> %.1f dB apart, peak %d, repeat talker starts %.1f dB louder\n",
+           dB(qRms / lRms), peak, dB(startRms / firstRms));
+}
+
+// A talker whose packets stop for 200 ms mid-over: the gap starts with concealment
+// that continues the voice without a step, fades to a comfort noise bed no louder
+// than -50 dBFS, and the stream resumes once its jitter buffer has refilled
+static void checkConcealment() {
+    static ChannelMixer mixer;
+    mixer.begin();
+    mixer.setAgc(false);
+    TestStream t = synthesize(0, 100);
+    decodeAlone(t);
+    MixStream* s = mixer.open(1, 1, "x");
+    std::vector<int16_t> out;
+    size_t next = 0, fed = 0, gapAt = 0, late = 0;
+    int underruns = 0;
+    while (next < t.packets.size() || mixer.hasOutput()) {
+        if (next == 40 && !late && out.size() >= fed + 3200) late = 3200;
+        bool stalled = next == 40 && !late;   // nothing arrives for 200 ms, then packets run that late
+        while (!stalled && next < t.packets.size() && fed + late < out.size() + MIX_PREBUFFER_SAMPLES) {
+            fed += mixer.decode(s, t.packets[next].data(), t.packets[next].size());
+            if (++next == t.packets.size()) mixer.close(1);
+        }
+        int16_t block[MIX_BLOCK_SAMPLES];
+        int starved = mixer.mix(block, MIX_BLOCK_SAMPLES);
+        if (starved && !gapAt) gapAt = out.size();
+        underruns += starved;
+        out.insert(out.end(), block, block + MIX_BLOCK_SAMPLES);
+    }
+    CHECK(underruns == 1, "%d underruns, expected 1", underruns);
+    CHECK(gapAt, "the stream never ran dry");
+    if (!gapAt) return;
+    size_t dry = 40 * 320;   // where the FIFO emptied: after packet 39
+    CHECK(gapAt <= dry && dry < gapAt + MIX_BLOCK_SAMPLES, "ran dry at %zu, expected %zu", gapAt, dry);
+    int step = 0;
+    for (size_t i = dry - 8; i < dry + 8; i++) step = std::max(step, abs(out[i + 1] - out[i]));
+    int voice = 0;
+    for (size_t i = dry - 320; i < dry; i++) voice = std::max(voice, abs(out[i] - out[i - 1]));
+    double concealRms = rmsOf(out, dry, dry + 320);
+    double bedRms = rmsOf(out, dry + 1600, dry + 3200);
+    CHECK(step <= voice + 200, "step of %d where the stream ran dry, the voice moves by up to %d", step, voice);
+    CHECK(concealRms > 300, "first 20 ms of the gap at %.0f RMS, expected concealment", concealRms);
+    CHECK(bedRms > 0 && bedRms <= MIX_CN_MAX_RMS * 1.2, "noise bed at %.0f RMS", bedRms);
+    CHECK(s->active == false && out.size() >= t.pcm.size() + 3200, "stream did not play out after the gap");
+    printf("concealment: %.0f RMS into the gap, noise bed %.0f RMS, %zu ms filled\n", concealRms, bedRms,
+           (out.size() - t.pcm.size()) * 1000 / PLAYBACK_SAMPLE_RATE);
+}
+
+// Positive-going zero crossings per second, the pitch of a pure tone
+static double toneHz(const std::vector<int16_t>& pcm, size_t from, size_t to) {
+    int crossings = 0;
+    for (size_t i = from + 1; i < to; i++) crossings += pcm[i - 1] < 0 && pcm[i] >= 0;
+    return crossings * (double)PLAYBACK_SAMPLE_RATE / (to - from);
+}
+
+// Packets 50..56 are held up and arrive with packet 57, 140 ms late: the stream
+// conceals a 100 ms gap, then has 160 ms queued. It plays that down to
+// MIX_BACKLOG_END_SAMPLES at MIX_BACKLOG_SPEED and keeps the tone's pitch.
+static void checkBacklog() {
+    static ChannelMixer mixer;
+    mixer.begin();
+    mixer.setAgc(false);
+    mixer.setDriftCompensation(false);
+    TestStream t;
+    int err;
+    OpusEncoder* enc = opus_encoder_create(PLAYBACK_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(24000));
+    for (int f = 0; f < 200; f++) {
+        int16_t frame[320];
+        for (int i = 0; i < 320; i++) frame[i] = (int16_t)(4000 * sin(2 * M_PI * 200 * (f * 320 + i) / PLAYBACK_SAMPLE_RATE));
+        uint8_t out[MIX_MAX_PACKET_BYTES];
+        int len = opus_encode(enc, frame, 320, out, sizeof(out));
+        t.packets.push_back(Packet(out, out + len));
+    }
+    opus_encoder_destroy(enc);
+
+    MixStream* s = mixer.open(1, 1, "x");
+    std::vector<int16_t> out;
+    size_t next = 0, burstAt = 0, drainedAt = 0;
+    while (next < t.packets.size() || mixer.hasOutput()) {
+        // Packet k arrives 40 ms before it is due, the held-up ones with packet 57
+        while (next < t.packets.size() &&
+               (std::max(next, next >= 50 ? (size_t)57 : 0) * 320 <= out.size() + MIX_PREBUFFER_SAMPLES)) {
+            mixer.decode(s, t.packets[next].data(), t.packets[next].size());
+            if (++next == t.packets.size()) mixer.close(1);
+            if (next == 57) burstAt = out.size();
+        }
+        int16_t block[MIX_BLOCK_SAMPLES];
+        mixer.mix(block, MIX_BLOCK_SAMPLES);
+        out.insert(out.end(), block, block + MIX_BLOCK_SAMPLES);
+        if (burstAt && !drainedAt && !s->draining) drainedAt = out.size();
+    }
+    CHECK(burstAt && drainedAt > burstAt, "no backlog was played down");
+    if (!(burstAt && drainedAt > burstAt)) return;
+    uint32_t caughtUp = s->caughtUp;
+    // 160 ms queued, 50 ms kept: 110 ms to skip at 20 ms a second
+    int drainMs = (int)((drainedAt - burstAt) * 1000 / PLAYBACK_SAMPLE_RATE);
+    int expectMs = (2560 - MIX_BACKLOG_END_SAMPLES) * 1000 / PLAYBACK_SAMPLE_RATE * 100 / (MIX_BACKLOG_SPEED - 100);
+    CHECK(abs(drainMs - expectMs) <= 200, "backlog played down in %d ms, expected ~%d", drainMs, expectMs);
+    CHECK(caughtUp >= 2560 - MIX_BACKLOG_END_SAMPLES - 320, "caught up %u samples", caughtUp);
+    size_t full = t.packets.size() * 320 + 100 * PLAYBACK_SAMPLE_RATE / 1000;   // the tone plus the gap
+    CHECK(out.size() + caughtUp >= full - 320 && out.size() + caughtUp <= full + 640,
+          "played %zu samples with %u skipped, expected %zu in all", out.size(), caughtUp, full);
+    double before = toneHz(out, 16 * 320, 48 * 320);
+    double during = toneHz(out, burstAt + 320, drainedAt);
+    CHECK(fabs(during - before) <= before * 0.02, "tone at %.1f Hz while catching up, %.1f Hz before", during, before);
+    printf("backlog: %u ms caught up in %d ms, tone %.1f Hz -> %.1f Hz\n",
+           (unsigned)(caughtUp * 1000 / PLAYBACK_SAMPLE_RATE), drainMs, before, during);
+}
+
+static void checkEviction(std::vector<TestStream>& streams) {
+    static ChannelMixer mixer;
+    mixer.begin();
+    const Packet& p = streams[0].packets[0];
+    for (uint32_t k = 1; k <= MIX_MAX_STREAMS; k++) CHECK(mixer.open(k, 1, "x"), "open %u", k);
+    for (uint32_t k = 1; k <= MIX_MAX_STREAMS; k++) {
+        if (k != 2) mixer.decode(mixer.find(k), p.data(), p.size());
+    }
+    uint32_t evicted = 0;
+    CHECK(mixer.open(100, 1, "new", &evicted), "open into a full pool");
+    CHECK(evicted == 2, "evicted %u, expected the idle stream 2", evicted);
+    CHECK(!mixer.find(2) && mixer.find(100), "lookup after eviction");
+
+    mixer.drop(100);
+    CHECK(mixer.open(101, 0, "low", &evicted), "refill");
+    evicted = 0;
+    mixer.decode(mixer.find(101), p.data(), p.size());   // most recent, but lowest priority
+    CHECK(mixer.open(102, 1, "new", &evicted) && evicted == 101, "evicted %u, expected priority-0 stream", evicted);
+    CHECK(!mixer.open(103, 0, "low"), "a lower priority never evicts a higher one");
+    printf("eviction: ok\n");
+}
+
+// Random open/close/drop over colliding ids against a reference set
+static void checkLookup() {
+    static ChannelMixer mixer;
+    mixer.begin();
+    std::vector<uint32_t> keys;   // many ids sharing two buckets
+    for (uint32_t k = 1; keys.size() < 24; k++) {
+        int h = (k * 2654435761u) >> (32 - MIX_INDEX_BITS);
+        if (h == 3 || h == 4) keys.push_back(k);
+    }
+    std::set<uint32_t> live;
+    for (int i = 0; i < 20000; i++) {
+        uint32_t key = keys[nextRandom() % keys.size()];
+        switch (nextRandom() % 3) {
+        case 0: {
+            uint32_t evicted = 0;
+            if (mixer.open(key, 0, "x", &evicted)) {
+                if (evicted) live.erase(evicted);
+                live.insert(key);
+            }
+            break;
+        }
+        case 1:
+            mixer.drop(key);
+            live.erase(key);
+            break;
+        default:
+            break;
+        }
+        for (size_t j = 0; j < keys.size(); j++) {
+            MixStream* s = mixer.find(keys[j]);
+            bool expected = live.count(keys[j]) > 0;
+            CHECK((s != nullptr) == expected && (!s || (s->key == keys[j] && s->active)),
+                  "op %d: lookup of %u %s", i, keys[j], expected ? "missed" : "found a dropped stream");
+            if (failures > 10) return;
+        }
+    }
+    CHECK(live.size() == mixer.activeCount(), "active count %u, expected %zu", mixer.activeCount(), live.size());
+    printf("lookup: 20000 operations over %zu colliding ids\n", keys.size());
+}
+
+int main(int argc, char** argv) {
+    std::vector<TestStream> streams;
+    for (int i = 1; i < argc; i++) readCapsules(argv[i], streams);
+    if (streams.empty()) {
+        for (int i = 0; i < MIX_MAX_STREAMS; i++) streams.push_back(synthesize(i, 100 + 37 * i));
+    }
+    if (streams.size() < 2) {
+        printf("need at least two streams\n");
+        return 1;
+    }
+    for (size_t i = 0; i < streams.size(); i++) decodeAlone(streams[i]);
+
+    checkMix(streams);
+    checkMessageQueue(streams);
+    checkCatchUp();
+    checkLoudness();
+    checkConcealment();
+    checkBacklog();
+    checkEviction(streams);
+    checkLookup();
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * Drift Check
+ *
+ * Host-side check of the clock drift compensation in include/channel_mixer.h
+ * (include/clock_drift.h). Replays a five-minute message whose sender clock runs
+ * off the playout clock by a synthetic skew, with packets arriving in order but
+ * up to 20 ms late, and records the buffer depth once per second. For each
+ * skew it runs with the compensation on and off and checks that, with it on:
+ *   - the stream runs dry no more often than without it (late packets alone
+ *     starve it now and then at a slow skew) and never nears a full FIFO;
+ *   - after the first minute the per-second depth stays within 5 ms of where it
+ *     settled, instead of wandering by the skew times the message length;
+ *   - the estimated drift ends within 5% (or 10 ppm) of the skew.
+ *
+ *   g++ -std=c++11 -O2 -Iinclude tools/drift_check.cpp $(pkg-config --cflags --libs opus) -o drift_check
+ *   ./drift_check
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "channel_mixer.h"
+
+static uint32_t nowMs = 0;
+uint32_t millis() { return nowMs; }
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                          \
+    do {                                          \
+        if (!(cond)) {                            \
+            printf("FAIL line %d: ", __LINE__);   \
+            printf(__VA_ARGS__);                  \
+            printf("\n");                         \
+            failures++;                           \
+        }                                         \
+    } while (0)
+
+typedef std::vector<uint8_t> Packet;
+
+#define MESSAGE_SECONDS 300
+#define PACKET_SAMPLES 320
+#define MAX_LATE_US 20000
+
+static uint32_t rng = 1;
+static uint32_t nextRandom() {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// Ten seconds of a talker (a gliding tone with a syllable envelope), looped by the replay
+static std::vector<Packet> encodeTalker() {
+    std::vector<Packet> packets;
+    int err;
+    OpusEncoder* enc = opus_encoder_create(PLAYBACK_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(16000));
+    double phase = 0;
+    for (int f = 0; f < 500; f++) {
+        int16_t frame[PACKET_SAMPLES];
+        for (int i = 0; i < PACKET_SAMPLES; i++) {
+            double t = (f * PACKET_SAMPLES + i) / (double)PLAYBACK_SAMPLE_RATE;
+            phase += 2 * M_PI * (200 + 60 * sin(t * 2)) / PLAYBACK_SAMPLE_RATE;
+            frame[i] = (int16_t)(6000 * (0.5 + 0.5 * sin(t * 2 * M_PI * 4)) * sin(phase));
+        }
+        uint8_t out[MIX_MAX_PACKET_BYTES];
+        int len = opus_encode(enc, frame, PACKET_SAMPLES, out, sizeof(out));
+        packets.push_back(Packet(out, out + len));
+    }
+    opus_encoder_destroy(enc);
+    return packets;
+}
+
+struct Result {
+    int underruns;
+    int minFill, maxFill;       // per-second average depths after the first minute, samples
+    int settled;                // per-second average at the one-minute mark
+    int ppm;
+};
+
+// Packets are sent every 20 ms of the sender's clock, which runs skewPpm fast, and
+// decoded when they arrive; the mixer is read every 10 ms of the local clock. The
+// depth is sampled at each arrival, as the estimator does: FIFO fill less what
+// has played since the last block.
+static Result replay(const std::vector<Packet>& talker, int skewPpm, bool compensate) {
+    static ChannelMixer mixer;
+    static bool begun = false;
+    if (!begun) begun = mixer.begin() > 0;
+    mixer.setAgc(false);
+    mixer.setDriftCompensation(compensate);
+    nowMs = 0;
+    MixStream* s = mixer.open(1, 1, "talker");
+    Result r = {0, INT32_MAX, INT32_MIN, 0, 0};
+    const int packets = MESSAGE_SECONDS * 50;
+    const double packetUs = 20000.0 / (1 + skewPpm * 1e-6);
+    double arrivalUs = -1;
+    int next = 0, second = 0, depthCount = 0;
+    int64_t depthSum = 0;
+    uint32_t lastMixMs = 0;
+    rng = 1;
+    for (uint64_t blockUs = 0; next < packets || mixer.hasOutput(); blockUs += 10000) {
+        while (next < packets) {
+            if (arrivalUs < next * packetUs) {
+                // In order, mostly a few ms late, one packet in twenty up to MAX_LATE_US
+                double late = nextRandom() % 1000 < 50 ? nextRandom() % MAX_LATE_US : nextRandom() % 3000;
+                arrivalUs = std::max(arrivalUs, next * packetUs + late);
+            }
+            if (arrivalUs > blockUs) break;
+            nowMs = (uint32_t)(arrivalUs / 1000);
+            const Packet& p = talker[next % talker.size()];
+            mixer.decode(s, p.data(), p.size());
+            if (++next == packets) mixer.close(1);
+            if (s->primed && !s->closing) {
+                depthSum += s->used - std::min(MIX_BLOCK_SAMPLES, (int)(nowMs - lastMixMs) * 16);
+                depthCount++;
+            }
+            arrivalUs = std::max(arrivalUs, next * packetUs - 1);   // the next one is not drawn yet
+        }
+        nowMs = lastMixMs = (uint32_t)(blockUs / 1000);
+        int16_t block[MIX_BLOCK_SAMPLES];
+        r.underruns += mixer.mix(block, MIX_BLOCK_SAMPLES);
+        if (blockUs / 1000000 != (uint64_t)second) {
+            int depth = depthCount ? (int)(depthSum / depthCount) : 0;
+            if (second == 60) r.settled = depth;
+            if (second >= 60 && depthCount) {
+                r.minFill = std::min(r.minFill, depth);
+                r.maxFill = std::max(r.maxFill, depth);
+            }
+            if (s->active) r.ppm = s->drift.ppm();
+            depthSum = depthCount = 0;
+            second = (int)(blockUs / 1000000);
+        }
+    }
+    return r;
+}
+
+static int ms(int samples) { return samples * 1000 / PLAYBACK_SAMPLE_RATE; }
+
+int main() {
+    std::vector<Packet> talker = encodeTalker();
+    printf("%d s message, packets up to %d ms late; depth after the first minute, per-second averages\n",
+           MESSAGE_SECONDS, MAX_LATE_US / 1000);
+    printf("  skew      compensation  underruns  depth (ms)     drift estimate\n");
+    const int skews[] = {0, 50, -50, 200, -200, 500, -500};
+    for (int skew : skews) {
+        Result off = replay(talker, skew, false);
+        Result on = replay(talker, skew, true);
+        printf("  %+5d ppm %-13s %9d  %4d .. %-4d   %+d ppm\n", skew, "on", on.underruns, ms(on.minFill),
+               ms(on.maxFill), on.ppm);
+        printf("  %+5d ppm %-13s %9d  %4d .. %-4d\n", skew, "off", off.underruns, ms(off.minFill),
+               ms(off.maxFill));
+        CHECK(on.underruns <= off.underruns, "%+d ppm: %d underruns, %d without compensation", skew,
+              on.underruns, off.underruns);
+        CHECK(on.maxFill < MIX_FIFO_SAMPLES - 2 * PACKET_SAMPLES, "%+d ppm: FIFO nearly full", skew);
+        CHECK(on.settled - on.minFill <= 80 && on.maxFill - on.settled <= 80,
+              "%+d ppm: depth wandered %d..%d samples from %d", skew, on.minFill, on.maxFill, on.settled);
+        CHECK(abs(on.ppm - skew) <= std::max(10, abs(skew) / 20), "%+d ppm: estimated %+d ppm", skew, on.ppm);
+    }
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * DSP Bench
+ *
+ * Host-side cost of the per-sample audio stages, in cycles (x86 TSC ticks) and
+ * nanoseconds per output sample:
+ *   - the mixer with one and four streams, AGC/limiter off and on
+ *     (include/channel_mixer.h, include/talker_agc.h);
+ *   - the output gain pass at unity, at a fixed level and while ramping
+ *     (include/output_gain.h);
+ *   - the tone generator rendering a single and a dual-tone cue
+ *     (include/tone_generator.h);
+ *   - WSOLA time compression at the backlog and the fastest replay speed
+ *     (include/time_stretch.h).
+ * Opus decoding is done outside the timed sections. Host numbers are only a
+ * relative guide: compare stages against each other, not against the ESP32.
+ *
+ *   g++ -std=c++11 -O2 -Iinclude tools/dsp_bench.cpp $(pkg-config --cflags --libs opus) -o dsp_bench
+ *   ./dsp_bench
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+#include "channel_mixer.h"
+#include "output_gain.h"
+#include "time_stretch.h"
+#include "tone_generator.h"
+
+uint32_t millis() { return 0; }
+
+typedef std::vector<uint8_t> Packet;
+
+struct Timer {
+    std::chrono::steady_clock::time_point t0;
+    uint64_t c0 = 0;
+    void start() {
+        t0 = std::chrono::steady_clock::now();
+#if HAVE_TSC
+        c0 = __rdtsc();
+#endif
+    }
+    void report(const char* name, double samples) {
+#if HAVE_TSC
+        double cycles = (double)(__rdtsc() - c0);
+#else
+        double cycles = 0;
+#endif
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        printf("  %-34s %7.2f cycles/sample %7.2f ns/sample\n", name, cycles / samples, ns / samples);
+    }
+};
+
+// One second of speech-like audio (a tone with a syllable envelope) as 20 ms packets
+static std::vector<Packet> encodeTalker(int index, double amplitude) {
+    std::vector<Packet> packets;
+    int err;
+    OpusEncoder* enc = opus_encoder_create(PLAYBACK_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+    double phase = 0;
+    for (int f = 0; f < 50; f++) {
+        int16_t frame[320];
+        for (int i = 0; i < 320; i++) {
+            double t = (f * 320 + i) / (double)PLAYBACK_SAMPLE_RATE;
+            phase += 2 * M_PI * (160 + 70 * index) / PLAYBACK_SAMPLE_RATE;
+            frame[i] = (int16_t)(amplitude * (0.5 + 0.5 * sin(t * 2 * M_PI * 4)) * sin(phase));
+        }
+        uint8_t out[MIX_MAX_PACKET_BYTES];
+        int len = opus_encode(enc, frame, 320, out, sizeof(out));
+        packets.push_back(Packet(out, out + len));
+    }
+    opus_encoder_destroy(enc);
+    return packets;
+}
+
+static void benchMixer(int streams, bool agc) {
+    static ChannelMixer mixer;
+    static bool begun = false;
+    if (!begun) begun = mixer.begin() > 0;
+    mixer.setAgc(agc);
+    mixer.setBacklogSpeed(100);   // the 160 ms fill is the bench's, not a backlog to play down
+    std::vector<std::vector<Packet>> talkers;
+    for (int s = 0; s < streams; s++) {
+        talkers.push_back(encodeTalker(s, 1000 + 3000 * s));
+        mixer.open(100 + s, 1, "bench");
+    }
+    const int rounds = 200;
+    double mixed = 0, elapsedCycles = 0, elapsedNs = 0;
+    int16_t block[MIX_BLOCK_SAMPLES];
+    for (int r = 0; r < rounds; r++) {
+        // Fill each FIFO with 160 ms (untimed), then mix it out in 10 ms blocks
+        for (int s = 0; s < streams; s++) {
+            MixStream* m = mixer.find(100 + s);
+            for (int p = 0; p < 8; p++) {
+                const Packet& pk = talkers[s][(r * 8 + p) % talkers[s].size()];
+                mixer.decode(m, pk.data(), pk.size());
+            }
+        }
+        auto t0 = std::chrono::steady_clock::now();
+#if HAVE_TSC
+        uint64_t c0 = __rdtsc();
+#endif
+        for (int b = 0; b < 15; b++) mixer.mix(block, MIX_BLOCK_SAMPLES);
+#if HAVE_TSC
+        elapsedCycles += __rdtsc() - c0;
+#endif
+        elapsedNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        mixed += 15 * MIX_BLOCK_SAMPLES;
+        for (int s = 0; s < streams; s++) mixer.drop(100 + s);   // start every round from empty FIFOs
+        for (int s = 0; s < streams; s++) mixer.open(100 + s, 1, "bench");
+    }
+    for (int s = 0; s < streams; s++) mixer.drop(100 + s);
+    char name[64];
+    snprintf(name, sizeof(name), "mix, %d stream%s, AGC %s", streams, streams > 1 ? "s" : "", agc ? "on" : "off");
+    printf("  %-34s %7.2f cycles/sample %7.2f ns/sample\n", name, elapsedCycles / mixed, elapsedNs / mixed);
+}
+
+static void benchOutputGain() {
+    static int16_t mono[MIX_BLOCK_SAMPLES];
+    static int16_t stereo[MIX_BLOCK_SAMPLES * 2];
+    for (int i = 0; i < MIX_BLOCK_SAMPLES; i++) mono[i] = (int16_t)(8000 * sin(i * 0.1));
+    const int blocks = 200000;
+    OutputGain gain;
+    Timer t;
+
+    t.start();
+    for (int b = 0; b < blocks; b++) gain.process(mono, stereo, MIX_BLOCK_SAMPLES);
+    t.report("output gain, unity", (double)blocks * MIX_BLOCK_SAMPLES);
+
+    gain.setLevel(12000);
+    gain.jump(12000);
+    t.start();
+    for (int b = 0; b < blocks; b++) gain.process(mono, stereo, MIX_BLOCK_SAMPLES);
+    t.report("output gain, fixed level", (double)blocks * MIX_BLOCK_SAMPLES);
+
+    t.start();
+    for (int b = 0; b < blocks; b++) {
+        gain.jump(b & 1 ? 2000 : 30000);   // never settles: every sample ramps
+        gain.process(mono, stereo, MIX_BLOCK_SAMPLES);
+    }
+    t.report("output gain, ramping", (double)blocks * MIX_BLOCK_SAMPLES);
+}
+
+static void benchTones() {
+    static int16_t block[MIX_BLOCK_SAMPLES];
+    const int blocks = 200000;
+    ToneGenerator tones;
+    tones.begin(4000);
+    Timer t;
+    Cue cues[] = {Cue::Startup, Cue::Error};
+    const char* names[] = {"tone, single", "tone, dual"};
+    for (int c = 0; c < 2; c++) {
+        double rendered = 0;
+        t.start();
+        for (int b = 0; b < blocks; b++) {
+            if (!tones.active()) tones.play(cues[c]);   // back to back: pauses count as rendered too
+            tones.render(block, MIX_BLOCK_SAMPLES, PLAYBACK_SAMPLE_RATE);
+            rendered += MIX_BLOCK_SAMPLES;
+        }
+        t.report(names[c], rendered);
+        tones.stop();
+    }
+}
+
+// Speech-like input, a gliding tone with a syllable envelope; every call has its
+// full search range, as a sped-up stream with audio queued does
+static void benchStretch() {
+    const int length = PLAYBACK_SAMPLE_RATE * 4;
+    std::vector<int16_t> in(length + STRETCH_MAX_INPUT);
+    double phase = 0;
+    for (size_t i = 0; i < in.size(); i++) {
+        double t = i / (double)PLAYBACK_SAMPLE_RATE;
+        phase += 2 * M_PI * (150 + 50 * sin(t * 3)) / PLAYBACK_SAMPLE_RATE;
+        in[i] = (int16_t)(8000 * (0.5 + 0.5 * sin(t * 2 * M_PI * 4)) * sin(phase));
+    }
+    int16_t out[STRETCH_SEGMENT_SAMPLES];
+    const uint16_t speeds[] = {120, 150};
+    const char* names[] = {"time stretch, 120%", "time stretch, 150%"};
+    for (int k = 0; k < 2; k++) {
+        TimeStretch stretch;
+        double produced = 0;
+        Timer t;
+        t.start();
+        for (int rep = 0; rep < 20; rep++) {
+            for (int pos = 0; pos < length;) {
+                pos += stretch.process(&in[pos], STRETCH_MAX_INPUT, out, speeds[k]);
+                produced += STRETCH_SEGMENT_SAMPLES;
+            }
+        }
+        t.report(names[k], produced);
+    }
+}
+
+int main() {
+    printf("per output sample at %d Hz:\n", PLAYBACK_SAMPLE_RATE);
+    benchMixer(1, false);
+    benchMixer(1, true);
+    benchMixer(4, false);
+    benchMixer(4, true);
+    benchOutputGain();
+    benchTones();
+    benchStretch();
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+ * Echo Canceller Check
+ *
+ * Host-side ERLE and CPU check of include/echo_canceller.h. Feeds the canceller
+ * a reference (what the speaker played) and a mic signal in 20 ms frames, as
+ * the capture task does, and reports:
+ *   - ERLE (echo return loss enhancement: mic over output energy) once
+ *     converged, while only the far end talks;
+ *   - how fast it gets to 10 and 20 dB;
+ *   - during double talk, how much of the near end's speech comes through,
+ *     and the ERLE after it, so a filter pulled off the echo path shows;
+ *   - that the output is the mic unchanged while nothing plays;
+ *   - the CPU time per 20 ms frame.
+ * It fails when the converged ERLE is under 20 dB, under 15 dB after double
+ * talk, or the near end loses more than it gains.
+ *
+ * Without arguments everything is synthetic: phrases of voiced speech from the
+ * far end through a 30 ms echo path (direct sound after 5 ms, then a decaying
+ * tail) at about -5 dB, mic noise at -60 dBFS, and the near end talking over
+ * it in their own rhythm from 7 to 9 s. Recordings are 16 kHz mono 16-bit WAV
+ * files: the reference and the mic, aligned as EchoReference aligns them on
+ * the device. With recordings the ERLE is reported per second, as the near
+ * end's part is not known.
+ *
+ * Like the noise suppressor it links Opus' fixed-point FFT from lib/OPUS:
+ *
+ *   gcc -O2 -c -Ilib/OPUS lib/OPUS/celt/kiss_fft.c lib/OPUS/celt/modes.c lib/OPUS/celt/mathops.c
+ *   g++ -std=c++11 -O2 -Iinclude -Ilib/OPUS tools/echo_canceller_check.cpp kiss_fft.o modes.o mathops.o -o echo_canceller_check
+ *   ./echo_canceller_check [reference.wav mic.wav [out.wav]]
+ *
+ * CPU numbers are for the host; the ESP32 measures itself in zello_tx_aec_us.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "echo_canceller.h"
+#include "wav_io.h"
+
+#define RATE WAV_RATE
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                          \
+    do {                                          \
+        if (!(cond)) {                            \
+            printf("FAIL line %d: ", __LINE__);   \
+            printf(__VA_ARGS__);                  \
+            printf("\n");                         \
+            failures++;                           \
+        }                                         \
+    } while (0)
+
+// Voiced syllables on a gliding pitch, shaped by three formants, with pauses;
+// a talker's rhythm is set by the syllable length and where their phrases start
+static Pcm synthesizeSpeech(double seconds, double pitch, double syllableSeconds, double phraseOffset,
+                            double amplitude, int seed) {
+    static const double formants[][3] = {{700, 1200, 2600}, {300, 2300, 3000}, {500, 900, 2400}, {400, 1900, 2550}};
+    Pcm pcm((size_t)(seconds * RATE));
+    double phase = 0;
+    for (size_t i = 0; i < pcm.size(); i++) {
+        double t = i / (double)RATE + phraseOffset;
+        double inPhrase = fmod(t, 2.0);   // 1.4 s of syllables, 0.6 s pause
+        if (inPhrase >= 1.4) continue;
+        int syllable = (int)(inPhrase / syllableSeconds);
+        double inSyllable = fmod(inPhrase, syllableSeconds) / syllableSeconds;
+        double env = sin(M_PI * inSyllable);
+        const double* f = formants[(syllable + seed + (int)(t / 2.0)) % 4];
+        double f0 = pitch + 0.25 * pitch * sin(t * 2.1 + seed) + 15 * inSyllable;
+        phase += 2 * M_PI * f0 / RATE;
+        double v = 0;
+        for (int h = 1; h * f0 < 3800; h++) {
+            double fh = h * f0, a = 0;
+            for (int k = 0; k < 3; k++) a += 1.0 / (1 + pow((fh - f[k]) / (80 + 40 * k), 2)) / (k + 1);
+            v += a * sin(h * phase) / sqrt((double)h);
+        }
+        pcm[i] = (int16_t)(amplitude * env * env * v);
+    }
+    return pcm;
+}
+
+// Runs the canceller over the mic signal as the capture task would; returns the host time per frame in us
+static double run(EchoCanceller& ec, const Pcm& ref, const Pcm& mic, Pcm& out) {
+    size_t frames = std::min(ref.size(), mic.size()) / EC_FRAME_SAMPLES;
+    out.assign(mic.begin(), mic.begin() + frames * EC_FRAME_SAMPLES);
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames; f++) ec.process(&out[f * EC_FRAME_SAMPLES], &ref[f * EC_FRAME_SAMPLES]);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    return frames ? us / frames : 0;
+}
+
+// ERLE over [from, to) seconds, counting only frames where the far end is active
+static double erle(const Pcm& far, const Pcm& mic, const Pcm& out, double from, double to) {
+    double in = 0, left = 0;
+    for (size_t f = (size_t)(from * RATE) / EC_FRAME_SAMPLES; f < (size_t)(to * RATE) / EC_FRAME_SAMPLES; f++) {
+        size_t at = f * EC_FRAME_SAMPLES;
+        if (energy(far, at, EC_FRAME_SAMPLES) < EC_FRAME_SAMPLES * 100.0 * 100.0) continue;
+        in += energy(mic, at, EC_FRAME_SAMPLES);
+        left += energy(out, at, EC_FRAME_SAMPLES);
+    }
+    return left > 0 ? dB(in / left) : 0;
+}
+
+static int recorded(const char* refPath, const char* micPath, const char* outPath) {
+    Pcm ref, mic, out;
+    if (!readWav(refPath, ref) || !readWav(micPath, mic)) {
+        printf("need 16 kHz mono 16-bit WAV files\n");
+        return 1;
+    }
+    EchoCanceller ec;
+    if (!ec.begin()) {
+        printf("no 480-point FFT state in this libopus\n");
+        return 1;
+    }
+    double usPerFrame = run(ec, ref, mic, out);
+    printf("%.1f s recorded\n", out.size() / (double)RATE);
+    for (size_t s = 0; s + 1 <= out.size() / RATE; s++) {
+        printf("  %2zu s  ERLE %5.1f dB\n", s, erle(ref, mic, out, s, s + 1));
+    }
+    printf("  double talk                     %u frames at a cut step\n", ec.doubleTalkFrames());
+    printf("  restarts after divergence       %u\n", ec.divergences());
+    printf("  CPU                             %.1f us per 20 ms frame on this host\n", usPerFrame);
+    if (outPath && !writeWav(outPath, out)) printf("cannot write %s\n", outPath);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3) return recorded(argv[1], argv[2], argc >= 4 ? argv[3] : nullptr);
+
+    const double seconds = 12;
+    Pcm far = synthesizeSpeech(seconds, 120, 0.2, 0, 6000, 0);
+    Pcm nearTalk = synthesizeSpeech(seconds, 210, 0.17, 0.9, 5000, 2);
+    for (size_t i = 0; i < nearTalk.size(); i++) {
+        double t = i / (double)RATE;
+        if (t < 7 || t >= 9) nearTalk[i] = 0;
+    }
+
+    // Echo path: direct sound after 5 ms, then a decaying tail to 30 ms
+    std::vector<double> path(480, 0);
+    path[80] = 0.5;
+    path[84] = -0.2;
+    for (size_t i = 96; i < path.size(); i++) path[i] = 0.08 * gaussian() * exp(-(double)(i - 96) / 80);
+
+    Pcm echo(far.size()), mic(far.size());
+    for (size_t i = 0; i < far.size(); i++) {
+        double v = 0;
+        for (size_t j = 0; j < path.size() && j <= i; j++) v += path[j] * far[i - j];
+        echo[i] = saturate(v);
+        mic[i] = saturate(v + nearTalk[i] + 33 * gaussian());
+    }
+
+    EchoCanceller ec;
+    if (!ec.begin()) {
+        printf("no 480-point FFT state in this libopus\n");
+        return 1;
+    }
+    printf("%.1f s, echo path 30 ms at %.1f dB, near end talking 7..9 s\n", seconds,
+           dB(energy(echo, RATE, 6 * RATE) / energy(far, RATE, 6 * RATE)));
+
+    // Nothing playing: the mic comes through unchanged
+    Pcm silence(mic.size(), 0), passed;
+    run(ec, silence, mic, passed);
+    bool same = true;
+    for (size_t i = 0; i < passed.size(); i++) same &= passed[i] == mic[i];
+    printf("  with nothing playing            output %s the mic\n", same ? "is" : "is NOT");
+    CHECK(same, "the canceller changed the mic signal without a reference");
+
+    EchoCanceller fresh;
+    fresh.begin();
+    Pcm out;
+    double usPerFrame = run(fresh, far, mic, out);
+
+    // Time to 10 and 20 dB, in 200 ms windows
+    double to10 = -1, to20 = -1;
+    for (double t = 0; t + 0.2 <= 7 && to20 < 0; t += 0.2) {
+        double e = erle(far, mic, out, t, t + 0.2);
+        if (e >= 10 && to10 < 0) to10 = t + 0.2;
+        if (e >= 20) to20 = t + 0.2;
+    }
+    double converged = erle(far, mic, out, 3, 7);
+    double after = erle(far, mic, out, 9.5, 12);
+    printf("  ERLE 10 dB after                %.1f s\n", to10);
+    printf("  ERLE 20 dB after                %.1f s\n", to20);
+    printf("  ERLE converged (3..7 s)         %.1f dB\n", converged);
+
+    // Double talk: the near end against what is left of the echo, before and after
+    double nearIn = 0, echoIn = 0, wrongOut = 0;
+    for (size_t i = 7 * RATE; i < 9 * RATE; i++) {
+        nearIn += (double)nearTalk[i] * nearTalk[i];
+        echoIn += (double)echo[i] * echo[i];
+        double d = (double)out[i] - nearTalk[i];
+        wrongOut += d * d;
+    }
+    double dtIn = dB(nearIn / echoIn), dtOut = dB(nearIn / wrongOut);
+    printf("  near end over echo, double talk %.1f -> %.1f dB\n", dtIn, dtOut);
+    printf("  ERLE after double talk          %.1f dB\n", after);
+    printf("  double talk                     %u frames at a cut step\n", fresh.doubleTalkFrames());
+    printf("  CPU                             %.1f us per 20 ms frame on this host\n", usPerFrame);
+
+    CHECK(converged >= 20, "converged ERLE only %.1f dB", converged);
+    CHECK(after >= 15, "ERLE only %.1f dB after double talk", after);
+    CHECK(dtOut > dtIn, "near end lost against the echo: %.1f -> %.1f dB", dtIn, dtOut);
+    CHECK(fresh.divergences() == 0, "%u restarts after divergence", fresh.divergences());
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
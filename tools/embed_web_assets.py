@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""
+Web Asset Embedder
+
+Gzips every file in web/ and writes include/web_assets.h, so the dashboard
+can be served straight from flash with "Content-Encoding: gzip".
+
+Runs standalone (python tools/embed_web_assets.py) or as a PlatformIO
+pre-build script (extra_scripts = pre:tools/embed_web_assets.py).
+"""
+
+import gzip
+import os
+import re
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+
+def symbol_name(filename):
+    return re.sub(r"[^A-Za-z0-9]", "_", filename).upper() + "_GZ"
+
+
+def generate(project_dir):
+    web_dir = os.path.join(project_dir, "web")
+    out_path = os.path.join(project_dir, "include", "web_assets.h")
+
+    lines = [
+        "// Generated by tools/embed_web_assets.py from web/ - do not edit",
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "    const char* path;",
+        "    const char* contentType;",
+        "    const uint8_t* data;   // gzip compressed, lives in flash",
+        "    size_t length;",
+        "};",
+        "",
+    ]
+    entries = []
+
+    for filename in sorted(os.listdir(web_dir)):
+        src = os.path.join(web_dir, filename)
+        ext = os.path.splitext(filename)[1]
+        if not os.path.isfile(src) or ext not in MIME_TYPES:
+            continue
+        with open(src, "rb") as f:
+            raw = f.read()
+        # mtime=0 keeps the output reproducible between builds
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        sym = symbol_name(filename)
+        lines.append("// %s: %d bytes -> %d bytes gzip" % (filename, len(raw), len(packed)))
+        lines.append("static const uint8_t %s[] PROGMEM = {" % sym)
+        for i in range(0, len(packed), 16):
+            chunk = ", ".join("0x%02X" % b for b in packed[i:i + 16])
+            lines.append("    %s," % chunk)
+        lines.append("};")
+        lines.append("")
+        path = "/" if filename == "index.html" else "/" + filename
+        entries.append((path, MIME_TYPES[ext], sym))
+
+    lines.append("static const WebAsset WEB_ASSETS[] = {")
+    for path, mime, sym in entries:
+        lines.append('    {"%s", "%s", %s, sizeof(%s)},' % (path, mime, sym, sym))
+    lines.append("};")
+    lines.append("static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    lines.append("")
+
+    content = "\n".join(lines)
+    # Only touch the header when something changed, to avoid needless rebuilds
+    if os.path.exists(out_path):
+        with open(out_path, "r") as f:
+            if f.read() == content:
+                return
+    with open(out_path, "w", newline="\n") as f:
+        f.write(content)
+    print("web_assets.h regenerated (%d assets)" % len(entries))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    generate(env["PROJECT_DIR"])  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
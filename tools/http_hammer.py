@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""
+Dashboard Load Generator
+
+Hammers the device's HTTP endpoints from several threads and reports the
+playback underrun counter (from /api/status) before and after, to check that
+web traffic does not disturb audio. Start a Zello transmission on the channel
+while this runs.
+
+Usage: python tools/http_hammer.py <device-ip> [seconds] [threads]
+"""
+
+import json
+import sys
+import threading
+import time
+import urllib.request
+
+PATHS = ["/", "/style.css", "/app.js", "/api/status", "/config/zello", "/ota"]
+
+
+def status(host):
+    with urllib.request.urlopen("http://%s/api/status" % host, timeout=5) as r:
+        return json.load(r)
+
+
+def worker(host, deadline, results, lock):
+    count, errors, worst = 0, 0, 0.0
+    i = 0
+    while time.time() < deadline:
+        path = PATHS[i % len(PATHS)]
+        i += 1
+        t0 = time.time()
+        try:
+            with urllib.request.urlopen("http://%s%s" % (host, path), timeout=10) as r:
+                r.read()
+            count += 1
+            worst = max(worst, time.time() - t0)
+        except Exception:
+            errors += 1
+    with lock:
+        results.append((count, errors, worst))
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    host = sys.argv[1]
+    seconds = int(sys.argv[2]) if len(sys.argv) > 2 else 30
+    threads = int(sys.argv[3]) if len(sys.argv) > 3 else 4
+
+    before = status(host)
+    print("Underruns before: %d (stream active: %s)" % (before["underruns"], before["stream"]))
+
+    results, lock = [], threading.Lock()
+    deadline = time.time() + seconds
+    pool = [threading.Thread(target=worker, args=(host, deadline, results, lock)) for _ in range(threads)]
+    for t in pool:
+        t.start()
+    for t in pool:
+        t.join()
+
+    after = status(host)
+    requests = sum(r[0] for r in results)
+    errors = sum(r[1] for r in results)
+    worst = max(r[2] for r in results)
+    print("Requests: %d (%.1f/s), errors: %d, slowest: %.0f ms" % (requests, requests / seconds, errors, worst * 1000))
+    print("Underruns after: %d (+%d)" % (after["underruns"], after["underruns"] - before["underruns"]))
+    print("Last /api/status cost: %d us, heap delta %d B" % (after["http"]["apiUs"], after["http"]["apiHeap"]))
+
+
+if __name__ == "__main__":
+    main()
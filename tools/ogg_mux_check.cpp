@@ -0,0 +1,144 @@
+/*
+ * Ogg Opus Muxer Check
+ *
+ * Host-side check of include/ogg_opus_muxer.h against libogg. Muxes synthetic
+ * Opus packets (including multiples of 255 bytes and packets that spill over
+ * pages), then demuxes the result with libogg and compares every page CRC,
+ * flag, granule position and packet byte. Optionally writes the stream to a
+ * file so it can also be inspected with opusinfo.
+ *
+ *   g++ -std=c++11 -Iinclude tools/ogg_mux_check.cpp -logg -o ogg_mux_check
+ *   ./ogg_mux_check [out.opus]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <ogg/ogg.h>
+#include "ogg_opus_muxer.h"
+
+struct MemorySink : OggPageSink {
+    std::vector<uint8_t> bytes;
+    bool writePage(const uint8_t* header, size_t headerLen, const uint8_t* body, size_t bodyLen) override {
+        bytes.insert(bytes.end(), header, header + headerLen);
+        bytes.insert(bytes.end(), body, body + bodyLen);
+        return true;
+    }
+};
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                          \
+    do {                                          \
+        if (!(cond)) {                            \
+            printf("FAIL line %d: ", __LINE__);   \
+            printf(__VA_ARGS__);                  \
+            printf("\n");                         \
+            failures++;                           \
+        }                                         \
+    } while (0)
+
+// A packet with a valid TOC (config 9: SILK-only WB 20 ms, code 0) and random payload
+static std::vector<uint8_t> makePacket(size_t len, uint32_t seed) {
+    std::vector<uint8_t> p(len);
+    p[0] = (9 << 3) | 0;
+    for (size_t i = 1; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        p[i] = seed >> 16;
+    }
+    return p;
+}
+
+int main(int argc, char** argv) {
+    // Sizes chosen to hit the lacing edge cases and page spills
+    std::vector<size_t> sizes = {40, 255, 510, 1, 254, 256, 3828, 4096, 5000, 80, 120};
+    for (int i = 0; i < 600; i++) sizes.push_back(20 + (i * 37) % 200);
+
+    std::vector<std::vector<uint8_t>> packets;
+    for (size_t i = 0; i < sizes.size(); i++) packets.push_back(makePacket(sizes[i], (uint32_t)i + 1));
+
+    MemorySink sink;
+    static OggOpusMuxer muxer;   // ~4.4 KB page buffer, keep it off the stack
+    CHECK(muxer.begin(&sink, 0x1234, 16000), "begin");
+    for (size_t i = 0; i < packets.size(); i++) {
+        CHECK(muxer.writePacket(packets[i].data(), packets[i].size()), "writePacket %zu", i);
+        if (i % 50 == 49) CHECK(muxer.flush(), "flush");
+    }
+    CHECK(muxer.end(), "end");
+    printf("muxed %zu packets into %u pages, %zu bytes\n", packets.size(), muxer.pages(), sink.bytes.size());
+
+    // libogg verifies the CRC of every page in ogg_sync_pageout
+    ogg_sync_state sync;
+    ogg_stream_state stream;
+    ogg_sync_init(&sync);
+    char* buf = ogg_sync_buffer(&sync, sink.bytes.size());
+    memcpy(buf, sink.bytes.data(), sink.bytes.size());
+    ogg_sync_wrote(&sync, sink.bytes.size());
+
+    ogg_page page;
+    ogg_packet packet;
+    int pageCount = 0;
+    size_t packetIndex = 0;   // 0, 1 = OpusHead, OpusTags
+    int64_t expectedGranule = 0;
+    bool sawEos = false;
+    int rc;
+    while ((rc = ogg_sync_pageout(&sync, &page)) != 0) {
+        CHECK(rc == 1, "lost sync / bad CRC before page %d", pageCount);
+        if (rc != 1) continue;
+        if (pageCount == 0) {
+            CHECK(ogg_page_bos(&page), "first page lacks BOS");
+            CHECK(ogg_page_serialno(&page) == 0x1234, "serial number");
+            ogg_stream_init(&stream, ogg_page_serialno(&page));
+        } else {
+            CHECK(!ogg_page_bos(&page), "BOS on page %d", pageCount);
+        }
+        CHECK(ogg_page_pageno(&page) == pageCount, "page number %ld != %d", ogg_page_pageno(&page), pageCount);
+        CHECK(!sawEos, "page after EOS");
+        sawEos = ogg_page_eos(&page);
+        CHECK(ogg_stream_pagein(&stream, &page) == 0, "pagein %d", pageCount);
+
+        int64_t lastEnd = -1;
+        while ((rc = ogg_stream_packetout(&stream, &packet)) != 0) {
+            CHECK(rc == 1, "hole in data at packet %zu", packetIndex);
+            if (rc != 1) continue;
+            if (packetIndex == 0) {
+                CHECK(packet.bytes == 19 && memcmp(packet.packet, "OpusHead", 8) == 0, "OpusHead");
+                CHECK(packet.packet[9] == 1, "channel count");
+            } else if (packetIndex == 1) {
+                CHECK(packet.bytes >= 16 && memcmp(packet.packet, "OpusTags", 8) == 0, "OpusTags");
+            } else {
+                const std::vector<uint8_t>& want = packets[packetIndex - 2];
+                CHECK((size_t)packet.bytes == want.size() && memcmp(packet.packet, want.data(), want.size()) == 0,
+                      "packet %zu content (%ld bytes, want %zu)", packetIndex - 2, packet.bytes, want.size());
+                expectedGranule += 960;
+                lastEnd = expectedGranule;
+            }
+            packetIndex++;
+        }
+        if (pageCount < 2) {
+            CHECK(ogg_page_granulepos(&page) == 0, "header page granule");
+        } else if (lastEnd >= 0) {
+            CHECK(ogg_page_granulepos(&page) == lastEnd, "page %d granule %lld, want %lld", pageCount,
+                  (long long)ogg_page_granulepos(&page), (long long)lastEnd);
+        } else if (!ogg_page_eos(&page)) {
+            CHECK(ogg_page_granulepos(&page) == -1, "page %d without packet end should have granule -1", pageCount);
+        }
+        pageCount++;
+    }
+    CHECK(sawEos, "no EOS page");
+    CHECK(packetIndex == packets.size() + 2, "demuxed %zu packets, want %zu", packetIndex, packets.size() + 2);
+    ogg_stream_clear(&stream);
+    ogg_sync_clear(&sync);
+
+    if (argc > 1) {
+        FILE* f = fopen(argv[1], "wb");
+        if (f) {
+            fwrite(sink.bytes.data(), 1, sink.bytes.size(), f);
+            fclose(f);
+        }
+    }
+
+    printf("%s (%d pages checked)\n", failures ? "FAILED" : "OK", pageCount);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Compressed and delta firmware images for the OTA update (include/ota_image.h).
+
+    python3 tools/ota_image.py zlib new.bin out.zota
+        Deflates the image.
+
+    python3 tools/ota_image.py patch old.bin new.bin out.zota
+        Diffs new.bin against old.bin (the firmware running on the device) and
+        deflates the result. Regions that only moved become runs of zero
+        differences, which deflate to almost nothing.
+
+    python3 tools/ota_image.py apply old.bin in.zota out.bin
+        Decodes a zlib or patch image, the way the device does.
+
+Both encoders decode their own output before writing it. tools/ota_sign.py
+uses this module to write the payload next to its manifest.
+"""
+
+import struct
+import sys
+import zlib
+
+OP_LITERAL = 1
+OP_DIFF = 2
+OP = struct.Struct("<BII")
+
+BLOCK = 32        # bytes that must match exactly to start a diff region
+STEP = 8          # old image positions indexed; any match of BLOCK + STEP bytes is found
+GIVE_UP = 64      # a diff region ends after this many more mismatches than matches
+
+
+def compress(data):
+    return zlib.compress(data, 9)
+
+
+def _index(old):
+    index = {}
+    for i in range(0, len(old) - BLOCK + 1, STEP):
+        index.setdefault(old[i:i + BLOCK], i)
+    return index
+
+
+def diff_ops(old, new):
+    """Yields (op, base offset, bytes) covering new from start to end."""
+    index = _index(old)
+    literal = 0
+    j = 0
+    while j + BLOCK <= len(new):
+        i = index.get(new[j:j + BLOCK])
+        if i is None:
+            j += 1
+            continue
+        # Grow backwards over exact matches still in the pending literal
+        while j > literal and i > 0 and old[i - 1] == new[j - 1]:
+            i -= 1
+            j -= 1
+        # Grow forwards while matches outweigh mismatches, like bsdiff's scan
+        score = best = length = 0
+        k = 0
+        while j + k < len(new) and i + k < len(old):
+            score += 1 if old[i + k] == new[j + k] else -1
+            k += 1
+            if score > best:
+                best, length = score, k
+            elif score < best - GIVE_UP:
+                break
+        if j > literal:
+            yield OP_LITERAL, 0, new[literal:j]
+        yield OP_DIFF, i, bytes((n - o) & 0xFF for n, o in zip(new[j:j + length], old[i:i + length]))
+        j += length
+        literal = j
+    if literal < len(new):
+        yield OP_LITERAL, 0, new[literal:]
+
+
+def make_patch(old, new):
+    stream = bytearray()
+    for op, offset, data in diff_ops(old, new):
+        stream += OP.pack(op, len(data), offset)
+        stream += data
+    return compress(bytes(stream))
+
+
+def apply(old, payload):
+    """Decodes a zlib image or a patch; a patch is recognised by its first op."""
+    data = zlib.decompress(payload)
+    if not data or data[0] not in (OP_LITERAL, OP_DIFF):
+        return data
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        op, length, offset = OP.unpack_from(data, pos)
+        body = data[pos + OP.size:pos + OP.size + length]
+        if op == OP_LITERAL:
+            out += body
+        else:
+            out += bytes((b + o) & 0xFF for b, o in zip(body, old[offset:offset + length]))
+        pos += OP.size + length
+    return bytes(out)
+
+
+def encode(new, old=None):
+    """Returns (format, payload) and checks that the payload decodes to new."""
+    if old is None:
+        payload = compress(new)
+        check = zlib.decompress(payload)
+        fmt = "zlib"
+    else:
+        payload = make_patch(old, new)
+        check = apply(old, payload)
+        fmt = "patch"
+    if check != new:
+        raise RuntimeError("%s image does not decode to the input" % fmt)
+    return fmt, payload
+
+
+def main():
+    args = sys.argv[1:]
+    if len(args) == 3 and args[0] == "zlib":
+        new = open(args[1], "rb").read()
+        fmt, payload = encode(new)
+        out = args[2]
+    elif len(args) == 4 and args[0] == "patch":
+        old = open(args[1], "rb").read()
+        new = open(args[2], "rb").read()
+        fmt, payload = encode(new, old)
+        out = args[3]
+    elif len(args) == 4 and args[0] == "apply":
+        old = open(args[1], "rb").read()
+        with open(args[3], "wb") as f:
+            f.write(apply(old, open(args[2], "rb").read()))
+        return 0
+    else:
+        print(__doc__)
+        return 1
+    with open(out, "wb") as f:
+        f.write(payload)
+    print("%s: %s, %d -> %d bytes (%.1f%%)" % (out, fmt, len(new), len(payload), 100.0 * len(payload) / len(new)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
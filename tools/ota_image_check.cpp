@@ -0,0 +1,197 @@
+/*
+ * OTA Image Check
+ *
+ * Host-side round trip of tools/ota_image.py through include/ota_image.h.
+ * Builds an "old" and a "new" firmware (synthetic, or two real images given on
+ * the command line), encodes the new one as a zlib image and as a patch
+ * against the old one with the Python tool, then streams both payloads
+ * through the device decoder in random-sized pieces and checks that:
+ *   - the output is the new image byte for byte, in sink pieces of bounded size;
+ *   - truncated, corrupted or over-long payloads fail instead of passing;
+ *   - a patch applied to the wrong base does not reproduce the image, and one
+ *     that reads past the end of the base is refused.
+ *
+ *   g++ -std=c++11 -Iinclude tools/ota_image_check.cpp -lz -o ota_image_check
+ *   ./ota_image_check [old.bin new.bin]
+ *
+ * Run it from the repository root; it calls python3 tools/ota_image.py.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "ota_image.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                          \
+    do {                                          \
+        if (!(cond)) {                            \
+            printf("FAIL line %d: ", __LINE__);   \
+            printf(__VA_ARGS__);                  \
+            printf("\n");                         \
+            failures++;                           \
+        }                                         \
+    } while (0)
+
+static uint32_t rng = 1;
+static uint32_t nextRandom() {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+static Bytes readFile(const std::string& path) {
+    Bytes data;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    fclose(f);
+    return data;
+}
+
+static void writeFile(const std::string& path, const Bytes& data) {
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+// Something like firmware: instruction-ish words with 32-bit addresses into
+// itself, so inserting code moves later functions and rewrites their callers
+static Bytes synthesizeFirmware(size_t words, size_t insertAt, size_t inserted) {
+    rng = 7;
+    Bytes out;
+    out.push_back(0xE9);
+    for (size_t w = 0; w < words; w++) {
+        if (w == insertAt) {
+            for (size_t i = 0; i < inserted; i++) out.push_back(0x20 + i % 50);
+        }
+        uint32_t op = nextRandom();
+        if (op % 4 == 0) {
+            uint32_t target = 0x400D0000 + (nextRandom() % words) * 4;
+            if (target >= 0x400D0000 + insertAt * 4) target += inserted;
+            for (int b = 0; b < 4; b++) out.push_back(target >> (8 * b));
+        } else {
+            for (int b = 0; b < 4; b++) out.push_back(op % 7 == 0 ? 0 : (op >> (8 * b)) & 0x3F);
+        }
+    }
+    return out;
+}
+
+struct Target {
+    Bytes out;
+    const Bytes* base;
+    size_t largestPiece = 0;
+};
+
+static bool sink(void* ctx, const uint8_t* data, size_t len) {
+    Target* t = (Target*)ctx;
+    t->out.insert(t->out.end(), data, data + len);
+    if (len > t->largestPiece) t->largestPiece = len;
+    return true;
+}
+
+static bool readBase(void* ctx, uint32_t offset, uint8_t* out, size_t len) {
+    Target* t = (Target*)ctx;
+    if (offset + len > t->base->size()) return false;
+    memcpy(out, t->base->data() + offset, len);
+    return true;
+}
+
+// Streams a payload through the decoder in random pieces; false if it fails
+static bool decode(OtaImageDecoder::Format format, const Bytes& payload, const Bytes& base, uint32_t baseSize,
+                   Target& t, const char** error = nullptr) {
+    static OtaImageDecoder decoder;
+    t.out.clear();
+    t.base = &base;
+    t.largestPiece = 0;
+    bool ok = decoder.begin(format, sink, readBase, &t, baseSize);
+    for (size_t pos = 0; ok && pos < payload.size();) {
+        size_t n = 1 + nextRandom() % 3000;
+        if (n > payload.size() - pos) n = payload.size() - pos;
+        ok = decoder.write(payload.data() + pos, n);
+        pos += n;
+    }
+    ok = ok && decoder.finish();
+    if (!ok) decoder.end();
+    if (error) *error = decoder.error();
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    Bytes oldImage, newImage;
+    if (argc == 3) {
+        oldImage = readFile(argv[1]);
+        newImage = readFile(argv[2]);
+        if (oldImage.empty() || newImage.empty()) {
+            printf("cannot read %s or %s\n", argv[1], argv[2]);
+            return 1;
+        }
+    } else {
+        oldImage = synthesizeFirmware(300000, 1000000, 0);
+        newImage = synthesizeFirmware(300000, 120000, 52);
+    }
+    writeFile("/tmp/ota_check_old.bin", oldImage);
+    writeFile("/tmp/ota_check_new.bin", newImage);
+    if (system("python3 tools/ota_image.py zlib /tmp/ota_check_new.bin /tmp/ota_check_new.zlib") != 0 ||
+        system("python3 tools/ota_image.py patch /tmp/ota_check_old.bin /tmp/ota_check_new.bin "
+               "/tmp/ota_check_new.patch") != 0) {
+        printf("tools/ota_image.py failed\n");
+        return 1;
+    }
+    Bytes zlibImage = readFile("/tmp/ota_check_new.zlib");
+    Bytes patch = readFile("/tmp/ota_check_new.patch");
+    uint32_t baseSize = oldImage.size();
+    Target t;
+    const char* error = nullptr;
+
+    CHECK(decode(OtaImageDecoder::Raw, newImage, oldImage, baseSize, t) && t.out == newImage, "raw pass-through");
+
+    for (int round = 0; round < 5; round++) {
+        CHECK(decode(OtaImageDecoder::Zlib, zlibImage, oldImage, baseSize, t, &error),
+              "zlib round %d: %s", round, error);
+        CHECK(t.out == newImage, "zlib round %d: %zu bytes out, expected %zu", round, t.out.size(), newImage.size());
+        CHECK(decode(OtaImageDecoder::Patch, patch, oldImage, baseSize, t, &error),
+              "patch round %d: %s", round, error);
+        CHECK(t.out == newImage, "patch round %d: %zu bytes out, expected %zu", round, t.out.size(), newImage.size());
+        CHECK(t.largestPiece <= 4096, "sink got a %zu byte piece", t.largestPiece);
+    }
+    printf("zlib: %zu -> %zu bytes, patch: %zu bytes, round trips ok\n", newImage.size(), zlibImage.size(),
+           patch.size());
+
+    Bytes truncated(patch.begin(), patch.end() - 10);
+    CHECK(!decode(OtaImageDecoder::Patch, truncated, oldImage, baseSize, t, &error), "truncated patch accepted");
+    printf("truncated: %s\n", error);
+
+    Bytes trailing = zlibImage;
+    trailing.push_back(0);
+    CHECK(!decode(OtaImageDecoder::Zlib, trailing, oldImage, baseSize, t, &error), "trailing data accepted");
+    printf("trailing data: %s\n", error);
+
+    Bytes corrupt = zlibImage;
+    corrupt[corrupt.size() / 2] ^= 0x55;
+    bool ok = decode(OtaImageDecoder::Zlib, corrupt, oldImage, baseSize, t, &error);
+    CHECK(!ok, "corrupt zlib image accepted (%zu bytes out)", t.out.size());
+    printf("corrupt: %s\n", error);
+
+    // The device checks the base hash first; without it the output is wrong, not silently right
+    Bytes wrongBase = oldImage;
+    for (size_t i = 0; i < wrongBase.size(); i += 997) wrongBase[i] ^= 0xFF;
+    decode(OtaImageDecoder::Patch, patch, wrongBase, baseSize, t);
+    CHECK(t.out != newImage, "patch applied to the wrong base reproduced the image");
+
+    CHECK(!decode(OtaImageDecoder::Patch, patch, oldImage, baseSize / 2, t, &error), "patch read past a short base");
+    printf("short base: %s\n", error);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
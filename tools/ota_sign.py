@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Sign firmware images for the streaming OTA update (include/ota_pipeline.h).
+
+    python3 tools/ota_sign.py keygen [ota_private.pem]
+        Creates an ECDSA P-256 key pair and writes the public half into
+        include/ota_key.h, so the next build only accepts images signed with it.
+
+    python3 tools/ota_sign.py sign firmware.bin [ota_private.pem] [version]
+                              [--zlib | --base old.bin]
+        Writes firmware.bin.manifest with the image size and SHA-256, signed
+        with the key if one is given. Upload the manifest and the image
+        together on the device's /ota page. With --zlib the image is deflated,
+        with --base it becomes a patch against old.bin, the firmware the
+        device runs now (tools/ota_image.py); either way the upload is
+        firmware.bin.zota instead of firmware.bin.
+
+Uses the openssl command line tool for the key and signature.
+"""
+
+import argparse
+import hashlib
+import os
+import subprocess
+import sys
+
+import ota_image
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+KEY_HEADER = os.path.join(ROOT, "include", "ota_key.h")
+DEFAULT_KEY = "ota_private.pem"
+
+
+def firmware_version():
+    with open(os.path.join(ROOT, "src", "main.cpp")) as f:
+        for line in f:
+            if line.startswith("#define FIRMWARE_VERSION"):
+                return line.split('"')[1]
+    return "unknown"
+
+
+def keygen(key_path):
+    if os.path.exists(key_path):
+        print("%s exists, not overwriting it" % key_path)
+        return 1
+    subprocess.check_call(["openssl", "ecparam", "-name", "prime256v1", "-genkey", "-noout", "-out", key_path])
+    os.chmod(key_path, 0o600)
+    public = subprocess.check_output(["openssl", "ec", "-in", key_path, "-pubout"], stderr=subprocess.DEVNULL)
+    with open(KEY_HEADER) as f:
+        header = f.read()
+    pem = "".join('    "%s\\n"\n' % line for line in public.decode().strip().splitlines())
+    start = header.index("static const char OTA_PUBLIC_KEY_PEM[]")
+    header = header[:start] + "static const char OTA_PUBLIC_KEY_PEM[] =\n" + pem.rstrip("\n") + ";\n"
+    with open(KEY_HEADER, "w") as f:
+        f.write(header)
+    print("wrote %s and %s" % (key_path, KEY_HEADER))
+    return 0
+
+
+def sign(image_path, key_path, version, compress=False, base_path=None):
+    image = open(image_path, "rb").read()
+    if not image or image[0] != 0xE9:
+        print("%s does not look like an ESP32 application image" % image_path)
+        return 1
+    text = "zello-ota 1\nsize %d\nsha256 %s\nversion %s\n" % (
+        len(image), hashlib.sha256(image).hexdigest(), version or firmware_version())
+    if compress or base_path:
+        base = open(base_path, "rb").read() if base_path else None
+        fmt, payload = ota_image.encode(image, base)
+        text += "format %s\n" % fmt
+        if base is not None:
+            text += "base %s\nbase_size %d\n" % (hashlib.sha256(base).hexdigest(), len(base))
+        with open(image_path + ".zota", "wb") as f:
+            f.write(payload)
+        print("%s.zota: %s, %d bytes (%.1f%% of the image)" % (
+            image_path, fmt, len(payload), 100.0 * len(payload) / len(image)))
+    if key_path:
+        sig = subprocess.check_output(["openssl", "dgst", "-sha256", "-sign", key_path], input=text.encode())
+        text += "sig %s\n" % sig.hex()
+    out = image_path + ".manifest"
+    with open(out, "w") as f:
+        f.write(text)
+    print("%s: %d bytes, %s" % (out, len(image), "signed" if key_path else "unsigned"))
+    return 0
+
+
+def main():
+    args = sys.argv[1:]
+    if args[:1] == ["keygen"]:
+        return keygen(args[1] if len(args) > 1 else DEFAULT_KEY)
+    if args[:1] == ["sign"] and len(args) > 1:
+        parser = argparse.ArgumentParser(prog="ota_sign.py sign")
+        parser.add_argument("image")
+        parser.add_argument("key", nargs="?", default=DEFAULT_KEY if os.path.exists(DEFAULT_KEY) else None)
+        parser.add_argument("version", nargs="?")
+        group = parser.add_mutually_exclusive_group()
+        group.add_argument("--zlib", action="store_true")
+        group.add_argument("--base")
+        opts = parser.parse_args(args[1:])
+        return sign(opts.image, opts.key, opts.version, opts.zlib, opts.base)
+    print(__doc__)
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
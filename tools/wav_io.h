@@ -0,0 +1,98 @@
+#pragma once
+
+// Shared by the host audio checks (tools/noise_suppressor_check.cpp,
+// tools/echo_canceller_check.cpp): 16 kHz mono 16-bit WAV files in and out,
+// a repeatable noise source, and the energy and level helpers they report with.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define WAV_RATE 16000
+
+typedef std::vector<int16_t> Pcm;
+
+// Uniform in [0, 1); the same sequence on every run
+inline double uniform() {
+    static uint32_t rng = 1;
+    rng = rng * 1103515245u + 12345u;
+    return (rng >> 8) / 16777216.0;
+}
+
+inline double gaussian() {
+    double u = uniform() + 1e-12, v = uniform();
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+inline uint32_t readLe(const uint8_t* p, int bytes) {
+    uint32_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// False unless the file is PCM, mono, WAV_RATE and 16-bit
+inline bool readWav(const char* path, Pcm& pcm) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    fclose(f);
+    if (data.size() < 12 || memcmp(&data[0], "RIFF", 4) || memcmp(&data[8], "WAVE", 4)) return false;
+    bool formatOk = false;
+    for (size_t pos = 12; pos + 8 <= data.size();) {
+        uint32_t size = readLe(&data[pos + 4], 4);
+        const uint8_t* body = &data[pos + 8];
+        if (!memcmp(&data[pos], "fmt ", 4) && size >= 16) {
+            formatOk = readLe(body, 2) == 1 && readLe(body + 2, 2) == 1 &&
+                       readLe(body + 4, 4) == WAV_RATE && readLe(body + 14, 2) == 16;
+        } else if (!memcmp(&data[pos], "data", 4)) {
+            if (!formatOk) return false;
+            size_t bytes = size < data.size() - pos - 8 ? size : data.size() - pos - 8;
+            pcm.resize(bytes / 2);
+            for (size_t i = 0; i < pcm.size(); i++) pcm[i] = (int16_t)readLe(body + i * 2, 2);
+            return true;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+inline void writeLe(FILE* f, uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) fputc((v >> (8 * i)) & 0xff, f);
+}
+
+inline bool writeWav(const char* path, const Pcm& pcm) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    uint32_t bytes = pcm.size() * 2;
+    fwrite("RIFF", 1, 4, f);
+    writeLe(f, 36 + bytes, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    writeLe(f, 16, 4);
+    writeLe(f, 1, 2);
+    writeLe(f, 1, 2);
+    writeLe(f, WAV_RATE, 4);
+    writeLe(f, WAV_RATE * 2, 4);
+    writeLe(f, 2, 2);
+    writeLe(f, 16, 2);
+    fwrite("data", 1, 4, f);
+    writeLe(f, bytes, 4);
+    for (int16_t s : pcm) writeLe(f, (uint16_t)s, 2);
+    fclose(f);
+    return true;
+}
+
+// Sum of squares over [from, from + n), clipped to the signal
+inline double energy(const Pcm& pcm, size_t from, size_t n) {
+    double e = 0;
+    for (size_t i = from; i < from + n && i < pcm.size(); i++) e += (double)pcm[i] * pcm[i];
+    return e;
+}
+
+inline double dB(double ratio) { return 10 * log10(ratio > 1e-12 ? ratio : 1e-12); }
+
+inline int16_t saturate(double v) { return v > 32767 ? 32767 : v < -32768 ? -32768 : (int16_t)lrint(v); }
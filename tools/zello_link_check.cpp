@@ -0,0 +1,489 @@
+/*
+ * Zello Link Check
+ *
+ * Host-side end-to-end check of the client's Zello path against
+ * tools/zello_sim.py. Encodes two talkers to Ogg Opus, starts the stand-in on
+ * them (plain ws://, overlapping messages on two channels) and logs on over a
+ * real WebSocket. Received messages go through include/zello_protocol.h as in
+ * the firmware's onMessageCallback, into the decoder pool of
+ * include/channel_mixer.h, and are mixed out in 10 ms blocks through
+ * include/output_gain.h on the wall clock, as the playback task does. While
+ * the replay runs it transmits one framed over. It checks that:
+ *   - the logon is answered and every channel reports its status;
+ *   - every announced stream gets a mixer slot, carries a 16 kHz / 20 ms codec
+ *     header and increasing packet ids, and decodes every packet it sent;
+ *   - the mixed output holds both talkers, overlapped, and the mixer drains
+ *     once they stop;
+ *   - the stand-in accepts the transmission (stream id from the start_stream
+ *     reply, increasing packet ids, matching stop_stream) and exits cleanly.
+ *
+ *   g++ -std=c++11 -Iinclude tools/zello_link_check.cpp $(pkg-config --cflags --libs opus) -o zello_link_check
+ *   ./zello_link_check [tools/zello_sim.py]
+ *
+ * Needs python3 on the PATH; the stand-in's log is echoed as it runs.
+ */
+
+#include <arpa/inet.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "channel_mixer.h"
+#include "ogg_opus_muxer.h"
+#include "output_gain.h"
+#include "zello_protocol.h"
+
+uint32_t millis() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                          \
+    do {                                          \
+        if (!(cond)) {                            \
+            printf("FAIL line %d: ", __LINE__);   \
+            printf(__VA_ARGS__);                  \
+            printf("\n");                         \
+            failures++;                           \
+        }                                         \
+    } while (0)
+
+#define TALK_FRAMES 100          // 2 s per talker
+#define TX_FRAMES 25             // the over the check transmits, 0.5 s
+#define RUN_TIMEOUT_MS 30000
+
+// --- Captures ---------------------------------------------------------------
+
+struct FileSink : OggPageSink {
+    FILE* f;
+    bool writePage(const uint8_t* header, size_t headerLen, const uint8_t* body, size_t bodyLen) override {
+        return fwrite(header, 1, headerLen, f) == headerLen && fwrite(body, 1, bodyLen, f) == bodyLen;
+    }
+};
+
+// One 20 ms frame of a talker: a tone per talker with a syllable-rate envelope
+static void talkerFrame(int index, int frame, int16_t* pcm) {
+    for (int i = 0; i < 320; i++) {
+        double t = (frame * 320 + i) / (double)PLAYBACK_SAMPLE_RATE;
+        double env = 0.6 + 0.4 * sin(t * 2 * M_PI * 3);
+        pcm[i] = (int16_t)(6000 * env * sin(t * 2 * M_PI * (220 + 110 * index)));
+    }
+}
+
+static bool writeTalker(const char* path, int index) {
+    static OggOpusMuxer muxer;
+    FileSink sink;
+    sink.f = fopen(path, "wb");
+    if (!sink.f) return false;
+    int err;
+    OpusEncoder* enc = opus_encoder_create(PLAYBACK_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(16000));
+    bool ok = muxer.begin(&sink, 1 + index, PLAYBACK_SAMPLE_RATE);
+    for (int f = 0; ok && f < TALK_FRAMES; f++) {
+        int16_t pcm[320];
+        uint8_t packet[400];
+        talkerFrame(index, f, pcm);
+        int len = opus_encode(enc, pcm, 320, packet, sizeof(packet));
+        ok = len > 0 && muxer.writePacket(packet, len);
+    }
+    ok = ok && muxer.end();
+    opus_encoder_destroy(enc);
+    return fclose(sink.f) == 0 && ok;
+}
+
+// --- WebSocket client (RFC 6455), just what a Zello session needs -------------
+
+enum { OP_TEXT = 0x1, OP_BINARY = 0x2, OP_CLOSE = 0x8, OP_PING = 0x9, OP_PONG = 0xA };
+
+static bool sendAll(int fd, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Client frames are masked; the key does not need to be random here
+static bool sendFrame(int fd, int opcode, const void* payload, size_t len) {
+    std::vector<uint8_t> f;
+    f.push_back(0x80 | opcode);
+    if (len < 126) {
+        f.push_back(0x80 | len);
+    } else {
+        f.push_back(0x80 | 126);
+        f.push_back(len >> 8);
+        f.push_back(len & 0xFF);
+    }
+    static const uint8_t key[4] = {0x12, 0x34, 0x56, 0x78};
+    f.insert(f.end(), key, key + 4);
+    for (size_t i = 0; i < len; i++) f.push_back(((const uint8_t*)payload)[i] ^ key[i & 3]);
+    return sendAll(fd, f.data(), f.size());
+}
+
+static bool sendText(int fd, const char* text) { return sendFrame(fd, OP_TEXT, text, strlen(text)); }
+
+// Reassembles server frames from whatever recv() returned
+struct FrameReader {
+    std::vector<uint8_t> buf;
+
+    // Next complete frame; false until one has arrived. The server does not fragment.
+    bool next(int& opcode, std::vector<uint8_t>& payload) {
+        if (buf.size() < 2) return false;
+        size_t len = buf[1] & 0x7F, pos = 2;
+        if (len == 126) {
+            if (buf.size() < 4) return false;
+            len = (buf[2] << 8) | buf[3];
+            pos = 4;
+        } else if (len == 127) {
+            if (buf.size() < 10) return false;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = (len << 8) | buf[2 + i];
+            pos = 10;
+        }
+        if (buf.size() < pos + len) return false;
+        opcode = buf[0] & 0x0F;
+        payload.assign(buf.begin() + pos, buf.begin() + pos + len);
+        buf.erase(buf.begin(), buf.begin() + pos + len);
+        return true;
+    }
+};
+
+static int connectTo(uint16_t port) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (uint32_t start = millis(); millis() - start < 10000; usleep(100000)) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        close(fd);
+    }
+    return -1;
+}
+
+static bool handshake(int fd, uint16_t port) {
+    char request[256];
+    snprintf(request, sizeof(request),
+             "GET /ws HTTP/1.1\r\nHost: 127.0.0.1:%u\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+             "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+             (unsigned)port);
+    if (!sendAll(fd, request, strlen(request))) return false;
+    std::string response;
+    char c;
+    while (response.find("\r\n\r\n") == std::string::npos && recv(fd, &c, 1, 0) == 1) response += c;
+    return response.compare(0, 12, "HTTP/1.1 101") == 0;
+}
+
+static uint16_t freePort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    getsockname(fd, (sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// --- The client side, as in src/main.cpp ---------------------------------------
+
+struct StreamLog {
+    std::string talker, channel;
+    ZelloCodecHeader codec;
+    bool codecOk = false;
+    bool opened = false, stopped = false;
+    int packets = 0, decoded = 0, decodeErrors = 0;
+    uint32_t lastPacketId = 0;
+    bool ordered = true;
+};
+
+struct Link {
+    int fd = -1;
+    ChannelMixer mixer;
+    OutputGain gain;
+    std::map<uint32_t, StreamLog> streams;
+    std::vector<std::string> statuses;
+    bool loggedOn = false;
+    int strayPackets = 0;
+    // Transmit side, as sendTxMessages()
+    uint32_t txSeq = 1, txStartSeq = 0, txStreamId = 0, txPacketId = 0;
+    bool txStarted = false, txRefused = false, txDone = false;
+    int txFrame = 0;
+    OpusEncoder* enc = nullptr;
+    // Output, as serviceAudioOutput()
+    uint32_t playoutStartMs = 0, blocks = 0;
+    int starved = 0;
+    std::vector<int16_t> out;   // left channel of what went to "I2S"
+
+    void onMessage(const uint8_t* data, size_t len, bool binary) {
+        if (binary) {
+            ZelloPacket packet;
+            if (!zelloParsePacket(data, len, packet)) {
+                strayPackets++;
+                return;
+            }
+            std::map<uint32_t, StreamLog>::iterator it = streams.find(packet.streamId);
+            MixStream* stream = mixer.find(packet.streamId);
+            if (it == streams.end() || it->second.stopped) {
+                strayPackets++;
+                return;
+            }
+            StreamLog& s = it->second;
+            if (s.packets && packet.packetId <= s.lastPacketId) s.ordered = false;
+            s.lastPacketId = packet.packetId;
+            s.packets++;
+            if (stream && !stream->closing) {
+                int samples = mixer.decode(stream, packet.opus, packet.opusLen);
+                if (samples > 0) {
+                    s.decoded++;
+                } else {
+                    s.decodeErrors++;
+                }
+            }
+            return;
+        }
+        std::string text((const char*)data, len);
+        const char* msg = text.c_str();
+        uint32_t streamId = 0, seq = 0;
+        if (zelloIsCommand(msg, "on_stream_start") && zelloJsonUInt(msg, "stream_id", streamId)) {
+            StreamLog& s = streams[streamId];
+            char field[64];
+            zelloJsonString(msg, "from", field, sizeof(field));
+            s.talker = field;
+            zelloJsonString(msg, "channel", field, sizeof(field));
+            s.channel = field;
+            s.codecOk = zelloCodecHeader(msg, s.codec);
+            uint8_t priority = s.channel == "Main" ? 1 : 0;   // the primary channel, as channelPriority()
+            s.opened = mixer.open(streamId, priority, s.talker.c_str()) != nullptr;
+        } else if (zelloIsCommand(msg, "on_stream_stop") && zelloJsonUInt(msg, "stream_id", streamId)) {
+            streams[streamId].stopped = true;
+            mixer.close(streamId);
+        } else if (zelloIsCommand(msg, "channel_status")) {
+            char channel[64];
+            zelloJsonString(msg, "channel", channel, sizeof(channel));
+            statuses.push_back(channel);
+        } else if (zelloJsonUInt(msg, "seq", seq) && seq == 1) {
+            loggedOn = strstr(msg, "\"success\":true") != nullptr;
+            char cmd[256];
+            zelloStartStream(cmd, sizeof(cmd), ++txSeq, "Main");
+            txStartSeq = txSeq;
+            sendText(fd, cmd);
+        } else if (seq == txStartSeq && txStartSeq) {
+            txStarted = zelloStartReply(msg, txStreamId);
+            txRefused = !txStarted;
+            txStartSeq = 0;
+        }
+    }
+
+    // One 20 ms frame per call once start_stream is answered, then stop_stream
+    void transmit() {
+        if (!txStarted || txDone) return;
+        if (txFrame < TX_FRAMES) {
+            int16_t pcm[320];
+            uint8_t opus[400];
+            uint8_t packet[ZELLO_PACKET_HEADER + sizeof(opus)];
+            talkerFrame(2, txFrame++, pcm);
+            int len = opus_encode(enc, pcm, 320, opus, sizeof(opus));
+            if (len > 0) sendFrame(fd, OP_BINARY, packet, zelloFramePacket(packet, txStreamId, txPacketId++, opus, len));
+        } else {
+            char cmd[96];
+            zelloStopStream(cmd, sizeof(cmd), ++txSeq, txStreamId);
+            sendText(fd, cmd);
+            txDone = true;
+        }
+    }
+
+    // Mixes blocks until the output has caught up with the wall clock
+    void serviceOutput() {
+        if (!mixer.hasOutput() && mixer.activeCount() == 0) {
+            playoutStartMs = 0;
+            return;
+        }
+        if (playoutStartMs == 0) {
+            playoutStartMs = millis();
+            blocks = 0;
+        }
+        while ((millis() - playoutStartMs) >= blocks * (MIX_BLOCK_SAMPLES * 1000 / PLAYBACK_SAMPLE_RATE)) {
+            int16_t mono[MIX_BLOCK_SAMPLES], stereo[MIX_BLOCK_SAMPLES * 2];
+            starved += mixer.mix(mono, MIX_BLOCK_SAMPLES);
+            gain.process(mono, stereo, MIX_BLOCK_SAMPLES);
+            for (int i = 0; i < MIX_BLOCK_SAMPLES; i++) out.push_back(stereo[i * 2]);
+            blocks++;
+        }
+    }
+};
+
+// Energy of the output at a talker's frequency (Goertzel), as a fraction of the total
+static double toneShare(const std::vector<int16_t>& pcm, size_t from, size_t n, double freq) {
+    double coeff = 2 * cos(2 * M_PI * freq / PLAYBACK_SAMPLE_RATE), s1 = 0, s2 = 0, total = 0;
+    for (size_t i = from; i < from + n && i < pcm.size(); i++) {
+        double s0 = pcm[i] + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+        total += (double)pcm[i] * pcm[i];
+    }
+    double power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+    return total > 0 ? power / (total * n / 2) : 0;
+}
+
+int main(int argc, char** argv) {
+    const char* sim = argc > 1 ? argv[1] : "tools/zello_sim.py";
+    char dir[] = "/tmp/zello_link_XXXXXX";
+    if (!mkdtemp(dir)) return 1;
+    std::string alice = std::string(dir) + "/alice.opus", bob = std::string(dir) + "/bob.opus";
+    CHECK(writeTalker(alice.c_str(), 0) && writeTalker(bob.c_str(), 1), "captures written to %s", dir);
+
+    // The stand-in, its log on a pipe
+    uint16_t port = freePort();
+    char portArg[8];
+    snprintf(portArg, sizeof(portArg), "%u", (unsigned)port);
+    int logPipe[2];
+    if (pipe(logPipe) != 0) return 1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(logPipe[1], 1);
+        dup2(logPipe[1], 2);
+        close(logPipe[0]);
+        execlp("python3", "python3", sim, "--plain", "--host", "127.0.0.1", "--port", portArg, "--gap", "-0.5",
+               alice.c_str(), bob.c_str(), (char*)nullptr);
+        perror("python3");
+        _exit(127);
+    }
+    close(logPipe[1]);
+
+    static Link link;   // mixer slots and output are large, keep them off the stack
+    link.mixer.begin();
+    link.gain.setLevel(OUTPUT_GAIN_UNITY_Q15);
+    link.gain.jump(OUTPUT_GAIN_UNITY_Q15);
+    int err;
+    link.enc = opus_encoder_create(PLAYBACK_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+    link.fd = connectTo(port);
+    CHECK(link.fd >= 0 && handshake(link.fd, port), "WebSocket to the stand-in on port %u", (unsigned)port);
+    if (link.fd >= 0) {
+        sendText(link.fd, "{\"command\":\"logon\",\"seq\":1,\"auth_token\":\"t\",\"username\":\"link-check\","
+                          "\"password\":\"p\",\"channels\":[\"Main\",\"Other\"]}");
+    }
+
+    // loop(): poll the socket, send a TX frame every 20 ms, mix every 10 ms
+    std::string simLog;
+    FrameReader reader;
+    uint32_t start = millis(), lastTx = start;
+    bool open = link.fd >= 0, logOpen = true;
+    while ((open || logOpen) && millis() - start < RUN_TIMEOUT_MS) {
+        pollfd fds[2] = {{open ? link.fd : -1, POLLIN, 0}, {logOpen ? logPipe[0] : -1, POLLIN, 0}};
+        poll(fds, 2, 5);
+        if (fds[0].revents) {
+            uint8_t buf[4096];
+            ssize_t n = recv(link.fd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                open = false;
+            } else {
+                reader.buf.insert(reader.buf.end(), buf, buf + n);
+                int opcode;
+                std::vector<uint8_t> payload;
+                while (reader.next(opcode, payload)) {
+                    if (opcode == OP_PING) {
+                        sendFrame(link.fd, OP_PONG, payload.data(), payload.size());
+                    } else if (opcode == OP_CLOSE) {
+                        sendFrame(link.fd, OP_CLOSE, payload.data(), payload.size() < 2 ? payload.size() : 2);
+                        open = false;
+                    } else {
+                        link.onMessage(payload.data(), payload.size(), opcode == OP_BINARY);
+                    }
+                }
+            }
+        }
+        if (fds[1].revents) {
+            char buf[1024];
+            ssize_t n = read(logPipe[0], buf, sizeof(buf));
+            if (n <= 0) {
+                logOpen = false;
+            } else {
+                simLog.append(buf, n);
+                fwrite(buf, 1, n, stdout);   // lines already carry the stand-in's timestamps
+            }
+        }
+        if (open && millis() - lastTx >= ZELLO_TX_PACKET_MS) {
+            lastTx += ZELLO_TX_PACKET_MS;
+            link.transmit();
+        }
+        link.serviceOutput();
+    }
+    if (link.fd >= 0) close(link.fd);
+    if (logOpen) kill(pid, SIGTERM);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    unlink(alice.c_str());
+    unlink(bob.c_str());
+    rmdir(dir);
+
+    CHECK(link.loggedOn, "logon answered");
+    CHECK(link.statuses.size() == 2 && link.statuses[0] == "Main" && link.statuses[1] == "Other",
+          "channel_status for each channel");
+    CHECK(link.streams.size() == 2, "%zu streams announced", link.streams.size());
+    for (std::map<uint32_t, StreamLog>::iterator it = link.streams.begin(); it != link.streams.end(); ++it) {
+        const StreamLog& s = it->second;
+        printf("stream %u from %s on %s: %d packets, %d decoded\n", (unsigned)it->first, s.talker.c_str(),
+               s.channel.c_str(), s.packets, s.decoded);
+        CHECK(s.opened && s.stopped, "stream %u opened and stopped", (unsigned)it->first);
+        CHECK(s.codecOk && s.codec.sampleRate == 16000 && s.codec.framesPerPacket == 1 && s.codec.frameMs == 20,
+              "stream %u codec header", (unsigned)it->first);
+        CHECK(s.ordered, "stream %u packet ids increase", (unsigned)it->first);
+        CHECK(s.packets == TALK_FRAMES && s.decoded == TALK_FRAMES && s.decodeErrors == 0,
+              "stream %u: %d of %d packets decoded, %d errors", (unsigned)it->first, s.decoded, TALK_FRAMES,
+              s.decodeErrors);
+    }
+    CHECK(link.strayPackets == 0, "%d packets outside a stream", link.strayPackets);
+    CHECK(link.streams.size() < 2 || link.streams.begin()->second.channel != link.streams.rbegin()->second.channel,
+          "overlapping messages on both channels");
+
+    // Both talkers come out of the mix, overlapped, and the mixer drains once they have played
+    size_t n = link.out.size();
+    double share0 = toneShare(link.out, 0, n, 220), share1 = toneShare(link.out, 0, n, 330);
+    printf("output: %.2f s mixed, %d blocks starved; talker tones %.0f%% and %.0f%% of the energy\n",
+           n / (double)PLAYBACK_SAMPLE_RATE, link.starved, share0 * 100, share1 * 100);
+    // 2 s each, the second starting 0.5 s before the first ends
+    CHECK(n > PLAYBACK_SAMPLE_RATE * 3.3 && n < PLAYBACK_SAMPLE_RATE * 4, "%zu samples mixed", n);
+    CHECK(share0 > 0.1 && share1 > 0.1, "both talkers in the output");
+    CHECK(!link.mixer.hasOutput() && link.mixer.activeCount() == 0, "mixer drained after the last stream");
+
+    // The stand-in's verdict on the transmission
+    char sent[64];
+    snprintf(sent, sizeof(sent), "device transmitted %d packets", TX_FRAMES);
+    CHECK(link.txStarted && !link.txRefused && link.txDone, "over transmitted");
+    CHECK(simLog.find(sent) != std::string::npos, "stand-in received the whole over");
+    CHECK(simLog.find("TX ERROR") == std::string::npos, "stand-in accepted the TX framing");
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "stand-in exit status %d", WEXITSTATUS(status));
+
+    opus_encoder_destroy(link.enc);
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
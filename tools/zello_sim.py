@@ -0,0 +1,664 @@
+#!/usr/bin/env python3
+"""
+Zello Stand-in Server
+
+A local replacement for wss://zello.io/ws that replays captured sessions, so the
+firmware can be run end to end, soaked and measured without the real service.
+It speaks the part of the Zello channel API the firmware uses: logon, then
+channel_status, on_stream_start / binary audio / on_stream_stop for every
+captured message, and start_stream / binary / stop_stream from the device's PTT,
+which it stores as .opus files.
+
+Captures are recorder segments (rec0.zcap .. rec3.zcap from the device's SPIFFS,
+include/stream_recorder.h), replayed with the arrival timing they were recorded
+with, or Ogg Opus files, replayed at the packets' own duration. Impairments are
+applied on top: random lateness (in order), loss, and periodic stalls that
+deliver a burst afterwards, as a Wi-Fi outage does. A negative gap makes
+consecutive messages overlap, alternating over the channels.
+
+Point the device at it in /wifi_credentials.ini:
+
+    server=wss://192.168.1.10:8443/ws
+    server_cert=/sim.crt
+
+with the certificate (made by openssl below) uploaded to SPIFFS as /sim.crt, or
+use server=ws://... and --plain to skip TLS. With --device the device's
+/api/status counters are printed before and after the run.
+
+    openssl req -x509 -newkey rsa:2048 -nodes -days 365 -keyout sim.key -out sim.crt \\
+        -subj /CN=192.168.1.10 -addext subjectAltName=IP:192.168.1.10
+    python3 tools/zello_sim.py --cert sim.crt --key sim.key --loop 0 --jitter 40 rec0.zcap
+    python3 tools/zello_sim.py --self-test
+
+--self-test runs the server against an in-process client on localhost and checks
+the protocol end to end (logon, stream framing and order, loss accounting, the
+TX path); it needs no device and no capture, so it can run in CI. Device packets
+must carry the stream id start_stream returned and increasing packet ids; any
+that do not are logged as TX errors and make the run exit with status 1.
+"""
+
+import argparse
+import asyncio
+import base64
+import hashlib
+import json
+import os
+import random
+import ssl
+import struct
+import sys
+import time
+import urllib.request
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from capsule_to_ogg import END_MARK, FOOTER, HEADER, capsule_to_ogg, packet_samples  # noqa: E402
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+OP_CONT, OP_TEXT, OP_BINARY, OP_CLOSE, OP_PING, OP_PONG = 0x0, 0x1, 0x2, 0x8, 0x9, 0xA
+RX_PACKET = TX_PACKET = 0x01   # [type][stream_id u32 BE][packet_id u32 BE][opus]
+FIRST_STREAM_ID = 1001
+
+
+# --- Captures -------------------------------------------------------------
+
+class Message:
+    """One captured transmission: talker, Zello codec header and (delay ms, packet) pairs."""
+
+    def __init__(self, talker, codec, packets):
+        self.talker = talker
+        self.codec = codec
+        self.packets = packets
+
+    def duration_ms(self):
+        return sum(packet_samples(p) for _, p in self.packets) // 48
+
+
+def codec_header(packet, rate=16000):
+    """Zello's 4-byte codec header (rate, frames per packet, frame ms) for a packet."""
+    ms = packet_samples(packet) // 48
+    code = packet[0] & 3
+    frames = 1 if code == 0 else 2 if code < 3 else (packet[1] & 0x3F if len(packet) > 1 else 1)
+    return struct.pack("<HBB", rate, frames, ms // max(frames, 1))
+
+
+def read_zcap(data):
+    """Messages of a recorder segment, with the packets' recorded arrival deltas."""
+    messages = []
+    pos = 0
+    while pos + HEADER.size <= len(data):
+        header = HEADER.unpack_from(data, pos)
+        if header[0] != b"ZCAP":
+            break
+        pos += HEADER.size
+        packets = []
+        while pos + 4 <= len(data):
+            length, delta = struct.unpack_from("<HH", data, pos)
+            if length == END_MARK:
+                pos += 2 + FOOTER.size
+                break
+            packets.append((delta, data[pos + 4:pos + 4 + length]))
+            pos += 4 + length
+        if packets:
+            talker = header[6].split(b"\0")[0].decode("utf-8", "replace")
+            codec = header[8][:header[2]] if header[2] == 4 else codec_header(packets[0][1])
+            packets[0] = (0, packets[0][1])
+            messages.append(Message(talker, codec, packets))
+    return messages
+
+
+def read_ogg(data, talker):
+    """One message from an Ogg Opus file, each packet due after the previous one's duration."""
+    packets, partial = [], b""
+    pos = 0
+    while pos + 27 <= len(data) and data[pos:pos + 4] == b"OggS":
+        segments = data[pos + 26]
+        lacing = data[pos + 27:pos + 27 + segments]
+        pos += 27 + segments
+        for n in lacing:
+            partial += data[pos:pos + n]
+            pos += n
+            if n < 255:
+                packets.append(partial)
+                partial = b""
+    audio = [p for p in packets[2:] if p]   # after OpusHead and OpusTags
+    if not audio:
+        return []
+    timed, due = [], 0
+    for p in audio:
+        timed.append((due, p))
+        due = packet_samples(p) // 48
+    return [Message(talker, codec_header(audio[0]), timed)]
+
+
+def load_captures(paths):
+    messages = []
+    for path in paths:
+        data = open(path, "rb").read()
+        if data[:4] == b"OggS":
+            messages += read_ogg(data, os.path.splitext(os.path.basename(path))[0])
+        else:
+            messages += read_zcap(data)
+    return messages
+
+
+# --- WebSocket (RFC 6455), just what a Zello session needs -----------------
+
+async def accept(reader, writer):
+    """Server side of the opening handshake; False if it was not a WebSocket request."""
+    request = await reader.readuntil(b"\r\n\r\n")
+    key = None
+    for line in request.decode("latin-1").split("\r\n")[1:]:
+        name, _, value = line.partition(":")
+        if name.strip().lower() == "sec-websocket-key":
+            key = value.strip()
+    if not key:
+        writer.write(b"HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n")
+        return False
+    accept_key = base64.b64encode(hashlib.sha1((key + WS_GUID).encode()).digest()).decode()
+    writer.write(("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  "Sec-WebSocket-Accept: %s\r\n\r\n" % accept_key).encode())
+    await writer.drain()
+    return True
+
+
+async def connect(host, port, path="/ws"):
+    """Client side, for the self-test."""
+    reader, writer = await asyncio.open_connection(host, port)
+    key = base64.b64encode(os.urandom(16)).decode()
+    writer.write(("GET %s HTTP/1.1\r\nHost: %s:%d\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % (path, host, port, key)).encode())
+    response = await reader.readuntil(b"\r\n\r\n")
+    if b" 101 " not in response.split(b"\r\n")[0]:
+        raise ConnectionError(response.split(b"\r\n")[0].decode())
+    return reader, writer
+
+
+def frame(opcode, payload, mask=False):
+    if isinstance(payload, str):
+        payload = payload.encode()
+    head = bytearray([0x80 | opcode])
+    bit = 0x80 if mask else 0
+    n = len(payload)
+    if n < 126:
+        head.append(bit | n)
+    elif n < 65536:
+        head += bytes([bit | 126]) + struct.pack(">H", n)
+    else:
+        head += bytes([bit | 127]) + struct.pack(">Q", n)
+    if mask:
+        key = os.urandom(4)
+        head += key
+        payload = bytes(b ^ key[i & 3] for i, b in enumerate(payload))
+    return bytes(head) + payload
+
+
+async def read_message(reader):
+    """Next (opcode, payload), continuation frames joined; control frames come as they arrive."""
+    opcode, data = None, b""
+    while True:
+        b0, b1 = await reader.readexactly(2)
+        n = b1 & 0x7F
+        if n == 126:
+            n = struct.unpack(">H", await reader.readexactly(2))[0]
+        elif n == 127:
+            n = struct.unpack(">Q", await reader.readexactly(8))[0]
+        key = await reader.readexactly(4) if b1 & 0x80 else None
+        payload = await reader.readexactly(n)
+        if key:
+            payload = bytes(b ^ key[i & 3] for i, b in enumerate(payload))
+        op = b0 & 0x0F
+        if op >= OP_CLOSE:
+            return op, payload
+        if op != OP_CONT:
+            opcode = op
+        data += payload
+        if b0 & 0x80:
+            return opcode, data
+
+
+# --- The stand-in server --------------------------------------------------
+
+class Impairments:
+    def __init__(self, jitter_ms=0, loss_pct=0.0, stall_ms=0, stall_every_s=0, seed=1):
+        self.jitter_ms = jitter_ms
+        self.loss_pct = loss_pct
+        self.stall_ms = stall_ms
+        self.stall_every_s = stall_every_s
+        self.random = random.Random(seed)
+
+
+class Session:
+    """One device connection: logon, the replay schedule, and the device's own transmissions."""
+
+    def __init__(self, server, reader, writer):
+        self.server = server
+        self.reader = reader
+        self.writer = writer
+        self.lock = asyncio.Lock()
+        self.tx = None
+        self.tx_count = 0
+        self.tx_stream = None   # stream id given for the open start_stream
+        self.tx_last = None     # last packet id received on it
+        self.closing = False
+        self.finished = asyncio.Event()
+
+    async def send(self, opcode, payload):
+        async with self.lock:
+            self.writer.write(frame(opcode, payload))
+            await self.writer.drain()
+
+    async def send_json(self, obj):
+        # Compact, as Zello sends it: the firmware looks fields up as "key":value
+        await self.send(OP_TEXT, json.dumps(obj, ensure_ascii=False, separators=(",", ":")))
+
+    async def close(self):
+        """Ends the session from this side (1001, going away) once the run is over."""
+        self.closing = True
+        await self.send(OP_CLOSE, struct.pack(">H", 1001))
+
+    async def run(self):
+        replay = None
+        try:
+            while True:
+                op, payload = await read_message(self.reader)
+                if op == OP_CLOSE:
+                    if not self.closing:
+                        await self.send(OP_CLOSE, payload[:2])
+                    break
+                if op == OP_PING:
+                    await self.send(OP_PONG, payload)
+                elif op == OP_TEXT:
+                    reply = await self.command(json.loads(payload.decode("utf-8")))
+                    if reply == "logon" and replay is None:
+                        replay = asyncio.ensure_future(self.server.replay(self))
+                elif op == OP_BINARY:
+                    self.packet(payload)
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            if replay:
+                replay.cancel()
+            self.writer.close()
+            self.finished.set()
+
+    def packet(self, payload):
+        if len(payload) < 9 or payload[0] != TX_PACKET:
+            self.server.tx_error("binary message of %d bytes is not an audio packet" % len(payload))
+            return
+        _, stream_id, packet_id = struct.unpack_from(">BII", payload)
+        if self.tx is None:
+            self.server.tx_error("packet %d for stream %d outside start_stream/stop_stream" % (packet_id, stream_id))
+        elif stream_id != self.tx_stream:
+            self.server.tx_error("packet %d for stream %d, start_stream gave %d" % (packet_id, stream_id,
+                                                                                   self.tx_stream))
+        elif self.tx_last is not None and packet_id <= self.tx_last:
+            self.server.tx_error("stream %d: packet id %d after %d" % (stream_id, packet_id, self.tx_last))
+        else:
+            self.tx_last = packet_id
+            self.tx.append(payload[9:])
+
+    async def command(self, msg):
+        command = msg.get("command")
+        seq = msg.get("seq")
+        if command == "logon":
+            channels = msg.get("channels") or [msg.get("channel", "")]
+            log("logon from %s on %s" % (msg.get("username", "?"), ", ".join(channels)))
+            self.server.channels = channels
+            await self.send_json({"success": True, "refresh_token": "zello-sim", "seq": seq})
+            for channel in channels:
+                await self.send_json({"command": "channel_status", "channel": channel, "status": "online",
+                                      "users_online": 2})
+            return "logon"
+        if command == "start_stream":
+            self.tx = []
+            self.tx_count += 1
+            self.tx_stream = 9000 + self.tx_count
+            self.tx_last = None
+            await self.send_json({"success": True, "stream_id": self.tx_stream, "seq": seq})
+        elif command == "stop_stream":
+            if self.tx is None or msg.get("stream_id") != self.tx_stream:
+                self.server.tx_error("stop_stream for stream %r, open stream %r" % (msg.get("stream_id"),
+                                                                                   self.tx_stream))
+            if self.tx is not None:
+                self.server.transmitted(self.tx_count, self.tx)
+            self.tx = None
+            self.tx_stream = None
+            if seq is not None:
+                await self.send_json({"success": True, "seq": seq})
+        elif seq is not None:
+            await self.send_json({"success": True, "seq": seq})
+        return command
+
+
+class Server:
+    def __init__(self, messages, loops=1, gap_s=1.0, impair=None, tx_dir=None):
+        self.messages = messages
+        self.loops = loops
+        self.gap_s = gap_s
+        self.impair = impair or Impairments()
+        self.tx_dir = tx_dir
+        self.channels = [""]
+        self.stream_id = FIRST_STREAM_ID
+        self.sent = {}          # stream id -> packets sent, for the self-test
+        self.tx_overs = []
+        self.tx_errors = []
+        self.epoch = 0.0
+        self.done = asyncio.Event()
+        self.sessions = set()
+
+    async def handle(self, reader, writer):
+        try:
+            if not await accept(reader, writer):
+                writer.close()
+                return
+        except (asyncio.IncompleteReadError, asyncio.LimitOverrunError, ConnectionError):
+            writer.close()
+            return
+        peer = writer.get_extra_info("peername")
+        log("connection from %s" % (peer[0] if peer else "?"))
+        session = Session(self, reader, writer)
+        self.sessions.add(session)
+        await session.run()
+        self.sessions.discard(session)
+        log("connection closed")
+
+    async def close_sessions(self, timeout_s=5):
+        for session in list(self.sessions):
+            try:
+                await session.close()
+            except ConnectionError:
+                pass
+        waits = [s.finished.wait() for s in self.sessions]
+        if waits:
+            try:
+                await asyncio.wait_for(asyncio.gather(*waits), timeout_s)
+            except asyncio.TimeoutError:
+                pass
+
+    async def replay(self, session):
+        """Every message once per loop (loops=0: until stopped); each starts gap_s after the last ended."""
+        await asyncio.sleep(self.gap_s if self.gap_s > 0 else 0)
+        running = []
+        start = self.epoch = time.monotonic()
+        n = 0
+        loop = 0
+        while self.loops == 0 or loop < self.loops:
+            for message in self.messages:
+                channel = self.channels[n % len(self.channels)] if self.gap_s < 0 else self.channels[0]
+                running.append(asyncio.ensure_future(self.stream(session, message, channel, start)))
+                start += message.duration_ms() / 1000.0 + self.gap_s
+                n += 1
+                await asyncio.sleep(max(0.0, start - time.monotonic()))
+            loop += 1
+        await asyncio.gather(*running)
+        log("replay finished: %d messages" % n)
+        self.done.set()
+
+    async def stream(self, session, message, channel, start):
+        stream_id = self.stream_id
+        self.stream_id += 1
+        await asyncio.sleep(max(0.0, start - time.monotonic()))
+        start_msg = {"command": "on_stream_start", "type": "audio", "codec": "opus",
+                     "codec_header": base64.b64encode(message.codec).decode(),
+                     "packet_duration": message.codec[2] * message.codec[3] if len(message.codec) == 4 else 20,
+                     "stream_id": stream_id, "from": message.talker}
+        if channel:
+            start_msg["channel"] = channel
+        await session.send_json(start_msg)
+        imp = self.impair
+        due = send_at = time.monotonic()
+        sent = dropped = 0
+        for packet_id, (delay_ms, packet) in enumerate(message.packets):
+            due += delay_ms / 1000.0
+            at = due + imp.random.uniform(0, imp.jitter_ms) / 1000.0
+            if imp.stall_ms and imp.stall_every_s:
+                # Stalls are on the server's clock, so they hit every stream at once
+                phase = (due - self.epoch) % imp.stall_every_s
+                if phase < imp.stall_ms / 1000.0:
+                    at = max(at, due - phase + imp.stall_ms / 1000.0)   # held back, then sent in a burst
+            send_at = max(send_at, at)                                  # late, never reordered
+            if imp.loss_pct and imp.random.random() * 100 < imp.loss_pct:
+                dropped += 1
+                continue
+            await asyncio.sleep(max(0.0, send_at - time.monotonic()))
+            await session.send(OP_BINARY, struct.pack(">BII", RX_PACKET, stream_id, packet_id) + packet)
+            sent += 1
+        await session.send_json({"command": "on_stream_stop", "stream_id": stream_id})
+        self.sent[stream_id] = sent
+        log("stream %d from %s%s: %d packets, %.1f s, %d dropped" % (
+            stream_id, message.talker, " on " + channel if channel else "", sent,
+            message.duration_ms() / 1000.0, dropped))
+
+    def transmitted(self, n, packets):
+        duration = sum(packet_samples(p) for p in packets if p) / 48000.0
+        self.tx_overs.append(len(packets))
+        log("device transmitted %d packets, %.1f s" % (len(packets), duration))
+        if self.tx_dir and packets:
+            header = (b"ZCAP", 1, 4, 0, n, 0, b"device", b"", struct.pack("<HBB", 16000, 1, 20))
+            path = os.path.join(self.tx_dir, "tx_%d.opus" % n)
+            with open(path, "wb") as f:
+                f.write(capsule_to_ogg(header, [p for p in packets if p]))
+            log("  saved %s" % path)
+
+
+    def tx_error(self, text):
+        self.tx_errors.append(text)
+        log("TX ERROR: " + text)
+
+
+def log(text):
+    print("[%s] %s" % (time.strftime("%H:%M:%S"), text), flush=True)
+
+
+# --- Device counters --------------------------------------------------------
+
+def device_status(host):
+    with urllib.request.urlopen("http://%s/api/status" % host, timeout=5) as r:
+        return json.load(r)
+
+
+def report_device(before, after):
+    print("device: %d underruns, %d I2S underruns, %d reconnects; drift %+d ppm" % (
+        after["underruns"] - before["underruns"], after["i2sUnderruns"] - before["i2sUnderruns"],
+        after["reconnects"] - before["reconnects"], after.get("driftPpm", 0)))
+    for key in ("arrival", "decode", "i2s"):
+        if key in after.get("lat", {}):
+            print("  %-8s p50 %6d us  p99 %6d us" % (key, after["lat"][key][0], after["lat"][key][1]))
+
+
+# --- Self-test ----------------------------------------------------------------
+
+SILENCE = bytes([0xF8, 0xFF, 0xFE])   # CELT 20 ms, the packet encoders send for silence
+
+
+def synthetic_capture():
+    """Two short messages of silence packets, 20 ms apart, as a recorder segment would hold them."""
+    data = b""
+    for seq, (talker, count) in enumerate((("alice", 40), ("bob", 25)), 1):
+        data += HEADER.pack(b"ZCAP", 1, 4, 0, seq, 0, talker.encode(), str(seq).encode(),
+                            struct.pack("<HBB", 16000, 1, 20))
+        for i in range(count):
+            data += struct.pack("<HH", len(SILENCE), 0 if i == 0 else 20) + SILENCE
+        data += struct.pack("<H", END_MARK) + FOOTER.pack(count, count * 20)
+    return data
+
+
+async def self_test():
+    failures = []
+
+    def check(cond, text):
+        if not cond:
+            failures.append(text)
+            print("FAIL: " + text)
+
+    messages = read_zcap(synthetic_capture())
+    check(len(messages) == 2 and len(messages[0].packets) == 40, "synthetic capture read back")
+    check(messages[0].duration_ms() == 800, "message duration %d ms" % messages[0].duration_ms())
+    ogg = capsule_to_ogg((b"ZCAP", 1, 4, 0, 1, 0, b"", b"", struct.pack("<HBB", 16000, 1, 20)),
+                         [p for _, p in messages[0].packets])
+    from_ogg = read_ogg(ogg, "ogg")
+    check(len(from_ogg) == 1 and len(from_ogg[0].packets) == 40 and from_ogg[0].packets[1][0] == 20,
+          "Ogg Opus capture read back")
+
+    server = Server(messages, loops=2, gap_s=-0.2, impair=Impairments(jitter_ms=30, loss_pct=10, seed=7))
+    listener = await asyncio.start_server(server.handle, "127.0.0.1", 0)
+    port = listener.sockets[0].getsockname()[1]
+    reader, writer = await connect("127.0.0.1", port)
+    writer.write(frame(OP_TEXT, json.dumps({"command": "logon", "seq": 1, "auth_token": "t", "username": "u",
+                                            "password": "p", "channels": ["Main", "Other"]}), mask=True))
+    writer.write(frame(OP_PING, b"hi", mask=True))
+    # The device transmits twice while the replay runs: once framed as the firmware does, with
+    # the stream id from the start_stream reply, then with a wrong stream id and a repeated packet id
+    writer.write(frame(OP_TEXT, json.dumps({"command": "start_stream", "seq": 2, "channel": "Main"}), mask=True))
+    await writer.drain()
+
+    def transmit(stream_id, packets, stop_seq):
+        for sid, packet_id in packets:
+            writer.write(frame(OP_BINARY, struct.pack(">BII", TX_PACKET, sid, packet_id) + SILENCE, mask=True))
+        writer.write(frame(OP_TEXT, json.dumps({"command": "stop_stream", "seq": stop_seq,
+                                                "stream_id": stream_id}), mask=True))
+
+    replies, statuses, pongs = {}, [], 0
+    streams = {}    # id -> {"channel", "ids", "stopped"}
+    order_ok = compact = True
+    while not (len(streams) == 4 and all(s["stopped"] for s in streams.values()) and 5 in replies):
+        op, payload = await asyncio.wait_for(read_message(reader), 10)
+        if op == OP_PONG:
+            pongs += 1
+        elif op == OP_TEXT:
+            compact &= b'": ' not in payload and b'", "' not in payload
+            msg = json.loads(payload)
+            if "seq" in msg:
+                replies[msg["seq"]] = msg
+                tx_stream = msg.get("stream_id")
+                if msg["seq"] == 2 and tx_stream is not None:
+                    transmit(tx_stream, [(tx_stream, i) for i in range(10)], 3)
+                    writer.write(frame(OP_TEXT, json.dumps({"command": "start_stream", "seq": 4,
+                                                            "channel": "Main"}), mask=True))
+                elif msg["seq"] == 4 and tx_stream is not None:
+                    transmit(tx_stream, [(tx_stream, 5), (tx_stream + 1, 6), (tx_stream, 5)], 5)
+                await writer.drain()
+            elif msg.get("command") == "channel_status":
+                statuses.append(msg["channel"])
+            elif msg.get("command") == "on_stream_start":
+                codec = base64.b64decode(msg["codec_header"])
+                check(codec == struct.pack("<HBB", 16000, 1, 20), "codec header %r" % codec)
+                streams[msg["stream_id"]] = {"channel": msg.get("channel"), "ids": [], "stopped": False}
+            elif msg.get("command") == "on_stream_stop":
+                streams[msg["stream_id"]]["stopped"] = True
+        elif op == OP_BINARY:
+            kind, stream_id, packet_id = struct.unpack_from(">BII", payload)
+            check(kind == RX_PACKET and stream_id in streams, "packet for an unannounced stream %d" % stream_id)
+            s = streams.get(stream_id)
+            if s:
+                check(not s["stopped"], "packet after on_stream_stop")
+                order_ok &= not s["ids"] or packet_id > s["ids"][-1]
+                s["ids"].append(packet_id)
+                check(payload[9:] == SILENCE, "payload intact")
+    await asyncio.wait_for(server.done.wait(), 5)
+    writer.write(frame(OP_CLOSE, struct.pack(">H", 1000), mask=True))
+    op, _ = await asyncio.wait_for(read_message(reader), 5)
+    check(op == OP_CLOSE, "close answered")
+    writer.close()
+    await writer.wait_closed()
+    listener.close()
+    await listener.wait_closed()
+
+    check(replies.get(1, {}).get("success") is True, "logon answered")
+    check(replies.get(2, {}).get("stream_id") is not None, "start_stream answered with a stream id")
+    check(statuses == ["Main", "Other"], "channel_status for each channel: %r" % statuses)
+    check(pongs == 1, "ping answered")
+    check(compact, "JSON sent compact, as Zello does")
+    check(order_ok, "packets in order")
+    check(sorted(streams) == list(range(FIRST_STREAM_ID, FIRST_STREAM_ID + 4)), "four streams in two loops")
+    check([s["channel"] for _, s in sorted(streams.items())] == ["Main", "Other", "Main", "Other"],
+          "overlapping messages alternate channels")
+    for stream_id, s in streams.items():
+        check(len(s["ids"]) == server.sent.get(stream_id), "stream %d: %d received, %d sent" % (
+            stream_id, len(s["ids"]), server.sent.get(stream_id, -1)))
+    total = sum(len(m.packets) for m in messages) * 2
+    received = sum(len(s["ids"]) for s in streams.values())
+    check(total * 0.8 < received < total, "about 10%% lost: %d of %d" % (received, total))
+    check(server.tx_overs == [10, 1], "device transmissions recorded: %r" % server.tx_overs)
+    check(len(server.tx_errors) == 2 and "start_stream gave" in server.tx_errors[0]
+          and "packet id 5 after 5" in server.tx_errors[1], "bad TX framing reported: %r" % server.tx_errors)
+
+    if failures:
+        print("%d failures" % len(failures))
+        return 1
+    print("all checks passed")
+    return 0
+
+
+# --- Main -------------------------------------------------------------------
+
+def main():
+    parser = argparse.ArgumentParser(description="Local Zello stand-in server replaying captured sessions")
+    parser.add_argument("captures", nargs="*", help="recorder segments (.zcap) or Ogg Opus files")
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert", help="TLS certificate (PEM); the device needs it as server_cert")
+    parser.add_argument("--key", help="TLS private key (PEM)")
+    parser.add_argument("--plain", action="store_true", help="no TLS: the device uses server=ws://...")
+    parser.add_argument("--loop", type=int, default=1, help="times to replay the captures, 0 = until stopped")
+    parser.add_argument("--gap", type=float, default=1.0,
+                        help="seconds between messages; negative overlaps them, alternating channels")
+    parser.add_argument("--jitter", type=float, default=0, help="packets up to this many ms late, in order")
+    parser.add_argument("--loss", type=float, default=0, help="percent of packets dropped")
+    parser.add_argument("--stall", default="", help="MS:EVERY_S, hold packets back MS every EVERY_S seconds")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--nominal", action="store_true", help="ignore recorded timing, send at packet duration")
+    parser.add_argument("--tx-dir", help="save the device's transmissions here as .opus")
+    parser.add_argument("--device", help="device IP: print its counters before and after the replay")
+    parser.add_argument("--self-test", action="store_true", help="check the protocol against a local client")
+    args = parser.parse_args()
+
+    if args.self_test:
+        return asyncio.run(self_test())
+    if not args.captures:
+        parser.print_help()
+        return 1
+    messages = load_captures(args.captures)
+    if not messages:
+        print("no messages in the captures")
+        return 1
+    if args.nominal:
+        for m in messages:
+            m.packets = [(0 if i == 0 else packet_samples(m.packets[i - 1][1]) // 48, p)
+                         for i, (_, p) in enumerate(m.packets)]
+    stall_ms, _, stall_every = args.stall.partition(":")
+    impair = Impairments(args.jitter, args.loss, int(stall_ms or 0), float(stall_every or 0), args.seed)
+    print("%d messages, %.1f s of audio" % (len(messages), sum(m.duration_ms() for m in messages) / 1000.0))
+
+    context = None
+    if not args.plain:
+        if not args.cert or not args.key:
+            print("--cert and --key are needed for wss://, or --plain for ws://")
+            return 1
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.cert, args.key)
+
+    async def serve():
+        server = Server(messages, args.loop, args.gap, impair, args.tx_dir)
+        before = device_status(args.device) if args.device else None
+        listener = await asyncio.start_server(server.handle, args.host, args.port, ssl=context)
+        log("listening on %s://%s:%d/ws" % ("ws" if args.plain else "wss", args.host, args.port))
+        async with listener:
+            await server.done.wait()
+            await asyncio.sleep(2)   # let the device play out the last message
+            await server.close_sessions()
+        if before:
+            report_device(before, device_status(args.device))
+        if server.tx_errors:
+            print("%d malformed device transmissions" % len(server.tx_errors))
+            return 1
+        return 0
+
+    try:
+        return asyncio.run(serve())
+    except KeyboardInterrupt:
+        return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,200 @@
+// Dashboard logic: the page itself is static. Live values are pushed as JSON deltas
+// over Server-Sent Events (/events); the slow-changing rest comes from /api/status.
+var PROFILES = ['None', 'Voice', 'Music'];
+var state = {};
+var pollTimer = null;
+
+function $(id) { return document.getElementById(id); }
+function set(id, v) { $(id).textContent = v; }
+
+function has(k) { return state[k] !== undefined; }
+
+function render() {
+  var s = state;
+  if (has('uptime')) {
+    set('uptime', s.uptime + ' seconds');
+    set('heapTotal', s.heapTotal + ' bytes');
+    set('flash', s.flash + ' bytes');
+    set('sketchFree', s.sketchFree + ' bytes');
+    set('sdk', s.sdk);
+    set('fw', s.fw);
+    set('httpCost', s.http.apiUs + ' us / ' + s.http.apiHeap + ' B heap');
+    set('ssid', s.ssid);
+    set('ip', s.ip);
+    set('mac', s.mac);
+    set('gw', s.gw);
+    set('channel', s.channel + (s.channel.indexOf(', ') >= 0 ? (s.preempt ? ' (pre-empt)' : ' (ducking)') : '') +
+      (s.overlap && s.overlap !== 'mix' ? ', overlap: ' + s.overlap : ''));
+    set('enhance', s.enhance ? 'ON' : 'OFF');
+    set('agc', s.agc ? 'ON' : 'OFF');
+    set('ns', s.ns ? 'ON' : 'OFF');
+    set('roger', s.roger ? 'ON' : 'OFF');
+    set('profile', PROFILES[s.profile] || '?');
+    set('packets', s.packets);
+    set('underruns', s.underruns + ' (I2S ' + s.i2sUnderruns + ')');
+    set('drift', (s.driftPpm > 0 ? '+' : '') + s.driftPpm + ' ppm');
+    set('dma', s.dmaCount + ' x ' + s.dmaFrames + ' frames (' + Math.round(s.dmaCount * s.dmaFrames / 16) + ' ms)');
+    set('streamTime', (s.streamMs / 1000).toFixed(1) + ' sec (' + (s.stream ? 'active' : 'ended') + ')');
+    for (var k in s.lat) set('lat-' + k, s.lat[k][0] + ' / ' + s.lat[k][1] + ' us');
+    set('jitterUs', s.jitterUs + ' us');
+    set('reconnects', s.reconnects);
+    set('heapMin', s.heapMin + ' bytes');
+    set('enhanceBtn', s.enhance ? 'Enhancement OFF' : 'Enhancement ON');
+    set('agcBtn', s.agc ? 'AGC OFF' : 'AGC ON');
+    set('nsBtn', s.ns ? 'Noise Suppression OFF' : 'Noise Suppression ON');
+    set('rogerBtn', s.roger ? 'Roger Beep OFF' : 'Roger Beep ON');
+    set('profileBtn', 'Next Profile (' + (PROFILES[s.profile] || '?') + ')');
+    set('record', s.record ? 'ON (write amplification ' + (s.recAmp / 100).toFixed(2) + 'x)' : 'OFF');
+    set('recordBtn', s.record ? 'Recording OFF' : 'Recording ON');
+    set('replay', s.replay >= 0
+      ? 'Message ' + (s.replay + 1) + ' of ' + s.hist + ' (' + s.replayTalker + ') at ' + s.replaySpeed / 100 + 'x'
+      : 'Idle, ' + s.hist + ' stored');
+    set('speedBtn', 'Replay Speed ' + s.replaySpeed / 100 + 'x');
+    set('dmaBtn', 'Output Buffers: ' + s.dmaCount);
+  }
+  if (has('heapKb')) set('heap', s.heapKb + ' KB');
+  else if (has('heap')) set('heap', s.heap + ' bytes');
+  if (has('rssi')) set('rssi', s.rssi + ' dBm');
+  if (has('volume')) {
+    set('volume', s.volume + '/63 (' + Math.floor(s.volume * 100 / 63) + '%)' + (s.muted ? ', muted' : ''));
+    set('muteBtn', s.muted ? 'Unmute' : 'Mute');
+  }
+  if (has('amp')) set('amp', s.amp ? 'ON' : 'OFF');
+  if (has('ws')) set('ws', s.ws ? 'Yes' : 'No');
+  if (has('stream')) set('stream', s.stream ? 'Yes' : 'No');
+  set('talker', s.stream && s.talker ? s.talker : '-');
+  set('sid', s.stream && s.sid ? s.sid : '-');
+  if (has('pps')) set('pps', s.pps);
+  if (has('bufMs')) set('bufMs', s.bufMs + ' ms');
+  if (has('decUs')) set('decUs', s.decUs + ' us');
+  if (has('streams')) {
+    set('streams', s.streams + ' live' + (s.held ? ' (' + s.held + ' queued)' : '') +
+      ', decode ' + (has('decLoad') ? s.decLoad : 0) + '% of a core');
+  }
+}
+
+function merge(delta) {
+  for (var k in delta) state[k] = delta[k];
+  render();
+}
+
+function refresh() {
+  fetch('/api/status').then(function (r) { return r.json(); }).then(function (s) {
+    delete state.heapKb;   // the full status carries exact heap bytes
+    merge(s);
+  }).catch(function () { set('refresh', 'Device not reachable, retrying...'); });
+}
+
+function pct(v) { return v < 0 ? 'n/a' : v + '%'; }
+
+// Task table from /api/tasks; CPU shows n/a on builds without FreeRTOS run-time stats
+function refreshTasks() {
+  fetch('/api/tasks').then(function (r) { return r.json(); }).then(function (t) {
+    set('cores', pct(t.cores[0]) + ' / ' + pct(t.cores[1]));
+    var q = t.queues;
+    set('queues', q.web + ' commands, ' + q.tx + ' TX frames, ' + q.input + ' button events, ' + q.log + ' log records, ' +
+      q.held + ' messages, ' + q.recBytes + ' B to record');
+    var body = $('tasks');
+    body.textContent = '';
+    t.tasks.sort(function (a, b) { return a.core - b.core || b.prio - a.prio; });
+    t.tasks.forEach(function (k) {
+      var row = body.insertRow();
+      [k.name, k.role, k.core < 0 ? 'any' : k.core, k.prio, pct(k.cpu),
+        k.stackFree + (k.stack ? ' of ' + k.stack : '') + ' B'].forEach(function (v) {
+        row.insertCell().textContent = v;
+      });
+    });
+  }).catch(function () {});
+}
+
+// Fall back to polling while the push channel is down
+function startPolling() {
+  if (!pollTimer) pollTimer = setInterval(refresh, 2000);
+}
+function stopPolling() {
+  if (pollTimer) { clearInterval(pollTimer); pollTimer = null; }
+}
+
+function connectEvents() {
+  if (!window.EventSource) { startPolling(); return; }
+  var es = new EventSource('/events');
+  es.onopen = function () { stopPolling(); set('refresh', 'Live'); };
+  es.onerror = function () { startPolling(); set('refresh', 'Live updates lost, polling...'); };
+  es.addEventListener('t', function (e) { merge(JSON.parse(e.data)); });
+}
+
+function control(action) {
+  fetch('/api/control', { method: 'POST', body: new URLSearchParams({ action: action }) });
+}
+
+document.querySelectorAll('[data-action]').forEach(function (b) {
+  b.onclick = function () {
+    var action = b.getAttribute('data-action');
+    control(action);
+    if (action.indexOf('replay') === 0) setTimeout(refresh, 300);   // replay state is not in the live deltas
+  };
+});
+document.querySelectorAll('[data-nav]').forEach(function (b) {
+  b.onclick = function () { window.location.href = b.getAttribute('data-nav'); };
+});
+$('enhanceBtn').onclick = function () {
+  if (has('enhance')) {
+    control(state.enhance ? 'enhance_off' : 'enhance_on');
+    setTimeout(refresh, 300);   // enhancement state is not part of the live deltas
+  }
+};
+$('muteBtn').onclick = function () {
+  if (has('muted')) control(state.muted ? 'mute_off' : 'mute_on');
+};
+$('agcBtn').onclick = function () {
+  if (has('agc')) {
+    control(state.agc ? 'agc_off' : 'agc_on');
+    setTimeout(refresh, 300);   // AGC state is not part of the live deltas
+  }
+};
+$('nsBtn').onclick = function () {
+  if (has('ns')) {
+    control(state.ns ? 'ns_off' : 'ns_on');
+    setTimeout(refresh, 300);   // applies from the next PTT press
+  }
+};
+$('rogerBtn').onclick = function () {
+  if (has('roger')) {
+    control(state.roger ? 'roger_off' : 'roger_on');
+    setTimeout(refresh, 300);
+  }
+};
+$('profileBtn').onclick = function () {
+  control('profile_next');
+  setTimeout(refresh, 300);
+};
+$('recordBtn').onclick = function () {
+  if (has('record')) {
+    control(state.record ? 'record_off' : 'record_on');
+    setTimeout(refresh, 300);
+  }
+};
+var SPEEDS = [100, 125, 150];
+$('speedBtn').onclick = function () {
+  if (has('replaySpeed')) {
+    var next = SPEEDS[(SPEEDS.indexOf(state.replaySpeed) + 1) % SPEEDS.length];
+    control('replay_speed_' + next);
+    setTimeout(refresh, 300);
+  }
+};
+var DMA_COUNTS = [2, 4, 8];
+$('dmaBtn').onclick = function () {
+  if (has('dmaCount')) {
+    control('dma_' + DMA_COUNTS[(DMA_COUNTS.indexOf(state.dmaCount) + 1) % DMA_COUNTS.length]);
+    setTimeout(refresh, 300);
+  }
+};
+$('rebootBtn').onclick = function () {
+  if (confirm('Restart the device?')) window.location.href = '/reboot';
+};
+
+refresh();
+setInterval(refresh, 30000);   // uptime, packet totals and other slow fields
+connectEvents();
+refreshTasks();
+setInterval(refreshTasks, 2000);